@@ -96,6 +96,12 @@ IF (OONF_SANITIZE)
     ENDIF()
 ENDIF()
 
+# instrument code for libFuzzer, the fuzz targets link the fuzzer itself
+IF (OONF_FUZZING)
+    SET(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -fsanitize=fuzzer-no-link,address")
+    SET(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -fsanitize=address")
+ENDIF()
+
 # add -Werror compiler options
 IF (OONF_NO_WERROR)
 	message ("Skip -Werror")
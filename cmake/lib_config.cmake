@@ -26,6 +26,9 @@ set (OONF_REMOVE_HELPTEXT false CACHE BOOL
 set (OONF_SANITIZE false CACHE BOOL
      "Activate the address sanitizer")
 
+set (OONF_FUZZING false CACHE BOOL
+     "Build the rfc5444 reader fuzz target with libFuzzer (needs clang)")
+
 ######################################
 #### Install target configuration ####
 ######################################
@@ -7,6 +7,7 @@ BAD=0
 
 EXCEPT="-not -wholename ./src-plugins/generic/nl80211_listener/nl80211.h"
 EXCEPT="${EXCEPT} -not -wholename ./src-plugins/generic/eth_listener/ethtool-copy.h"
+EXCEPT="${EXCEPT} -not -wholename ./src-plugins/generic/eth_listener/ethtool_netlink-copy.h"
 for file in $(eval find ./src* ./tests ./examples -type f -name *[.][ch] ${EXCEPT})
 do
 	cmp --bytes ${LEN} ${file} ./files/default_licence.txt
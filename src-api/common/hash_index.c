@@ -0,0 +1,192 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+
+#include "common/common_types.h"
+#include "common/hash_index.h"
+
+static int _resize(struct hash_index *, size_t size);
+
+/**
+ * Add an object to a hash index. The same object must not be
+ * added twice.
+ * @param index pointer to hash index
+ * @param obj pointer to object
+ * @param hash hash value of the objects key
+ * @return -1 if out of memory, 0 otherwise
+ */
+int
+hash_index_add(struct hash_index *index, void *obj, uint32_t hash) {
+  struct hash_index_slot *slot;
+  size_t pos;
+
+  /* keep at least half of the slots empty */
+  if ((index->count + 1) * 2 > index->_size) {
+    if (_resize(index, index->_size ? index->_size * 2 : HASH_INDEX_MIN_SIZE)) {
+      return -1;
+    }
+  }
+
+  pos = hash;
+  while (true) {
+    slot = &index->_slots[pos & (index->_size - 1)];
+    if (slot->obj == NULL) {
+      break;
+    }
+    pos++;
+  }
+
+  slot->hash = hash;
+  slot->obj = obj;
+  index->count++;
+  return 0;
+}
+
+/**
+ * Remove an object from a hash index. Nothing happens if the
+ * object is not part of the index.
+ * @param index pointer to hash index
+ * @param obj pointer to object
+ * @param hash hash value of the objects key
+ */
+void
+hash_index_remove(struct hash_index *index, void *obj, uint32_t hash) {
+  struct hash_index_slot *slot;
+  size_t mask, empty, pos, home;
+
+  if (index->_slots == NULL) {
+    return;
+  }
+
+  mask = index->_size - 1;
+
+  /* find slot of object */
+  pos = hash;
+  while (true) {
+    slot = &index->_slots[pos & mask];
+    if (slot->obj == NULL) {
+      /* object is not in index */
+      return;
+    }
+    if (slot->obj == obj) {
+      break;
+    }
+    pos++;
+  }
+
+  /* shift the following objects of the probe sequence back */
+  empty = pos & mask;
+  pos = empty;
+  while (true) {
+    pos = (pos + 1) & mask;
+    slot = &index->_slots[pos];
+    if (slot->obj == NULL) {
+      break;
+    }
+
+    home = slot->hash & mask;
+    if (((pos - home) & mask) >= ((pos - empty) & mask)) {
+      /* object can be moved into the empty slot */
+      index->_slots[empty] = *slot;
+      empty = pos;
+    }
+  }
+  index->_slots[empty].obj = NULL;
+  index->count--;
+
+  if (index->count == 0) {
+    hash_index_free(index);
+  }
+  else if (index->_size > HASH_INDEX_MIN_SIZE && index->count * 8 < index->_size) {
+    /* a failed shrink does not matter, the old table is still valid */
+    _resize(index, index->_size / 2);
+  }
+}
+
+/**
+ * Release the memory of a hash index. The index is empty
+ * afterwards, the indexed objects are not touched.
+ * @param index pointer to hash index
+ */
+void
+hash_index_free(struct hash_index *index) {
+  free(index->_slots);
+  hash_index_init(index);
+}
+
+/**
+ * Allocate a new slot array and rehash all objects
+ * @param index pointer to hash index
+ * @param size new number of slots, must be a power of two
+ * @return -1 if out of memory, 0 otherwise
+ */
+static int
+_resize(struct hash_index *index, size_t size) {
+  struct hash_index_slot *slots;
+  size_t i, pos;
+
+  slots = calloc(size, sizeof(*slots));
+  if (slots == NULL) {
+    return -1;
+  }
+
+  for (i = 0; i < index->_size; i++) {
+    if (index->_slots[i].obj == NULL) {
+      continue;
+    }
+
+    pos = index->_slots[i].hash;
+    while (slots[pos & (size - 1)].obj != NULL) {
+      pos++;
+    }
+    slots[pos & (size - 1)] = index->_slots[i];
+  }
+
+  free(index->_slots);
+  index->_slots = slots;
+  index->_size = size;
+  return 0;
+}
@@ -0,0 +1,155 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef HASH_INDEX_H_
+#define HASH_INDEX_H_
+
+#include "common/common_types.h"
+
+/*! number of slots allocated for the first object of an index */
+#define HASH_INDEX_MIN_SIZE 16
+
+/**
+ * One slot of an open addressing hash index
+ */
+struct hash_index_slot {
+  /*! hash value of the object, only valid if obj is not NULL */
+  uint32_t hash;
+
+  /*! pointer to indexed object, NULL if the slot is empty */
+  void *obj;
+};
+
+/**
+ * Open addressing (linear probing) hash index of object pointers.
+ * The index does not know the key of the objects, it only stores
+ * the hash value of the key together with the object pointer.
+ * Lookups iterate over all objects with a matching hash value,
+ * the caller compares the real keys. This allows secondary
+ * indexes to existing avl_trees without an additional node
+ * inside the indexed objects.
+ *
+ * The index never fills more than half of its slots, so every
+ * probe sequence ends at an empty slot. Removal uses backward
+ * shifting, so there are no tombstones.
+ */
+struct hash_index {
+  /*! array of slots, NULL if the index is empty */
+  struct hash_index_slot *_slots;
+
+  /*! number of slots, zero or a power of two */
+  size_t _size;
+
+  /*! number of indexed objects */
+  size_t count;
+};
+
+EXPORT int hash_index_add(struct hash_index *, void *obj, uint32_t hash);
+EXPORT void hash_index_remove(struct hash_index *, void *obj, uint32_t hash);
+EXPORT void hash_index_free(struct hash_index *);
+
+/**
+ * Initialize an empty hash index
+ * @param index pointer to hash index
+ */
+static INLINE void
+hash_index_init(struct hash_index *index) {
+  index->_slots = NULL;
+  index->_size = 0;
+  index->count = 0;
+}
+
+/**
+ * Continue a lookup in the hash index
+ * @param index pointer to hash index
+ * @param hash hash value of the key
+ * @param pos pointer to probe position of the lookup
+ * @return next object with the same hash value, NULL if there is none
+ */
+static INLINE void *
+hash_index_next_match(const struct hash_index *index, uint32_t hash, size_t *pos) {
+  const struct hash_index_slot *slot;
+
+  while (true) {
+    slot = &index->_slots[*pos & (index->_size - 1)];
+    if (slot->obj == NULL) {
+      return NULL;
+    }
+    (*pos)++;
+    if (slot->hash == hash) {
+      return slot->obj;
+    }
+  }
+}
+
+/**
+ * Start a lookup in the hash index
+ * @param index pointer to hash index
+ * @param hash hash value of the key
+ * @param pos pointer to probe position, will be initialized
+ * @return first object with the same hash value, NULL if there is none
+ */
+static INLINE void *
+hash_index_first_match(const struct hash_index *index, uint32_t hash, size_t *pos) {
+  if (index->_slots == NULL) {
+    return NULL;
+  }
+  *pos = hash;
+  return hash_index_next_match(index, hash, pos);
+}
+
+/**
+ * Loop over all objects of a hash index with a matching hash value.
+ * The index must not be modified during the loop.
+ * @param index pointer to hash index
+ * @param hash hash value of the key
+ * @param obj pointer to object, will be set by the loop
+ * @param pos size_t variable to store the probe position
+ */
+#define hash_index_for_each_match(index, hash, obj, pos) \
+  for (obj = hash_index_first_match(index, hash, &pos); \
+       obj != NULL; obj = hash_index_next_match(index, hash, &pos))
+
+#endif /* HASH_INDEX_H_ */
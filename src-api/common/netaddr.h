@@ -337,6 +337,35 @@ netaddr_cmp(const struct netaddr *a1, const struct netaddr *a2) {
   return memcmp(a1, a2, sizeof(*a1));
 }
 
+/**
+ * Calculates a hash value over all fields of an address.
+ * Two addresses with netaddr_cmp() == 0 have the same hash.
+ * @param addr address
+ * @return 32 bit hash value
+ */
+static INLINE uint32_t
+netaddr_hash(const struct netaddr *addr) {
+  uint32_t word[NETADDR_MAX_LENGTH / 4];
+  uint32_t hash;
+  size_t i;
+
+  memcpy(word, addr->_addr, sizeof(word));
+
+  hash = ((uint32_t)addr->_type << 8) | addr->_prefix_len;
+  for (i = 0; i < ARRAYSIZE(word); i++) {
+    hash = (hash ^ word[i]) * 0x9e3779b1u;
+    hash ^= hash >> 15;
+  }
+
+  /* final avalanche (murmur3 finalizer) */
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
 /**
  * Compares two sockets.
  * @param a1 address 1
@@ -87,7 +87,7 @@ static void _l2_neigh_added(struct oonf_layer2_neigh *l2neigh,
       struct oonf_layer2_destination *l2dest, const struct netaddr *mac);
 
 static void _cb_l2_neigh_added(void *);
-static void _cb_l2_neigh_changed(void *);
+static void _cb_l2_neigh_changed(struct oonf_layer2_neigh *, uint32_t);
 static void _cb_l2_neigh_removed(void *);
 
 static void _cb_l2_dst_added(void *);
@@ -169,10 +169,16 @@ static struct oonf_class_extension _layer2_neigh_listener = {
   .class_name = LAYER2_CLASS_NEIGHBOR,
 
   .cb_add = _cb_l2_neigh_added,
-  .cb_change = _cb_l2_neigh_changed,
   .cb_remove = _cb_l2_neigh_removed,
 };
 
+/* coalesce all neighbor updates of a time slice into one destination update */
+static struct oonf_layer2_listener _layer2_listener = {
+  .name = "dlep radio",
+  .neigh_mask = OONF_LAYER2_NEIGH_MASK_ALL,
+  .cb_neigh_changed = _cb_l2_neigh_changed,
+};
+
 static struct oonf_class_extension _layer2_dst_listener = {
   .ext_name = "dlep radio",
   .class_name = LAYER2_CLASS_DESTINATION,
@@ -194,11 +200,20 @@ dlep_base_proto_radio_init(void) {
 
   oonf_class_extension_add(&_layer2_neigh_listener);
   oonf_class_extension_add(&_layer2_dst_listener);
+  oonf_layer2_add_listener(&_layer2_listener);
 
   _base->cb_session_init_radio = _cb_init_radio;
   _base->cb_session_cleanup_radio = _cb_cleanup_radio;
 }
 
+/**
+ * Cleanup the radios DLEP base protocol extension
+ */
+void
+dlep_base_proto_radio_cleanup(void) {
+  oonf_layer2_remove_listener(&_layer2_listener);
+}
+
 /**
  * Callback to initialize the radio session
  * @param session dlep session
@@ -717,15 +732,15 @@ _cb_l2_neigh_added(void *ptr) {
 }
 
 /**
- * Callback triggered when a layer2 neighbor object has been changed
- * @param ptr layer2 neighbor
+ * Callback triggered when the data of a layer2 neighbor object has been changed
+ * @param l2neigh layer2 neighbor
+ * @param data_changed bitmask of changed neighbor data
  */
 static void
-_cb_l2_neigh_changed(void *ptr) {
-  struct oonf_layer2_neigh *l2neigh;
+_cb_l2_neigh_changed(struct oonf_layer2_neigh *l2neigh,
+    uint32_t data_changed __attribute__((unused))) {
   struct oonf_layer2_destination *l2dst;
 
-  l2neigh = ptr;
   _l2_neigh_changed(l2neigh, NULL, &l2neigh->addr);
 
   avl_for_each_element(&l2neigh->destinations, l2dst, _node) {
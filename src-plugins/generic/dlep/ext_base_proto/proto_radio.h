@@ -47,5 +47,6 @@
 #define _PROTO_RADIO_H_
 
 void dlep_base_proto_radio_init(void);
+void dlep_base_proto_radio_cleanup(void);
 
 #endif /* _PROTO_RADIO_H_ */
@@ -120,6 +120,7 @@ dlep_radio_interface_cleanup(void) {
   }
 
   oonf_class_remove(&_interface_class);
+  dlep_base_proto_radio_cleanup();
   dlep_radio_session_cleanup();
   dlep_extension_cleanup();
 }
@@ -43,11 +43,18 @@
  * @file
  */
 
+/* must be first because of a problem with linux/netlink.h */
+#include <sys/socket.h>
+
+/* and now the rest of the includes */
+#include <linux/types.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
 #include <linux/sockios.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
-#include <sys/socket.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <unistd.h>
 
@@ -58,9 +65,11 @@
 #include "subsystems/oonf_layer2.h"
 #include "subsystems/oonf_timer.h"
 #include "subsystems/os_interface.h"
+#include "subsystems/os_system.h"
 
 #include "eth_listener/eth_listener.h"
 #include "eth_listener/ethtool-copy.h"
+#include "eth_listener/ethtool_netlink-copy.h"
 
 /* definitions */
 #define LOG_ETH _eth_listener_subsystem.logging
@@ -73,17 +82,40 @@ struct _eth_config {
   uint64_t interval;
 };
 
+/**
+ * Source of the ethernet link speed
+ */
+enum _eth_backend {
+  /*! ethtool netlink family has not been resolved yet */
+  ETH_BACKEND_UNKNOWN,
+
+  /*! kernel reports link speed and its changes by ethtool netlink */
+  ETH_BACKEND_NETLINK,
+
+  /*! link speed is polled with the SIOCETHTOOL ioctl */
+  ETH_BACKEND_IOCTL,
+};
+
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
 
+static void _send_get_family(void);
+
 static void _cb_transmission_event(struct oonf_timer_instance *);
+static int _cb_if_changed(struct os_interface_listener *);
 static void _cb_config_changed(void);
 
+static void _cb_nl_message(struct nlmsghdr *hdr);
+static void _cb_nl_error(uint32_t seq, int error);
+static void _cb_nl_timeout(void);
+static void _cb_nl_done(uint32_t seq);
+
 /* configuration */
 static struct cfg_schema_entry _eth_entries[] = {
   CFG_MAP_CLOCK_MIN(_eth_config, interval, "interval", "60.0",
-      "Interval between two linklayer information updates", 100),
+      "Interval between two linklayer information updates, only used"
+      " if the kernel does not support ethtool netlink", 100),
 };
 
 static struct cfg_schema_section _eth_section = {
@@ -101,6 +133,7 @@ static const char *_dependencies[] = {
   OONF_LAYER2_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
   OONF_OS_INTERFACE_SUBSYSTEM,
+  OONF_OS_SYSTEM_SUBSYSTEM,
 };
 static struct oonf_subsystem _eth_listener_subsystem = {
   .name = OONF_ETH_LISTENER_SUBSYSTEM,
@@ -133,6 +166,43 @@ static struct oonf_layer2_origin _l2_origin = {
   .proactive = true,
 };
 
+/* listener for changes of all interfaces */
+static struct os_interface_listener _if_listener = {
+  .name = OS_INTERFACE_ANY,
+  .if_changed = _cb_if_changed,
+};
+
+/* netlink handler for ethtool */
+static struct os_system_netlink _netlink_handler = {
+  .name = "ethtool listener",
+  .used_by = &_eth_listener_subsystem,
+  .cb_message = _cb_nl_message,
+  .cb_error = _cb_nl_error,
+  .cb_done = _cb_nl_done,
+  .cb_timeout = _cb_nl_timeout,
+};
+
+/* buffer for outgoing netlink message */
+static uint32_t _nl_msgbuffer[UIO_MAXIOV/4];
+static struct nlmsghdr *_nl_msg = (void *)_nl_msgbuffer;
+
+/* true if the netlink socket for ethtool is open */
+static bool _netlink_open = false;
+
+/* current source of the link speed */
+static enum _eth_backend _backend = ETH_BACKEND_UNKNOWN;
+
+/* ethtool generic netlink identification */
+static uint32_t _ethtool_id = 0;
+static uint32_t _ethtool_monitor_group = 0;
+
+/* sequence numbers of outstanding netlink requests */
+static uint32_t _family_seq = 0;
+static uint32_t _dump_seq = 0;
+
+/* true if the link modes should be dumped again after the current dump */
+static bool _dump_again = false;
+
 static int _ioctl_sock;
 
 static int
@@ -145,12 +215,27 @@ _init(void) {
 
   oonf_timer_add(&_transmission_timer_info);
   oonf_layer2_add_origin(&_l2_origin);
+  os_interface_add(&_if_listener);
 
+  if (os_system_linux_netlink_add(&_netlink_handler, NETLINK_GENERIC)) {
+    OONF_INFO(LOG_ETH, "Could not open generic netlink socket, use ioctl");
+    _backend = ETH_BACKEND_IOCTL;
+  }
+  else {
+    _netlink_open = true;
+    _send_get_family();
+  }
   return 0;
 }
 
 static void
 _cleanup(void) {
+  if (_netlink_open) {
+    os_system_linux_netlink_remove(&_netlink_handler);
+    _netlink_open = false;
+  }
+
+  os_interface_remove(&_if_listener);
   oonf_layer2_remove_origin(&_l2_origin);
 
   oonf_timer_stop(&_transmission_timer);
@@ -160,21 +245,324 @@ _cleanup(void) {
 }
 
 /**
- * Callback for querying ethernet status
- * @param ptr timer instance that fired
+ * Parse a stream of netlink attributes into an array
+ * indexed by the attribute type
+ * @param attrs array of max+1 attribute pointers
+ * @param max highest attribute type that should be stored
+ * @param attr pointer to first attribute
+ * @param len length of attribute stream
  */
 static void
-_cb_transmission_event(struct oonf_timer_instance *ptr __attribute((unused))) {
+_parse_attributes(struct nlattr **attrs, int max, struct nlattr *attr, int len) {
+  int type;
+
+  memset(attrs, 0, sizeof(*attrs) * (max + 1));
+
+  while (len >= (int)NLA_HDRLEN
+      && attr->nla_len >= NLA_HDRLEN && attr->nla_len <= len) {
+    type = attr->nla_type & NLA_TYPE_MASK;
+    if (type <= max) {
+      attrs[type] = attr;
+    }
+
+    len -= NLA_ALIGN(attr->nla_len);
+    attr = (struct nlattr *)((char *)attr + NLA_ALIGN(attr->nla_len));
+  }
+}
+
+/**
+ * @param attr netlink attribute
+ * @return pointer to payload of attribute
+ */
+static void *
+_get_attr_data(struct nlattr *attr) {
+  return (char *)attr + NLA_HDRLEN;
+}
+
+/**
+ * @param attr netlink attribute
+ * @return length of payload of attribute
+ */
+static int
+_get_attr_len(struct nlattr *attr) {
+  return attr->nla_len - NLA_HDRLEN;
+}
+
+/**
+ * @param attr netlink attribute
+ * @return 32 bit unsigned payload of attribute, 0 if too short
+ */
+static uint32_t
+_get_attr_u32(struct nlattr *attr) {
+  uint32_t value = 0;
+
+  if (_get_attr_len(attr) >= (int)sizeof(value)) {
+    memcpy(&value, _get_attr_data(attr), sizeof(value));
+  }
+  return value;
+}
+
+/**
+ * @param attr netlink attribute
+ * @param str zero terminated string
+ * @return true if payload of attribute is the string
+ */
+static bool
+_is_attr_string(struct nlattr *attr, const char *str) {
+  size_t len = strlen(str) + 1;
+
+  return _get_attr_len(attr) >= (int)len
+      && memcmp(_get_attr_data(attr), str, len) == 0;
+}
+
+/**
+ * Initialize a generic netlink request
+ * @param type netlink message type
+ * @param cmd generic netlink command
+ * @param version generic netlink version
+ */
+static void
+_init_genl_message(uint16_t type, uint8_t cmd, uint8_t version) {
+  struct genlmsghdr *hdr;
+
+  memset(&_nl_msgbuffer, 0, sizeof(_nl_msgbuffer));
+
+  _nl_msg->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+  _nl_msg->nlmsg_flags = NLM_F_REQUEST;
+  _nl_msg->nlmsg_type = type;
+
+  hdr = NLMSG_DATA(_nl_msg);
+  hdr->cmd = cmd;
+  hdr->version = version;
+}
+
+/**
+ * Ask the kernel for the id and multicast groups of
+ * the ethtool generic netlink family
+ */
+static void
+_send_get_family(void) {
+  _init_genl_message(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 1);
+  os_system_linux_netlink_addreq(&_netlink_handler, _nl_msg,
+      CTRL_ATTR_FAMILY_NAME, ETHTOOL_GENL_NAME, sizeof(ETHTOOL_GENL_NAME));
+
+  _family_seq = os_system_linux_netlink_send(&_netlink_handler, _nl_msg);
+}
+
+/**
+ * Request the link modes of all ethernet interfaces
+ */
+static void
+_send_linkmodes_dump(void) {
+  struct nlattr *header;
+  uint32_t flags;
+
+  if (_dump_seq) {
+    /* only one dump at a time */
+    _dump_again = true;
+    return;
+  }
+
+  _init_genl_message(_ethtool_id, ETHTOOL_MSG_LINKMODES_GET, ETHTOOL_GENL_VERSION);
+  _nl_msg->nlmsg_flags |= NLM_F_DUMP;
+
+  /* nested request header, we are not interested in the link mode names */
+  header = (struct nlattr *)((char *)_nl_msg + NLMSG_ALIGN(_nl_msg->nlmsg_len));
+  os_system_linux_netlink_addreq(&_netlink_handler, _nl_msg,
+      ETHTOOL_A_LINKMODES_HEADER | NLA_F_NESTED, NULL, 0);
+
+  flags = ETHTOOL_FLAG_COMPACT_BITSETS;
+  os_system_linux_netlink_addreq(&_netlink_handler, _nl_msg,
+      ETHTOOL_A_HEADER_FLAGS, &flags, sizeof(flags));
+  header->nla_len = (char *)_nl_msg + _nl_msg->nlmsg_len - (char *)header;
+
+  OONF_DEBUG(LOG_ETH, "Request ethtool link modes");
+  _dump_seq = os_system_linux_netlink_send(&_netlink_handler, _nl_msg);
+  _dump_again = false;
+}
+
+/**
+ * Switch to polling the link speed with ioctl calls
+ */
+static void
+_use_ioctl_backend(void) {
+  if (_backend == ETH_BACKEND_IOCTL) {
+    return;
+  }
+
+  OONF_INFO(LOG_ETH, "Kernel has no usable ethtool netlink interface, use ioctl");
+  _backend = ETH_BACKEND_IOCTL;
+  _family_seq = 0;
+  _dump_seq = 0;
+
+  if (_config.interval) {
+    oonf_timer_set_ext(&_transmission_timer, 1, _config.interval);
+  }
+}
+
+/**
+ * Switch to receiving the link speed by ethtool netlink
+ */
+static void
+_use_netlink_backend(void) {
+  if (!_ethtool_id || !_ethtool_monitor_group) {
+    _use_ioctl_backend();
+    return;
+  }
+
+  if (os_system_linux_netlink_add_mc(&_netlink_handler, &_ethtool_monitor_group, 1)) {
+    _use_ioctl_backend();
+    return;
+  }
+
+  OONF_INFO(LOG_ETH, "Use ethtool netlink for ethernet link speed");
+  _backend = ETH_BACKEND_NETLINK;
+
+  /* changes are reported by the kernel from now on */
+  oonf_timer_stop(&_transmission_timer);
+  _send_linkmodes_dump();
+}
+
+/**
+ * Set the default link speed of the neighbors of an interface
+ * @param os_if network interface
+ * @param speed link speed in MBit/s as reported by ethtool
+ */
+static void
+_set_link_speed(struct os_interface *os_if, uint32_t speed) {
   struct oonf_layer2_net *l2net;
-  struct os_interface *os_if;
-  struct ethtool_cmd cmd;
-  struct ifreq req;
   int64_t ethspeed;
-  int err;
 #ifdef OONF_LOG_DEBUG_INFO
   struct isonumber_str ibuf;
 #endif
 
+  if (speed == 0 || speed == (uint16_t)-1 || speed == (uint32_t)-1) {
+    /* speed is not known */
+    return;
+  }
+  ethspeed = (int64_t)speed * 1000 * 1000;
+
+  /* layer-2 object for this interface */
+  l2net = oonf_layer2_net_add(os_if->name);
+  if (l2net == NULL) {
+    return;
+  }
+  if (l2net->if_type == OONF_LAYER2_TYPE_UNDEFINED) {
+    l2net->if_type = OONF_LAYER2_TYPE_ETHERNET;
+  }
+
+  /* set corresponding database entries */
+  OONF_DEBUG(LOG_ETH, "Set default link speed of interface %s to %s",
+      os_if->name,
+      isonumber_from_s64(&ibuf, ethspeed, "bit/s", 0, false, false));
+
+  oonf_layer2_set_value(&l2net->neighdata[OONF_LAYER2_NEIGH_RX_BITRATE],
+      &_l2_origin, ethspeed);
+  oonf_layer2_set_value(&l2net->neighdata[OONF_LAYER2_NEIGH_TX_BITRATE],
+      &_l2_origin, ethspeed);
+  oonf_layer2_net_commit(l2net);
+}
+
+/**
+ * Process the reply to the ethtool family request
+ * @param hdr netlink message header
+ */
+static void
+_process_get_family_result(struct nlmsghdr *hdr) {
+  struct nlattr *attrs[CTRL_ATTR_MAX+1];
+  struct nlattr *grp_attrs[CTRL_ATTR_MCAST_GRP_MAX+1];
+  struct nlattr *mcgrp;
+  uint16_t family_id;
+  int len;
+
+  _parse_attributes(attrs, CTRL_ATTR_MAX,
+      (struct nlattr *)((char *)NLMSG_DATA(hdr) + GENL_HDRLEN),
+      hdr->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+
+  if (!attrs[CTRL_ATTR_FAMILY_ID] || !attrs[CTRL_ATTR_FAMILY_NAME]
+      || !_is_attr_string(attrs[CTRL_ATTR_FAMILY_NAME], ETHTOOL_GENL_NAME)) {
+    return;
+  }
+
+  memcpy(&family_id, _get_attr_data(attrs[CTRL_ATTR_FAMILY_ID]), sizeof(family_id));
+  _ethtool_id = family_id;
+  OONF_DEBUG(LOG_ETH, "Received ethtool family id: %u", _ethtool_id);
+
+  if (!attrs[CTRL_ATTR_MCAST_GROUPS]) {
+    return;
+  }
+
+  /* look for the monitor group */
+  mcgrp = _get_attr_data(attrs[CTRL_ATTR_MCAST_GROUPS]);
+  len = _get_attr_len(attrs[CTRL_ATTR_MCAST_GROUPS]);
+  while (len >= (int)NLA_HDRLEN
+      && mcgrp->nla_len >= NLA_HDRLEN && mcgrp->nla_len <= len) {
+    _parse_attributes(grp_attrs, CTRL_ATTR_MCAST_GRP_MAX,
+        _get_attr_data(mcgrp), _get_attr_len(mcgrp));
+
+    if (grp_attrs[CTRL_ATTR_MCAST_GRP_NAME] && grp_attrs[CTRL_ATTR_MCAST_GRP_ID]
+        && _is_attr_string(grp_attrs[CTRL_ATTR_MCAST_GRP_NAME],
+            ETHTOOL_MCGRP_MONITOR_NAME)) {
+      _ethtool_monitor_group = _get_attr_u32(grp_attrs[CTRL_ATTR_MCAST_GRP_ID]);
+      OONF_DEBUG(LOG_ETH, "Received ethtool monitor group: %u",
+          _ethtool_monitor_group);
+    }
+
+    len -= NLA_ALIGN(mcgrp->nla_len);
+    mcgrp = (struct nlattr *)((char *)mcgrp + NLA_ALIGN(mcgrp->nla_len));
+  }
+}
+
+/**
+ * Process the link modes of an ethernet interface
+ * reported by ethtool netlink
+ * @param hdr netlink message header
+ */
+static void
+_process_linkmodes(struct nlmsghdr *hdr) {
+  struct nlattr *attrs[ETHTOOL_A_LINKMODES_DUPLEX+1];
+  struct nlattr *header[ETHTOOL_A_HEADER_MAX+1];
+  struct os_interface *os_if;
+  uint32_t if_index, speed;
+
+  _parse_attributes(attrs, ETHTOOL_A_LINKMODES_DUPLEX,
+      (struct nlattr *)((char *)NLMSG_DATA(hdr) + GENL_HDRLEN),
+      hdr->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+
+  if (!attrs[ETHTOOL_A_LINKMODES_HEADER] || !attrs[ETHTOOL_A_LINKMODES_SPEED]) {
+    return;
+  }
+
+  _parse_attributes(header, ETHTOOL_A_HEADER_MAX,
+      _get_attr_data(attrs[ETHTOOL_A_LINKMODES_HEADER]),
+      _get_attr_len(attrs[ETHTOOL_A_LINKMODES_HEADER]));
+  if (!header[ETHTOOL_A_HEADER_DEV_INDEX]) {
+    return;
+  }
+
+  if_index = _get_attr_u32(header[ETHTOOL_A_HEADER_DEV_INDEX]);
+  speed = _get_attr_u32(attrs[ETHTOOL_A_LINKMODES_SPEED]);
+
+  OONF_DEBUG(LOG_ETH, "Received link speed %u of interface %u", speed, if_index);
+
+  /* vlan interfaces inherit the speed of their base interface */
+  avl_for_each_element(os_interface_get_tree(), os_if, _node) {
+    if (os_if->base_index == if_index) {
+      _set_link_speed(os_if, speed);
+    }
+  }
+}
+
+/**
+ * Query the link speed of all interfaces with the SIOCETHTOOL ioctl
+ */
+static void
+_query_ioctl(void) {
+  struct os_interface *os_if;
+  struct ethtool_cmd cmd;
+  struct ifreq req;
+  int err;
+
   avl_for_each_element(os_interface_get_tree(), os_if, _node) {
     /* initialize ethtool command */
     memset(&cmd, 0, sizeof(cmd));
@@ -205,31 +593,113 @@ _cb_transmission_event(struct oonf_timer_instance *ptr __attribute((unused))) {
     }
 
     /* get ethernet linkspeed */
-    ethspeed = ethtool_cmd_speed(&cmd);
-    if (ethspeed == 0 || ethspeed == (uint16_t)-1 || ethspeed == (uint32_t)-1) {
-      /* speed is not known */
-      continue;
-    }
-    ethspeed *= 1000 * 1000;
+    _set_link_speed(os_if, ethtool_cmd_speed(&cmd));
+  }
+}
 
-    /* layer-2 object for this interface */
-    l2net = oonf_layer2_net_add(os_if->name);
-    if (l2net == NULL) {
-      continue;
-    }
-    if (l2net->if_type == OONF_LAYER2_TYPE_UNDEFINED) {
-      l2net->if_type = OONF_LAYER2_TYPE_ETHERNET;
-    }
+/**
+ * Callback for querying ethernet status
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_transmission_event(struct oonf_timer_instance *ptr __attribute((unused))) {
+  if (_backend != ETH_BACKEND_NETLINK) {
+    /* poll until ethtool netlink is available */
+    _query_ioctl();
+  }
+}
+
+/**
+ * Callback for changes of network interfaces, a link change
+ * might have changed the link speed
+ * @param listener interface listener
+ * @return always 0
+ */
+static int
+_cb_if_changed(struct os_interface_listener *listener __attribute__((unused))) {
+  if (_backend == ETH_BACKEND_NETLINK) {
+    _send_linkmodes_dump();
+  }
+  return 0;
+}
+
+/**
+ * Parse an incoming netlink message from the kernel
+ * @param hdr pointer to netlink message
+ */
+static void
+_cb_nl_message(struct nlmsghdr *hdr) {
+  struct genlmsghdr *gen_hdr;
+
+  gen_hdr = NLMSG_DATA(hdr);
+  if (hdr->nlmsg_type == GENL_ID_CTRL && gen_hdr->cmd == CTRL_CMD_NEWFAMILY) {
+    _process_get_family_result(hdr);
+    return;
+  }
 
-    /* set corresponding database entries */
-    OONF_DEBUG(LOG_ETH, "Set default link speed of interface %s to %s",
-        os_if->name,
-        isonumber_from_s64(&ibuf, ethspeed, "bit/s", 0, false, false));
+  if (!_ethtool_id || hdr->nlmsg_type != _ethtool_id) {
+    OONF_DEBUG(LOG_ETH, "Unhandled netlink message type: %u", hdr->nlmsg_type);
+    return;
+  }
+
+  switch (gen_hdr->cmd) {
+    case ETHTOOL_MSG_LINKMODES_GET_REPLY:
+    case ETHTOOL_MSG_LINKMODES_NTF:
+      _process_linkmodes(hdr);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Callback triggered when a netlink message failes
+ * @param seq sequence number
+ * @param error error code
+ */
+static void
+_cb_nl_error(uint32_t seq, int error __attribute__((unused))) {
+  OONF_DEBUG(LOG_ETH, "seq %u: Received error %d", seq, error);
 
-    oonf_layer2_set_value(&l2net->neighdata[OONF_LAYER2_NEIGH_RX_BITRATE],
-        &_l2_origin, ethspeed);
-    oonf_layer2_set_value(&l2net->neighdata[OONF_LAYER2_NEIGH_TX_BITRATE],
-        &_l2_origin, ethspeed);
+  if (seq == _family_seq || seq == _dump_seq) {
+    /* ethtool family is missing or link modes cannot be dumped */
+    _use_ioctl_backend();
+  }
+}
+
+/**
+ * Callback triggered when one or more netlink messages time out
+ */
+static void
+_cb_nl_timeout(void) {
+  OONF_DEBUG(LOG_ETH, "Received timeout");
+
+  if (_family_seq) {
+    _use_ioctl_backend();
+  }
+  else if (_dump_seq) {
+    _dump_seq = 0;
+    _send_linkmodes_dump();
+  }
+}
+
+/**
+ * Callback triggered when a netlink message is done
+ * @param seq sequence number
+ */
+static void
+_cb_nl_done(uint32_t seq) {
+  OONF_DEBUG(LOG_ETH, "%u: Received done", seq);
+
+  if (seq == _family_seq) {
+    _family_seq = 0;
+    _use_netlink_backend();
+  }
+  else if (seq == _dump_seq) {
+    _dump_seq = 0;
+    if (_dump_again) {
+      _send_linkmodes_dump();
+    }
   }
 }
 
@@ -242,5 +712,7 @@ _cb_config_changed(void) {
     return;
   }
 
-  oonf_timer_set_ext(&_transmission_timer, 1, _config.interval);
+  if (_backend != ETH_BACKEND_NETLINK) {
+    oonf_timer_set_ext(&_transmission_timer, 1, _config.interval);
+  }
 }
@@ -85,6 +85,10 @@ static int _cb_create_text_interface(struct oonf_viewer_template *);
 static int _cb_create_text_neighbor(struct oonf_viewer_template *);
 static int _cb_create_text_default(struct oonf_viewer_template *);
 static int _cb_create_text_dst(struct oonf_viewer_template *);
+static int _cb_create_text_if_history(struct oonf_viewer_template *);
+static int _cb_create_text_neigh_history(struct oonf_viewer_template *);
+static int _cb_create_text_if_sample(struct oonf_viewer_template *);
+static int _cb_create_text_neigh_sample(struct oonf_viewer_template *);
 
 /*
  * list of template keys and corresponding buffers for values.
@@ -128,6 +132,30 @@ static int _cb_create_text_dst(struct oonf_viewer_template *);
 /*! template key for destination origin */
 #define KEY_DST_ORIGIN                  "dst_origin"
 
+/*! template key for data key of history */
+#define KEY_HISTORY_DATA                "history_data"
+
+/*! template key for number of samples in history */
+#define KEY_HISTORY_COUNT               "history_count"
+
+/*! template key for minimum value of history */
+#define KEY_HISTORY_MIN                 "history_min"
+
+/*! template key for maximum value of history */
+#define KEY_HISTORY_MAX                 "history_max"
+
+/*! template key for average value of history */
+#define KEY_HISTORY_AVG                 "history_avg"
+
+/*! template key for rate of change of history */
+#define KEY_HISTORY_RATE                "history_rate"
+
+/*! template key for age of history sample */
+#define KEY_SAMPLE_AGE                  "sample_age"
+
+/*! template key for value of history sample */
+#define KEY_SAMPLE_VALUE                "sample_value"
+
 
 /*! string prefix for all interface keys */
 #define KEY_IF_PREFIX                   "if_"
@@ -160,6 +188,15 @@ static char                             _value_neigh_origin[OONF_LAYER2_NEIGH_CO
 static struct netaddr_str               _value_dst_addr;
 static char                             _value_dst_origin[IF_NAMESIZE];
 
+static char                             _value_history_data[16];
+static char                             _value_history_count[12];
+static struct isonumber_str             _value_history_min;
+static struct isonumber_str             _value_history_max;
+static struct isonumber_str             _value_history_avg;
+static struct isonumber_str             _value_history_rate;
+static struct isonumber_str             _value_sample_age;
+static struct isonumber_str             _value_sample_value;
+
 /* definition of the template data entries for JSON and table output */
 static struct abuf_template_data_entry _tde_if_key[] = {
     { KEY_IF, _value_if, true },
@@ -196,6 +233,21 @@ static struct abuf_template_data_entry _tde_dst[] = {
     { KEY_DST_ORIGIN, _value_dst_origin, true },
 };
 
+static struct abuf_template_data_entry _tde_history_key[] = {
+    { KEY_HISTORY_DATA, _value_history_data, true },
+};
+static struct abuf_template_data_entry _tde_history[] = {
+    { KEY_HISTORY_COUNT, _value_history_count, false },
+    { KEY_HISTORY_MIN, _value_history_min.buf, true },
+    { KEY_HISTORY_MAX, _value_history_max.buf, true },
+    { KEY_HISTORY_AVG, _value_history_avg.buf, true },
+    { KEY_HISTORY_RATE, _value_history_rate.buf, true },
+};
+static struct abuf_template_data_entry _tde_sample[] = {
+    { KEY_SAMPLE_AGE, _value_sample_age.buf, false },
+    { KEY_SAMPLE_VALUE, _value_sample_value.buf, true },
+};
+
 static struct abuf_template_storage _template_storage;
 static struct autobuf _key_storage;
 
@@ -224,6 +276,28 @@ static struct abuf_template_data _td_dst[] = {
     { _tde_dst_key, ARRAYSIZE(_tde_dst_key) },
     { _tde_dst, ARRAYSIZE(_tde_dst) },
 };
+static struct abuf_template_data _td_if_history[] = {
+    { _tde_if_key, ARRAYSIZE(_tde_if_key) },
+    { _tde_history_key, ARRAYSIZE(_tde_history_key) },
+    { _tde_history, ARRAYSIZE(_tde_history) },
+};
+static struct abuf_template_data _td_neigh_history[] = {
+    { _tde_if_key, ARRAYSIZE(_tde_if_key) },
+    { _tde_neigh_key, ARRAYSIZE(_tde_neigh_key) },
+    { _tde_history_key, ARRAYSIZE(_tde_history_key) },
+    { _tde_history, ARRAYSIZE(_tde_history) },
+};
+static struct abuf_template_data _td_if_sample[] = {
+    { _tde_if_key, ARRAYSIZE(_tde_if_key) },
+    { _tde_history_key, ARRAYSIZE(_tde_history_key) },
+    { _tde_sample, ARRAYSIZE(_tde_sample) },
+};
+static struct abuf_template_data _td_neigh_sample[] = {
+    { _tde_if_key, ARRAYSIZE(_tde_if_key) },
+    { _tde_neigh_key, ARRAYSIZE(_tde_neigh_key) },
+    { _tde_history_key, ARRAYSIZE(_tde_history_key) },
+    { _tde_sample, ARRAYSIZE(_tde_sample) },
+};
 
 /* OONF viewer templates (based on Template Data arrays) */
 static struct oonf_viewer_template _templates[] = {
@@ -251,6 +325,30 @@ static struct oonf_viewer_template _templates[] = {
         .json_name = "destination",
         .cb_function = _cb_create_text_dst,
     },
+    {
+        .data = _td_if_history,
+        .data_size = ARRAYSIZE(_td_if_history),
+        .json_name = "interface_history",
+        .cb_function = _cb_create_text_if_history,
+    },
+    {
+        .data = _td_neigh_history,
+        .data_size = ARRAYSIZE(_td_neigh_history),
+        .json_name = "neighbor_history",
+        .cb_function = _cb_create_text_neigh_history,
+    },
+    {
+        .data = _td_if_sample,
+        .data_size = ARRAYSIZE(_td_if_sample),
+        .json_name = "interface_sample",
+        .cb_function = _cb_create_text_if_sample,
+    },
+    {
+        .data = _td_neigh_sample,
+        .data_size = ARRAYSIZE(_td_neigh_sample),
+        .json_name = "neighbor_sample",
+        .cb_function = _cb_create_text_neigh_sample,
+    },
 };
 
 /* telnet command of this plugin */
@@ -505,6 +603,62 @@ _initialize_destination_values(struct oonf_layer2_destination *l2dst) {
   strscpy(_value_dst_origin, l2dst->origin->name, IF_NAMESIZE);
 }
 
+/**
+ * Initialize the value buffers for the statistics of a layer2 data history
+ * @param template viewer template
+ * @param history layer2 data history
+ * @param meta metadata of the data entry of the history
+ */
+static void
+_initialize_history_values(struct oonf_viewer_template *template,
+    const struct oonf_layer2_history *history,
+    const struct oonf_layer2_metadata *meta) {
+  char rate_unit[sizeof(meta->unit) + 2];
+
+  strscpy(_value_history_data, meta->key, sizeof(_value_history_data));
+  snprintf(_value_history_count, sizeof(_value_history_count), "%"PRINTF_SIZE_T_SPECIFIER,
+      oonf_layer2_history_get_count(history));
+
+  isonumber_from_s64(&_value_history_min, oonf_layer2_history_get_min(history),
+      meta->unit, meta->fraction, meta->binary, template->create_raw);
+  isonumber_from_s64(&_value_history_max, oonf_layer2_history_get_max(history),
+      meta->unit, meta->fraction, meta->binary, template->create_raw);
+  isonumber_from_s64(&_value_history_avg, oonf_layer2_history_get_average(history),
+      meta->unit, meta->fraction, meta->binary, template->create_raw);
+
+  snprintf(rate_unit, sizeof(rate_unit), "%s/s", meta->unit);
+  isonumber_from_s64(&_value_history_rate, oonf_layer2_history_get_rate(history),
+      rate_unit, meta->fraction, meta->binary, template->create_raw);
+}
+
+/**
+ * Generate one output line for each sample of a layer2 data history
+ * @param template viewer template
+ * @param history layer2 data history
+ * @param meta metadata of the data entry of the history
+ */
+static void
+_print_history_samples(struct oonf_viewer_template *template,
+    const struct oonf_layer2_history *history,
+    const struct oonf_layer2_metadata *meta) {
+  const struct oonf_layer2_sample *sample;
+  size_t i;
+
+  strscpy(_value_history_data, meta->key, sizeof(_value_history_data));
+
+  for (i=0; i<oonf_layer2_history_get_count(history); i++) {
+    sample = oonf_layer2_history_get_sample(history, i);
+
+    oonf_clock_toIntervalString(&_value_sample_age,
+        -oonf_clock_get_relative(sample->timestamp));
+    isonumber_from_s64(&_value_sample_value, sample->value,
+        meta->unit, meta->fraction, meta->binary, template->create_raw);
+
+    /* generate template output */
+    oonf_viewer_output_print_line(template);
+  }
+}
+
 /**
  * Callback to generate text/json description of all layer2 interfaces
  * @param template viewer template
@@ -599,3 +753,104 @@ _cb_create_text_dst(struct oonf_viewer_template *template) {
   return 0;
 }
 
+/**
+ * Callback to generate text/json statistics of all layer2 interface histories
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_if_history(struct oonf_viewer_template *template) {
+  const struct oonf_layer2_history *history;
+  struct oonf_layer2_net *net;
+
+  avl_for_each_element(oonf_layer2_get_network_tree(), net, _node) {
+    _initialize_if_values(net);
+
+    list_for_each_element(&net->history, history, _node) {
+      _initialize_history_values(template, history,
+          oonf_layer2_get_net_metadata(history->index));
+
+      /* generate template output */
+      oonf_viewer_output_print_line(template);
+    }
+  }
+  return 0;
+}
+
+/**
+ * Callback to generate text/json statistics of all layer2 neighbor histories
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_neigh_history(struct oonf_viewer_template *template) {
+  const struct oonf_layer2_history *history;
+  struct oonf_layer2_neigh *neigh;
+  struct oonf_layer2_net *net;
+
+  avl_for_each_element(oonf_layer2_get_network_tree(), net, _node) {
+    _initialize_if_values(net);
+
+    avl_for_each_element(&net->neighbors, neigh, _node) {
+      _initialize_neigh_values(neigh);
+
+      list_for_each_element(&neigh->history, history, _node) {
+        _initialize_history_values(template, history,
+            oonf_layer2_get_neigh_metadata(history->index));
+
+        /* generate template output */
+        oonf_viewer_output_print_line(template);
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * Callback to generate text/json description of all samples
+ * of layer2 interface histories
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_if_sample(struct oonf_viewer_template *template) {
+  const struct oonf_layer2_history *history;
+  struct oonf_layer2_net *net;
+
+  avl_for_each_element(oonf_layer2_get_network_tree(), net, _node) {
+    _initialize_if_values(net);
+
+    list_for_each_element(&net->history, history, _node) {
+      _print_history_samples(template, history,
+          oonf_layer2_get_net_metadata(history->index));
+    }
+  }
+  return 0;
+}
+
+/**
+ * Callback to generate text/json description of all samples
+ * of layer2 neighbor histories
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_neigh_sample(struct oonf_viewer_template *template) {
+  const struct oonf_layer2_history *history;
+  struct oonf_layer2_neigh *neigh;
+  struct oonf_layer2_net *net;
+
+  avl_for_each_element(oonf_layer2_get_network_tree(), net, _node) {
+    _initialize_if_values(net);
+
+    avl_for_each_element(&net->neighbors, neigh, _node) {
+      _initialize_neigh_values(neigh);
+
+      list_for_each_element(&neigh->history, history, _node) {
+        _print_history_samples(template, history,
+            oonf_layer2_get_neigh_metadata(history->index));
+      }
+    }
+  }
+  return 0;
+}
@@ -103,10 +103,13 @@ genl_send_get_family(struct nlmsghdr *nl_msg, struct genlmsghdr *hdr) {
  * Process CTRL_CMD_NEWFAMILY message
  * @param hdr pointer to netlink message header
  * @param nl80211_id pointer to nl80211 id, will be overwritten by function
- * @param nl80211_mc pointer to nl80211 multicast group, will be overwritten by function
+ * @param nl80211_mc pointer to nl80211 mlme multicast group, will be overwritten by function
+ * @param nl80211_config_mc pointer to nl80211 config multicast group,
+ *   will be overwritten by function
  */
 void
-genl_process_get_family_result(struct nlmsghdr *hdr, uint32_t *nl80211_id, uint32_t *nl80211_mc) {
+genl_process_get_family_result(struct nlmsghdr *hdr, uint32_t *nl80211_id,
+    uint32_t *nl80211_mc, uint32_t *nl80211_config_mc) {
   static struct nla_policy ctrl_policy[CTRL_ATTR_MAX+1] = {
     [CTRL_ATTR_FAMILY_ID]    = { .type = NLA_U16 },
     [CTRL_ATTR_FAMILY_NAME]  = { .type = NLA_STRING, .maxlen = GENL_NAMSIZ },
@@ -167,22 +170,11 @@ genl_process_get_family_result(struct nlmsghdr *hdr, uint32_t *nl80211_id, uint3
         (char *)nla_data(tb_mcgrp[CTRL_ATTR_MCAST_GRP_NAME]),
         group);
 
-    if (strcmp(nla_data(tb_mcgrp[CTRL_ATTR_MCAST_GRP_NAME]), "mlme"))
-      continue;
-
-    *nl80211_mc = group;
-  }
-}
-
-#if 0
-    if (os_system_netlink_add_mc(&netlink_handler, &group, 1)) {
-      OONF_WARN(LOG_NL80211,
-          "Could not activate multicast group %d for nl80211", group);
+    if (strcmp(nla_data(tb_mcgrp[CTRL_ATTR_MCAST_GRP_NAME]), "mlme") == 0) {
+      *nl80211_mc = group;
     }
-    else {
+    else if (strcmp(nla_data(tb_mcgrp[CTRL_ATTR_MCAST_GRP_NAME]), "config") == 0) {
+      *nl80211_config_mc = group;
     }
-    break;
   }
 }
-
-#endif
@@ -85,6 +85,7 @@
 #include "nl80211_listener/nl80211_listener.h"
 #include "nl80211_listener/nl80211_get_interface.h"
 
+static void _process_frequency(struct nl80211_if *interf, struct nlattr **tb_msg);
 static uint64_t _get_bandwidth(uint32_t width);
 
 /**
@@ -114,12 +115,10 @@ nl80211_send_get_interface(struct os_system_netlink *nl,
 void
 nl80211_process_get_interface_result(struct nl80211_if *interf,
     struct nlmsghdr *hdr) {
-  struct genlmsghdr *gnlh;
   struct nlattr *tb_msg[NL80211_ATTR_MAX + 1];
 
-  gnlh = nlmsg_data(hdr);
-  nla_parse(tb_msg, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
-      genlmsg_attrlen(gnlh, 0), NULL);
+  nla_parse(tb_msg, NL80211_ATTR_MAX, nlmsg_attrdata(hdr, GENL_HDRLEN),
+      nlmsg_attrlen(hdr, GENL_HDRLEN), NULL);
 
   if (!tb_msg[NL80211_ATTR_IFNAME]
       || !tb_msg[NL80211_ATTR_WIPHY]) {
@@ -145,6 +144,33 @@ nl80211_process_get_interface_result(struct nl80211_if *interf,
       interf->ifdata_changed = true;
     }
   }
+  _process_frequency(interf, tb_msg);
+}
+
+/**
+ * Process NL80211_CMD_CH_SWITCH_NOTIFY event
+ * @param interf nl80211 listener interface
+ * @param hdr pointer to netlink message header
+ */
+void
+nl80211_process_channel_switch_event(struct nl80211_if *interf,
+    struct nlmsghdr *hdr) {
+  struct nlattr *tb_msg[NL80211_ATTR_MAX + 1];
+
+  nla_parse(tb_msg, NL80211_ATTR_MAX, nlmsg_attrdata(hdr, GENL_HDRLEN),
+      nlmsg_attrlen(hdr, GENL_HDRLEN), NULL);
+
+  _process_frequency(interf, tb_msg);
+}
+
+/**
+ * Update the frequency and bandwidth of an interface from the
+ * attributes of a nl80211 message
+ * @param interf nl80211 listener interface
+ * @param tb_msg array of parsed nl80211 attributes
+ */
+static void
+_process_frequency(struct nl80211_if *interf, struct nlattr **tb_msg) {
   if (tb_msg[NL80211_ATTR_WIPHY_FREQ]) {
     uint64_t freq[2], bandwidth[2];
 
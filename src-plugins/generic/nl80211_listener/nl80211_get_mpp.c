@@ -122,11 +122,9 @@ nl80211_process_get_mpp_result(struct nl80211_if *interf,
 #endif
 
   struct nlattr *tb[NL80211_ATTR_MAX + 1];
-  struct genlmsghdr *gnlh;
 
-  gnlh = nlmsg_data(hdr);
-  nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
-      genlmsg_attrlen(gnlh, 0), NULL);
+  nla_parse(tb, NL80211_ATTR_MAX, nlmsg_attrdata(hdr, GENL_HDRLEN),
+      nlmsg_attrlen(hdr, GENL_HDRLEN), NULL);
 
   if (nl80211_get_if_baseindex(interf) != nla_get_u32(tb[NL80211_ATTR_IFINDEX])) {
     /* wrong interface ? */
@@ -123,7 +123,6 @@ nl80211_process_get_station_dump_result(struct nl80211_if *interf,
   struct netaddr l2neigh_mac;
 
   struct nlattr *tb[NL80211_ATTR_MAX + 1];
-  struct genlmsghdr *gnlh;
   struct nlattr *sinfo[NL80211_STA_INFO_MAX + 1];
   static struct nla_policy stats_policy[NL80211_STA_INFO_MAX + 1] = {
     [NL80211_STA_INFO_INACTIVE_TIME] = { .type = NLA_U32 },
@@ -143,10 +142,8 @@ nl80211_process_get_station_dump_result(struct nl80211_if *interf,
   struct netaddr_str nbuf;
 #endif
 
-  gnlh = nlmsg_data(hdr);
-
-  nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
-      genlmsg_attrlen(gnlh, 0), NULL);
+  nla_parse(tb, NL80211_ATTR_MAX, nlmsg_attrdata(hdr, GENL_HDRLEN),
+      nlmsg_attrlen(hdr, GENL_HDRLEN), NULL);
 
   if (!tb[NL80211_ATTR_STA_INFO]) {
     /* station info missing */
@@ -112,7 +112,6 @@ nl80211_send_get_survey(struct os_system_netlink *nl, struct nlmsghdr *nl_msg,
  */
 void
 nl80211_process_get_survey_result(struct nl80211_if *interf, struct nlmsghdr *hdr) {
-  struct genlmsghdr *gnlh;
   struct nlattr *tb[NL80211_ATTR_MAX + 1];
   struct nlattr *sinfo[NL80211_SURVEY_INFO_MAX + 1];
 
@@ -121,10 +120,8 @@ nl80211_process_get_survey_result(struct nl80211_if *interf, struct nlmsghdr *hd
     [NL80211_SURVEY_INFO_NOISE] = { .type = NLA_U8 },
   };
 
-  gnlh = nlmsg_data(hdr);
-
-  nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
-      genlmsg_attrlen(gnlh, 0), NULL);
+  nla_parse(tb, NL80211_ATTR_MAX, nlmsg_attrdata(hdr, GENL_HDRLEN),
+      nlmsg_attrlen(hdr, GENL_HDRLEN), NULL);
 
   if (nl80211_get_if_baseindex(interf) != nla_get_u32(tb[NL80211_ATTR_IFINDEX])) {
     /* wrong interface ? */
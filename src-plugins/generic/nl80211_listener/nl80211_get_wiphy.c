@@ -193,17 +193,14 @@ nl80211_send_get_wiphy(struct os_system_netlink *nl,
 void
 nl80211_process_get_wiphy_result(struct nl80211_if *interf,
     struct nlmsghdr *hdr) {
-  struct genlmsghdr *gnlh;
   struct nlattr *tb_msg[NL80211_ATTR_MAX + 1];
   struct nlattr *tb_band[NL80211_BAND_ATTR_MAX + 1];
   struct nlattr *nl_band;
   bool ht20_sgi, ht40_sgi;
   int rem_band;
 
-  gnlh = nlmsg_data(hdr);
-
-  nla_parse(tb_msg, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
-      genlmsg_attrlen(gnlh, 0), NULL);
+  nla_parse(tb_msg, NL80211_ATTR_MAX, nlmsg_attrdata(hdr, GENL_HDRLEN),
+      nlmsg_attrlen(hdr, GENL_HDRLEN), NULL);
 
   if (tb_msg[NL80211_ATTR_WIPHY]) {
     interf->wifi_phy_if = nla_get_u32(tb_msg[NL80211_ATTR_WIPHY]);
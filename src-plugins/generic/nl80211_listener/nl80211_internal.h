@@ -46,9 +46,22 @@
 #ifndef NL80211_INTERNAL_H_
 #define NL80211_INTERNAL_H_
 
+#include "common/common_types.h"
 #include "core/oonf_logging.h"
 
+#include "nl80211_listener/nl80211_listener.h"
+
 /* headers only for use inside the NL80211 subsystem */
 enum oonf_log_source LOG_NL80211;
 
+struct nl80211_if *nl80211_if_get(const char *name);
+struct nl80211_if *nl80211_if_get_by_index(unsigned if_index);
+struct nl80211_if *nl80211_if_add(const char *name);
+void nl80211_if_remove(struct nl80211_if *);
+
+void nl80211_trigger_next_query(void);
+bool nl80211_is_query_series_finished(void);
+void nl80211_set_query_limits(int32_t max_pending, uint64_t refresh_interval);
+void nl80211_set_family(uint32_t nl80211_id, uint32_t multicast_group, bool events_active);
+
 #endif /* NL80211_INTERNAL_H_ */
@@ -55,12 +55,14 @@
 #include "nl80211.h"
 #include <netlink/attr.h>
 #include <netlink/msg.h>
+#include <netlink/genl/genl.h>
 #include <sys/uio.h>
 
 #include "common/autobuf.h"
 #include "common/avl.h"
 #include "common/avl_comp.h"
 #include "common/common_types.h"
+#include "common/hash_index.h"
 #include "common/netaddr.h"
 #include "common/netaddr_acl.h"
 #include "common/string.h"
@@ -70,6 +72,7 @@
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/oonf_class.h"
+#include "subsystems/oonf_clock.h"
 #include "subsystems/oonf_layer2.h"
 #include "subsystems/oonf_timer.h"
 #include "subsystems/os_interface.h"
@@ -81,16 +84,26 @@
 #include "nl80211_listener/nl80211_get_station_dump.h"
 #include "nl80211_listener/nl80211_get_survey.h"
 #include "nl80211_listener/nl80211_get_wiphy.h"
+#include "nl80211_listener/nl80211_internal.h"
 #include "nl80211_listener/nl80211_listener.h"
 
 /* definitions */
 
+/*! maximum number of interfaces that can be queried in parallel */
+#define NL80211_MAX_PENDING 8
+
 /**
  * nl80211 configuration
  */
 struct _nl80211_config {
   /*! interval between two series of netlink probes */
   uint64_t interval;
+
+  /*! interval between two queries of static interface data */
+  uint64_t refresh_interval;
+
+  /*! maximum number of interfaces queried in parallel */
+  int32_t max_pending;
 };
 
 /**
@@ -130,6 +143,8 @@ struct _nl80211_query {
 enum _nl80211_cfg_idx {
   IDX_INTERVAL,  //!< IDX_INTERVAL
   IDX_INTERFACES,//!< IDX_INTERFACES
+  IDX_REFRESH_INTERVAL,//!< IDX_REFRESH_INTERVAL
+  IDX_MAX_PENDING,     //!< IDX_MAX_PENDING
 };
 
 /**
@@ -149,6 +164,31 @@ enum _if_query {
   QUERY_COUNT,          //!< QUERY_COUNT
 };
 
+/**
+ * A netlink socket together with the interface it is currently
+ * querying. The kernel only runs a single dump per netlink socket,
+ * so each parallel query needs its own socket.
+ */
+struct _nl80211_query_slot {
+  /*! netlink handler of this slot */
+  struct os_system_netlink netlink;
+
+  /*! name of netlink handler */
+  char name[32];
+
+  /*! interface that is queried, NULL if the slot is idle */
+  struct nl80211_if *interf;
+
+  /*! query that is in progress */
+  enum _if_query query;
+
+  /*! sequence number of the outstanding request, 0 if none */
+  uint32_t seq;
+
+  /*! true if the netlink socket of this slot is open */
+  bool open;
+};
+
 static struct _nl80211_query _if_query_ops[QUERY_COUNT] =
 {
     [QUERY_GET_IF] = {
@@ -175,18 +215,24 @@ static struct _nl80211_query _if_query_ops[QUERY_COUNT] =
 
 /* prototypes */
 static void _early_cfg_init(void);
+static bool _change_value(struct oonf_layer2_data *data, int64_t value);
+static void _keep_static_l2net_data(struct oonf_layer2_net *l2net);
 static int _init(void);
 static void _cleanup(void);
 
-static struct nl80211_if *_nl80211_if_get(const char *name);
-static struct nl80211_if *_nl80211_if_add(const char *name);
-static void _nl80211_if_remove(struct nl80211_if *);
+static void _update_if_index(struct nl80211_if *interf);
+static int _cb_if_changed(struct os_interface_listener *);
+
+static int _open_query_slot(struct _nl80211_query_slot *slot);
+static void _open_query_slots(void);
 
 static void _cb_config_changed(void);
 static void _cb_if_config_changed(void);
 
 static void _cb_transmission_event(struct oonf_timer_instance *);
-static void _trigger_next_netlink_query(void);
+static void _send_next_query(struct _nl80211_query_slot *slot);
+static void _join_multicast_groups(void);
+static void _process_event(struct nlmsghdr *hdr);
 
 static void _cb_nl_message(struct nlmsghdr *hdr);
 static void _cb_nl_error(uint32_t seq, int error);
@@ -209,6 +255,14 @@ static struct cfg_schema_entry _nl80211_entries[] = {
   [IDX_INTERFACES] = CFG_VALIDATE_PRINTABLE_LEN("if", "",
       "List of additional interfaces to read nl80211 data from",
       IF_NAMESIZE, .list=true),
+  [IDX_REFRESH_INTERVAL] = CFG_MAP_CLOCK_MIN(_nl80211_config, refresh_interval,
+      "refresh_interval", "10.0",
+      "Interval between two queries of the interface and wiphy data. Changes"
+      " in between are received as nl80211 events.", 100),
+  [IDX_MAX_PENDING] = CFG_MAP_INT32_MINMAX(_nl80211_config, max_pending,
+      "max_pending", "1",
+      "Maximum number of interfaces queried in parallel, each of them"
+      " uses its own netlink socket.", 0, false, 1, NL80211_MAX_PENDING),
 };
 
 static struct cfg_schema_section _nl80211_section = {
@@ -247,15 +301,8 @@ DECLARE_OONF_PLUGIN(_nl80211_listener_subsystem);
 
 enum oonf_log_source LOG_NL80211;
 
-/* netlink specific data */
-static struct os_system_netlink _netlink_handler = {
-  .name = "nl80211 listener",
-  .used_by = &_nl80211_listener_subsystem,
-  .cb_message = _cb_nl_message,
-  .cb_error = _cb_nl_error,
-  .cb_done = _cb_nl_done,
-  .cb_timeout = _cb_nl_timeout,
-};
+/* netlink sockets for parallel queries, the first one also receives the events */
+static struct _nl80211_query_slot _query_slots[NL80211_MAX_PENDING];
 
 /* buffer for outgoing netlink message */
 static uint32_t _nl_msgbuffer[UIO_MAXIOV/4];
@@ -264,6 +311,13 @@ static struct nlmsghdr *_nl_msg = (void *)_nl_msgbuffer;
 /* netlink nl80211 identification */
 static uint32_t _nl80211_id = 0;
 static uint32_t _nl80211_multicast_group = 0;
+static uint32_t _nl80211_config_group = 0;
+
+/* true if the listener receives nl80211 events */
+static bool _nl80211_events_active = false;
+
+/* true if joining the multicast groups has been tried */
+static bool _nl80211_events_tried = false;
 
 /* layer2 metadata */
 static struct oonf_layer2_origin _layer2_updated_origin = {
@@ -277,10 +331,22 @@ static struct oonf_layer2_origin _layer2_data_origin = {
   .priority = OONF_LAYER2_ORIGIN_RELIABLE,
 };
 
-/* current query data */
-static struct nl80211_if *_current_query_if = NULL;
-static enum _if_query _current_query_number = QUERY_START;
-static bool _current_query_in_progress = false;
+/* network data only set by the GET_IF query */
+static const enum oonf_layer2_network_index _static_net_data[] = {
+  OONF_LAYER2_NET_FREQUENCY_1,
+  OONF_LAYER2_NET_FREQUENCY_2,
+  OONF_LAYER2_NET_BANDWIDTH_1,
+  OONF_LAYER2_NET_BANDWIDTH_2,
+};
+
+/* neighbor defaults only set by the GET_WIPHY query */
+static const enum oonf_layer2_neighbor_index _static_neigh_defaults[] = {
+  OONF_LAYER2_NEIGH_RX_MAX_BITRATE,
+  OONF_LAYER2_NEIGH_TX_MAX_BITRATE,
+};
+
+/* next interface of the current series that is not assigned to a query slot */
+static struct nl80211_if *_next_query_if = NULL;
 
 /* timer for generating netlink requests */
 static struct oonf_timer_class _transmission_timer_info = {
@@ -296,6 +362,9 @@ static struct oonf_timer_instance _transmission_timer = {
 /* nl80211_if handling */
 static struct avl_tree _nl80211_if_tree;
 
+/* hash of nl80211 interfaces by base interface index for nl80211 events */
+static struct hash_index _nl80211_if_index;
+
 static struct oonf_class _nl80211_if_class = {
   .name = "nl80211 if",
   .size = sizeof(struct nl80211_if),
@@ -312,13 +381,30 @@ _early_cfg_init(void) {
  */
 static int
 _init(void) {
-  if (os_system_linux_netlink_add(&_netlink_handler, NETLINK_GENERIC)) {
+  struct _nl80211_query_slot *slot;
+  size_t i;
+
+  for (i=0; i<ARRAYSIZE(_query_slots); i++) {
+    slot = &_query_slots[i];
+
+    snprintf(slot->name, sizeof(slot->name), "nl80211 listener %"PRINTF_SIZE_T_SPECIFIER, i);
+    slot->netlink.name = slot->name;
+    slot->netlink.used_by = &_nl80211_listener_subsystem;
+    slot->netlink.cb_message = _cb_nl_message;
+    slot->netlink.cb_error = _cb_nl_error;
+    slot->netlink.cb_done = _cb_nl_done;
+    slot->netlink.cb_timeout = _cb_nl_timeout;
+  }
+
+  /* the first socket is always necessary */
+  if (_open_query_slot(&_query_slots[0])) {
     return -1;
   }
 
   /* initialize nl80211 if storage system */
   oonf_class_add(&_nl80211_if_class);
   avl_init(&_nl80211_if_tree, avl_comp_strcasecmp, false);
+  hash_index_init(&_nl80211_if_index);
 
   /* get layer2 origin */
   oonf_layer2_add_origin(&_layer2_updated_origin);
@@ -334,15 +420,139 @@ _init(void) {
 static void
 _cleanup(void) {
   struct nl80211_if *interf, *it_if;
+  size_t i;
+
   avl_for_each_element_safe(&_nl80211_if_tree, interf, _node, it_if) {
-    _nl80211_if_remove(interf);
+    nl80211_if_remove(interf);
   }
+  hash_index_free(&_nl80211_if_index);
   oonf_layer2_remove_origin(&_layer2_updated_origin);
   oonf_layer2_remove_origin(&_layer2_data_origin);
 
   oonf_timer_stop(&_transmission_timer);
   oonf_timer_remove(&_transmission_timer_info);
-  os_system_linux_netlink_remove(&_netlink_handler);
+
+  for (i=0; i<ARRAYSIZE(_query_slots); i++) {
+    if (_query_slots[i].open) {
+      os_system_linux_netlink_remove(&_query_slots[i].netlink);
+      _query_slots[i].open = false;
+    }
+  }
+}
+
+/**
+ * Open the netlink socket of a query slot
+ * @param slot query slot
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_open_query_slot(struct _nl80211_query_slot *slot) {
+  if (!slot->open) {
+    if (os_system_linux_netlink_add(&slot->netlink, NETLINK_GENERIC)) {
+      return -1;
+    }
+    slot->open = true;
+  }
+  return 0;
+}
+
+/**
+ * Open the netlink sockets for the configured number of parallel queries
+ */
+static void
+_open_query_slots(void) {
+  int32_t i;
+
+  for (i=1; i<_config.max_pending; i++) {
+    if (_open_query_slot(&_query_slots[i])) {
+      OONF_WARN(LOG_NL80211, "Could not open netlink socket for"
+          " parallel query %d", i);
+      break;
+    }
+  }
+}
+
+/**
+ * @param slot query slot
+ * @return true if slot can be used for a new query
+ */
+static bool
+_is_query_slot_usable(struct _nl80211_query_slot *slot) {
+  return slot->open && slot - _query_slots < _config.max_pending;
+}
+
+/**
+ * Get the query slot waiting for a netlink sequence number
+ * @param seq netlink sequence number
+ * @return query slot, NULL if no query is waiting for the number
+ */
+static struct _nl80211_query_slot *
+_get_query_slot(uint32_t seq) {
+  size_t i;
+
+  if (seq == 0) {
+    return NULL;
+  }
+
+  for (i=0; i<ARRAYSIZE(_query_slots); i++) {
+    if (_query_slots[i].seq == seq) {
+      return &_query_slots[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @return true if a query slot still has an outstanding request
+ */
+static bool
+_is_query_pending(void) {
+  size_t i;
+
+  for (i=0; i<ARRAYSIZE(_query_slots); i++) {
+    if (_query_slots[i].seq) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @return true if all interfaces of the current series of
+ *   queries have been queried completely
+ */
+bool
+nl80211_is_query_series_finished(void) {
+  return _next_query_if == NULL && !_is_query_pending();
+}
+
+/**
+ * Set the limits of the query series without a configuration
+ * database, used by the unit test
+ * @param max_pending maximum number of interfaces queried in parallel
+ * @param refresh_interval interval between two queries of static
+ *   interface data
+ */
+void
+nl80211_set_query_limits(int32_t max_pending, uint64_t refresh_interval) {
+  _config.max_pending = max_pending;
+  _config.refresh_interval = refresh_interval;
+  _open_query_slots();
+}
+
+/**
+ * Set the nl80211 generic netlink family without querying the kernel,
+ * used by the unit test
+ * @param nl80211_id generic netlink family id of nl80211
+ * @param multicast_group nl80211 multicast group for events
+ * @param events_active true if the nl80211 events are received
+ */
+void
+nl80211_set_family(uint32_t nl80211_id, uint32_t multicast_group, bool events_active) {
+  _nl80211_id = nl80211_id;
+  _nl80211_multicast_group = multicast_group;
+  _nl80211_events_tried = true;
+  _nl80211_events_active = events_active;
 }
 
 /**
@@ -372,7 +582,7 @@ nl80211_add_dst(struct oonf_layer2_neigh *l2neigh, const struct netaddr *dstmac)
 bool
 nl80211_change_l2net_data(struct oonf_layer2_net *l2net,
     enum oonf_layer2_network_index idx, uint64_t value) {
-  return oonf_layer2_change_value(&l2net->data[idx], &_layer2_updated_origin, value);
+  return _change_value(&l2net->data[idx], value);
 }
 
 /**
@@ -385,7 +595,7 @@ nl80211_change_l2net_data(struct oonf_layer2_net *l2net,
 bool
 nl80211_change_l2net_neighbor_default(struct oonf_layer2_net *l2net,
     enum oonf_layer2_neighbor_index idx, uint64_t value) {
-  return oonf_layer2_change_value(&l2net->neighdata[idx], &_layer2_updated_origin, value);
+  return _change_value(&l2net->neighdata[idx], value);
 }
 
 /**
@@ -408,7 +618,44 @@ nl80211_cleanup_l2neigh_data(struct oonf_layer2_neigh *l2neigh) {
 bool
 nl80211_change_l2neigh_data(struct oonf_layer2_neigh *l2neigh,
     enum oonf_layer2_neighbor_index idx, uint64_t value) {
-  return oonf_layer2_change_value(&l2neigh->data[idx], &_layer2_updated_origin, value);
+  return _change_value(&l2neigh->data[idx], value);
+}
+
+/**
+ * Change a layer2 value of this listener. Data of the last series
+ * of queries has the same priority as the new data, so it has to be
+ * relabeled before it can be overwritten.
+ * @param data pointer to layer2 data
+ * @param value new value
+ * @return true if value changed, false otherwise
+ */
+static bool
+_change_value(struct oonf_layer2_data *data, int64_t value) {
+  if (oonf_layer2_get_origin(data) == &_layer2_data_origin) {
+    oonf_layer2_set_origin(data, &_layer2_updated_origin);
+  }
+  return oonf_layer2_change_value(data, &_layer2_updated_origin, value);
+}
+
+/**
+ * Remove all data generated by this listener from a layer2 neighbor
+ * and commit the neighbor, which removes it if no other data is left.
+ * @param l2neigh pointer to layer2 neighbor
+ */
+static void
+_remove_l2neigh(struct oonf_layer2_neigh *l2neigh) {
+  struct oonf_layer2_destination *l2dst, *l2dst_it;
+
+  avl_for_each_element_safe(&l2neigh->destinations, l2dst, _node, l2dst_it) {
+    if (l2dst->origin == &_layer2_updated_origin
+        || l2dst->origin == &_layer2_data_origin) {
+      oonf_layer2_destination_remove(l2dst);
+    }
+  }
+
+  oonf_layer2_neigh_cleanup(l2neigh, &_layer2_updated_origin);
+  oonf_layer2_neigh_cleanup(l2neigh, &_layer2_data_origin);
+  oonf_layer2_neigh_commit(l2neigh);
 }
 
 /**
@@ -416,23 +663,80 @@ nl80211_change_l2neigh_data(struct oonf_layer2_neigh *l2neigh,
  * @param name interface name
  * @return nl80211 interface, NULL if not found
  */
-static struct nl80211_if *
-_nl80211_if_get(const char *name) {
+struct nl80211_if *
+nl80211_if_get(const char *name) {
   struct nl80211_if *interf;
 
   return avl_find_element(&_nl80211_if_tree, name, interf, _node);
 }
 
+/**
+ * Get a nl80211 interface by its interface index
+ * @param if_index interface index
+ * @return nl80211 interface, NULL if not found
+ */
+struct nl80211_if *
+nl80211_if_get_by_index(unsigned if_index) {
+  struct nl80211_if *interf;
+  size_t pos;
+
+  hash_index_for_each_match(&_nl80211_if_index, if_index, interf, pos) {
+    if (interf->_if_index == if_index) {
+      return interf;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Keep the interface index hash in sync with the base interface
+ * index of the operation system
+ * @param interf nl80211 interface
+ */
+static void
+_update_if_index(struct nl80211_if *interf) {
+  unsigned if_index;
+
+  if_index = interf->if_listener.data ? nl80211_get_if_baseindex(interf) : 0;
+  if (if_index == interf->_if_index) {
+    return;
+  }
+
+  if (interf->_if_index) {
+    hash_index_remove(&_nl80211_if_index, interf, interf->_if_index);
+  }
+
+  interf->_if_index = if_index;
+  if (if_index && hash_index_add(&_nl80211_if_index, interf, if_index)) {
+    OONF_WARN(LOG_NL80211, "Could not index interface %s", interf->name);
+    interf->_if_index = 0;
+  }
+}
+
+/**
+ * Callback for interface changes of the operation system
+ * @param listener interface listener
+ * @return always 0
+ */
+static int
+_cb_if_changed(struct os_interface_listener *listener) {
+  struct nl80211_if *interf;
+
+  interf = container_of(listener, struct nl80211_if, if_listener);
+  _update_if_index(interf);
+  return 0;
+}
+
 /**
  * Add a nl80211 interface to the tree
  * @param name interface name
  * @return nl80211 interface, NULL if out of memory
  */
-static struct nl80211_if *
-_nl80211_if_add(const char *name) {
+struct nl80211_if *
+nl80211_if_add(const char *name) {
   struct nl80211_if *interf;
 
-  interf = _nl80211_if_get(name);
+  interf = nl80211_if_get(name);
   if (interf) {
     return interf;
   }
@@ -459,6 +763,7 @@ _nl80211_if_add(const char *name) {
 
   /* initialize interface listener */
   interf->if_listener.name = interf->name;
+  interf->if_listener.if_changed = _cb_if_changed;
   if (!os_interface_add(&interf->if_listener)) {
     oonf_layer2_net_remove(interf->l2net, &_layer2_data_origin);
     oonf_layer2_net_remove(interf->l2net, &_layer2_updated_origin);
@@ -468,6 +773,7 @@ _nl80211_if_add(const char *name) {
 
   /* initialize interface */
   interf->wifi_phy_if = -1;
+  _update_if_index(interf);
 
   OONF_DEBUG(LOG_NL80211, "Add if %s", name);
   avl_insert(&_nl80211_if_tree, &interf->_node);
@@ -478,8 +784,24 @@ _nl80211_if_add(const char *name) {
  * Remove a nl80211 interface from tree
  * @param interf nl80211 interface
  */
-static void
-_nl80211_if_remove(struct nl80211_if *interf) {
+void
+nl80211_if_remove(struct nl80211_if *interf) {
+  size_t i;
+
+  /* make sure the query series does not touch the interface anymore */
+  if (_next_query_if == interf) {
+    _next_query_if = avl_next_element_safe(&_nl80211_if_tree, interf, _node);
+  }
+  for (i=0; i<ARRAYSIZE(_query_slots); i++) {
+    if (_query_slots[i].interf == interf) {
+      /* replies of the outstanding request will be ignored */
+      _query_slots[i].interf = NULL;
+    }
+  }
+
+  if (interf->_if_index) {
+    hash_index_remove(&_nl80211_if_index, interf, interf->_if_index);
+  }
   avl_remove(&_nl80211_if_tree, &interf->_node);
   os_interface_remove(&interf->if_listener);
   oonf_class_free(&_nl80211_if_class, interf);
@@ -496,18 +818,18 @@ _cb_if_config_changed(void) {
 
   ifname = cfg_get_phy_if(ifbuf, _if_section.section_name);
   if (_if_section.pre == NULL) {
-    interf = _nl80211_if_add(ifname);
+    interf = nl80211_if_add(ifname);
     if (interf) {
       interf->_if_section = true;
     }
   }
 
   if (_if_section.post == NULL) {
-    interf = _nl80211_if_get(ifname);
+    interf = nl80211_if_get(ifname);
     if (interf) {
       interf->_if_section = false;
       if (!interf->_nl80211_section) {
-        _nl80211_if_remove(interf);
+        nl80211_if_remove(interf);
       }
     }
   }
@@ -519,18 +841,18 @@ _cb_if_config_changed(void) {
  */
 static void
 _cb_transmission_event(struct oonf_timer_instance *ptr __attribute__((unused))) {
-  if (!_current_query_in_progress) {
-    _trigger_next_netlink_query();
-  }
+  nl80211_trigger_next_query();
 }
 
 /**
- * Send a netlink message to the nl80211 subsystem
- * @param interf nl80211 interface for message
- * @param query query id
+ * Send the netlink message of the current query of a query slot
+ * to the nl80211 subsystem
+ * @param slot query slot
  */
 static void
-_send_netlink_message(struct nl80211_if *interf, enum _if_query query) {
+_send_netlink_message(struct _nl80211_query_slot *slot) {
+  struct nl80211_if *interf = slot->interf;
+  enum _if_query query = slot->query;
   struct genlmsghdr *hdr;
 
   memset(&_nl_msgbuffer, 0, sizeof(_nl_msgbuffer));
@@ -558,82 +880,279 @@ _send_netlink_message(struct nl80211_if *interf, enum _if_query query) {
     genl_send_get_family(_nl_msg, hdr);
   }
   else if (_if_query_ops[query].send) {
-    _if_query_ops[query].send(&_netlink_handler, _nl_msg, hdr, interf);
+    _if_query_ops[query].send(&slot->netlink, _nl_msg, hdr, interf);
   }
 
-  os_system_linux_netlink_send(&_netlink_handler, _nl_msg);
+  slot->seq = os_system_linux_netlink_send(&slot->netlink, _nl_msg);
+}
+
+/**
+ * Check if a query has to be done in the current series of queries
+ * of an interface. Static interface data is only queried every
+ * refresh interval while nl80211 events are received.
+ * @param interf nl80211 interface
+ * @param query query id
+ * @return true if query should be sent, false otherwise
+ */
+static bool
+_is_query_due(struct nl80211_if *interf, enum _if_query query) {
+  if (query == QUERY_START) {
+    interf->_full_query = !_nl80211_events_active
+        || interf->wifi_phy_if < 0
+        || oonf_clock_is_past(interf->_next_full_query);
+    if (interf->_full_query) {
+      interf->_next_full_query = oonf_clock_get_absolute(_config.refresh_interval);
+    }
+  }
+
+  switch (query) {
+    case QUERY_GET_IF:
+    case QUERY_GET_WIPHY:
+      return interf->_full_query;
+    default:
+      return true;
+  }
 }
 
 /**
- * Proceed to next query
+ * Mark the static interface data of the last full series as
+ * updated, so it survives the cleanup of a series without the
+ * GET_IF and GET_WIPHY queries.
+ * @param l2net layer2 network
  */
 static void
-_get_next_query(void) {
-  if (avl_is_empty(&_nl80211_if_tree)) {
-    OONF_DEBUG(LOG_NL80211, "No nl80211 interfaces");
-    _current_query_if = NULL;
-    return;
+_keep_static_l2net_data(struct oonf_layer2_net *l2net) {
+  struct oonf_layer2_data *data;
+  size_t i;
+
+  for (i=0; i<ARRAYSIZE(_static_net_data); i++) {
+    data = &l2net->data[_static_net_data[i]];
+    if (oonf_layer2_get_origin(data) == &_layer2_data_origin) {
+      oonf_layer2_set_origin(data, &_layer2_updated_origin);
+    }
+  }
+  for (i=0; i<ARRAYSIZE(_static_neigh_defaults); i++) {
+    data = &l2net->neighdata[_static_neigh_defaults[i]];
+    if (oonf_layer2_get_origin(data) == &_layer2_data_origin) {
+      oonf_layer2_set_origin(data, &_layer2_updated_origin);
+    }
   }
+}
 
-  /* no query left to do? start again at the first */
-  if (!_current_query_if) {
-    /* start with first interface and query */
-    _current_query_if = avl_first_element(&_nl80211_if_tree, _current_query_if, _node);
-    _current_query_number = QUERY_START;
-    _current_query_in_progress = true;
+/**
+ * Send the next query of the interface assigned to a query slot.
+ * Continue with the next unassigned interface of the series
+ * when all queries of the interface are done.
+ * @param slot query slot
+ */
+static void
+_send_next_query(struct _nl80211_query_slot *slot) {
+  struct nl80211_if *interf;
+
+  slot->seq = 0;
+  if (slot->query == QUERY_GET_FAMILY) {
+    slot->query = QUERY_END;
   }
-  else {
+  else if (slot->interf) {
     /* next query */
-    _current_query_number++;
-
-    if (_current_query_number == QUERY_END) {
-      /* commit interface data */
-      if (_current_query_if->ifdata_changed) {
-        oonf_layer2_net_cleanup(_current_query_if->l2net, &_layer2_data_origin, true);
-        oonf_layer2_net_relabel(_current_query_if->l2net,
-            &_layer2_data_origin, &_layer2_updated_origin);
-        oonf_layer2_net_commit(_current_query_if->l2net);
-        _current_query_if->ifdata_changed = false;
+    slot->query++;
+  }
+
+  while (slot->interf || (_next_query_if && _is_query_slot_usable(slot))) {
+    if (!slot->interf) {
+      /* assign next interface of the series to slot */
+      slot->interf = _next_query_if;
+      slot->query = QUERY_START;
+      _next_query_if = avl_next_element_safe(&_nl80211_if_tree, _next_query_if, _node);
+    }
+    interf = slot->interf;
+
+    /* skip queries that are not necessary in this series */
+    while (slot->query < QUERY_END && !_is_query_due(interf, slot->query)) {
+      slot->query++;
+    }
+
+    if (slot->query < QUERY_END) {
+      _send_netlink_message(slot);
+      return;
+    }
+
+    /* commit interface data */
+    if (interf->ifdata_changed) {
+      if (!interf->_full_query) {
+        _keep_static_l2net_data(interf->l2net);
       }
+      oonf_layer2_net_cleanup(interf->l2net, &_layer2_data_origin, true);
+      oonf_layer2_net_relabel(interf->l2net,
+          &_layer2_data_origin, &_layer2_updated_origin);
+      oonf_layer2_net_commit(interf->l2net);
+      interf->ifdata_changed = false;
+    }
+    slot->interf = NULL;
+  }
 
-      _current_query_if = avl_next_element_safe(
-          &_nl80211_if_tree, _current_query_if, _node);
-      _current_query_number = QUERY_START;
+  if (nl80211_is_query_series_finished()) {
+    OONF_DEBUG(LOG_NL80211, "All queries done for all interfaces");
+  }
+}
+
+/**
+ * Finish the outstanding request of a query slot and send the next one
+ * @param slot query slot
+ * @param success true if the kernel has answered the request completely
+ */
+static void
+_finish_query(struct _nl80211_query_slot *slot, bool success) {
+  if (slot->query == QUERY_GET_FAMILY) {
+    slot->seq = 0;
+    if (_nl80211_id && _nl80211_multicast_group) {
+      nl80211_trigger_next_query();
     }
+    return;
+  }
+
+  if (success && slot->interf && _if_query_ops[slot->query].finalize) {
+    _if_query_ops[slot->query].finalize(slot->interf);
   }
+  _send_next_query(slot);
 }
 
 /**
- * Trigger the next netlink query
+ * Join the nl80211 multicast groups to receive station
+ * and interface events
+ */
+static void
+_join_multicast_groups(void) {
+  uint32_t groups[2];
+  size_t count;
+
+  _nl80211_events_tried = true;
+
+  count = 0;
+  groups[count++] = _nl80211_multicast_group;
+  if (_nl80211_config_group) {
+    groups[count++] = _nl80211_config_group;
+  }
+
+  if (os_system_linux_netlink_add_mc(&_query_slots[0].netlink, groups, count)) {
+    OONF_WARN(LOG_NL80211, "Could not join nl80211 multicast groups,"
+        " query all data every interval");
+    return;
+  }
+  _nl80211_events_active = true;
+}
+
+/**
+ * Apply a nl80211 event to the layer2 database
+ * @param hdr pointer to netlink message
  */
 static void
-_trigger_next_netlink_query(void) {
+_process_event(struct nlmsghdr *hdr) {
+  struct oonf_layer2_neigh *l2neigh, *l2neigh_it;
+  struct nlattr *tb[NL80211_ATTR_MAX + 1];
+  struct genlmsghdr *gen_hdr;
+  struct nl80211_if *interf;
+  struct netaddr mac;
+
+  gen_hdr = NLMSG_DATA(hdr);
+  nla_parse(tb, NL80211_ATTR_MAX, nlmsg_attrdata(hdr, GENL_HDRLEN),
+      nlmsg_attrlen(hdr, GENL_HDRLEN), NULL);
+
+  if (!tb[NL80211_ATTR_IFINDEX]) {
+    return;
+  }
+
+  interf = nl80211_if_get_by_index(nla_get_u32(tb[NL80211_ATTR_IFINDEX]));
+  if (!interf) {
+    /* event for an interface we do not listen to */
+    return;
+  }
+
+  OONF_DEBUG(LOG_NL80211, "Received nl80211 event %u for interface %s",
+      gen_hdr->cmd, interf->name);
+
+  switch (gen_hdr->cmd) {
+    case NL80211_CMD_NEW_STATION:
+      nl80211_process_get_station_dump_result(interf, hdr);
+      break;
+    case NL80211_CMD_DEL_STATION:
+      if (tb[NL80211_ATTR_MAC]
+          && nla_len(tb[NL80211_ATTR_MAC]) == 6) {
+        netaddr_from_binary(&mac, nla_data(tb[NL80211_ATTR_MAC]), 6, AF_MAC48);
+        l2neigh = oonf_layer2_neigh_get(interf->l2net, &mac);
+        if (l2neigh) {
+          _remove_l2neigh(l2neigh);
+        }
+      }
+      break;
+    case NL80211_CMD_DISCONNECT:
+      avl_for_each_element_safe(&interf->l2net->neighbors, l2neigh, _node, l2neigh_it) {
+        _remove_l2neigh(l2neigh);
+      }
+      break;
+    case NL80211_CMD_CH_SWITCH_NOTIFY:
+      nl80211_process_channel_switch_event(interf, hdr);
+      if (interf->ifdata_changed) {
+        oonf_layer2_net_commit(interf->l2net);
+      }
+      break;
+    case NL80211_CMD_NEW_INTERFACE:
+    case NL80211_CMD_SET_INTERFACE:
+      nl80211_process_get_interface_result(interf, hdr);
+      if (interf->ifdata_changed) {
+        oonf_layer2_net_commit(interf->l2net);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Start a new series of netlink queries if the last one is finished
+ * and hand out the unassigned interfaces of the current series
+ * to the idle query slots.
+ */
+void
+nl80211_trigger_next_query(void) {
+  struct _nl80211_query_slot *slot;
+  size_t i;
+
   if (!_nl80211_id || !_nl80211_multicast_group) {
-    if (_current_query_in_progress) {
+    slot = &_query_slots[0];
+    if (slot->seq) {
       /* wait for the next timer */
-      _current_query_in_progress = false;
       return;
     }
 
     /* first we need to get the ID and multicast group */
     OONF_DEBUG(LOG_NL80211, "Get nl80211 family and multicast id");
-    _current_query_in_progress = true;
-    _send_netlink_message(NULL, QUERY_GET_FAMILY);
+    slot->interf = NULL;
+    slot->query = QUERY_GET_FAMILY;
+    _send_netlink_message(slot);
     return;
   }
 
-  /* calculate next interface/query */
-  _get_next_query();
+  if (!_nl80211_events_tried) {
+    _join_multicast_groups();
+  }
 
-  if (!_current_query_if) {
-    /* done with this series of queries, wait for next timer */
-    OONF_DEBUG(LOG_NL80211, "All queries done for all interfaces");
-    _current_query_in_progress = false;
-    return;
+  if (nl80211_is_query_series_finished()) {
+    if (avl_is_empty(&_nl80211_if_tree)) {
+      OONF_DEBUG(LOG_NL80211, "No nl80211 interfaces");
+      return;
+    }
+
+    /* start a new series with the first interface */
+    _next_query_if = avl_first_element(&_nl80211_if_tree, _next_query_if, _node);
   }
 
-  _send_netlink_message(_current_query_if,
-      _current_query_number);
+  for (i=0; i<ARRAYSIZE(_query_slots) && _next_query_if; i++) {
+    slot = &_query_slots[i];
+    if (slot->seq == 0 && _is_query_slot_usable(slot)) {
+      _send_next_query(slot);
+    }
+  }
 }
 
 /**
@@ -642,12 +1161,13 @@ _trigger_next_netlink_query(void) {
  */
 static void
 _cb_nl_message(struct nlmsghdr *hdr) {
+  struct _nl80211_query_slot *slot;
   struct genlmsghdr *gen_hdr;
 
   gen_hdr = NLMSG_DATA(hdr);
   if (hdr->nlmsg_type == GENL_ID_CTRL && gen_hdr->cmd == CTRL_CMD_NEWFAMILY) {
-    genl_process_get_family_result(hdr,
-        &_nl80211_id, &_nl80211_multicast_group);
+    genl_process_get_family_result(hdr, &_nl80211_id,
+        &_nl80211_multicast_group, &_nl80211_config_group);
     return;
   }
 
@@ -656,15 +1176,25 @@ _cb_nl_message(struct nlmsghdr *hdr) {
     return;
   }
 
-  if (gen_hdr->cmd != _if_query_ops[_current_query_number].cmd) {
+  if (hdr->nlmsg_seq == 0) {
+    /* multicast events are not a reply to one of our queries */
+    _process_event(hdr);
+    return;
+  }
+
+  slot = _get_query_slot(hdr->nlmsg_seq);
+  if (!slot || !slot->interf) {
+    OONF_DEBUG(LOG_NL80211, "Received Nl80211 command %u for unknown seq %u",
+        gen_hdr->cmd, hdr->nlmsg_seq);
+  }
+  else if (gen_hdr->cmd != _if_query_ops[slot->query].cmd) {
     OONF_INFO(LOG_NL80211, "Received Nl80211 command %u for query %u (should be %u)",
-        gen_hdr->cmd, _current_query_number,
-        _if_query_ops[_current_query_number].cmd);
+        gen_hdr->cmd, slot->query, _if_query_ops[slot->query].cmd);
   }
-  else if (_if_query_ops[_current_query_number].process) {
-    OONF_DEBUG(LOG_NL80211, "Received Nl80211 command %u for query %u",
-        gen_hdr->cmd, _current_query_number);
-    _if_query_ops[_current_query_number].process(_current_query_if, hdr);
+  else if (_if_query_ops[slot->query].process) {
+    OONF_DEBUG(LOG_NL80211, "Received Nl80211 command %u for query %u of interface %s",
+        gen_hdr->cmd, slot->query, slot->interf->name);
+    _if_query_ops[slot->query].process(slot->interf, hdr);
   }
 }
 
@@ -674,10 +1204,14 @@ _cb_nl_message(struct nlmsghdr *hdr) {
  * @param error error code
  */
 static void
-_cb_nl_error(uint32_t seq __attribute((unused)), int error __attribute((unused))) {
+_cb_nl_error(uint32_t seq, int error __attribute((unused))) {
+  struct _nl80211_query_slot *slot;
+
   OONF_DEBUG(LOG_NL80211, "seq %u: Received error %d", seq, error);
-  if (_nl80211_id && _nl80211_multicast_group) {
-    _trigger_next_netlink_query();
+
+  slot = _get_query_slot(seq);
+  if (slot) {
+    _finish_query(slot, false);
   }
 }
 
@@ -686,12 +1220,17 @@ _cb_nl_error(uint32_t seq __attribute((unused)), int error __attribute((unused))
  */
 static void
 _cb_nl_timeout(void) {
+  struct _nl80211_query_slot *slot;
+  size_t i;
+
   OONF_DEBUG(LOG_NL80211, "Received timeout");
-  if (_nl80211_id && _nl80211_multicast_group) {
-    if (_if_query_ops[_current_query_number].finalize) {
-      _if_query_ops[_current_query_number].finalize(_current_query_if);
+
+  /* the timer of the socket that timed out is not running anymore */
+  for (i=0; i<ARRAYSIZE(_query_slots); i++) {
+    slot = &_query_slots[i];
+    if (slot->seq && !oonf_timer_is_active(&slot->netlink.timeout)) {
+      _finish_query(slot, true);
     }
-    _trigger_next_netlink_query();
   }
 }
 
@@ -700,13 +1239,14 @@ _cb_nl_timeout(void) {
  * @param seq sequence number
  */
 static void
-_cb_nl_done(uint32_t seq __attribute((unused))) {
+_cb_nl_done(uint32_t seq) {
+  struct _nl80211_query_slot *slot;
+
   OONF_DEBUG(LOG_NL80211, "%u: Received done", seq);
-  if (_nl80211_id && _nl80211_multicast_group) {
-    if (_if_query_ops[_current_query_number].finalize) {
-      _if_query_ops[_current_query_number].finalize(_current_query_if);
-    }
-    _trigger_next_netlink_query();
+
+  slot = _get_query_slot(seq);
+  if (slot) {
+    _finish_query(slot, true);
   }
 }
 
@@ -726,6 +1266,8 @@ _cb_config_changed(void) {
     return;
   }
 
+  _open_query_slots();
+
   /* set transmission timer */
   oonf_timer_set_ext(&_transmission_timer, 1, _config.interval);
 
@@ -734,7 +1276,7 @@ _cb_config_changed(void) {
       _nl80211_section.pre, &_nl80211_entries[IDX_INTERFACES]);
   if (array && strarray_get_count_c(array) > 0) {
     strarray_for_each_element(array, str) {
-      interf = _nl80211_if_get(str);
+      interf = nl80211_if_get(str);
       if (interf) {
         interf->_remove = !interf->_if_section;
         interf->_nl80211_section = false;
@@ -747,7 +1289,7 @@ _cb_config_changed(void) {
       _nl80211_section.post, &_nl80211_entries[IDX_INTERFACES]);
   if (array && strarray_get_count_c(array) > 0) {
     strarray_for_each_element(array, str) {
-      interf = _nl80211_if_add(str);
+      interf = nl80211_if_add(str);
       if (interf) {
         /* mark for removal */
         interf->_remove = false;
@@ -760,9 +1302,9 @@ _cb_config_changed(void) {
       _nl80211_section.pre, &_nl80211_entries[IDX_INTERFACES]);
   if (array && strarray_get_count_c(array) > 0) {
     strarray_for_each_element(array, str) {
-      interf = _nl80211_if_get(str);
+      interf = nl80211_if_get(str);
       if (interf && interf->_remove) {
-        _nl80211_if_remove(interf);
+        nl80211_if_remove(interf);
       }
     }
   }
@@ -79,6 +79,12 @@ struct nl80211_if {
   /*! true if data of interface were changed */
   bool ifdata_changed;
 
+  /*! true if the current series of queries includes the static interface data */
+  bool _full_query;
+
+  /*! absolute time when the static interface data should be queried again */
+  uint64_t _next_full_query;
+
   /*! true if interface should be removed */
   bool _remove;
 
@@ -88,6 +94,9 @@ struct nl80211_if {
   /*! true if nl80211 section config was already committed for interface */
   bool _nl80211_section;
 
+  /*! base interface index used as key of the interface index hash, 0 if not indexed */
+  unsigned _if_index;
+
   /*! hook into tree of nl80211 interfaces */
   struct avl_node _node;
 };
@@ -74,6 +74,7 @@ static void _initialize_time_values(struct oonf_viewer_template *template);
 static void _initialize_version_values(struct oonf_viewer_template *template);
 static void _initialize_memory_values(
     struct oonf_viewer_template *template, struct oonf_class *c);
+static void _initialize_budget_values(struct oonf_viewer_template *template);
 static void _initialize_timer_values(
     struct oonf_viewer_template *template, struct oonf_timer_class *tc);
 static void _initialize_socket_values(
@@ -84,6 +85,7 @@ static void _initialize_logging_values(
 static int _cb_create_text_time(struct oonf_viewer_template *);
 static int _cb_create_text_version(struct oonf_viewer_template *);
 static int _cb_create_text_memory(struct oonf_viewer_template *);
+static int _cb_create_text_budget(struct oonf_viewer_template *);
 static int _cb_create_text_timer(struct oonf_viewer_template *);
 static int _cb_create_text_socket(struct oonf_viewer_template *);
 static int _cb_create_text_logging(struct oonf_viewer_template *);
@@ -121,6 +123,42 @@ static int _cb_create_text_logging(struct oonf_viewer_template *);
 /*! template key for recycled memory blocks */
 #define KEY_MEMORY_RECYCLED             "memory_recycled"
 
+/*! template key for number of slabs */
+#define KEY_MEMORY_SLABS                "memory_slabs"
+
+/*! template key for number of empty slabs */
+#define KEY_MEMORY_SLABS_EMPTY          "memory_slabs_empty"
+
+/*! template key for percentage of used slab memory blocks */
+#define KEY_MEMORY_SLAB_OCCUPANCY       "memory_slab_occupancy"
+
+/*! template key for memory budget of class */
+#define KEY_MEMORY_BUDGET               "memory_budget"
+
+/*! template key for memory used by objects of class */
+#define KEY_MEMORY_USED                 "memory_used"
+
+/*! template key for number of memory pressure events */
+#define KEY_MEMORY_PRESSURE             "memory_pressure"
+
+/*! template key for number of objects evicted because of memory pressure */
+#define KEY_MEMORY_EVICTED              "memory_evicted"
+
+/*! template key for number of allocations rejected by memory budget */
+#define KEY_MEMORY_DENIED               "memory_denied"
+
+/*! template key for global memory budget */
+#define KEY_BUDGET_TOTAL                "budget_total"
+
+/*! template key for memory used by all classes */
+#define KEY_BUDGET_USED                 "budget_used"
+
+/*! template key for number of global memory pressure events */
+#define KEY_BUDGET_PRESSURE             "budget_pressure"
+
+/*! template key for number of allocations rejected by global budget */
+#define KEY_BUDGET_DENIED               "budget_denied"
+
 /*! template key for timer usage */
 #define KEY_TIMER_USAGE                 "timer_usage"
 
@@ -164,6 +202,19 @@ static struct isonumber_str             _value_memory_usage;
 static struct isonumber_str             _value_memory_freelist;
 static struct isonumber_str             _value_memory_alloc;
 static struct isonumber_str             _value_memory_recycled;
+static struct isonumber_str             _value_memory_slabs;
+static struct isonumber_str             _value_memory_slabs_empty;
+static struct isonumber_str             _value_memory_slab_occupancy;
+static struct isonumber_str             _value_memory_budget;
+static struct isonumber_str             _value_memory_used;
+static struct isonumber_str             _value_memory_pressure;
+static struct isonumber_str             _value_memory_evicted;
+static struct isonumber_str             _value_memory_denied;
+
+static struct isonumber_str             _value_budget_total;
+static struct isonumber_str             _value_budget_used;
+static struct isonumber_str             _value_budget_pressure;
+static struct isonumber_str             _value_budget_denied;
 
 static struct isonumber_str             _value_timer_usage;
 static struct isonumber_str             _value_timer_change;
@@ -192,6 +243,20 @@ static struct abuf_template_data_entry _tde_memory_key[] = {
     { KEY_MEMORY_FREELIST, _value_memory_freelist.buf, false },
     { KEY_MEMORY_ALLOC, _value_memory_alloc.buf, false },
     { KEY_MEMORY_RECYCLED, _value_memory_recycled.buf, false },
+    { KEY_MEMORY_SLABS, _value_memory_slabs.buf, false },
+    { KEY_MEMORY_SLABS_EMPTY, _value_memory_slabs_empty.buf, false },
+    { KEY_MEMORY_SLAB_OCCUPANCY, _value_memory_slab_occupancy.buf, false },
+    { KEY_MEMORY_BUDGET, _value_memory_budget.buf, false },
+    { KEY_MEMORY_USED, _value_memory_used.buf, false },
+    { KEY_MEMORY_PRESSURE, _value_memory_pressure.buf, false },
+    { KEY_MEMORY_EVICTED, _value_memory_evicted.buf, false },
+    { KEY_MEMORY_DENIED, _value_memory_denied.buf, false },
+};
+static struct abuf_template_data_entry _tde_budget_key[] = {
+    { KEY_BUDGET_TOTAL, _value_budget_total.buf, false },
+    { KEY_BUDGET_USED, _value_budget_used.buf, false },
+    { KEY_BUDGET_PRESSURE, _value_budget_pressure.buf, false },
+    { KEY_BUDGET_DENIED, _value_budget_denied.buf, false },
 };
 static struct abuf_template_data_entry _tde_timer_key[] = {
     { KEY_STATISTICS_NAME, _value_stat_name, true },
@@ -223,6 +288,9 @@ static struct abuf_template_data _td_version[] = {
 static struct abuf_template_data _td_memory[] = {
     { _tde_memory_key, ARRAYSIZE(_tde_memory_key) },
 };
+static struct abuf_template_data _td_budget[] = {
+    { _tde_budget_key, ARRAYSIZE(_tde_budget_key) },
+};
 static struct abuf_template_data _td_timer[] = {
     { _tde_timer_key, ARRAYSIZE(_tde_timer_key) },
 };
@@ -253,6 +321,12 @@ static struct oonf_viewer_template _templates[] = {
         .json_name = "memory",
         .cb_function = _cb_create_text_memory,
     },
+    {
+        .data = _td_budget,
+        .data_size = ARRAYSIZE(_td_budget),
+        .json_name = "budget",
+        .cb_function = _cb_create_text_budget,
+    },
     {
         .data = _td_timer,
         .data_size = ARRAYSIZE(_td_timer),
@@ -376,6 +450,37 @@ _initialize_memory_values(struct oonf_viewer_template *template,
       oonf_class_get_allocations(cl), "", 0, false, template->create_raw);
   isonumber_from_u64(&_value_memory_recycled,
       oonf_class_get_recycled(cl), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_memory_slabs,
+      oonf_class_get_slabs(cl), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_memory_slabs_empty,
+      oonf_class_get_empty_slabs(cl), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_memory_slab_occupancy,
+      oonf_class_get_slab_occupancy(cl), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_memory_budget,
+      oonf_class_get_budget(cl), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_memory_used,
+      oonf_class_get_memory_usage(cl), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_memory_pressure,
+      oonf_class_get_pressure(cl), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_memory_evicted,
+      oonf_class_get_evicted(cl), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_memory_denied,
+      oonf_class_get_denied(cl), "", 0, false, template->create_raw);
+}
+
+/**
+ * Initialize the value buffers for the global memory budget
+ */
+static void
+_initialize_budget_values(struct oonf_viewer_template *template) {
+  isonumber_from_u64(&_value_budget_total,
+      oonf_class_get_global_budget(), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_budget_used,
+      oonf_class_get_global_usage(), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_budget_pressure,
+      oonf_class_get_global_pressure(), "", 0, false, template->create_raw);
+  isonumber_from_u64(&_value_budget_denied,
+      oonf_class_get_global_denied(), "", 0, false, template->create_raw);
 }
 
 /**
@@ -474,6 +579,20 @@ _cb_create_text_memory(struct oonf_viewer_template *template) {
   return 0;
 }
 
+/**
+ * Callback to generate text/json description of the global memory budget
+ * @param template viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_budget(struct oonf_viewer_template *template) {
+  _initialize_budget_values(template);
+
+  /* generate template output */
+  oonf_viewer_output_print_line(template);
+  return 0;
+}
+
 /**
  * Callback to generate text/json description of registered timers
  * @param template viewer template
@@ -0,0 +1,109 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include "common/common_types.h"
+#include "subsystems/rfc5444/rfc5444.h"
+
+#include "ff_dat_metric/ff_dat_cost.h"
+#include "ff_dat_metric/ff_dat_metric.h"
+
+/**
+ * Calculate the incoming link metric of a single link sample
+ * before it is rounded to a transmittable value
+ * @param sample ff_dat link sample
+ * @return incoming link metric between RFC7181_METRIC_MIN
+ *   and RFC7181_METRIC_MAX
+ */
+uint32_t
+ff_dat_cost_calculate(const struct ff_dat_sample *sample) {
+  int64_t metric;
+  int32_t loss_exponent;
+
+  /* apply median link speed */
+  if (sample->rx_bitrate > DATFF_LINKSPEED_RANGE) {
+    metric = 1;
+  }
+  else {
+    metric = DATFF_LINKSPEED_RANGE / sample->rx_bitrate;
+  }
+
+  /* apply frame loss */
+  if (sample->success_scaled_by_1000 == 0) {
+    metric *= DATFF_FRAME_SUCCESS_RANGE;
+  }
+  else {
+    for (loss_exponent = sample->loss_exponent; loss_exponent > 0; loss_exponent--) {
+      metric = (metric * (int64_t)DATFF_FRAME_SUCCESS_RANGE * 1000ll + 500ll)
+          / sample->success_scaled_by_1000;
+    }
+    metric *= sample->neighborhood;
+  }
+
+  if (metric > RFC7181_METRIC_MAX) {
+    return RFC7181_METRIC_MAX;
+  }
+  if (metric < RFC7181_METRIC_MIN) {
+    return RFC7181_METRIC_MIN;
+  }
+  return metric;
+}
+
+/**
+ * Convert a link metric into something that can be transmitted
+ * over the network
+ * @param metric link metric between RFC7181_METRIC_MIN
+ *   and RFC7181_METRIC_MAX
+ * @return metric after encoding and decoding
+ */
+uint32_t
+ff_dat_cost_encode(uint32_t metric) {
+  struct rfc7181_metric_field encoded_metric;
+
+  if (rfc7181_metric_encode(&encoded_metric, metric)) {
+    /* metric encoding failed */
+    return RFC7181_METRIC_MAX;
+  }
+  return rfc7181_metric_decode(&encoded_metric);
+}
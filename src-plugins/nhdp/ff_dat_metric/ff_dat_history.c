@@ -0,0 +1,200 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <string.h>
+
+#include "common/common_types.h"
+
+#include "ff_dat_metric/ff_dat_history.h"
+
+static void _set_bucket_packets(struct link_datff_history *,
+    struct link_datff_bucket *, uint32_t received, uint32_t total);
+static size_t _find_speed(const struct link_datff_history *, uint32_t speed);
+
+/**
+ * Initialize the sampling history of a new link. All buckets
+ * contain one lost packet and no link speed.
+ * @param history link sampling history
+ */
+void
+ff_dat_history_init(struct link_datff_history *history) {
+  size_t i;
+
+  for (i = 0; i<DAT_SAMPLING_COUNT; i++) {
+    history->buckets[i].received = 0;
+    history->buckets[i].total = 1;
+    history->buckets[i].scaled_speed = 0;
+    history->sorted_speed[i] = 0;
+  }
+
+  history->zero_speed_count = DAT_SAMPLING_COUNT;
+  history->received = 0;
+  history->total = DAT_SAMPLING_COUNT;
+  history->activePtr = 0;
+}
+
+/**
+ * Start sampling with the first received packet of a link
+ * @param history link sampling history
+ */
+void
+ff_dat_history_start(struct link_datff_history *history) {
+  history->activePtr = 0;
+  _set_bucket_packets(history, &history->buckets[0], 1, 1);
+}
+
+/**
+ * Add packets to the current bucket of the history
+ * @param history link sampling history
+ * @param received number of received packets
+ * @param total number of received and lost packets
+ */
+void
+ff_dat_history_add_packets(struct link_datff_history *history,
+    uint32_t received, uint32_t total) {
+  struct link_datff_bucket *bucket;
+
+  bucket = &history->buckets[history->activePtr];
+  _set_bucket_packets(history, bucket,
+      bucket->received + received, bucket->total + total);
+}
+
+/**
+ * Set the link speed of the current bucket. The sorted link
+ * speed array is updated with a binary search and a single
+ * move of the entries between the old and the new position.
+ * @param history link sampling history
+ * @param scaled_speed new link speed
+ */
+void
+ff_dat_history_set_speed(struct link_datff_history *history, uint32_t scaled_speed) {
+  struct link_datff_bucket *bucket;
+  size_t old_pos, new_pos;
+
+  bucket = &history->buckets[history->activePtr];
+  if (bucket->scaled_speed == scaled_speed) {
+    return;
+  }
+
+  old_pos = _find_speed(history, bucket->scaled_speed);
+  new_pos = _find_speed(history, scaled_speed);
+
+  if (new_pos > old_pos) {
+    /* new value is larger, move the entries in between down */
+    new_pos--;
+    memmove(&history->sorted_speed[old_pos], &history->sorted_speed[old_pos + 1],
+        (new_pos - old_pos) * sizeof(history->sorted_speed[0]));
+  }
+  else if (new_pos < old_pos) {
+    /* new value is smaller, move the entries in between up */
+    memmove(&history->sorted_speed[new_pos + 1], &history->sorted_speed[new_pos],
+        (old_pos - new_pos) * sizeof(history->sorted_speed[0]));
+  }
+  history->sorted_speed[new_pos] = scaled_speed;
+
+  if (bucket->scaled_speed == 0) {
+    history->zero_speed_count--;
+  }
+  if (scaled_speed == 0) {
+    history->zero_speed_count++;
+  }
+  bucket->scaled_speed = scaled_speed;
+}
+
+/**
+ * Move to the next bucket of the history and clear its
+ * packet counters. The link speed of the bucket stays until
+ * it is overwritten.
+ * @param history link sampling history
+ */
+void
+ff_dat_history_next(struct link_datff_history *history) {
+  history->activePtr++;
+  if (history->activePtr >= DAT_SAMPLING_COUNT) {
+    history->activePtr = 0;
+  }
+  _set_bucket_packets(history, &history->buckets[history->activePtr], 0, 0);
+}
+
+/**
+ * Set the packet counters of a bucket and update the sums
+ * @param history link sampling history
+ * @param bucket history bucket
+ * @param received new number of received packets
+ * @param total new number of received and lost packets
+ */
+static void
+_set_bucket_packets(struct link_datff_history *history,
+    struct link_datff_bucket *bucket, uint32_t received, uint32_t total) {
+  history->received += received - bucket->received;
+  history->total += total - bucket->total;
+
+  bucket->received = received;
+  bucket->total = total;
+}
+
+/**
+ * Binary search in the sorted link speed array
+ * @param history link sampling history
+ * @param speed link speed
+ * @return index of the first entry not smaller than speed
+ */
+static size_t
+_find_speed(const struct link_datff_history *history, uint32_t speed) {
+  size_t low, high, mid;
+
+  low = 0;
+  high = DAT_SAMPLING_COUNT;
+  while (low < high) {
+    mid = (low + high) / 2;
+    if (history->sorted_speed[mid] < speed) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
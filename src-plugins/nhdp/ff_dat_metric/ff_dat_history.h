@@ -0,0 +1,147 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef FF_DAT_HISTORY_H_
+#define FF_DAT_HISTORY_H_
+
+#include "common/common_types.h"
+
+/* Definitions */
+enum {
+  /*! number of sampling intervals stored in the history */
+  DAT_SAMPLING_COUNT = 32,
+};
+
+/**
+ * a single history memory cell, stores the metric
+ * data for a single update interval
+ */
+struct link_datff_bucket {
+  /*! number of RFC5444 packets received in time interval */
+  uint32_t received;
+
+  /*! sum of received and lost RFC5444 packets in time interval */
+  uint32_t total;
+
+  /*! link speed scaled to "minimum speed = 1" */
+  uint32_t scaled_speed;
+};
+
+/**
+ * Sampling history of a link with incrementally maintained
+ * packet sums and link speed order statistics.
+ */
+struct link_datff_history {
+  /*! history ringbuffer */
+  struct link_datff_bucket buckets[DAT_SAMPLING_COUNT];
+
+  /*! link speeds of all buckets in ascending order */
+  uint32_t sorted_speed[DAT_SAMPLING_COUNT];
+
+  /*! number of buckets without a link speed */
+  uint32_t zero_speed_count;
+
+  /*! sum of received packets of all buckets */
+  uint32_t received;
+
+  /*! sum of total packets of all buckets */
+  uint32_t total;
+
+  /*! current position in history ringbuffer */
+  uint16_t activePtr;
+};
+
+void ff_dat_history_init(struct link_datff_history *);
+void ff_dat_history_start(struct link_datff_history *);
+void ff_dat_history_add_packets(struct link_datff_history *,
+    uint32_t received, uint32_t total);
+void ff_dat_history_set_speed(struct link_datff_history *, uint32_t scaled_speed);
+void ff_dat_history_next(struct link_datff_history *);
+
+/**
+ * @param history link sampling history
+ * @return number of received packets in all buckets
+ */
+static INLINE uint32_t
+ff_dat_history_get_received(const struct link_datff_history *history) {
+  return history->received;
+}
+
+/**
+ * @param history link sampling history
+ * @return number of received and lost packets in all buckets
+ */
+static INLINE uint32_t
+ff_dat_history_get_total(const struct link_datff_history *history) {
+  return history->total;
+}
+
+/**
+ * @param history link sampling history
+ * @return link speed of the current bucket
+ */
+static INLINE uint32_t
+ff_dat_history_get_speed(const struct link_datff_history *history) {
+  return history->buckets[history->activePtr].scaled_speed;
+}
+
+/**
+ * Get the median of all recorded link speeds, ignoring buckets
+ * without link speed
+ * @param history link sampling history
+ * @return median link speed, 1 if no link speed is known
+ */
+static INLINE uint32_t
+ff_dat_history_get_median_speed(const struct link_datff_history *history) {
+  uint32_t window;
+
+  window = DAT_SAMPLING_COUNT - history->zero_speed_count;
+  if (window == 0) {
+    return 1;
+  }
+  return history->sorted_speed[history->zero_speed_count + window/2];
+}
+
+#endif /* FF_DAT_HISTORY_H_ */
@@ -64,13 +64,10 @@
 #include "nhdp/nhdp_domain.h"
 #include "nhdp/nhdp_interfaces.h"
 
+#include "ff_dat_metric/ff_dat_cost.h"
+#include "ff_dat_metric/ff_dat_history.h"
 #include "ff_dat_metric/ff_dat_metric.h"
 
-/* Definitions */
-enum {
-  DAT_SAMPLING_COUNT = 32,
-};
-
 /**
  * Configuration settings of DATFF Metric
  */
@@ -93,25 +90,13 @@ struct ff_dat_if_config {
   /*! timer for sampling interface data */
   struct oonf_timer_instance _sampling_timer;
 
+  /*! back pointer to NHDP interface */
+  struct nhdp_interface *nhdp_if;
+
   /*! true if we registered the interface */
   bool registered;
 };
 
-/**
- * a single history memory cell, stores the metric
- * data for a single update interval
- */
-struct link_datff_bucket {
-  /*! number of RFC5444 packets received in time interval */
-  uint32_t received;
-
-  /*! sum of received and lost RFC5444 packets in time interval */
-  uint32_t total;
-
-  /*! link speed scaled to "minimum speed = 1" */
-  uint32_t scaled_speed;
-};
-
 /**
  * Additional data for a nhdp_link class for metric calculation
  */
@@ -128,9 +113,6 @@ struct link_datff_data {
   /*! number of missed hellos based on timeouts since last received packet */
   uint32_t missed_hellos;
 
-  /*! current position in history ringbuffer */
-  uint16_t activePtr;
-
   /*! last received packet sequence number */
   uint16_t last_seq_nr;
 
@@ -143,8 +125,20 @@ struct link_datff_data {
   /*! estimated number of neighbors of this link */
   uint32_t link_neigborhood;
 
-  /*! history ringbuffer */
-  struct link_datff_bucket buckets[DAT_SAMPLING_COUNT];
+  /*! cached layer2 network of the links interface, NULL if not known */
+  struct oonf_layer2_net *l2net;
+
+  /*! cached layer2 neighbor of the link, NULL if not known */
+  struct oonf_layer2_neigh *l2neigh;
+
+  /*! remote MAC address used for the lookup of the cached layer2 neighbor */
+  struct netaddr l2neigh_mac;
+
+  /*! true if l2net and l2neigh have been looked up and are still valid */
+  bool l2_valid;
+
+  /*! sampling history */
+  struct link_datff_history history;
 };
 
 /* prototypes */
@@ -155,6 +149,7 @@ static void _cleanup(void);
 static void _cb_enable_metric(void);
 static void _cb_disable_metric(void);
 
+static void _cb_link_init(void *);
 static void _cb_link_added(void *);
 static void _cb_link_changed(void *);
 static void _cb_link_removed(void *);
@@ -162,14 +157,22 @@ static void _cb_link_removed(void *);
 static void _cb_nhdpif_added(void *);
 static void _cb_nhdpif_removed(void *);
 
+static void _cb_l2net_changed(void *);
+static void _cb_l2neigh_added(void *);
+static void _cb_l2neigh_removed(void *);
+
 static void _cb_dat_sampling(struct oonf_timer_instance *);
 static void _calculate_link_neighborhood(struct nhdp_link *lnk,
     struct link_datff_data *ldata);
 static int _calculate_dynamic_loss_exponent(int link_neigborhood);
-static uint32_t _apply_packet_loss(
+static void _sample_link(struct ff_dat_if_config *ifconfig,
+    struct nhdp_link *lnk, struct link_datff_data *ldata,
+    struct ff_dat_sample *sample);
+static void _sample_packet_loss(
     struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk,
-    struct link_datff_data *ldata,
-    uint32_t metric, uint32_t received, uint32_t total);
+    struct link_datff_data *ldata, struct ff_dat_sample *sample,
+    uint32_t received, uint32_t total);
+static void _cb_calculate_batch(uint32_t *costs, const void *samples, size_t count);
 
 static void _cb_hello_lost(struct oonf_timer_instance *);
 
@@ -276,6 +279,7 @@ static struct oonf_class_extension _link_extenstion = {
   .class_name = NHDP_CLASS_LINK,
   .size = sizeof(struct link_datff_data),
 
+  .init = _cb_link_init,
   .cb_add = _cb_link_added,
   .cb_change = _cb_link_changed,
   .cb_remove = _cb_link_removed,
@@ -290,6 +294,23 @@ static struct oonf_class_extension _nhdpif_extenstion = {
   .cb_remove = _cb_nhdpif_removed,
 };
 
+/* listeners to keep the cached layer2 pointers of the links valid */
+static struct oonf_class_extension _l2net_listener = {
+  .ext_name = "datff linkmetric",
+  .class_name = LAYER2_CLASS_NETWORK,
+
+  .cb_add = _cb_l2net_changed,
+  .cb_remove = _cb_l2net_changed,
+};
+
+static struct oonf_class_extension _l2neigh_listener = {
+  .ext_name = "datff linkmetric",
+  .class_name = LAYER2_CLASS_NEIGHBOR,
+
+  .cb_add = _cb_l2neigh_added,
+  .cb_remove = _cb_l2neigh_removed,
+};
+
 /* timer for sampling in RFC5444 packets */
 static struct oonf_timer_class _sampling_timer_info = {
   .name = "Sampling timer for DATFF-metric",
@@ -314,12 +335,16 @@ static struct nhdp_domain_metric _datff_handler = {
   .path_to_string = _path_to_string,
   .internal_link_to_string = _int_link_to_string,
 
+  .batch_sample_size = sizeof(struct ff_dat_sample),
+  .calculate_batch = _cb_calculate_batch,
+
   .enable = _cb_enable_metric,
   .disable = _cb_disable_metric,
 };
 
-/* Temporary buffer to sort incoming link speed for median calculation */
-static int _rx_sort_array[DAT_SAMPLING_COUNT] = { 0 };
+/* link samples of one batch metric calculation */
+static struct ff_dat_sample _samples[NHDP_DOMAIN_METRIC_BATCH_SIZE];
+static struct nhdp_link *_sample_links[NHDP_DOMAIN_METRIC_BATCH_SIZE];
 
 /* ff_dat has multiple logging targets */
 enum oonf_log_source LOG_FF_DAT;
@@ -354,6 +379,19 @@ _init(void) {
     nhdp_domain_metric_remove(&_datff_handler);
     return -1;
   }
+  if (oonf_class_extension_add(&_l2net_listener)) {
+    oonf_class_extension_remove(&_link_extenstion);
+    oonf_class_extension_remove(&_nhdpif_extenstion);
+    nhdp_domain_metric_remove(&_datff_handler);
+    return -1;
+  }
+  if (oonf_class_extension_add(&_l2neigh_listener)) {
+    oonf_class_extension_remove(&_l2net_listener);
+    oonf_class_extension_remove(&_link_extenstion);
+    oonf_class_extension_remove(&_nhdpif_extenstion);
+    nhdp_domain_metric_remove(&_datff_handler);
+    return -1;
+  }
   oonf_timer_add(&_sampling_timer_info);
   oonf_timer_add(&_hello_lost_info);
 
@@ -384,6 +422,8 @@ _cleanup(void) {
   oonf_rfc5444_remove_protocol_pktseqno(_protocol);
   _protocol = NULL;
 
+  oonf_class_extension_remove(&_l2neigh_listener);
+  oonf_class_extension_remove(&_l2net_listener);
   oonf_class_extension_remove(&_link_extenstion);
   oonf_class_extension_remove(&_nhdpif_extenstion);
 
@@ -427,6 +467,21 @@ _cb_disable_metric(void) {
   }
 }
 
+/**
+ * Initialize the metric data of a new nhdp link without zeroing
+ * the whole sample history first.
+ * @param ptr nhdp link
+ */
+static void
+_cb_link_init(void *ptr) {
+  struct link_datff_data *data;
+
+  data = oonf_class_get_extension(&_link_extenstion, ptr);
+
+  memset(data, 0, offsetof(struct link_datff_data, history));
+  ff_dat_history_init(&data->history);
+}
+
 /**
  * Callback triggered when a new nhdp link is added
  * @param ptr nhdp link
@@ -435,19 +490,10 @@ static void
 _cb_link_added(void *ptr) {
   struct link_datff_data *data;
   struct nhdp_link *lnk;
-  size_t i;
 
   lnk = ptr;
   data = oonf_class_get_extension(&_link_extenstion, lnk);
 
-  memset(data, 0, sizeof(*data));
-  // data->contains_data = false;
-
-  for (i = 0; i<ARRAYSIZE(data->buckets); i++) {
-    data->buckets[i].total = 1;
-    // data->buckets[i].scaled_speed = 0;
-  }
-
   /* initialize 'hello lost' timer for link */
   data->hello_lost_timer.class = &_hello_lost_info;
 
@@ -484,6 +530,9 @@ _cb_link_changed(void *ptr) {
     data->hello_interval = lnk->vtime_value;
   }
 
+  /* remote MAC might have changed */
+  data->l2_valid = false;
+
   _reset_missed_hello_timer(data);
 }
 
@@ -507,6 +556,7 @@ _cb_nhdpif_added(void *ptr) {
   ifconfig = oonf_class_get_extension(&_nhdpif_extenstion, ptr);
 
   ifconfig->_sampling_timer.class = &_sampling_timer_info;
+  ifconfig->nhdp_if = ptr;
 }
 
 static void
@@ -522,52 +572,99 @@ _cb_nhdpif_removed(void *ptr) {
 }
 
 /**
- * Helper for sorting datarate array
- * @param p1 pointer to integer 1
- * @param p2 pointer to integer 2
- * @return <0, 0 >0 (standard comparator output)
+ * Callback triggered when a layer2 network is added or removed,
+ * invalidates the layer2 cache of all links of the interface
+ * @param ptr layer2 network
  */
-static int
-_int_comparator(const void *p1, const void *p2) {
-  const int *i1 = (int *)p1;
-  const int *i2 = (int *)p2;
+static void
+_cb_l2net_changed(void *ptr) {
+  struct oonf_layer2_net *l2net;
+  struct link_datff_data *ldata;
+  struct nhdp_link *lnk;
 
-  if (*i1 > *i2) {
-    return 1;
-  }
-  else if (*i1 < *i2) {
-    return -1;
+  l2net = ptr;
+  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
+    if (strcmp(nhdp_interface_get_if_listener(lnk->local_if)->data->name, l2net->name) == 0) {
+      ldata = oonf_class_get_extension(&_link_extenstion, lnk);
+      ldata->l2_valid = false;
+    }
   }
-  return 0;
 }
 
 /**
- * Get the median of all recorded link speeds by sorting
- * @param ldata linkdata
- * @return median linkspeed
+ * Callback triggered when a layer2 neighbor is added, invalidates
+ * the layer2 cache of links of the network without a neighbor
+ * @param ptr layer2 neighbor
  */
-static int
-_get_median_rx_linkspeed(struct link_datff_data *ldata) {
-  int zero_count;
-  size_t window;
-  size_t i;
+static void
+_cb_l2neigh_added(void *ptr) {
+  struct oonf_layer2_neigh *l2neigh;
+  struct link_datff_data *ldata;
+  struct nhdp_link *lnk;
 
-  zero_count = 0;
-  for (i=0; i<ARRAYSIZE(ldata->buckets); i++) {
-    _rx_sort_array[i] = ldata->buckets[i].scaled_speed;
-    if (_rx_sort_array[i] == 0) {
-      zero_count++;
+  l2neigh = ptr;
+  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
+    ldata = oonf_class_get_extension(&_link_extenstion, lnk);
+    if (ldata->l2net == l2neigh->network && ldata->l2neigh == NULL) {
+      ldata->l2_valid = false;
     }
   }
+}
 
-  window = ARRAYSIZE(ldata->buckets) - zero_count;
-  if (window == 0) {
-    return 1;
+/**
+ * Callback triggered when a layer2 neighbor is removed, drops
+ * all cached references to it
+ * @param ptr layer2 neighbor
+ */
+static void
+_cb_l2neigh_removed(void *ptr) {
+  struct link_datff_data *ldata;
+  struct nhdp_link *lnk;
+
+  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
+    ldata = oonf_class_get_extension(&_link_extenstion, lnk);
+    if (ldata->l2neigh == ptr) {
+      ldata->l2neigh = NULL;
+      ldata->l2_valid = false;
+    }
   }
+}
 
-  qsort(_rx_sort_array, ARRAYSIZE(ldata->buckets), sizeof(int), _int_comparator);
+/**
+ * Get layer2 neighbor data of a link, using the cached layer2
+ * network and neighbor of the link.
+ * @param lnk nhdp link
+ * @param ldata ff_dat data of link
+ * @param idx layer2 neighbor data index
+ * @return pointer to linklayer data, NULL if no value available
+ */
+static const struct oonf_layer2_data *
+_get_l2neigh_data(struct nhdp_link *lnk, struct link_datff_data *ldata,
+    enum oonf_layer2_neighbor_index idx) {
+  const struct oonf_layer2_data *data;
+
+  /* the remote MAC of a link can change without a link change event */
+  if (!ldata->l2_valid || netaddr_cmp(&ldata->l2neigh_mac, &lnk->remote_mac) != 0) {
+    ldata->l2net = oonf_layer2_net_get(
+        nhdp_interface_get_if_listener(lnk->local_if)->data->name);
+    ldata->l2neigh = NULL;
+    if (ldata->l2net) {
+      ldata->l2neigh = oonf_layer2_neigh_get(ldata->l2net, &lnk->remote_mac);
+    }
+    memcpy(&ldata->l2neigh_mac, &lnk->remote_mac, sizeof(ldata->l2neigh_mac));
+    ldata->l2_valid = true;
+  }
 
-  return _rx_sort_array[zero_count + window/2];
+  if (ldata->l2neigh) {
+    return oonf_layer2_neigh_get_value(ldata->l2neigh, idx);
+  }
+  if (ldata->l2net) {
+    data = &ldata->l2net->neighdata[idx];
+    if (oonf_layer2_has_value(data)) {
+      return data;
+    }
+  }
+  return NULL;
 }
 
 /**
@@ -578,7 +675,6 @@ _get_median_rx_linkspeed(struct link_datff_data *ldata) {
  */
 static int
 _get_scaled_rx_linkspeed(struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk) {
-  struct os_interface *os_if;
   const struct oonf_layer2_data *l2data;
   int64_t rate;
 #ifdef OONF_LOG_INFO
@@ -590,11 +686,8 @@ _get_scaled_rx_linkspeed(struct ff_dat_if_config *ifconfig, struct nhdp_link *ln
     return 1;
   }
 
-  /* get local interface data  */
-  os_if = nhdp_interface_get_if_listener(lnk->local_if)->data;
-
-  l2data = oonf_layer2_neigh_query(
-      os_if->name, &lnk->remote_mac, OONF_LAYER2_NEIGH_RX_BITRATE);
+  l2data = _get_l2neigh_data(lnk, oonf_class_get_extension(&_link_extenstion, lnk),
+      OONF_LAYER2_NEIGH_RX_BITRATE);
   if (!l2data) {
     OONF_INFO(LOG_FF_DAT, "Datarate for link %s (%s) not available",
         netaddr_to_string(&nbuf, &lnk->if_addr),
@@ -628,134 +721,125 @@ _get_scaled_rx_linkspeed(struct ff_dat_if_config *ifconfig, struct nhdp_link *ln
  */
 static void
 _cb_dat_sampling(struct oonf_timer_instance *ptr) {
-  struct rfc7181_metric_field encoded_metric;
   struct ff_dat_if_config *ifconfig;
   struct link_datff_data *ldata;
   struct nhdp_link *lnk;
-  uint32_t total, received;
-  uint64_t metric;
-  uint32_t metric_value;
-  uint32_t missing_intervals;
-  size_t i;
-  int rx_bitrate;
-  bool change_happened;
-
-  struct netaddr_str nbuf;
+  size_t count;
 
   ifconfig = container_of(ptr, struct ff_dat_if_config, _sampling_timer);
 
   OONF_DEBUG(LOG_FF_DAT, "Calculate Metric from sampled data");
 
-  change_happened = false;
-
-  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
-    if (oonf_class_get_extension(&_nhdpif_extenstion, lnk->local_if) != ifconfig) {
-      continue;
-    }
-
+  count = 0;
+  list_for_each_element(&ifconfig->nhdp_if->_links, lnk, _if_node) {
     ldata = oonf_class_get_extension(&_link_extenstion, lnk);
     if (!ldata->contains_data) {
       /* still no data for this link */
       continue;
     }
 
-    /* initialize counter */
-    total = 0;
-    received = 0;
+    _sample_link(ifconfig, lnk, ldata, &_samples[count]);
+    _sample_links[count] = lnk;
+    count++;
 
-    /* calculate metric */
-    for (i=0; i<ARRAYSIZE(ldata->buckets); i++) {
-      received += ldata->buckets[i].received;
-      total += ldata->buckets[i].total;
+    if (count == ARRAYSIZE(_samples)) {
+      nhdp_domain_calculate_incoming_metrics(
+          &_datff_handler, _sample_links, _samples, count);
+      count = 0;
     }
+  }
 
-    if (ldata->missed_hellos > 0) {
-      missing_intervals = (ldata->missed_hellos * ldata->hello_interval)
-          / ifconfig->interval;
-      if (missing_intervals > ARRAYSIZE(ldata->buckets)) {
-        received = 0;
-      }
-      else {
-        received = (received * (ARRAYSIZE(ldata->buckets) - missing_intervals))
-            / ARRAYSIZE(ldata->buckets);
-      }
-    }
+  if (count > 0) {
+    nhdp_domain_calculate_incoming_metrics(
+        &_datff_handler, _sample_links, _samples, count);
+  }
+}
 
-    /* update link speed */
-    ldata->buckets[ldata->activePtr].scaled_speed = _get_scaled_rx_linkspeed(ifconfig, lnk);
+/**
+ * Collect the sampled data of a link for the metric calculation
+ * and move the history to the next interval
+ * @param ifconfig ff_dat interface configuration
+ * @param lnk nhdp link
+ * @param ldata link data object
+ * @param sample pointer to link sample
+ */
+static void
+_sample_link(struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk,
+    struct link_datff_data *ldata, struct ff_dat_sample *sample) {
+  uint32_t total, received;
+  uint32_t missing_intervals;
+  uint32_t rx_bitrate;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
 
-    OONF_DEBUG(LOG_FF_DAT, "Query incoming linkspeed for link %s: %"PRIu64,
-        netaddr_to_string(&nbuf, &lnk->if_addr),
-        (uint64_t)(ldata->buckets[ldata->activePtr].scaled_speed) * DATFF_LINKSPEED_MINIMUM);
-
-    /* get median scaled link speed and apply it to metric */
-    rx_bitrate = _get_median_rx_linkspeed(ldata);
-    if (rx_bitrate > DATFF_LINKSPEED_RANGE) {
-      OONF_WARN(LOG_FF_DAT, "Metric overflow %s (%s): %d",
-          netaddr_to_string(&nbuf, &lnk->if_addr),
-          nhdp_interface_get_name(lnk->local_if), rx_bitrate);
-      metric = 1;
-    }
-    else {
-      metric = DATFF_LINKSPEED_RANGE / rx_bitrate;
-    }
+  /* get packet counters of the whole history */
+  received = ff_dat_history_get_received(&ldata->history);
+  total = ff_dat_history_get_total(&ldata->history);
 
-    /* calculate frame loss, use discrete values */
-    if (total == 0 || received == 0
-        || received * DATFF_FRAME_SUCCESS_RANGE <= total) {
-      metric *= DATFF_FRAME_SUCCESS_RANGE;
+  if (ldata->missed_hellos > 0) {
+    missing_intervals = (ldata->missed_hellos * ldata->hello_interval)
+        / ifconfig->interval;
+    if (missing_intervals > DAT_SAMPLING_COUNT) {
+      received = 0;
     }
     else {
-      metric = _apply_packet_loss(ifconfig, lnk, ldata, metric, received, total);
+      received = (received * (DAT_SAMPLING_COUNT - missing_intervals))
+          / DAT_SAMPLING_COUNT;
     }
+  }
 
-    /* convert into something that can be transmitted over the network */
-    if (metric > RFC7181_METRIC_MAX) {
-      /* give the metric an upper bound */
-      OONF_INFO(LOG_FF_DAT, "Metric overflow %s (%s): %"PRIu64,
-          netaddr_to_string(&nbuf, &lnk->if_addr),
-          nhdp_interface_get_name(lnk->local_if), metric);
-      metric_value = RFC7181_METRIC_MAX;
-    }
-    else if (metric < RFC7181_METRIC_MIN) {
-      OONF_WARN(LOG_FF_DAT, "Metric underflow %s (%s): %"PRIu64,
-          netaddr_to_string(&nbuf, &lnk->if_addr),
-          nhdp_interface_get_name(lnk->local_if), metric);
-      metric_value = RFC7181_METRIC_MIN;
-    }
-    else if(!rfc7181_metric_encode(&encoded_metric, metric)) {
-      metric_value = rfc7181_metric_decode(&encoded_metric);
-    }
-    else {
-      /* metric encoding failed */
-      OONF_WARN(LOG_FF_DAT, "Metric encoding failed for link %s (%s): %"PRIu64,
-          netaddr_to_string(&nbuf, &lnk->if_addr),
-          nhdp_interface_get_name(lnk->local_if), metric);
-      metric_value = RFC7181_METRIC_MAX;
-    }
+  /* update link speed */
+  ff_dat_history_set_speed(&ldata->history, _get_scaled_rx_linkspeed(ifconfig, lnk));
 
-    /* set metric for incoming link */
-    change_happened |= nhdp_domain_set_incoming_metric(
-        &_datff_handler, lnk, metric_value);
+  OONF_DEBUG(LOG_FF_DAT, "Query incoming linkspeed for link %s: %"PRIu64,
+      netaddr_to_string(&nbuf, &lnk->if_addr),
+      (uint64_t)(ff_dat_history_get_speed(&ldata->history)) * DATFF_LINKSPEED_MINIMUM);
 
-    OONF_DEBUG(LOG_FF_DAT, "New sampling rate for link %s (%s):"
-        " %d/%d = %u (speed=%"PRIu64 ")\n",
-        netaddr_to_string(&nbuf, &lnk->if_addr),
-        nhdp_interface_get_name(lnk->local_if),
-        received, total, metric_value, (uint64_t)(rx_bitrate) * DATFF_LINKSPEED_MINIMUM);
+  /* get median scaled link speed */
+  rx_bitrate = ff_dat_history_get_median_speed(&ldata->history);
+  sample->rx_bitrate = rx_bitrate;
 
-    /* update rolling buffer */
-    ldata->activePtr++;
-    if (ldata->activePtr >= ARRAYSIZE(ldata->buckets)) {
-      ldata->activePtr = 0;
-    }
-    ldata->buckets[ldata->activePtr].received = 0;
-    ldata->buckets[ldata->activePtr].total = 0;
+  /* calculate frame loss, use discrete values */
+  if (total == 0 || received == 0
+      || received * DATFF_FRAME_SUCCESS_RANGE <= total) {
+    sample->success_scaled_by_1000 = 0;
+    sample->loss_exponent = 0;
+    sample->neighborhood = 1;
+  }
+  else {
+    _sample_packet_loss(ifconfig, lnk, ldata, sample, received, total);
+  }
+
+  OONF_DEBUG(LOG_FF_DAT, "New sampling rate for link %s (%s):"
+      " %d/%d (speed=%"PRIu64 ")\n",
+      netaddr_to_string(&nbuf, &lnk->if_addr),
+      nhdp_interface_get_name(lnk->local_if),
+      received, total, (uint64_t)(rx_bitrate) * DATFF_LINKSPEED_MINIMUM);
+
+  /* update rolling buffer */
+  ff_dat_history_next(&ldata->history);
+}
+
+/**
+ * Calculate the incoming link metric of a batch of link samples
+ * @param costs array for incoming link metrics
+ * @param ptr array of ff_dat link samples
+ * @param count number of links
+ */
+static void
+_cb_calculate_batch(uint32_t *costs, const void *ptr, size_t count) {
+  const struct ff_dat_sample *samples = ptr;
+  size_t i;
+
+  /* plain arithmetic first, so the compiler can keep the loop tight */
+  for (i = 0; i < count; i++) {
+    costs[i] = ff_dat_cost_calculate(&samples[i]);
   }
 
-  /* update neighbor metrics */
-  if (change_happened) {
-    nhdp_domain_neighborhood_changed();
+  /* round to metric values that can be transmitted over the network */
+  for (i = 0; i < count; i++) {
+    costs[i] = ff_dat_cost_encode(costs[i]);
   }
 }
 
@@ -767,7 +851,6 @@ _cb_dat_sampling(struct oonf_timer_instance *ptr) {
 static void
 _calculate_link_neighborhood(struct nhdp_link *lnk, struct link_datff_data *data) {
   struct nhdp_l2hop *l2hop;
-  struct nhdp_laddr *laddr;
   int count;
 
   /* local link neighbors */
@@ -776,7 +859,7 @@ _calculate_link_neighborhood(struct nhdp_link *lnk, struct link_datff_data *data
   /* links twohop neighbors */
   avl_for_each_element(&lnk->_2hop, l2hop, _link_node) {
     if (l2hop->same_interface
-        && !avl_find_element(&lnk->local_if->_link_addresses, &l2hop->twohop_addr, laddr, _if_node)) {
+        && !nhdp_interface_get_link_addr(lnk->local_if, &l2hop->twohop_addr)) {
       count ++;
     }
   }
@@ -805,20 +888,18 @@ _calculate_dynamic_loss_exponent(int link_neigborhood) {
 
 /**
  * Select discrete packet loss values and apply a hysteresis
+ * @param ifconfig ff_dat interface configuration
  * @param lnk nhdp link
  * @param ldata link data object
- * @param metric metric based on linkspeed
+ * @param sample link sample to store the packet loss parameters
  * @param received received packets
  * @param total total packets
- * @return metric including linkspeed and packet loss
  */
-static uint32_t
-_apply_packet_loss(struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk,
-    struct link_datff_data *ldata, uint32_t metric,
+static void
+_sample_packet_loss(struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk,
+    struct link_datff_data *ldata, struct ff_dat_sample *sample,
     uint32_t received, uint32_t total) {
   int64_t success_scaled_by_1000;
-  int loss_exponent;
-  int64_t tmp_metric;
 
   if (received * DATFF_FRAME_SUCCESS_RANGE < total) {
     success_scaled_by_1000 = 1000ll;
@@ -837,44 +918,34 @@ _apply_packet_loss(struct ff_dat_if_config *ifconfig, struct nhdp_link *lnk,
     /* remember new loss rate */
     ldata->last_packet_success_rate = success_scaled_by_1000;
   }
+  sample->success_scaled_by_1000 = success_scaled_by_1000;
 
   _calculate_link_neighborhood(lnk, ldata);
 
   switch (ifconfig->loss_exponent) {
     case IDX_LOSS_LINEAR:
-      loss_exponent = 1;
+      sample->loss_exponent = 1;
       break;
     case IDX_LOSS_QUADRATIC:
-      loss_exponent = 2;
+      sample->loss_exponent = 2;
       break;
     case IDX_LOSS_CUBIC:
-      loss_exponent = 3;
+      sample->loss_exponent = 3;
       break;
     case IDX_LOSS_DYNAMIC:
-      loss_exponent = _calculate_dynamic_loss_exponent(ldata->link_neigborhood);
+      sample->loss_exponent = _calculate_dynamic_loss_exponent(ldata->link_neigborhood);
       break;
     default:
-      loss_exponent = 1;
+      sample->loss_exponent = 1;
       break;
   }
 
-  tmp_metric = metric;
-  while (loss_exponent) {
-    tmp_metric = (tmp_metric * (int64_t)DATFF_FRAME_SUCCESS_RANGE * 1000ll + 500ll) / success_scaled_by_1000;
-    loss_exponent--;
-  }
-
   if (ifconfig->mic && ldata->link_neigborhood > 1) {
-    tmp_metric = tmp_metric * (int64_t)ldata->link_neigborhood;
+    sample->neighborhood = ldata->link_neigborhood;
   }
-
-  if (tmp_metric > RFC7181_METRIC_MAX) {
-    return RFC7181_METRIC_MAX;
-  }
-  if (tmp_metric < RFC7181_METRIC_MIN) {
-    return RFC7181_METRIC_MIN;
+  else {
+    sample->neighborhood = 1;
   }
-  return tmp_metric;
 }
 
 /**
@@ -933,8 +1004,8 @@ _cb_process_packet(struct rfc5444_reader_tlvblock_context *context) {
   struct nhdp_link *lnk;
   int total;
 
-  struct netaddr_str nbuf;
 #ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
   struct isonumber_str timebuf;
 #endif
 
@@ -976,18 +1047,9 @@ _cb_process_packet(struct rfc5444_reader_tlvblock_context *context) {
   lnk = laddr->link;
   ldata = oonf_class_get_extension(&_link_extenstion, lnk);
 
-  if (!ldata->buckets) {
-    OONF_WARN(LOG_FF_DAT, "No buckets for link to %s (%s)",
-        netaddr_to_string(&nbuf, &lnk->if_addr),
-        nhdp_interface_get_name(lnk->local_if));
-    return RFC5444_OKAY;
-  }
-
   if (!ldata->contains_data) {
     ldata->contains_data = true;
-    ldata->activePtr = 0;
-    ldata->buckets[0].received = 1;
-    ldata->buckets[0].total = 1;
+    ff_dat_history_start(&ldata->history);
     ldata->last_seq_nr = context->pkt_seqno;
 
     return RFC5444_OKAY;
@@ -1000,8 +1062,7 @@ _cb_process_packet(struct rfc5444_reader_tlvblock_context *context) {
     total = ((uint32_t)(context->pkt_seqno) + 65536) - (uint32_t)(ldata->last_seq_nr);
   }
 
-  ldata->buckets[ldata->activePtr].received++;
-  ldata->buckets[ldata->activePtr].total += total;
+  ff_dat_history_add_packets(&ldata->history, 1, total);
   ldata->last_seq_nr = context->pkt_seqno;
 
   _reset_missed_hello_timer(ldata);
@@ -1074,28 +1135,14 @@ _path_to_string(struct nhdp_metric_str *buf, uint32_t metric, uint8_t hopcount)
 static const char *
 _int_link_to_string(struct nhdp_metric_str *buf, struct nhdp_link *lnk) {
   struct link_datff_data *ldata;
-  int64_t received = 0, total = 0;
-  size_t i;
-
-  struct netaddr_str nbuf;
 
   ldata = oonf_class_get_extension(&_link_extenstion, lnk);
 
-  if (!ldata->buckets) {
-    OONF_WARN(LOG_FF_DAT, "No buckets for link to %s (%s)",
-        netaddr_to_string(&nbuf, &lnk->if_addr),
-        nhdp_interface_get_name(lnk->local_if));
-    return RFC5444_OKAY;
-  }
-
-  for (i=0; i<ARRAYSIZE(ldata->buckets); i++) {
-    received += ldata->buckets[i].received;
-    total += ldata->buckets[i].total;
-  }
-
   snprintf(buf->buf, sizeof(*buf), "p_recv=%"PRId64",p_total=%"PRId64","
       "speed=%"PRId64",success=%"PRId64",missed_hello=%d,lastseq=%u,lneigh=%d",
-      received, total, (int64_t)_get_median_rx_linkspeed(ldata) * (int64_t)1024,
+      (int64_t)ff_dat_history_get_received(&ldata->history),
+      (int64_t)ff_dat_history_get_total(&ldata->history),
+      (int64_t)ff_dat_history_get_median_speed(&ldata->history) * (int64_t)1024,
       ldata->last_packet_success_rate, ldata->missed_hellos,
       ldata->last_seq_nr, ldata->link_neigborhood);
   return buf->buf;
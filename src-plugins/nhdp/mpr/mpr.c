@@ -43,19 +43,13 @@
  * @file
  */
 
-#include <errno.h>
-#include <stdio.h>
-
 #include "common/common_types.h"
-#include "common/autobuf.h"
 #include "common/avl.h"
-#include "common/avl_comp.h"
-#include "common/container_of.h"
 #include "config/cfg_schema.h"
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/oonf_class.h"
-#include "subsystems/oonf_rfc5444.h"
+#include "subsystems/oonf_clock.h"
 
 #include "nhdp/nhdp.h"
 #include "nhdp/nhdp_db.h"
@@ -66,23 +60,76 @@
 
 #include "neighbor-graph-flooding.h"
 #include "neighbor-graph-routing.h"
+#include "selection-incremental.h"
+#include "selection-matrix.h"
 #include "selection-rfc7181.h"
 
-/* FIXME remove unneeded includes */
+/*! implementations of the RFC 7181 MPR selection */
+enum _mpr_selection {
+  /*! selection working directly on the neighbor graph */
+  IDX_SELECTION_RFC7181,
+
+  /*! selection working on a dense cost matrix */
+  IDX_SELECTION_MATRIX,
+};
+
+/**
+ * Configuration of MPR plugin
+ */
+struct _config {
+  /*! implementation of the MPR selection */
+  int32_t selection;
+
+  /*! true to update the routing MPR set incrementally */
+  bool incremental;
+
+  /*! time interval between two full recalculations of the routing MPR set */
+  uint64_t full_interval;
+};
 
 /* prototypes */
 static void _early_cfg_init(void);
 static int _init(void);
 static void _cleanup(void);
 static void _cb_update_mpr(void);
+static void _cb_cfg_changed(void);
+static void _calculate_mpr(const struct nhdp_domain *, struct neighbor_graph *);
 
 #ifndef NDEBUG
 static void _validate_mpr_set(
     const struct nhdp_domain *domain, struct neighbor_graph *graph);
 #endif
 
+/* configuration */
+static const char *SELECTION[] = {
+  [IDX_SELECTION_RFC7181] = "rfc7181",
+  [IDX_SELECTION_MATRIX]  = "matrix",
+};
+
+static struct cfg_schema_entry _mpr_entries[] = {
+  CFG_MAP_CHOICE(_config, selection, "selection", "rfc7181",
+      "Implementation of the MPR selection, both calculate the same MPR set."
+      " 'rfc7181' works directly on the neighbor graph, 'matrix' uses a dense"
+      " cost matrix", SELECTION),
+  CFG_MAP_BOOL(_config, incremental, "incremental", "false",
+      "Update the routing MPR set incrementally, only checking the two-hop"
+      " neighbors touched by a change. The incremental set never drops MPRs,"
+      " redundant ones are only removed by the next full recalculation"),
+  CFG_MAP_CLOCK_MIN(_config, full_interval, "full_interval", "60.0",
+      "Time interval between two full recalculations of the routing MPR set,"
+      " which also cross-check the incremental result", 1000),
+};
+
+static struct cfg_schema_section _mpr_section = {
+  .type = OONF_MPR_SUBSYSTEM,
+  .cb_delta_handler = _cb_cfg_changed,
+  .entries = _mpr_entries,
+  .entry_count = ARRAYSIZE(_mpr_entries),
+};
+
 static const char *_dependencies[] = {
   OONF_CLASS_SUBSYSTEM,
+  OONF_CLOCK_SUBSYSTEM,
   OONF_TIMER_SUBSYSTEM,
   OONF_NHDP_SUBSYSTEM,
 };
@@ -93,6 +140,7 @@ static struct oonf_subsystem _nhdp_mpr_subsystem = {
   .descr = "RFC7181 Appendix B MPR Plugin",
   .author = "Jonathan Kirchhoff",
   .early_cfg_init = _early_cfg_init,
+  .cfg_section = &_mpr_section,
 
   .init = _init,
   .cleanup = _cleanup,
@@ -107,6 +155,11 @@ static struct nhdp_domain_mpr _mpr_handler = {
 /* logging sources for NHDP subsystem */
 enum oonf_log_source LOG_MPR;
 
+static struct _config _mpr_config;
+
+/* incremental routing MPR state of each domain */
+static struct mpr_incremental_state _routing_state[NHDP_MAXIMUM_DOMAINS];
+
 /**
  * Initialize additional logging sources for NHDP
  */
@@ -121,9 +174,15 @@ _early_cfg_init(void) {
  */
 static int
 _init(void) {
+  size_t i;
+
   if (nhdp_domain_mpr_add(&_mpr_handler)) {
     return -1;
   }
+
+  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    mpr_incremental_init(&_routing_state[i]);
+  }
   return 0;
 }
 
@@ -132,25 +191,46 @@ _init(void) {
  */
 static void
 _cleanup(void) {
+  size_t i;
+
+  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    mpr_incremental_clear(&_routing_state[i]);
+  }
 }
 
 /**
  * Updates the current routing MPR selection in the NHDP database
- * @param current_mpr_data
+ * @param domain NHDP domain
+ * @param graph neighbor graph with calculated MPR set
  */
 static void
-_update_nhdp_routing(struct neighbor_graph *graph) {
+_update_nhdp_routing(struct nhdp_domain *domain, struct neighbor_graph *graph) {
   struct nhdp_link *lnk;
   struct n1_node *current_mpr_node;
   
   list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
-    lnk->neigh->_domaindata[0].neigh_is_mpr = false;
     current_mpr_node = avl_find_element(&graph->set_mpr,
         &lnk->neigh->originator,
         current_mpr_node, _avl_node);
-    if (current_mpr_node != NULL) {
-      lnk->neigh->_domaindata[0].neigh_is_mpr = true;
-    }
+    nhdp_domain_get_neighbordata(domain, lnk->neigh)->neigh_is_mpr =
+        current_mpr_node != NULL;
+  }
+}
+
+/**
+ * Updates the current routing MPR selection in the NHDP database
+ * from the incremental MPR state
+ * @param domain NHDP domain
+ * @param state incremental MPR state of domain
+ */
+static void
+_update_nhdp_routing_incremental(struct nhdp_domain *domain,
+    struct mpr_incremental_state *state) {
+  struct nhdp_neighbor *neigh;
+
+  list_for_each_element(nhdp_db_get_neigh_list(), neigh, _global_node) {
+    nhdp_domain_get_neighbordata(domain, neigh)->neigh_is_mpr =
+        mpr_incremental_is_mpr(state, neigh);
   }
 }
 
@@ -206,8 +286,7 @@ _update_flooding_mpr(void) {
     
     mpr_calculate_neighbor_graph_flooding(
         nhdp_domain_get_flooding(), &flooding_data);
-    mpr_calculate_mpr_rfc7181(nhdp_domain_get_flooding(),
-        &flooding_data.neigh_graph);
+    _calculate_mpr(nhdp_domain_get_flooding(), &flooding_data.neigh_graph);
     mpr_print_sets(&flooding_data.neigh_graph);
 #ifndef NDEBUG
     _validate_mpr_set(nhdp_domain_get_flooding(), &flooding_data.neigh_graph);
@@ -218,9 +297,48 @@ _update_flooding_mpr(void) {
 
 }
 
+/**
+ * Calculate the routing MPR set of a domain from scratch
+ * @param domain NHDP domain
+ * @param state incremental MPR state to cross-check and update,
+ *   NULL if incremental updates are disabled
+ */
 static void
-_update_routing_mpr(void) {
+_calculate_routing_mpr(struct nhdp_domain *domain,
+    struct mpr_incremental_state *state) {
   struct neighbor_graph routing_graph;
+
+  OONF_DEBUG(LOG_MPR, "*** Calculate routing MPRs for domain %u ***", domain->index);
+
+  memset(&routing_graph, 0, sizeof(routing_graph));
+  mpr_calculate_neighbor_graph_routing(domain, &routing_graph);
+  _calculate_mpr(domain, &routing_graph);
+  mpr_print_sets(&routing_graph);
+#ifndef NDEBUG
+  _validate_mpr_set(domain, &routing_graph);
+#endif
+
+  if (state == NULL) {
+    _update_nhdp_routing(domain, &routing_graph);
+  }
+  else {
+    if (!mpr_incremental_validate(domain, state, &routing_graph)) {
+      OONF_WARN(LOG_MPR, "Incremental routing MPR set of domain %u is invalid,"
+          " replacing it with full recalculation", domain->index);
+    }
+    mpr_incremental_set_mprs(state, &routing_graph.set_mpr);
+    _update_nhdp_routing_incremental(domain, state);
+
+    OONF_INFO(LOG_MPR, "Routing MPRs of domain %u: %u incremental updates,"
+        " %u full recalculations, %u invalid incremental sets", domain->index,
+        state->incremental_count, state->full_count, state->mismatch_count);
+  }
+  mpr_clear_neighbor_graph(&routing_graph);
+}
+
+static void
+_update_routing_mpr(void) {
+  struct mpr_incremental_state *state;
   struct nhdp_domain *domain;
 
   list_for_each_element(nhdp_domain_get_list(), domain, _node) {
@@ -228,19 +346,40 @@ _update_routing_mpr(void) {
       /* we are not the routing MPR for this domain */
       continue;
     }
-    OONF_DEBUG(LOG_MPR, "*** Calculate routing MPRs for domain %u ***", domain->index);
-    
-    memset(&routing_graph, 0, sizeof(routing_graph));
-    mpr_calculate_neighbor_graph_routing(domain, &routing_graph);
-    mpr_calculate_mpr_rfc7181(domain, &routing_graph);
-    mpr_print_sets(&routing_graph);
-#ifndef NDEBUG
-    _validate_mpr_set(domain, &routing_graph);
-#endif
-    _update_nhdp_routing(&routing_graph);
-    mpr_clear_neighbor_graph(&routing_graph);
+
+    if (!_mpr_config.incremental) {
+      _calculate_routing_mpr(domain, NULL);
+      continue;
+    }
+
+    state = &_routing_state[domain->index];
+    mpr_incremental_update(domain, state);
+
+    if (oonf_clock_is_past(state->next_full)) {
+      /* periodic full recalculation to remove redundant MPRs */
+      _calculate_routing_mpr(domain, state);
+      state->next_full = oonf_clock_get_absolute(_mpr_config.full_interval);
+    }
+    else {
+      _update_nhdp_routing_incremental(domain, state);
+    }
   } 
-  
+}
+
+/**
+ * Calculate the MPR set of a neighbor graph with the configured
+ * implementation
+ * @param domain NHDP domain
+ * @param graph neighbor graph
+ */
+static void
+_calculate_mpr(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
+  if (_mpr_config.selection == IDX_SELECTION_MATRIX) {
+    mpr_calculate_mpr_matrix(domain, graph);
+  }
+  else {
+    mpr_calculate_mpr_rfc7181(domain, graph);
+  }
 }
 
 /**
@@ -259,6 +398,26 @@ _cb_update_mpr(void) {
   OONF_DEBUG(LOG_MPR, "Finished recalculating MPRs");
 }
 
+/**
+ * Callback triggered when configuration changes
+ */
+static void
+_cb_cfg_changed(void) {
+  size_t i;
+
+  if (cfg_schema_tobin(&_mpr_config, _mpr_section.post,
+      _mpr_entries, ARRAYSIZE(_mpr_entries))) {
+    OONF_WARN(LOG_MPR, "Cannot convert configuration for " OONF_MPR_SUBSYSTEM);
+    return;
+  }
+
+  /* start with a full recalculation */
+  for (i = 0; i < NHDP_MAXIMUM_DOMAINS; i++) {
+    mpr_incremental_clear(&_routing_state[i]);
+    _routing_state[i].next_full = 0;
+  }
+}
+
 #ifndef NDEBUG
 
 /**
@@ -154,8 +154,7 @@ _calculate_d2_x_y(const struct nhdp_domain *domain,
   struct nhdp_l2hop_domaindata *twohopdata;
 
   /* find the corresponding 2-hop entry, if it exists */
-  tmp_l2hop = avl_find_element(&x->link->_2hop,
-      &y->addr, tmp_l2hop, _link_node);
+  tmp_l2hop = ndhp_db_link_2hop_get(x->link, &y->addr);
   if (tmp_l2hop) {
     twohopdata = nhdp_domain_get_l2hopdata(domain, tmp_l2hop);
     return twohopdata->metric.out;
@@ -215,17 +214,19 @@ _calculate_d1_x_of_n2_addr(const struct nhdp_domain *domain,
 
   // FIXME Implementation correct?!?!
 
-  avl_for_each_element(&graph->set_n1, node_n1, _avl_node) {
-    /* check if the address provided corresponds to this node */
-    naddr = avl_find_element(&node_n1->neigh->_neigh_addresses,
-        &addr->addr, naddr, _neigh_node);
-    if (naddr) {
-      linkdata = nhdp_domain_get_linkdata(domain, node_n1->link);
-      return linkdata->metric.out;
-    }
+  /* find the N1 node the address provided corresponds to */
+  naddr = nhdp_db_neighbor_addr_get(&addr->addr);
+  if (naddr == NULL) {
+    return RFC7181_METRIC_INFINITE;
   }
 
-  return RFC7181_METRIC_INFINITE;
+  node_n1 = avl_find_element(&graph->set_n1, &naddr->neigh->originator, node_n1, _avl_node);
+  if (node_n1 == NULL) {
+    return RFC7181_METRIC_INFINITE;
+  }
+
+  linkdata = nhdp_domain_get_linkdata(domain, node_n1->link);
+  return linkdata->metric.out;
 }
 
 /**
@@ -94,8 +94,9 @@ static struct neighbor_graph_interface _rt_api_interface = {
  * @return 
  */
 static bool
-_is_reachable_neighbor_tuple(struct nhdp_neighbor *neigh) {
-  if (neigh->_domaindata[0].metric.in <= RFC7181_METRIC_MAX
+_is_reachable_neighbor_tuple(const struct nhdp_domain *domain,
+    struct nhdp_neighbor *neigh) {
+  if (nhdp_domain_get_neighbordata(domain, neigh)->metric.in <= RFC7181_METRIC_MAX
       && neigh->symmetric > 0) {
     return true;
   }
@@ -109,9 +110,9 @@ _is_reachable_neighbor_tuple(struct nhdp_neighbor *neigh) {
  * @return 
  */
 static bool
-_is_allowed_neighbor_tuple(const struct nhdp_domain *domain __attribute__((unused)),
+_is_allowed_neighbor_tuple(const struct nhdp_domain *domain,
     struct nhdp_neighbor *neigh) {
-  if (_is_reachable_neighbor_tuple(neigh)) {
+  if (_is_reachable_neighbor_tuple(domain, neigh)) {
     // FIXME Willingness handling appears to be broken; routing willingness is always 0
     //      && neigh->_domaindata[0].willingness > RFC5444_WILLINGNESS_NEVER) {
     return true;
@@ -164,8 +165,7 @@ _calculate_d2_x_y(const struct nhdp_domain *domain, struct n1_node *x, struct ad
 
   /* find the corresponding 2-hop entry, if it exists */
   list_for_each_element(&x->neigh->_links, lnk, _neigh_node) {
-    l2hop = avl_find_element(&lnk->_2hop,
-        &y->addr, l2hop, _link_node);
+    l2hop = ndhp_db_link_2hop_get(lnk, &y->addr);
     if (l2hop) {
       twohopdata = nhdp_domain_get_l2hopdata(domain, l2hop);
       return twohopdata->metric.in;
@@ -220,19 +220,22 @@ static uint32_t
 _calculate_d1_of_y(const struct nhdp_domain *domain,
     struct neighbor_graph *graph, struct addr_node *y) {
   struct n1_node *node_n1;
-  struct nhdp_laddr *laddr;
+  struct nhdp_naddr *naddr;
   struct nhdp_neighbor_domaindata *neighdata;
 
   /* find the N1 neighbor corresponding to this address, if it exists */
-  avl_for_each_element(&graph->set_n1, node_n1, _avl_node) {
-    laddr = avl_find_element(&node_n1->neigh->_neigh_addresses, y,
-        laddr, _neigh_node);
-    if (laddr != NULL) {
-      neighdata = nhdp_domain_get_neighbordata(domain, node_n1->neigh);
-      return neighdata->metric.in;
-    }
+  naddr = nhdp_db_neighbor_addr_get(&y->addr);
+  if (naddr == NULL) {
+    return RFC7181_METRIC_INFINITE;
   }
-  return RFC7181_METRIC_INFINITE;
+
+  node_n1 = avl_find_element(&graph->set_n1, &naddr->neigh->originator, node_n1, _avl_node);
+  if (node_n1 == NULL) {
+    return RFC7181_METRIC_INFINITE;
+  }
+
+  neighdata = nhdp_domain_get_neighbordata(domain, node_n1->neigh);
+  return neighdata->metric.in;
 }
 
 /**
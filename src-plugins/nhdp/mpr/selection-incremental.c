@@ -0,0 +1,654 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+
+#include "common/common_types.h"
+#include "common/avl.h"
+#include "common/avl_comp.h"
+#include "common/list.h"
+#include "common/netaddr.h"
+#include "core/oonf_logging.h"
+#include "subsystems/oonf_rfc5444.h"
+
+#include "nhdp/nhdp_db.h"
+#include "nhdp/nhdp_domain.h"
+
+#include "mpr/mpr_internal.h"
+#include "mpr/neighbor-graph.h"
+#include "mpr/selection-incremental.h"
+
+static struct mpr_incremental_n1 *_add_n1(
+    struct mpr_incremental_state *state, struct nhdp_neighbor *neigh);
+static void _remove_n1(
+    struct mpr_incremental_state *state, struct mpr_incremental_n1 *x);
+static struct mpr_incremental_n2 *_add_n2(
+    struct mpr_incremental_state *state, const struct netaddr *addr);
+static void _remove_edge(
+    struct mpr_incremental_state *state, struct mpr_incremental_edge *edge);
+static void _mark_affected(
+    struct mpr_incremental_state *state, struct mpr_incremental_n2 *y);
+static void _refresh_n1(const struct nhdp_domain *domain,
+    struct mpr_incremental_state *state, struct mpr_incremental_n1 *x);
+static uint32_t _calculate_d1_of_y(
+    struct mpr_incremental_state *state, struct mpr_incremental_n2 *y);
+static void _update_coverage(struct mpr_incremental_n2 *y);
+static void _add_mpr(struct mpr_incremental_n1 *x);
+static bool _is_uncovered(struct mpr_incremental_n2 *y);
+static void _process_unique_mprs(struct mpr_incremental_state *state);
+static void _process_remaining(struct mpr_incremental_state *state);
+
+/**
+ * Initialize the incremental MPR state of a domain
+ * @param state incremental MPR state
+ */
+void
+mpr_incremental_init(struct mpr_incremental_state *state) {
+  memset(state, 0, sizeof(*state));
+  avl_init(&state->set_n1, avl_comp_netaddr, false);
+  avl_init(&state->set_n2, avl_comp_netaddr, false);
+  list_init_head(&state->_affected);
+}
+
+/**
+ * Remove all elements from the incremental MPR state
+ * @param state incremental MPR state
+ */
+void
+mpr_incremental_clear(struct mpr_incremental_state *state) {
+  struct mpr_incremental_n1 *x, *x_it;
+  struct mpr_incremental_n2 *y, *y_it;
+
+  avl_for_each_element_safe(&state->set_n1, x, _node, x_it) {
+    _remove_n1(state, x);
+  }
+  avl_for_each_element_safe(&state->set_n2, y, _node, y_it) {
+    avl_remove(&state->set_n2, &y->_node);
+    free(y);
+  }
+  list_init_head(&state->_affected);
+  state->valid = false;
+}
+
+/**
+ * Bring the incremental MPR state up to date with the NHDP database.
+ * Only the N2 elements with a changed edge or d1(y) are checked for
+ * coverage, the rest of the MPR set is kept.
+ * @param domain NHDP domain
+ * @param state incremental MPR state
+ */
+void
+mpr_incremental_update(const struct nhdp_domain *domain,
+    struct mpr_incremental_state *state) {
+  struct nhdp_neighbor_domaindata *neighdata;
+  struct mpr_incremental_n1 *x, *x_it;
+  struct mpr_incremental_n2 *y, *y_it;
+  struct nhdp_neighbor *neigh;
+  uint32_t d1;
+
+  OONF_DEBUG(LOG_MPR, "Incremental MPR update for domain %u", domain->index);
+
+  avl_for_each_element(&state->set_n1, x, _node) {
+    x->_seen = false;
+  }
+
+  /* update N1 and the edges to N2 */
+  list_for_each_element(nhdp_db_get_neigh_list(), neigh, _global_node) {
+    neighdata = nhdp_domain_get_neighbordata(domain, neigh);
+    if (neighdata->metric.in > RFC7181_METRIC_MAX || neigh->symmetric == 0) {
+      continue;
+    }
+
+    x = avl_find_element(&state->set_n1, &neigh->originator, x, _node);
+    if (x == NULL) {
+      x = _add_n1(state, neigh);
+      if (x == NULL) {
+        continue;
+      }
+    }
+    else if (x->_seen) {
+      /* neighbor without originator sharing an N1 element */
+      continue;
+    }
+    x->neigh = neigh;
+    x->_seen = true;
+
+    _refresh_n1(domain, state, x);
+  }
+
+  avl_for_each_element_safe(&state->set_n1, x, _node, x_it) {
+    if (!x->_seen) {
+      _remove_n1(state, x);
+    }
+  }
+
+  /* d1(y) can change without a change of the edges of y */
+  avl_for_each_element(&state->set_n2, y, _node) {
+    d1 = _calculate_d1_of_y(state, y);
+    if (d1 != y->d1) {
+      y->d1 = d1;
+      _mark_affected(state, y);
+    }
+  }
+
+  /* recalculate N and the coverage of all affected N2 elements */
+  list_for_each_element_safe(&state->_affected, y, _affected_node, y_it) {
+    if (list_is_empty(&y->_edges)) {
+      list_remove(&y->_affected_node);
+      avl_remove(&state->set_n2, &y->_node);
+      free(y);
+      continue;
+    }
+    _update_coverage(y);
+  }
+
+  /* all x in N1 with W(x) = WILL_ALWAYS are in M */
+  avl_for_each_element(&state->set_n1, x, _node) {
+    if (!x->is_mpr && nhdp_domain_get_neighbordata(domain, x->neigh)->willingness
+        == RFC7181_WILLINGNESS_ALWAYS) {
+      _add_mpr(x);
+    }
+  }
+
+  _process_unique_mprs(state);
+  _process_remaining(state);
+
+  list_for_each_element_safe(&state->_affected, y, _affected_node, y_it) {
+    list_remove(&y->_affected_node);
+    y->_affected = false;
+  }
+
+  state->valid = true;
+  state->incremental_count++;
+}
+
+/**
+ * Overwrite the MPR selection of the incremental state,
+ * e.g. with the result of a full recalculation.
+ * @param state incremental MPR state
+ * @param set_mpr tree of n1_nodes selected as MPRs
+ */
+void
+mpr_incremental_set_mprs(struct mpr_incremental_state *state, struct avl_tree *set_mpr) {
+  struct mpr_incremental_n1 *x;
+  struct mpr_incremental_n2 *y;
+  struct n1_node *mpr;
+
+  avl_for_each_element(&state->set_n1, x, _node) {
+    x->is_mpr = avl_find_element(set_mpr, &x->addr, mpr, _avl_node) != NULL;
+  }
+  avl_for_each_element(&state->set_n2, y, _node) {
+    _update_coverage(y);
+  }
+  state->full_count++;
+}
+
+/**
+ * Cross-check the MPR set of the incremental state against a
+ * neighbor graph calculated from scratch. The sets do not need
+ * to be identical, but the incremental one must cover N with
+ * the same path costs as N1.
+ * @param domain NHDP domain
+ * @param state incremental MPR state
+ * @param graph neighbor graph after a full MPR calculation
+ * @return true if the incremental MPR set is valid
+ */
+bool
+mpr_incremental_validate(const struct nhdp_domain *domain,
+    struct mpr_incremental_state *state, struct neighbor_graph *graph) {
+  struct mpr_incremental_n1 *x;
+  struct mpr_incremental_n2 *y;
+  struct n1_node *node_n1;
+  struct addr_node *node_n;
+  struct avl_tree set_mpr;
+  uint32_t n_count;
+  bool valid;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
+
+  avl_init(&set_mpr, avl_comp_netaddr, false);
+  avl_for_each_element(&graph->set_n1, node_n1, _avl_node) {
+    x = avl_find_element(&state->set_n1, &node_n1->addr, x, _node);
+    if (x != NULL && x->is_mpr) {
+      mpr_add_n1_node_to_set(&set_mpr, node_n1->neigh, node_n1->link,
+          node_n1->table_offset);
+    }
+  }
+
+  valid = true;
+  avl_for_each_element(&graph->set_n, node_n, _avl_node) {
+    y = avl_find_element(&state->set_n2, &node_n->addr, y, _node);
+    if (y == NULL || !y->in_n) {
+      OONF_DEBUG(LOG_MPR, "%s is missing in incremental N",
+          netaddr_to_string(&nbuf, &node_n->addr));
+      valid = false;
+      break;
+    }
+    if (mpr_calculate_d_of_y_s(domain, graph, node_n, &set_mpr)
+        != mpr_calculate_d_of_y_s(domain, graph, node_n, &graph->set_n1)) {
+      OONF_DEBUG(LOG_MPR, "%s is not covered by incremental MPR set",
+          netaddr_to_string(&nbuf, &node_n->addr));
+      valid = false;
+      break;
+    }
+  }
+
+  n_count = 0;
+  avl_for_each_element(&state->set_n2, y, _node) {
+    if (y->in_n) {
+      n_count++;
+    }
+  }
+  if (n_count != graph->set_n.count) {
+    OONF_DEBUG(LOG_MPR, "Incremental N has %u elements instead of %u",
+        n_count, graph->set_n.count);
+    valid = false;
+  }
+
+  mpr_clear_n1_set(&set_mpr);
+
+  if (!valid) {
+    state->mismatch_count++;
+  }
+  return valid;
+}
+
+/**
+ * @param state incremental MPR state
+ * @param neigh NHDP neighbor
+ * @return true if neighbor is selected as MPR
+ */
+bool
+mpr_incremental_is_mpr(struct mpr_incremental_state *state, struct nhdp_neighbor *neigh) {
+  struct mpr_incremental_n1 *x;
+
+  x = avl_find_element(&state->set_n1, &neigh->originator, x, _node);
+  return x != NULL && x->is_mpr;
+}
+
+/**
+ * Add a new N1 element to the incremental state
+ * @param state incremental MPR state
+ * @param neigh NHDP neighbor
+ * @return new N1 element, NULL if out of memory
+ */
+static struct mpr_incremental_n1 *
+_add_n1(struct mpr_incremental_state *state, struct nhdp_neighbor *neigh) {
+  struct mpr_incremental_n1 *x;
+
+  x = calloc(1, sizeof(*x));
+  if (x == NULL) {
+    return NULL;
+  }
+
+  memcpy(&x->addr, &neigh->originator, sizeof(x->addr));
+  avl_init(&x->_edges, avl_comp_netaddr, false);
+
+  x->_node.key = &x->addr;
+  avl_insert(&state->set_n1, &x->_node);
+  return x;
+}
+
+/**
+ * Remove an N1 element and its edges from the incremental state
+ * @param state incremental MPR state
+ * @param x N1 element
+ */
+static void
+_remove_n1(struct mpr_incremental_state *state, struct mpr_incremental_n1 *x) {
+  struct mpr_incremental_edge *edge, *edge_it;
+
+  avl_for_each_element_safe(&x->_edges, edge, _x_node, edge_it) {
+    _remove_edge(state, edge);
+  }
+  avl_remove(&state->set_n1, &x->_node);
+  free(x);
+}
+
+/**
+ * Get an N2 element of the incremental state, create it if necessary
+ * @param state incremental MPR state
+ * @param addr two-hop address
+ * @return N2 element, NULL if out of memory
+ */
+static struct mpr_incremental_n2 *
+_add_n2(struct mpr_incremental_state *state, const struct netaddr *addr) {
+  struct mpr_incremental_n2 *y;
+
+  y = avl_find_element(&state->set_n2, addr, y, _node);
+  if (y) {
+    return y;
+  }
+
+  y = calloc(1, sizeof(*y));
+  if (y == NULL) {
+    return NULL;
+  }
+
+  memcpy(&y->addr, addr, sizeof(y->addr));
+  y->d1 = RFC7181_METRIC_INFINITE;
+  y->min_cost = RFC7181_METRIC_INFINITE_PATH;
+  list_init_head(&y->_edges);
+
+  y->_node.key = &y->addr;
+  avl_insert(&state->set_n2, &y->_node);
+  return y;
+}
+
+/**
+ * Remove an edge from the incremental state
+ * @param state incremental MPR state
+ * @param edge edge between N1 and N2 element
+ */
+static void
+_remove_edge(struct mpr_incremental_state *state, struct mpr_incremental_edge *edge) {
+  _mark_affected(state, edge->y);
+
+  avl_remove(&edge->x->_edges, &edge->_x_node);
+  list_remove(&edge->_y_node);
+  free(edge);
+}
+
+/**
+ * Remember that the coverage of an N2 element has to be checked
+ * @param state incremental MPR state
+ * @param y N2 element
+ */
+static void
+_mark_affected(struct mpr_incremental_state *state, struct mpr_incremental_n2 *y) {
+  if (!y->_affected) {
+    y->_affected = true;
+    list_add_tail(&state->_affected, &y->_affected_node);
+  }
+}
+
+/**
+ * Update d1(x) and the edges of an N1 element from the NHDP database
+ * @param domain NHDP domain
+ * @param state incremental MPR state
+ * @param x N1 element
+ */
+static void
+_refresh_n1(const struct nhdp_domain *domain,
+    struct mpr_incremental_state *state, struct mpr_incremental_n1 *x) {
+  struct nhdp_l2hop_domaindata *l2data;
+  struct mpr_incremental_edge *edge, *edge_it;
+  struct mpr_incremental_n2 *y;
+  struct nhdp_l2hop *l2hop;
+  struct nhdp_link *lnk;
+
+  x->d1 = nhdp_domain_get_neighbordata(domain, x->neigh)->metric.in;
+
+  avl_for_each_element(&x->_edges, edge, _x_node) {
+    edge->_seen = false;
+  }
+
+  list_for_each_element(&x->neigh->_links, lnk, _neigh_node) {
+    avl_for_each_element(&lnk->_2hop, l2hop, _link_node) {
+      l2data = nhdp_domain_get_l2hopdata(domain, l2hop);
+
+      edge = avl_find_element(&x->_edges, &l2hop->twohop_addr, edge, _x_node);
+      if (edge == NULL) {
+        edge = calloc(1, sizeof(*edge));
+        if (edge == NULL) {
+          continue;
+        }
+        y = _add_n2(state, &l2hop->twohop_addr);
+        if (y == NULL) {
+          free(edge);
+          continue;
+        }
+        edge->x = x;
+        edge->y = y;
+        edge->cost = RFC7181_METRIC_INFINITE_PATH;
+
+        edge->_x_node.key = &y->addr;
+        avl_insert(&x->_edges, &edge->_x_node);
+        list_add_tail(&y->_edges, &edge->_y_node);
+        _mark_affected(state, y);
+      }
+
+      if (!edge->_seen) {
+        /* the first link with this two-hop address defines d2(x,y) */
+        edge->_seen = true;
+        edge->_allowed = false;
+        if (x->d1 > RFC7181_METRIC_MAX || l2data->metric.in > RFC7181_METRIC_MAX) {
+          edge->_cost = RFC7181_METRIC_INFINITE_PATH;
+        }
+        else {
+          edge->_cost = x->d1 + l2data->metric.in;
+        }
+      }
+      if (l2data->metric.in <= RFC7181_METRIC_MAX) {
+        edge->_allowed = true;
+      }
+    }
+  }
+
+  avl_for_each_element_safe(&x->_edges, edge, _x_node, edge_it) {
+    if (!edge->_seen) {
+      _remove_edge(state, edge);
+    }
+    else if (edge->cost != edge->_cost || edge->allowed != edge->_allowed) {
+      edge->cost = edge->_cost;
+      edge->allowed = edge->_allowed;
+      _mark_affected(state, edge->y);
+    }
+  }
+}
+
+/**
+ * Calculate d1(y) according to section 18.2
+ * @param state incremental MPR state
+ * @param y N2 element
+ * @return d1(y)
+ */
+static uint32_t
+_calculate_d1_of_y(struct mpr_incremental_state *state, struct mpr_incremental_n2 *y) {
+  struct mpr_incremental_n1 *x;
+  struct nhdp_naddr *naddr;
+
+  naddr = nhdp_db_neighbor_addr_get(&y->addr);
+  if (naddr == NULL) {
+    return RFC7181_METRIC_INFINITE;
+  }
+
+  x = avl_find_element(&state->set_n1, &naddr->neigh->originator, x, _node);
+  if (x == NULL) {
+    return RFC7181_METRIC_INFINITE;
+  }
+  return x->d1;
+}
+
+/**
+ * Recalculate membership in N and the number of MPRs
+ * covering an N2 element with minimal cost
+ * @param y N2 element
+ */
+static void
+_update_coverage(struct mpr_incremental_n2 *y) {
+  struct mpr_incremental_edge *edge;
+  bool allowed;
+
+  allowed = false;
+  y->min_cost = RFC7181_METRIC_INFINITE_PATH;
+  list_for_each_element(&y->_edges, edge, _y_node) {
+    if (edge->allowed) {
+      allowed = true;
+    }
+    if (edge->cost < y->min_cost) {
+      y->min_cost = edge->cost;
+    }
+  }
+
+  y->mpr_count = 0;
+  list_for_each_element(&y->_edges, edge, _y_node) {
+    if (edge->x->is_mpr && edge->cost == y->min_cost) {
+      y->mpr_count++;
+    }
+  }
+
+  /* y is in N if an intermediate hop is better than a direct link */
+  y->in_n = allowed
+      && (y->d1 == RFC7181_METRIC_INFINITE || y->min_cost < y->d1);
+}
+
+/**
+ * Add an N1 element to the MPR set and update the coverage
+ * of its N2 elements
+ * @param x N1 element
+ */
+static void
+_add_mpr(struct mpr_incremental_n1 *x) {
+  struct mpr_incremental_edge *edge;
+#ifdef OONF_LOG_DEBUG_INFO
+  struct netaddr_str nbuf;
+#endif
+
+  OONF_DEBUG(LOG_MPR, "Add %s to the MPR set",
+      netaddr_to_string(&nbuf, &x->addr));
+
+  x->is_mpr = true;
+  avl_for_each_element(&x->_edges, edge, _x_node) {
+    if (edge->cost == edge->y->min_cost) {
+      edge->y->mpr_count++;
+    }
+  }
+}
+
+/**
+ * @param y N2 element
+ * @return true if y is in N and not covered by an MPR with minimal cost
+ */
+static bool
+_is_uncovered(struct mpr_incremental_n2 *y) {
+  return y->in_n && y->mpr_count == 0
+      && y->min_cost < RFC7181_METRIC_INFINITE_PATH;
+}
+
+/**
+ * For each uncovered element y in N for which there is only one
+ * element x in N1 such that d2(x,y) is defined, add x to M.
+ * @param state incremental MPR state
+ */
+static void
+_process_unique_mprs(struct mpr_incremental_state *state) {
+  struct mpr_incremental_edge *edge, *possible_mpr;
+  struct mpr_incremental_n2 *y;
+  uint32_t possible_mprs;
+
+  list_for_each_element(&state->_affected, y, _affected_node) {
+    if (!_is_uncovered(y)) {
+      continue;
+    }
+
+    possible_mprs = 0;
+    possible_mpr = NULL;
+    list_for_each_element(&y->_edges, edge, _y_node) {
+      if (edge->cost < RFC7181_METRIC_INFINITE_PATH) {
+        possible_mprs++;
+        possible_mpr = edge;
+      }
+    }
+    if (possible_mprs == 1) {
+      _add_mpr(possible_mpr->x);
+    }
+  }
+}
+
+/**
+ * While there is an uncovered element in N, add the element x
+ * of N1 with the greatest R(x,M) to M. R(x,M) only needs to be
+ * calculated for the affected N2 elements, all others are still
+ * covered by the existing MPR set.
+ * @param state incremental MPR state
+ */
+static void
+_process_remaining(struct mpr_incremental_state *state) {
+  struct mpr_incremental_n1 *best;
+  struct mpr_incremental_edge *edge;
+  struct mpr_incremental_n2 *y;
+
+  while (true) {
+    list_for_each_element(&state->_affected, y, _affected_node) {
+      list_for_each_element(&y->_edges, edge, _y_node) {
+        edge->x->_r = 0;
+      }
+    }
+
+    /* calculate R(x,M) */
+    list_for_each_element(&state->_affected, y, _affected_node) {
+      if (!_is_uncovered(y)) {
+        continue;
+      }
+      list_for_each_element(&y->_edges, edge, _y_node) {
+        if (!edge->x->is_mpr && edge->cost == y->min_cost) {
+          edge->x->_r++;
+        }
+      }
+    }
+
+    /* select the greatest R(x,M), lowest address on a tie */
+    best = NULL;
+    list_for_each_element(&state->_affected, y, _affected_node) {
+      list_for_each_element(&y->_edges, edge, _y_node) {
+        if (edge->x->_r == 0) {
+          continue;
+        }
+        if (best == NULL || edge->x->_r > best->_r
+            || (edge->x->_r == best->_r
+                && netaddr_cmp(&edge->x->addr, &best->addr) < 0)) {
+          best = edge->x;
+        }
+      }
+    }
+
+    if (best == NULL) {
+      return;
+    }
+    _add_mpr(best);
+  }
+}
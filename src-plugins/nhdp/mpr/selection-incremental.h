@@ -0,0 +1,188 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#ifndef __SELECTION_INCREMENTAL__
+#define __SELECTION_INCREMENTAL__
+
+#include "common/avl.h"
+#include "common/list.h"
+#include "common/netaddr.h"
+#include "nhdp/nhdp_db.h"
+#include "nhdp/nhdp_domain.h"
+
+#include "neighbor-graph.h"
+
+/**
+ * N1 element of the incremental MPR state, keyed by the
+ * originator of the neighbor
+ */
+struct mpr_incremental_n1 {
+  /*! originator address of neighbor */
+  struct netaddr addr;
+
+  /*! NHDP neighbor, only valid during an update */
+  struct nhdp_neighbor *neigh;
+
+  /*! d1(x) */
+  uint32_t d1;
+
+  /*! true if neighbor is selected as MPR */
+  bool is_mpr;
+
+  /*! true if neighbor was found during the current update */
+  bool _seen;
+
+  /*! coverage of the neighbor during the greedy selection */
+  uint32_t _r;
+
+  /*! tree of edges to N2 elements */
+  struct avl_tree _edges;
+
+  /*! node for tree of N1 elements */
+  struct avl_node _node;
+};
+
+/**
+ * N2 element of the incremental MPR state
+ */
+struct mpr_incremental_n2 {
+  /*! two-hop address */
+  struct netaddr addr;
+
+  /*! d1(y) */
+  uint32_t d1;
+
+  /*! minimal d(x,y) over all x in N1 */
+  uint32_t min_cost;
+
+  /*! number of MPRs x with d(x,y) = min_cost */
+  uint32_t mpr_count;
+
+  /*! true if element is part of N */
+  bool in_n;
+
+  /*! true if element is on the list of affected N2 elements */
+  bool _affected;
+
+  /*! list of edges from N1 elements */
+  struct list_entity _edges;
+
+  /*! node for list of affected N2 elements */
+  struct list_entity _affected_node;
+
+  /*! node for tree of N2 elements */
+  struct avl_node _node;
+};
+
+/**
+ * Edge between an N1 and an N2 element
+ */
+struct mpr_incremental_edge {
+  /*! N1 element */
+  struct mpr_incremental_n1 *x;
+
+  /*! N2 element */
+  struct mpr_incremental_n2 *y;
+
+  /*! d(x,y) */
+  uint32_t cost;
+
+  /*! true if the two-hop tuple is allowed, which puts y into N2 */
+  bool allowed;
+
+  /*! true if edge was found during the current update */
+  bool _seen;
+
+  /*! d(x,y) found during the current update */
+  uint32_t _cost;
+
+  /*! allowed state found during the current update */
+  bool _allowed;
+
+  /*! node for edge tree of N1 element */
+  struct avl_node _x_node;
+
+  /*! node for edge list of N2 element */
+  struct list_entity _y_node;
+};
+
+/**
+ * Incremental MPR state of a domain
+ */
+struct mpr_incremental_state {
+  /*! tree of N1 elements */
+  struct avl_tree set_n1;
+
+  /*! tree of N2 elements */
+  struct avl_tree set_n2;
+
+  /*! list of N2 elements touched by the current update */
+  struct list_entity _affected;
+
+  /*! true if the state contains a valid MPR set */
+  bool valid;
+
+  /*! absolute timestamp of the next full recalculation */
+  uint64_t next_full;
+
+  /*! number of incremental updates */
+  uint32_t incremental_count;
+
+  /*! number of full recalculations */
+  uint32_t full_count;
+
+  /*! number of full recalculations that found an invalid MPR set */
+  uint32_t mismatch_count;
+};
+
+void mpr_incremental_init(struct mpr_incremental_state *state);
+void mpr_incremental_clear(struct mpr_incremental_state *state);
+void mpr_incremental_update(const struct nhdp_domain *, struct mpr_incremental_state *state);
+void mpr_incremental_set_mprs(struct mpr_incremental_state *state, struct avl_tree *set_mpr);
+bool mpr_incremental_validate(const struct nhdp_domain *,
+    struct mpr_incremental_state *state, struct neighbor_graph *graph);
+bool mpr_incremental_is_mpr(struct mpr_incremental_state *state, struct nhdp_neighbor *neigh);
+
+#endif
@@ -0,0 +1,361 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+
+#include "common/common_types.h"
+#include "common/avl.h"
+#include "common/netaddr.h"
+#include "core/oonf_logging.h"
+#include "subsystems/oonf_rfc5444.h"
+
+#include "nhdp/nhdp_db.h"
+#include "nhdp/nhdp_domain.h"
+
+#include "mpr/mpr_internal.h"
+#include "mpr/neighbor-graph.h"
+#include "mpr/selection-matrix.h"
+
+/**
+ * Dense representation of a neighbor graph. The cost matrix
+ * stores d(x,y) with one row of |N1| entries for each y in N2,
+ * which makes all minimum and coverage calculations simple loops
+ * over continuous memory.
+ */
+struct _matrix {
+  /*! number of N1 elements (columns) */
+  uint32_t n1_count;
+
+  /*! number of N2 elements (rows) */
+  uint32_t n2_count;
+
+  /*! N1 elements by column index */
+  struct n1_node **n1;
+
+  /*! N2 elements by row index */
+  struct addr_node **n2;
+
+  /*! d(x,y) by row and column, stored in the d_x_y_cache of the graph */
+  uint32_t *cost;
+
+  /*! minimal d(z,y) of each row */
+  uint32_t *min_cost;
+
+  /*! row indices of the elements of N */
+  uint32_t *n;
+
+  /*! number of elements of N */
+  uint32_t n_count;
+
+  /*! true for each row covered by a selected MPR with minimal cost */
+  bool *covered;
+
+  /*! true for each column selected as MPR */
+  bool *selected;
+
+  /*! R(x,M) of each column */
+  uint32_t *r;
+};
+
+static int _matrix_init(const struct nhdp_domain *domain,
+    struct neighbor_graph *graph, struct _matrix *m);
+static void _matrix_free(struct _matrix *m);
+static void _add_mpr(struct neighbor_graph *graph, struct _matrix *m,
+    uint32_t col, bool select);
+static void _process_will_always(const struct nhdp_domain *domain,
+    struct neighbor_graph *graph, struct _matrix *m);
+static void _process_unique_mprs(struct neighbor_graph *graph, struct _matrix *m);
+static void _process_remaining(struct neighbor_graph *graph, struct _matrix *m);
+
+/**
+ * Calculate the MPR set with the algorithm of RFC 7181 Appendix B,
+ * using a dense cost matrix. The result is identical to
+ * mpr_calculate_mpr_rfc7181().
+ * @param domain NHDP domain
+ * @param graph neighbor graph with N1 and N2
+ */
+void
+mpr_calculate_mpr_matrix(const struct nhdp_domain *domain, struct neighbor_graph *graph) {
+  struct _matrix m;
+
+  OONF_DEBUG(LOG_MPR, "Calculate MPR set (matrix)");
+
+  if (_matrix_init(domain, graph, &m)) {
+    OONF_WARN(LOG_MPR, "Out of memory for MPR cost matrix");
+    _matrix_free(&m);
+    return;
+  }
+
+  _process_will_always(domain, graph, &m);
+  _process_unique_mprs(graph, &m);
+  _process_remaining(graph, &m);
+
+  _matrix_free(&m);
+}
+
+/**
+ * Materialize the cost matrix and calculate N
+ * @param domain NHDP domain
+ * @param graph neighbor graph
+ * @param m matrix
+ * @return -1 if out of memory, 0 otherwise
+ */
+static int
+_matrix_init(const struct nhdp_domain *domain,
+    struct neighbor_graph *graph, struct _matrix *m) {
+  struct n1_node *x;
+  struct addr_node *y;
+  uint32_t i, j, d1_y, min, *row;
+
+  memset(m, 0, sizeof(*m));
+  m->n1_count = graph->set_n1.count;
+  m->n2_count = graph->set_n2.count;
+
+  /* same layout as the lazy cache, so the graph methods can use it */
+  graph->d_x_y_cache = calloc((size_t)m->n1_count * m->n2_count + 1, sizeof(uint32_t));
+  m->n1 = calloc(m->n1_count + 1, sizeof(*m->n1));
+  m->n2 = calloc(m->n2_count + 1, sizeof(*m->n2));
+  m->min_cost = calloc(m->n2_count + 1, sizeof(*m->min_cost));
+  m->n = calloc(m->n2_count + 1, sizeof(*m->n));
+  m->covered = calloc(m->n2_count + 1, sizeof(*m->covered));
+  m->selected = calloc(m->n1_count + 1, sizeof(*m->selected));
+  m->r = calloc(m->n1_count + 1, sizeof(*m->r));
+  if (!graph->d_x_y_cache || !m->n1 || !m->n2 || !m->min_cost || !m->n
+      || !m->covered || !m->selected || !m->r) {
+    return -1;
+  }
+  m->cost = graph->d_x_y_cache;
+
+  i = 0;
+  avl_for_each_element(&graph->set_n1, x, _avl_node) {
+    x->table_offset = i;
+    m->n1[i] = x;
+    m->selected[i] = x->neigh->selection_is_mpr;
+    i++;
+  }
+
+  j = 0;
+  avl_for_each_element(&graph->set_n2, y, _avl_node) {
+    y->table_offset = j * m->n1_count;
+    m->n2[j] = y;
+    j++;
+  }
+
+  for (j = 0; j < m->n2_count; j++) {
+    y = m->n2[j];
+    row = &m->cost[y->table_offset];
+
+    /* fill the row, this is the only place calling the graph methods */
+    for (i = 0; i < m->n1_count; i++) {
+      row[i] = graph->methods->calculate_d_x_y(domain, graph, m->n1[i], y);
+    }
+
+    min = RFC7181_METRIC_INFINITE_PATH;
+    for (i = 0; i < m->n1_count; i++) {
+      min = row[i] < min ? row[i] : min;
+    }
+    m->min_cost[j] = min;
+
+    /* y is in N if an intermediate hop is better than a direct link */
+    d1_y = graph->methods->calculate_d1_x_of_n2_addr(domain, graph, y);
+    if (d1_y == RFC7181_METRIC_INFINITE || min < d1_y) {
+      m->n[m->n_count++] = j;
+      mpr_add_addr_node_to_set(&graph->set_n, y->addr, y->table_offset);
+    }
+  }
+  return 0;
+}
+
+/**
+ * Free the matrix, the cost matrix stays in the graph
+ * @param m matrix
+ */
+static void
+_matrix_free(struct _matrix *m) {
+  free(m->n1);
+  free(m->n2);
+  free(m->min_cost);
+  free(m->n);
+  free(m->covered);
+  free(m->selected);
+  free(m->r);
+}
+
+/**
+ * Add an element of N1 to the MPR set
+ * @param graph neighbor graph
+ * @param m matrix
+ * @param col column of N1 element
+ * @param select true to mark the N1 element as selected MPR,
+ *     which is used to calculate the coverage
+ */
+static void
+_add_mpr(struct neighbor_graph *graph, struct _matrix *m, uint32_t col, bool select) {
+  struct n1_node *x;
+  uint32_t k, j;
+
+  x = m->n1[col];
+  mpr_add_n1_node_to_set(&graph->set_mpr, x->neigh, x->link, x->table_offset);
+
+  if (!select || m->selected[col]) {
+    return;
+  }
+
+  x->neigh->selection_is_mpr = true;
+  m->selected[col] = true;
+
+  for (k = 0; k < m->n_count; k++) {
+    j = m->n[k];
+    if (m->cost[j * m->n1_count + col] == m->min_cost[j]) {
+      m->covered[j] = true;
+    }
+  }
+}
+
+/**
+ * Add all elements x in N1 that have W(x) = WILL_ALWAYS to M.
+ * Like the list based selection, this does not mark them as
+ * selected for the coverage calculation.
+ * @param domain NHDP domain
+ * @param graph neighbor graph
+ * @param m matrix
+ */
+static void
+_process_will_always(const struct nhdp_domain *domain,
+    struct neighbor_graph *graph, struct _matrix *m) {
+  uint32_t i;
+
+  for (i = 0; i < m->n1_count; i++) {
+    if (graph->methods->get_willingness_n1(domain, m->n1[i])
+        == RFC7181_WILLINGNESS_ALWAYS) {
+      _add_mpr(graph, m, i, false);
+    }
+  }
+}
+
+/**
+ * For each element y in N for which there is only one element
+ * x in N1 such that d2(x,y) is defined, add that element x to M.
+ * All x in N1 have a defined d1(x), so d2(x,y) is defined
+ * exactly if d(x,y) is.
+ * @param graph neighbor graph
+ * @param m matrix
+ */
+static void
+_process_unique_mprs(struct neighbor_graph *graph, struct _matrix *m) {
+  uint32_t i, j, k, possible_mprs, possible_mpr, *row;
+
+  for (k = 0; k < m->n_count; k++) {
+    j = m->n[k];
+    row = &m->cost[j * m->n1_count];
+
+    possible_mprs = 0;
+    possible_mpr = 0;
+    for (i = 0; i < m->n1_count; i++) {
+      if (row[i] < RFC7181_METRIC_INFINITE_PATH) {
+        possible_mprs++;
+        possible_mpr = i;
+      }
+    }
+
+    if (possible_mprs == 1) {
+      _add_mpr(graph, m, possible_mpr, true);
+    }
+  }
+}
+
+/**
+ * While there exists any element x in N1 with R(x,M) > 0, add the
+ * one with the greatest R(x,M) to M. On a tie the element with the
+ * lowest address wins.
+ * @param graph neighbor graph
+ * @param m matrix
+ */
+static void
+_process_remaining(struct neighbor_graph *graph, struct _matrix *m) {
+  uint32_t i, j, k, min, best, *row;
+
+  /* coverage of the unique MPRs and the ones selected before */
+  for (k = 0; k < m->n_count; k++) {
+    j = m->n[k];
+    row = &m->cost[j * m->n1_count];
+    for (i = 0; i < m->n1_count; i++) {
+      if (m->selected[i] && row[i] == m->min_cost[j]) {
+        m->covered[j] = true;
+        break;
+      }
+    }
+  }
+
+  while (true) {
+    /* calculate R(x,M) for all columns at once */
+    memset(m->r, 0, m->n1_count * sizeof(*m->r));
+    for (k = 0; k < m->n_count; k++) {
+      j = m->n[k];
+      if (m->covered[j]) {
+        continue;
+      }
+
+      row = &m->cost[j * m->n1_count];
+      min = m->min_cost[j];
+      for (i = 0; i < m->n1_count; i++) {
+        m->r[i] += row[i] <= min;
+      }
+    }
+
+    best = m->n1_count;
+    for (i = 0; i < m->n1_count; i++) {
+      if (!m->selected[i] && m->r[i] > 0
+          && (best == m->n1_count || m->r[i] > m->r[best])) {
+        best = i;
+      }
+    }
+
+    if (best == m->n1_count) {
+      return;
+    }
+    _add_mpr(graph, m, best, true);
+  }
+}
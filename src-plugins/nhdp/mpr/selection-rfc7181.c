@@ -211,7 +211,7 @@ _process_will_always(const struct nhdp_domain *domain, struct neighbor_graph *gr
       OONF_DEBUG(LOG_MPR, "Add neighbor %s with WILL_ALWAYS to the MPR set",
           netaddr_to_string(&buf1, &current_n1_node->addr));
       mpr_add_n1_node_to_set(&graph->set_mpr,
-          current_n1_node->link->neigh,
+          current_n1_node->neigh,
           current_n1_node->link, current_n1_node->table_offset);
     }
   }
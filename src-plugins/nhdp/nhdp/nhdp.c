@@ -71,6 +71,9 @@ struct _domain_parameters {
 
   /*! routing willingness */
   int32_t mpr_willingness;
+
+  /*! filter for incoming link metric changes */
+  struct nhdp_domain_metric_filter metric_filter;
 };
 
 /**
@@ -82,6 +85,9 @@ struct _generic_parameters {
 
   /*! routing willingness */
   int32_t mpr_willingness;
+
+  /*! time to collect neighbor changes before recalculating metrics and MPRs */
+  uint64_t change_debounce;
 };
 
 /* prototypes */
@@ -109,6 +115,9 @@ static struct cfg_schema_entry _nhdp_entries[] = {
       RFC7181_WILLINGNESS_DEFAULT_STRING,
       "Flooding willingness for MPR calculation", 0, false,
       RFC7181_WILLINGNESS_MIN, RFC7181_WILLINGNESS_MAX),
+  CFG_MAP_CLOCK(_generic_parameters, change_debounce, "change_debounce", "0.0",
+      "Time to collect neighbor changes before the metrics and MPR sets are"
+      " recalculated, 0 means recalculation in the next time slice."),
 };
 
 static struct cfg_schema_section _nhdp_section = {
@@ -152,6 +161,17 @@ static struct cfg_schema_entry _domain_entries[] = {
   CFG_MAP_INT32_MINMAX(_domain_parameters, mpr_willingness, "willingness",
       RFC7181_WILLINGNESS_DEFAULT_STRING, "Routing willingness used for MPR calculation",
       0, false, RFC7181_WILLINGNESS_MIN, RFC7181_WILLINGNESS_MAX),
+  CFG_MAP_INT32_MINMAX(_domain_parameters, metric_filter.threshold_relative,
+      "metric_threshold_relative", "0",
+      "Minimum relative change of an incoming link metric before it is used for routing",
+      3, false, 0, 1000),
+  CFG_MAP_INT32_MINMAX(_domain_parameters, metric_filter.threshold_absolute,
+      "metric_threshold_absolute", "0",
+      "Minimum absolute change of an incoming link metric before it is used for routing",
+      0, false, 0, RFC7181_METRIC_MAX),
+  CFG_MAP_CLOCK(_domain_parameters, metric_filter.hold_down, "metric_hold_down", "0.0",
+      "Minimum time between two changes of the incoming metric of a link,"
+      " changes from or to an infinite metric are always applied immediately."),
 };
 
 static struct cfg_schema_section _domain_section = {
@@ -379,6 +399,7 @@ _forwarding_selector(struct rfc5444_writer_target *rfc5444_target) {
 static void
 _cb_cfg_domain_changed(void) {
   struct _domain_parameters param;
+  struct nhdp_domain *domain;
   int ext;
 
   OONF_INFO(LOG_NHDP, "Received domain cfg change for name '%s': %s %s",
@@ -394,8 +415,11 @@ _cb_cfg_domain_changed(void) {
     return;
   }
 
-  nhdp_domain_configure(ext, param.metric_name,
+  domain = nhdp_domain_configure(ext, param.metric_name,
       param.mpr_name, param.mpr_willingness);
+  if (domain) {
+    nhdp_domain_set_metric_filter(domain, &param.metric_filter);
+  }
 }
 
 /**
@@ -462,6 +486,7 @@ _cb_cfg_nhdp_changed(void) {
   }
 
   nhdp_domain_set_flooding_mpr(param.flooding_mpr_name, param.mpr_willingness);
+  nhdp_domain_set_change_debounce(param.change_debounce);
 }
 
 /**
@@ -69,6 +69,8 @@ static void _cb_link_heard(struct oonf_timer_instance *);
 static void _cb_link_symtime(struct oonf_timer_instance *);
 static void _cb_l2hop_vtime(struct oonf_timer_instance *);
 static void _cb_naddr_vtime(struct oonf_timer_instance *);
+static void _cb_link_init(void *);
+static void _cb_l2hop_init(void *);
 
 /* Link status names */
 static const char *_LINK_PENDING   = "pending";
@@ -85,6 +87,8 @@ static struct oonf_class _neigh_info = {
 static struct oonf_class _link_info = {
   .name = NHDP_CLASS_LINK,
   .size = sizeof(struct nhdp_link),
+  .slab = true,
+  .init = _cb_link_init,
 };
 
 static struct oonf_class _laddr_info = {
@@ -95,6 +99,7 @@ static struct oonf_class _laddr_info = {
 static struct oonf_class _l2hop_info = {
   .name = NHDP_CLASS_LINK_2HOP,
   .size = sizeof(struct nhdp_l2hop),
+  .init = _cb_l2hop_init,
 };
 
 static struct oonf_class _naddr_info = {
@@ -130,6 +135,9 @@ static struct oonf_timer_class _l2hop_vtime_info = {
 /* global tree of neighbor addresses */
 static struct avl_tree _naddr_tree;
 
+/* hash index of _naddr_tree for fast lookup */
+static struct hash_index _naddr_index;
+
 /* list of neighbors */
 static struct list_entity _neigh_list;
 
@@ -148,6 +156,7 @@ static uint32_t _neighbor_set_id = 0;
 void
 nhdp_db_init(void) {
   avl_init(&_naddr_tree, avl_comp_netaddr, false);
+  hash_index_init(&_naddr_index);
   list_init_head(&_neigh_list);
   avl_init(&_neigh_originator_tree, avl_comp_netaddr, false);
   list_init_head(&_link_list);
@@ -177,6 +186,9 @@ nhdp_db_cleanup(void) {
     nhdp_db_neighbor_remove(neigh);
   }
 
+  /* release neighbor address index */
+  hash_index_free(&_naddr_index);
+
   /* cleanup all timers */
   oonf_timer_remove(&_l2hop_vtime_info);
   oonf_timer_remove(&_link_symtime_info);
@@ -262,6 +274,9 @@ nhdp_db_neighbor_remove(struct nhdp_neighbor *neigh) {
     avl_remove(&_neigh_originator_tree, &neigh->_originator_node);
   }
 
+  /* remove pending metric updates */
+  nhdp_domain_cleanup_neighbor(neigh);
+
   /* remove from global list and free memory */
   list_remove(&neigh->_global_node);
   oonf_class_free(&_neigh_info, neigh);
@@ -363,6 +378,10 @@ nhdp_db_neighbor_addr_add(struct nhdp_neighbor *neigh,
   naddr->_lost_vtime.class = &_naddr_vtime_info;
 
   /* add to trees */
+  if (hash_index_add(&_naddr_index, naddr, netaddr_hash(addr))) {
+    oonf_class_free(&_naddr_info, naddr);
+    return NULL;
+  }
   avl_insert(&_naddr_tree, &naddr->_global_node);
   avl_insert(&neigh->_neigh_addresses, &naddr->_neigh_node);
 
@@ -382,6 +401,7 @@ nhdp_db_neighbor_addr_remove(struct nhdp_naddr *naddr) {
   oonf_class_event(&_naddr_info, naddr, OONF_OBJECT_REMOVED);
 
   /* remove from trees */
+  hash_index_remove(&_naddr_index, naddr, netaddr_hash(&naddr->neigh_addr));
   avl_remove(&_naddr_tree, &naddr->_global_node);
   avl_remove(&naddr->neigh->_neigh_addresses, &naddr->_neigh_node);
 
@@ -537,6 +557,7 @@ nhdp_db_link_add(struct nhdp_neighbor *neigh, struct nhdp_interface *local_if) {
   /* init local trees */
   avl_init(&lnk->_addresses, avl_comp_netaddr, false);
   avl_init(&lnk->_2hop, avl_comp_netaddr, false);
+  hash_index_init(&lnk->_2hop_index);
 
   /* init timers */
   lnk->sym_time.class = &_link_symtime_info;
@@ -658,9 +679,12 @@ nhdp_db_link_addr_add(struct nhdp_link *lnk, const struct netaddr *addr) {
   laddr->link = lnk;
 
   /* add to trees */
+  if (nhdp_interface_add_laddr(laddr)) {
+    oonf_class_free(&_laddr_info, laddr);
+    return NULL;
+  }
   avl_insert(&lnk->_addresses, &laddr->_link_node);
   avl_insert(&lnk->neigh->_link_addresses, &laddr->_neigh_node);
-  nhdp_interface_add_laddr(laddr);
 
   /* trigger event */
   oonf_class_event(&_laddr_info, laddr, OONF_OBJECT_ADDED);
@@ -736,6 +760,10 @@ nhdp_db_link_2hop_add(struct nhdp_link *lnk, const struct netaddr *addr) {
   l2hop->_vtime.class = &_l2hop_vtime_info;
 
   /* add to link tree */
+  if (hash_index_add(&lnk->_2hop_index, l2hop, netaddr_hash(addr))) {
+    oonf_class_free(&_l2hop_info, l2hop);
+    return NULL;
+  }
   avl_insert(&lnk->_2hop, &l2hop->_link_node);
 
   /* add to interface tree */
@@ -760,6 +788,8 @@ nhdp_db_link_2hop_remove(struct nhdp_l2hop *l2hop) {
   oonf_class_event(&_l2hop_info, l2hop, OONF_OBJECT_REMOVED);
 
   /* remove from link tree */
+  hash_index_remove(&l2hop->link->_2hop_index, l2hop,
+      netaddr_hash(&l2hop->twohop_addr));
   avl_remove(&l2hop->link->_2hop, &l2hop->_link_node);
 
   /* remove from interface tree */
@@ -887,6 +917,15 @@ nhdp_db_get_naddr_tree(void) {
   return &_naddr_tree;
 }
 
+/**
+ * get global hash index of nhdp neighbor addresses
+ * @return neighbor address index
+ */
+struct hash_index *
+nhdp_db_get_naddr_index(void) {
+  return &_naddr_index;
+}
+
 /**
  * get global tree of nhdp originators
  * @return originator tree
@@ -1071,3 +1110,23 @@ _cb_l2hop_vtime(struct oonf_timer_instance *ptr) {
   nhdp_db_link_2hop_remove(l2hop);
   nhdp_domain_neighbor_changed(neigh);
 }
+
+/**
+ * Initialize memory of a new NHDP link. The domain data is
+ * initialized by nhdp_domain_init_link() when the link is added.
+ * @param ptr pointer to nhdp link
+ */
+static void
+_cb_link_init(void *ptr) {
+  memset(ptr, 0, offsetof(struct nhdp_link, _domaindata));
+}
+
+/**
+ * Initialize memory of a new NHDP two-hop address. The domain data is
+ * initialized by nhdp_domain_init_l2hop() when the address is added.
+ * @param ptr pointer to nhdp l2hop
+ */
+static void
+_cb_l2hop_init(void *ptr) {
+  memset(ptr, 0, offsetof(struct nhdp_l2hop, _domaindata));
+}
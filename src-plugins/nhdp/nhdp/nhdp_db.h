@@ -53,6 +53,7 @@ struct nhdp_laddr;
 
 #include "common/common_types.h"
 #include "common/avl.h"
+#include "common/hash_index.h"
 #include "common/list.h"
 #include "common/netaddr.h"
 #include "subsystems/oonf_rfc5444.h"
@@ -120,6 +121,15 @@ struct nhdp_link_domaindata {
 
   /*! time when this metric value was changed */
   uint64_t last_metric_change;
+
+  /*! true if an incoming metric has been published for this link */
+  bool metric_published;
+
+  /*! incoming metric waiting for the end of the hold-down time */
+  uint32_t pending_metric_in;
+
+  /*! true if pending_metric_in has not been applied yet */
+  bool metric_pending;
 };
 
 /**
@@ -203,6 +213,9 @@ struct nhdp_link {
   /*! tree of two-hop addresses reachable through the other side of the link */
   struct avl_tree _2hop;
 
+  /*! hash index of the two-hop addresses for fast lookup */
+  struct hash_index _2hop_index;
+
   /*! member entry for global list of nhdp links */
   struct list_entity _global_node;
 
@@ -317,6 +330,9 @@ struct nhdp_neighbor {
   /*! optional member node for global tree of originators */
   struct avl_node _originator_node;
 
+  /*! member entry for list of neighbors waiting for metric recalculation */
+  struct list_entity _dirty_node;
+
   /*! Array of link metrics */
   struct nhdp_neighbor_domaindata _domaindata[NHDP_MAXIMUM_DOMAINS];
 };
@@ -392,6 +408,7 @@ EXPORT const char *nhdp_db_link_status_to_string(struct nhdp_link *);
 EXPORT struct list_entity *nhdp_db_get_neigh_list(void);
 EXPORT struct list_entity *nhdp_db_get_link_list(void);
 EXPORT struct avl_tree *nhdp_db_get_naddr_tree(void);
+EXPORT struct hash_index *nhdp_db_get_naddr_index(void);
 EXPORT struct avl_tree *nhdp_db_get_neigh_originator_tree(void);
 
 /**
@@ -401,7 +418,14 @@ EXPORT struct avl_tree *nhdp_db_get_neigh_originator_tree(void);
 static INLINE struct nhdp_naddr *
 nhdp_db_neighbor_addr_get(const struct netaddr *addr) {
   struct nhdp_naddr *naddr;
-  return avl_find_element(nhdp_db_get_naddr_tree(), addr, naddr, _global_node);
+  size_t pos;
+
+  hash_index_for_each_match(nhdp_db_get_naddr_index(), netaddr_hash(addr), naddr, pos) {
+    if (netaddr_cmp(&naddr->neigh_addr, addr) == 0) {
+      return naddr;
+    }
+  }
+  return NULL;
 }
 
 /**
@@ -433,7 +457,14 @@ nhdp_db_link_addr_get(const struct nhdp_link *lnk, const struct netaddr *addr) {
 static INLINE struct nhdp_l2hop *
 ndhp_db_link_2hop_get(const struct nhdp_link *lnk, const struct netaddr *addr) {
   struct nhdp_l2hop *l2hop;
-  return avl_find_element(&lnk->_2hop, addr, l2hop, _link_node);
+  size_t pos;
+
+  hash_index_for_each_match(&lnk->_2hop_index, netaddr_hash(addr), l2hop, pos) {
+    if (netaddr_cmp(&l2hop->twohop_addr, addr) == 0) {
+      return l2hop;
+    }
+  }
+  return NULL;
 }
 
 /**
@@ -54,6 +54,7 @@
 #include "core/oonf_logging.h"
 #include "subsystems/oonf_class.h"
 #include "subsystems/oonf_rfc5444.h"
+#include "subsystems/oonf_timer.h"
 
 #include "nhdp/nhdp.h"
 #include "nhdp/nhdp_db.h"
@@ -61,6 +62,20 @@
 #include "nhdp/nhdp_interfaces.h"
 #include "nhdp/nhdp_internal.h"
 
+/**
+ * Result of the incoming link metric filter
+ */
+enum _metric_filter_result {
+  /*! metric change should be applied */
+  _METRIC_FILTER_APPLY,
+
+  /*! metric change is below the thresholds */
+  _METRIC_FILTER_SUPPRESS,
+
+  /*! metric change has to wait for the end of the hold-down time */
+  _METRIC_FILTER_DEFER,
+};
+
 static void _apply_metric(struct nhdp_domain *domain, const char *metric_name);
 static void _remove_metric(struct nhdp_domain *);
 static void _apply_mpr(struct nhdp_domain *domain,
@@ -69,6 +84,17 @@ static void _remove_mpr(struct nhdp_domain *);
 
 static void _cb_update_everyone_mpr(void);
 
+static void _trigger_change_flush(void);
+static void _cb_flush_changes(struct oonf_timer_instance *);
+
+static enum _metric_filter_result _filter_metric(struct nhdp_domain *domain,
+    struct nhdp_link_domaindata *linkdata, uint32_t new_metric);
+static void _apply_incoming_metric(struct nhdp_domain *domain,
+    struct nhdp_link_domaindata *linkdata, uint32_t new_metric);
+static void _trigger_hold_down(struct nhdp_domain *domain,
+    struct nhdp_link_domaindata *linkdata);
+static void _cb_hold_down_expired(struct oonf_timer_instance *);
+
 static void _recalculate_neighbor_metric(struct nhdp_domain *domain,
         struct nhdp_neighbor *neigh);
 static const char *_link_to_string(struct nhdp_metric_str *, uint32_t);
@@ -124,6 +150,35 @@ static struct oonf_rfc5444_protocol *_protocol;
 /* remember if node is MPR or not */
 static bool _node_is_selected_as_mpr = false;
 
+/* timer to coalesce neighbor changes into one metric and MPR pass */
+static struct oonf_timer_class _change_timer_info = {
+  .name = "NHDP domain change flush",
+  .callback = _cb_flush_changes,
+};
+
+static struct oonf_timer_instance _change_timer = {
+  .class = &_change_timer_info,
+};
+
+/* neighbors waiting for a metric recalculation */
+static struct list_entity _dirty_neighbors;
+
+/* true if the metrics of all neighbors have to be recalculated */
+static bool _all_neighbors_dirty = false;
+
+/* time between first neighbor change and metric recalculation */
+static uint64_t _change_debounce = 0;
+
+/* timer to apply incoming metric changes delayed by the hold-down time */
+static struct oonf_timer_class _hold_down_timer_info = {
+  .name = "NHDP metric hold-down",
+  .callback = _cb_hold_down_expired,
+};
+
+static struct oonf_timer_instance _hold_down_timer = {
+  .class = &_hold_down_timer_info,
+};
+
 /**
  * Initialize nhdp metric core
  * @param p pointer to rfc5444 protocol
@@ -136,6 +191,10 @@ nhdp_domain_init(struct oonf_rfc5444_protocol *p) {
   list_init_head(&_domain_list);
   list_init_head(&_domain_listener_list);
   list_init_head(&_domain_metric_postprocessor_list);
+  list_init_head(&_dirty_neighbors);
+
+  oonf_timer_add(&_change_timer_info);
+  oonf_timer_add(&_hold_down_timer_info);
 
   avl_init(&_domain_metrics, avl_comp_strcasecmp, false);
   avl_init(&_domain_mprs, avl_comp_strcasecmp, false);
@@ -158,6 +217,11 @@ nhdp_domain_cleanup(void) {
   struct nhdp_domain_metric_postprocessor *processor, *p_it;
   int i;
 
+  oonf_timer_stop(&_change_timer);
+  oonf_timer_remove(&_change_timer_info);
+  oonf_timer_stop(&_hold_down_timer);
+  oonf_timer_remove(&_hold_down_timer_info);
+
   list_for_each_element_safe(&_domain_list, domain, _node, d_it) {
     /* free allocated TLVs */
     for (i=0; i<4; i++) {
@@ -355,7 +419,9 @@ nhdp_domain_init_link(struct nhdp_link *lnk) {
   for (i=0; i<NHDP_MAXIMUM_DOMAINS; i++) {
     lnk->_domaindata[i].metric.in = RFC7181_METRIC_INFINITE;
     lnk->_domaindata[i].metric.out = RFC7181_METRIC_INFINITE;
-    lnk->_domaindata[i].last_metric_change = oonf_clock_getNow();
+    lnk->_domaindata[i].last_metric_change = 0;
+    lnk->_domaindata[i].metric_published = false;
+    lnk->_domaindata[i].metric_pending = false;
   }
   list_for_each_element(&_domain_list, domain, _node) {
     data = nhdp_domain_get_linkdata(domain, lnk);
@@ -409,6 +475,8 @@ nhdp_domain_init_neighbor(struct nhdp_neighbor *neigh) {
   neigh->neigh_is_flooding_mpr = false;
   neigh->selection_is_mpr = false;
 
+  list_init_node(&neigh->_dirty_node);
+
   for (i=0; i<NHDP_MAXIMUM_DOMAINS; i++) {
     neigh->_domaindata[i].metric.in = RFC7181_METRIC_INFINITE;
     neigh->_domaindata[i].metric.out = RFC7181_METRIC_INFINITE;
@@ -483,12 +551,41 @@ nhdp_domain_process_metric_2hoptlv(struct nhdp_domain *domain,
 
 static bool _recalculate_mpr = false;
 
+/**
+ * Remove a NHDP neighbor from the list of pending metric updates
+ * @param neigh NHDP neighbor
+ */
+void
+nhdp_domain_cleanup_neighbor(struct nhdp_neighbor *neigh) {
+  struct nhdp_domain *domain;
+
+  if (list_is_node_added(&neigh->_dirty_node)) {
+    list_remove(&neigh->_dirty_node);
+  }
+
+  /* a removed neighbor always changes the neighborhood */
+  list_for_each_element(&_domain_list, domain, _node) {
+    if (nhdp_domain_get_neighbordata(domain, neigh)->metric.out
+        != RFC7181_METRIC_INFINITE) {
+      domain->neighbor_metric_changed = true;
+      _recalculate_mpr = true;
+    }
+  }
+}
+
+/**
+ * Recalculate the MPR sets of all domains if a neighbor metric
+ * changed since the last calculation. Pending neighbor changes
+ * are flushed first.
+ */
 void
 nhdp_domain_recalculate_mpr(void) {
   struct nhdp_domain_listener *listener;
   struct nhdp_domain *domain;
   struct nhdp_neighbor *neigh;
-  
+
+  nhdp_domain_flush_changes();
+
   if (!_recalculate_mpr) {
     return;
   }
@@ -525,32 +622,69 @@ nhdp_domain_recalculate_mpr(void) {
 }
 /**
  * Neighborhood changed in terms of metrics or connectivity.
- * This will trigger a MPR set recalculation.
+ * This will trigger a metric and MPR set recalculation
+ * for all neighbors.
  */
 void
 nhdp_domain_neighborhood_changed(void) {
-  struct nhdp_domain *domain;
-  struct nhdp_neighbor *neigh;
-
-  list_for_each_element(&_domain_list, domain, _node) {
-    list_for_each_element(nhdp_db_get_neigh_list(), neigh, _global_node) {
-      _recalculate_neighbor_metric(domain, neigh);
-    }
-  }
+  _all_neighbors_dirty = true;
+  _trigger_change_flush();
 }
 
 /**
  * One neighbor changed in terms of metrics or connectivity.
- * This will trigger a MPR set recalculation.
+ * This will trigger a metric and MPR set recalculation.
  * @param neigh neighbor where the changed happened
  */
 void
 nhdp_domain_neighbor_changed(struct nhdp_neighbor *neigh) {
+  if (!_all_neighbors_dirty && !list_is_node_added(&neigh->_dirty_node)) {
+    list_add_tail(&_dirty_neighbors, &neigh->_dirty_node);
+  }
+  _trigger_change_flush();
+}
+
+/**
+ * Recalculate the metrics of all neighbors marked as changed.
+ * Code reading neighbor metrics or the neighbor_metric_changed
+ * flag of a domain should call this first. The MPR recalculation
+ * is still done by the change timer or nhdp_domain_recalculate_mpr().
+ */
+void
+nhdp_domain_flush_changes(void) {
   struct nhdp_domain *domain;
-  
-  list_for_each_element(&_domain_list, domain, _node) {
-    _recalculate_neighbor_metric(domain, neigh);
+  struct nhdp_neighbor *neigh, *n_it;
+
+  if (_all_neighbors_dirty) {
+    list_for_each_element(&_domain_list, domain, _node) {
+      list_for_each_element(nhdp_db_get_neigh_list(), neigh, _global_node) {
+        _recalculate_neighbor_metric(domain, neigh);
+      }
+    }
   }
+  else {
+    list_for_each_element(&_dirty_neighbors, neigh, _dirty_node) {
+      list_for_each_element(&_domain_list, domain, _node) {
+        _recalculate_neighbor_metric(domain, neigh);
+      }
+    }
+  }
+
+  list_for_each_element_safe(&_dirty_neighbors, neigh, _dirty_node, n_it) {
+    list_remove(&neigh->_dirty_node);
+  }
+  _all_neighbors_dirty = false;
+}
+
+/**
+ * Set the time between the first neighbor change and the
+ * coalesced metric/MPR recalculation.
+ * @param debounce debounce interval in milliseconds,
+ *   0 to recalculate in the next time slice
+ */
+void
+nhdp_domain_set_change_debounce(uint64_t debounce) {
+  _change_debounce = debounce;
 }
 
 /**
@@ -851,6 +985,8 @@ nhdp_domain_set_flooding_mpr(const char *mpr_name, uint8_t willingness) {
 /**
  * Sets the incoming metric of a link. This is the only function external
  * code should use to commit the calculated metric values to the nhdp db.
+ * The new value is passed through the metric filter of the domain,
+ * so it might be ignored or applied later.
  * @param metric NHDP domain metric
  * @param lnk NHDP link
  * @param metric_in incoming metric value for NHDP link
@@ -876,16 +1012,89 @@ nhdp_domain_set_incoming_metric(struct nhdp_domain_metric *metric,
         new_metric = processor->process_in_metric(domain, lnk, new_metric);
       }
 
-      if (linkdata->metric.in != new_metric) {
-        changed = true;
-        linkdata->last_metric_change = oonf_clock_getNow();
+      /* a new value replaces an older delayed one */
+      domain->metric_updates++;
+      linkdata->metric_pending = false;
+
+      if (linkdata->metric.in == new_metric) {
+        continue;
+      }
+
+      switch (_filter_metric(domain, linkdata, new_metric)) {
+        case _METRIC_FILTER_SUPPRESS:
+          domain->metric_suppressed++;
+          break;
+        case _METRIC_FILTER_DEFER:
+          domain->metric_deferred++;
+          linkdata->pending_metric_in = new_metric;
+          linkdata->metric_pending = true;
+          _trigger_hold_down(domain, linkdata);
+          break;
+        default:
+          _apply_incoming_metric(domain, linkdata, new_metric);
+          changed = true;
+          break;
+      }
+    }
+  }
+  return changed;
+}
+
+/**
+ * Calculates and sets the incoming metric of multiple links with
+ * the batch callback of the metric. Neighbors with a changed metric
+ * are collected for a single metric and MPR recalculation.
+ * @param metric NHDP domain metric
+ * @param links array of NHDP links
+ * @param samples array of metric specific link samples, one for each link
+ * @param count number of links
+ * @return number of links with a changed incoming metric
+ */
+size_t
+nhdp_domain_calculate_incoming_metrics(struct nhdp_domain_metric *metric,
+    struct nhdp_link **links, const void *samples, size_t count) {
+  uint32_t costs[NHDP_DOMAIN_METRIC_BATCH_SIZE];
+  const uint8_t *sample_ptr;
+  size_t i, j, chunk, changed;
+
+  sample_ptr = samples;
+  changed = 0;
+
+  for (i = 0; i < count; i += chunk) {
+    chunk = count - i;
+    if (chunk > NHDP_DOMAIN_METRIC_BATCH_SIZE) {
+      chunk = NHDP_DOMAIN_METRIC_BATCH_SIZE;
+    }
+
+    metric->calculate_batch(costs, sample_ptr, chunk);
+    sample_ptr += chunk * metric->batch_sample_size;
+
+    for (j = 0; j < chunk; j++) {
+      if (nhdp_domain_set_incoming_metric(metric, links[i + j], costs[j])) {
+        nhdp_domain_neighbor_changed(links[i + j]->neigh);
+        changed++;
       }
-      linkdata->metric.in = new_metric;
     }
   }
   return changed;
 }
 
+/**
+ * Set the filter for incoming link metric changes of a domain
+ * @param domain NHDP domain
+ * @param filter new metric filter settings
+ */
+void
+nhdp_domain_set_metric_filter(struct nhdp_domain *domain,
+    const struct nhdp_domain_metric_filter *filter) {
+  memcpy(&domain->metric_filter, filter, sizeof(*filter));
+
+  if (oonf_timer_is_active(&_hold_down_timer)) {
+    /* re-evaluate delayed metric changes with the new hold-down time */
+    oonf_timer_set(&_hold_down_timer, 1);
+  }
+}
+
 /**
  * get list of nhdp domains
  * @return domain list
@@ -913,6 +1122,146 @@ nhdp_domain_get_flooding(void) {
   return &_flooding_domain;
 }
 
+/**
+ * Start the change timer if not already running
+ */
+static void
+_trigger_change_flush(void) {
+  if (!oonf_timer_is_active(&_change_timer)) {
+    /* 1 means "trigger as soon as we hit the next time slice" */
+    oonf_timer_set(&_change_timer, _change_debounce > 0 ? _change_debounce : 1);
+  }
+}
+
+/**
+ * Callback for change timer, does one metric and one MPR pass
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_flush_changes(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  nhdp_domain_recalculate_mpr();
+}
+
+/**
+ * Check if a new incoming link metric is significant enough
+ * to be applied.
+ * @param domain NHDP domain
+ * @param linkdata domain data of NHDP link
+ * @param new_metric new incoming link metric
+ * @return filter result
+ */
+static enum _metric_filter_result
+_filter_metric(struct nhdp_domain *domain,
+    struct nhdp_link_domaindata *linkdata, uint32_t new_metric) {
+  const struct nhdp_domain_metric_filter *filter;
+  uint32_t old_metric;
+  uint64_t delta;
+
+  filter = &domain->metric_filter;
+  old_metric = linkdata->metric.in;
+
+  if (old_metric == RFC7181_METRIC_INFINITE
+      || new_metric == RFC7181_METRIC_INFINITE) {
+    /* link became usable or unusable */
+    return _METRIC_FILTER_APPLY;
+  }
+
+  delta = new_metric > old_metric
+      ? new_metric - old_metric : old_metric - new_metric;
+  if (delta < (uint64_t)filter->threshold_absolute
+      || delta * 1000 < (uint64_t)old_metric * filter->threshold_relative) {
+    return _METRIC_FILTER_SUPPRESS;
+  }
+
+  if (filter->hold_down > 0 && linkdata->metric_published
+      && oonf_clock_get_relative(
+      linkdata->last_metric_change + filter->hold_down) > 0) {
+    return _METRIC_FILTER_DEFER;
+  }
+  return _METRIC_FILTER_APPLY;
+}
+
+/**
+ * Apply a new incoming link metric
+ * @param domain NHDP domain
+ * @param linkdata domain data of NHDP link
+ * @param new_metric new incoming link metric
+ */
+static void
+_apply_incoming_metric(struct nhdp_domain *domain,
+    struct nhdp_link_domaindata *linkdata, uint32_t new_metric) {
+  domain->metric_changes++;
+  linkdata->metric.in = new_metric;
+  linkdata->last_metric_change = oonf_clock_getNow();
+  linkdata->metric_published = true;
+}
+
+/**
+ * Make sure the hold-down timer fires when the hold-down time
+ * of a delayed incoming link metric is over.
+ * @param domain NHDP domain
+ * @param linkdata domain data of NHDP link
+ */
+static void
+_trigger_hold_down(struct nhdp_domain *domain,
+    struct nhdp_link_domaindata *linkdata) {
+  int64_t due;
+
+  due = oonf_clock_get_relative(
+      linkdata->last_metric_change + domain->metric_filter.hold_down);
+  if (due < 1) {
+    /* 1 means "trigger as soon as we hit the next time slice" */
+    due = 1;
+  }
+
+  if (!oonf_timer_is_active(&_hold_down_timer)
+      || oonf_timer_get_due(&_hold_down_timer) > due) {
+    oonf_timer_set(&_hold_down_timer, due);
+  }
+}
+
+/**
+ * Callback for hold-down timer, applies all delayed incoming
+ * link metrics with an expired hold-down time.
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_hold_down_expired(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  struct nhdp_link_domaindata *linkdata;
+  struct nhdp_domain *domain;
+  struct nhdp_link *lnk;
+  bool changed;
+
+  changed = false;
+  list_for_each_element(nhdp_db_get_link_list(), lnk, _global_node) {
+    list_for_each_element(&_domain_list, domain, _node) {
+      linkdata = nhdp_domain_get_linkdata(domain, lnk);
+      if (!linkdata->metric_pending) {
+        continue;
+      }
+
+      switch (_filter_metric(domain, linkdata, linkdata->pending_metric_in)) {
+        case _METRIC_FILTER_DEFER:
+          _trigger_hold_down(domain, linkdata);
+          break;
+        case _METRIC_FILTER_SUPPRESS:
+          /* filter settings changed */
+          linkdata->metric_pending = false;
+          break;
+        default:
+          linkdata->metric_pending = false;
+          _apply_incoming_metric(domain, linkdata, linkdata->pending_metric_in);
+          changed = true;
+          break;
+      }
+    }
+  }
+
+  if (changed) {
+    nhdp_domain_neighborhood_changed();
+  }
+}
+
 /**
  * Recalculate the 'best link/metric' values of a neighbor
  * @param domain NHDP domain
@@ -65,6 +65,9 @@ enum {
 
   /*! maximum length of mpr name */
   NHDP_DOMAIN_MPR_MAXLEN = 16,
+
+  /*! number of links calculated by one call of a batch metric callback */
+  NHDP_DOMAIN_METRIC_BATCH_SIZE = 64,
 };
 
 /**
@@ -131,6 +134,18 @@ struct nhdp_domain_metric {
   const char *(*internal_link_to_string)(
       struct nhdp_metric_str *buf, struct nhdp_link *lnk);
 
+  /*! size of a metric specific link sample for calculate_batch */
+  size_t batch_sample_size;
+
+  /**
+   * callback to calculate the incoming link metric of multiple links,
+   * called by nhdp_domain_calculate_incoming_metrics()
+   * @param costs array for the calculated incoming link metrics
+   * @param samples array of metric specific link samples
+   * @param count number of links, at most NHDP_DOMAIN_METRIC_BATCH_SIZE
+   */
+  void (*calculate_batch)(uint32_t *costs, const void *samples, size_t count);
+
   /**
    * callback to enable metric
    */
@@ -177,6 +192,24 @@ struct nhdp_domain_mpr {
   struct avl_node _node;
 };
 
+/**
+ * Significance filter between the incoming link metric calculated
+ * by a metric plugin and the value used for routing. A metric change
+ * is only applied if it exceeds both thresholds and the hold-down
+ * time since the last applied change has elapsed. Changes from or
+ * to an infinite metric are always applied immediately.
+ */
+struct nhdp_domain_metric_filter {
+  /*! minimum relative metric change in 1/1000 of the current metric */
+  int32_t threshold_relative;
+
+  /*! minimum absolute metric change */
+  int32_t threshold_absolute;
+
+  /*! minimum time between two applied metric changes of a link */
+  uint64_t hold_down;
+};
+
 /**
  * NHDP domain
  *
@@ -212,6 +245,21 @@ struct nhdp_domain {
   /*! index in the domain array */
   int index;
 
+  /*! filter for incoming link metric changes */
+  struct nhdp_domain_metric_filter metric_filter;
+
+  /*! number of incoming link metric values reported by the metric */
+  uint64_t metric_updates;
+
+  /*! number of incoming link metric changes applied */
+  uint64_t metric_changes;
+
+  /*! number of incoming link metric changes below the thresholds */
+  uint64_t metric_suppressed;
+
+  /*! number of incoming link metric changes delayed by the hold-down time */
+  uint64_t metric_deferred;
+
   /*! temporary storage for willingness processing */
   uint8_t _tmp_willingness;
 
@@ -280,6 +328,7 @@ EXPORT struct nhdp_domain *nhdp_domain_get_by_ext(uint8_t);
 EXPORT void nhdp_domain_init_link(struct nhdp_link *);
 EXPORT void nhdp_domain_init_l2hop(struct nhdp_l2hop *);
 EXPORT void nhdp_domain_init_neighbor(struct nhdp_neighbor *);
+EXPORT void nhdp_domain_cleanup_neighbor(struct nhdp_neighbor *);
 
 EXPORT void nhdp_domain_process_metric_linktlv(struct nhdp_domain *,
     struct nhdp_link *lnk, const uint8_t *value);
@@ -289,6 +338,8 @@ EXPORT void nhdp_domain_process_metric_2hoptlv(struct nhdp_domain *d,
 EXPORT void nhdp_domain_recalculate_mpr(void);
 EXPORT void nhdp_domain_neighborhood_changed(void);
 EXPORT void nhdp_domain_neighbor_changed(struct nhdp_neighbor *neigh);
+EXPORT void nhdp_domain_flush_changes(void);
+EXPORT void nhdp_domain_set_change_debounce(uint64_t debounce);
 EXPORT bool nhdp_domain_node_is_mpr(void);
 
 EXPORT size_t nhdp_domain_process_mprtypes_tlv(
@@ -309,6 +360,11 @@ EXPORT size_t nhdp_domain_encode_willingness_tlvvalue(
 
 EXPORT bool nhdp_domain_set_incoming_metric(
     struct nhdp_domain_metric *metric, struct nhdp_link *lnk, uint32_t metric_in);
+EXPORT size_t nhdp_domain_calculate_incoming_metrics(
+    struct nhdp_domain_metric *metric, struct nhdp_link **links,
+    const void *samples, size_t count);
+EXPORT void nhdp_domain_set_metric_filter(struct nhdp_domain *domain,
+    const struct nhdp_domain_metric_filter *filter);
 
 EXPORT struct list_entity *nhdp_domain_get_list(void);
 EXPORT struct list_entity *nhdp_domain_get_listener_list(void);
@@ -246,6 +246,7 @@ nhdp_interface_add(const char *name) {
 
     /* init link address tree */
     avl_init(&interf->_link_addresses, avl_comp_netaddr, false);
+    hash_index_init(&interf->_link_address_index);
 
     /*
      * init originator tree
@@ -311,6 +312,9 @@ nhdp_interface_remove(struct nhdp_interface *interf) {
   /* remove first from tree because we use the interface name as a key */
   avl_remove(&_interface_tree, &interf->_node);
 
+  /* release link address index */
+  hash_index_free(&interf->_link_address_index);
+
   /* now clean up the rest */
   os_interface_remove(&interf->os_if_listener);
   oonf_rfc5444_remove_interface(interf->rfc5444_if.interface, &interf->rfc5444_if);
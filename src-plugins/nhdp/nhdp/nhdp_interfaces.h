@@ -52,6 +52,7 @@ struct nhdp_interface_domaindata;
 
 #include "common/common_types.h"
 #include "common/avl.h"
+#include "common/hash_index.h"
 #include "common/list.h"
 #include "common/netaddr.h"
 #include "common/netaddr_acl.h"
@@ -132,6 +133,9 @@ struct nhdp_interface {
   /*! tree of addresses of links (nhdp_laddr objects) */
   struct avl_tree _link_addresses;
 
+  /*! hash index of _link_addresses for fast lookup */
+  struct hash_index _link_address_index;
+
   /*! tree of originator addresses of links (nhdp_link objects) */
   struct avl_tree _link_originators;
 
@@ -275,10 +279,18 @@ nhdp_interface_remove_l2hop(struct nhdp_l2hop *twohop) {
 /**
  * Attach a link address to the local nhdp interface
  * @param laddr
+ * @return -1 if out of memory, 0 otherwise
  */
-static INLINE void
+static INLINE int
 nhdp_interface_add_laddr(struct nhdp_laddr *laddr) {
-  avl_insert(&laddr->link->local_if->_link_addresses, &laddr->_if_node);
+  struct nhdp_interface *interf = laddr->link->local_if;
+
+  if (hash_index_add(&interf->_link_address_index, laddr,
+      netaddr_hash(&laddr->link_addr))) {
+    return -1;
+  }
+  avl_insert(&interf->_link_addresses, &laddr->_if_node);
+  return 0;
 }
 
 /**
@@ -287,7 +299,11 @@ nhdp_interface_add_laddr(struct nhdp_laddr *laddr) {
  */
 static INLINE void
 nhdp_interface_remove_laddr(struct nhdp_laddr *laddr) {
-  avl_remove(&laddr->link->local_if->_link_addresses, &laddr->_if_node);
+  struct nhdp_interface *interf = laddr->link->local_if;
+
+  hash_index_remove(&interf->_link_address_index, laddr,
+      netaddr_hash(&laddr->link_addr));
+  avl_remove(&interf->_link_addresses, &laddr->_if_node);
 }
 
 /**
@@ -298,8 +314,14 @@ nhdp_interface_remove_laddr(struct nhdp_laddr *laddr) {
 static INLINE struct nhdp_laddr *
 nhdp_interface_get_link_addr(const struct nhdp_interface *interf, const struct netaddr *addr) {
   struct nhdp_laddr *laddr;
+  size_t pos;
 
-  return avl_find_element(&interf->_link_addresses, addr, laddr, _if_node);
+  hash_index_for_each_match(&interf->_link_address_index, netaddr_hash(addr), laddr, pos) {
+    if (netaddr_cmp(&laddr->link_addr, addr) == 0) {
+      return laddr;
+    }
+  }
+  return NULL;
 }
 
 /**
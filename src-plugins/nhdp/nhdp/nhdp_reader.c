@@ -881,7 +881,7 @@ static enum rfc5444_result
 _cb_msg_pass2_end(struct rfc5444_reader_tlvblock_context *context, bool dropped) {
   struct nhdp_naddr *naddr;
   struct nhdp_laddr *laddr, *la_it;
-  struct nhdp_l2hop *twohop, *twohop_it;
+  struct nhdp_l2hop *twohop;
   uint64_t t;
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str nbuf;
@@ -906,15 +906,8 @@ _cb_msg_pass2_end(struct rfc5444_reader_tlvblock_context *context, bool dropped)
       nhdp_db_neighbor_addr_set_lost(naddr, _current.localif->n_hold_time);
 
       /* section 12.6.1: remove all similar n2 addresses */
-      // TODO: not nice, replace with new iteration macro
-      twohop_it = avl_find_element(&_current.link->_2hop, &naddr->neigh_addr, twohop_it, _link_node);
-      while (twohop_it) {
-        twohop = twohop_it;
-        twohop_it = avl_next_element_safe(&_current.link->_2hop, twohop_it, _link_node);
-        if (twohop_it != NULL && !twohop_it->_link_node.follower) {
-          twohop_it = NULL;
-        }
-
+      twohop = ndhp_db_link_2hop_get(_current.link, &naddr->neigh_addr);
+      if (twohop) {
         nhdp_db_link_2hop_remove(twohop);
       }
     }
@@ -72,6 +72,7 @@ static enum oonf_telnet_result _cb_nhdpinfo_help(struct oonf_telnet_data *con);
 static void _initialize_interface_values(struct nhdp_interface *nhdp_if);
 static void _initialize_interface_address_values(struct nhdp_interface_addr *if_addr);
 static void _initialize_nhdp_link_values(struct nhdp_link *lnk);
+static void _initialize_nhdp_domain_values(struct nhdp_domain *domain);
 static void _initialize_nhdp_domain_metric_values(struct nhdp_domain *domain,
     struct nhdp_metric *metric);
 static void _initialize_nhdp_neighbor_mpr_values(struct nhdp_domain *domain,
@@ -90,6 +91,7 @@ static int _cb_create_text_link_address(struct oonf_viewer_template *);
 static int _cb_create_text_link_twohop(struct oonf_viewer_template *);
 static int _cb_create_text_neighbor(struct oonf_viewer_template *);
 static int _cb_create_text_neighbor_address(struct oonf_viewer_template *);
+static int _cb_create_text_domain(struct oonf_viewer_template *);
 
 /*
  * list of template keys and corresponding buffers for values.
@@ -217,6 +219,18 @@ static int _cb_create_text_neighbor_address(struct oonf_viewer_template *);
 /*! template key for internal metric representation */
 #define KEY_DOMAIN_METRIC_INTERNAL  "domain_metric_internal"
 
+/*! template key for number of incoming link metric values of a domain */
+#define KEY_DOMAIN_METRIC_UPDATES   "domain_metric_updates"
+
+/*! template key for number of applied incoming link metric changes of a domain */
+#define KEY_DOMAIN_METRIC_CHANGES   "domain_metric_changes"
+
+/*! template key for number of incoming link metric changes below the thresholds */
+#define KEY_DOMAIN_METRIC_SUPPRESSED "domain_metric_suppressed"
+
+/*! template key for number of incoming link metric changes delayed by hold-down */
+#define KEY_DOMAIN_METRIC_DEFERRED  "domain_metric_deferred"
+
 /*! template key for NHDP domain MPR name */
 #define KEY_DOMAIN_MPR              "domain_mpr"
 
@@ -278,6 +292,10 @@ static struct nhdp_metric_str     _value_domain_metric_out;
 static char                       _value_domain_metric_in_raw[12];
 static char                       _value_domain_metric_out_raw[12];
 static struct nhdp_metric_str     _value_domain_metric_internal;
+static char                       _value_domain_metric_updates[21];
+static char                       _value_domain_metric_changes[21];
+static char                       _value_domain_metric_suppressed[21];
+static char                       _value_domain_metric_deferred[21];
 static char                       _value_domain_mpr[NHDP_DOMAIN_MPR_MAXLEN];
 static char                       _value_domain_mpr_local[TEMPLATE_JSON_BOOL_LENGTH];
 static char                       _value_domain_mpr_remote[TEMPLATE_JSON_BOOL_LENGTH];
@@ -339,6 +357,15 @@ static struct abuf_template_data_entry _tde_domain_metric_int[] = {
     { KEY_DOMAIN_METRIC_INTERNAL, _value_domain_metric_internal.buf, true },
 };
 
+static struct abuf_template_data_entry _tde_domain_filter[] = {
+    { KEY_DOMAIN_METRIC, _value_domain_metric, true },
+    { KEY_DOMAIN_MPR, _value_domain_mpr, true },
+    { KEY_DOMAIN_METRIC_UPDATES, _value_domain_metric_updates, false },
+    { KEY_DOMAIN_METRIC_CHANGES, _value_domain_metric_changes, false },
+    { KEY_DOMAIN_METRIC_SUPPRESSED, _value_domain_metric_suppressed, false },
+    { KEY_DOMAIN_METRIC_DEFERRED, _value_domain_metric_deferred, false },
+};
+
 static struct abuf_template_data_entry _tde_domain_mpr[] = {
     { KEY_DOMAIN_MPR, _value_domain_mpr, true },
     { KEY_DOMAIN_MPR_LOCAL, _value_domain_mpr_local, true },
@@ -414,6 +441,10 @@ static struct abuf_template_data _td_neigh_addr[] = {
     { _tde_neigh_key, ARRAYSIZE(_tde_neigh_key) },
     { _tde_neigh_addr, ARRAYSIZE(_tde_neigh_addr) },
 };
+static struct abuf_template_data _td_domain[] = {
+    { _tde_domain, ARRAYSIZE(_tde_domain) },
+    { _tde_domain_filter, ARRAYSIZE(_tde_domain_filter) },
+};
 
 /* OONF viewer templates (based on Template Data arrays) */
 static struct oonf_viewer_template _templates[] = {
@@ -458,6 +489,12 @@ static struct oonf_viewer_template _templates[] = {
         .data_size = ARRAYSIZE(_td_neigh_addr),
         .json_name = "neighbor_addr",
         .cb_function = _cb_create_text_neighbor_address,
+    },
+    {
+        .data = _td_domain,
+        .data_size = ARRAYSIZE(_td_domain),
+        .json_name = "domain",
+        .cb_function = _cb_create_text_domain,
     }
 };
 
@@ -510,6 +547,9 @@ _cleanup(void) {
  */
 static enum oonf_telnet_result
 _cb_nhdpinfo(struct oonf_telnet_data *con) {
+  /* apply pending metric and MPR changes before printing them */
+  nhdp_domain_recalculate_mpr();
+
   return oonf_viewer_telnet_handler(con->out, &_template_storage,
       OONF_NHDPINFO_SUBSYSTEM, con->parameter,
       _templates, ARRAYSIZE(_templates));
@@ -639,6 +679,26 @@ _initialize_nhdp_domain_metric_values(struct nhdp_domain *domain,
       sizeof(_value_domain_metric_out_raw), "%u", metric->out);
 }
 
+/**
+ * Initialize the value buffers for the metric filter statistics of a NHDP domain
+ * @param domain NHDP domain
+ */
+static void
+_initialize_nhdp_domain_values(struct nhdp_domain *domain) {
+  snprintf(_value_domain, sizeof(_value_domain), "%u", domain->ext);
+  strscpy(_value_domain_metric, domain->metric->name, sizeof(_value_domain_metric));
+  strscpy(_value_domain_mpr, domain->mpr->name, sizeof(_value_domain_mpr));
+
+  snprintf(_value_domain_metric_updates,
+      sizeof(_value_domain_metric_updates), "%"PRIu64, domain->metric_updates);
+  snprintf(_value_domain_metric_changes,
+      sizeof(_value_domain_metric_changes), "%"PRIu64, domain->metric_changes);
+  snprintf(_value_domain_metric_suppressed,
+      sizeof(_value_domain_metric_suppressed), "%"PRIu64, domain->metric_suppressed);
+  snprintf(_value_domain_metric_deferred,
+      sizeof(_value_domain_metric_deferred), "%"PRIu64, domain->metric_deferred);
+}
+
 /**
  * Initialize the value buffers for a NHDP domain MPR values
  * @param domain NHDP domain
@@ -932,3 +992,21 @@ _cb_create_text_neighbor_address(struct oonf_viewer_template *template) {
   }
   return 0;
 }
+
+/**
+ * Displays the metric filter statistics of all NHDP domains.
+ * @param template oonf viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_domain(struct oonf_viewer_template *template) {
+  struct nhdp_domain *domain;
+
+  list_for_each_element(nhdp_domain_get_list(), domain, _node) {
+    _initialize_nhdp_domain_values(domain);
+
+    /* generate template output */
+    oonf_viewer_output_print_line(template);
+  }
+  return 0;
+}
@@ -1065,6 +1065,9 @@ _cb_netjsoninfo(struct oonf_telnet_data *con) {
 
   json_init_session(&session, &out);
 
+  /* apply pending metric and MPR changes before printing them */
+  nhdp_domain_recalculate_mpr();
+
   next = con->parameter;
   if (next && *next) {
     if ((ptr = str_hasnextword(next, JSON_NAME_FILTER))) {
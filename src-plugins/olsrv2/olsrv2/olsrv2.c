@@ -540,6 +540,9 @@ olsrv2_update_ansn(bool force) {
   struct nhdp_domain *domain;
   bool changed;
 
+  /* make sure all neighbor metrics are up to date */
+  nhdp_domain_flush_changes();
+
   changed = false;
   list_for_each_element(nhdp_domain_get_list(), domain, _node) {
     if (domain->neighbor_metric_changed) {
@@ -98,6 +98,7 @@ static struct olsrv2_routing_domain _domain_parameter[NHDP_MAXIMUM_DOMAINS];
 static struct oonf_class _rtset_entry = {
   .name = "Olsrv2 Routing Set Entry",
   .size = sizeof(struct olsrv2_routing_entry),
+  .slab = true,
 };
 
 /* rate limitation for dijkstra algorithm */
@@ -275,6 +276,9 @@ olsrv2_routing_force_update(bool skip_wait) {
 
   OONF_DEBUG(LOG_OLSRV2_ROUTING, "Run Dijkstra");
 
+  /* make sure all neighbor metrics are up to date */
+  nhdp_domain_flush_changes();
+
   list_for_each_element(nhdp_domain_get_list(), domain, _node) {
     /* initialize dijkstra specific fields */
     _prepare_routes(domain);
@@ -43,6 +43,8 @@
  * @file
  */
 
+#include <stdlib.h>
+
 #include "common/avl.h"
 #include "common/avl_comp.h"
 #include "common/common_types.h"
@@ -59,6 +61,12 @@
 
 /* prototypes */
 static void _cb_tc_node_timeout(struct oonf_timer_instance *);
+static void _cb_tc_node_pressure(struct oonf_class *, uint32_t);
+static void _cb_tc_endpoint_pressure(struct oonf_class *, uint32_t);
+static void _cb_tc_evict(struct oonf_timer_instance *);
+static bool _evict_endpoints(uint32_t count);
+static bool _evict_nodes(uint32_t count);
+static int _cb_compare_target_distance(const void *, const void *);
 static bool _remove_edge(struct olsrv2_tc_edge *edge, bool cleanup);
 
 static void _cb_neighbor_change(void *ptr);
@@ -68,11 +76,13 @@ static void _cb_neighbor_remove(void *ptr);
 static struct oonf_class _tc_node_class = {
   .name = OLSRV2_CLASS_TC_NODE,
   .size = sizeof(struct olsrv2_tc_node),
+  .cb_pressure = _cb_tc_node_pressure,
 };
 
 static struct oonf_class _tc_edge_class = {
   .name = OLSRV2_CLASS_TC_EDGE,
   .size = sizeof(struct olsrv2_tc_edge),
+  .slab = true,
 };
 
 static struct oonf_class _tc_attached_class = {
@@ -83,6 +93,7 @@ static struct oonf_class _tc_attached_class = {
 static struct oonf_class _tc_endpoint_class = {
   .name = OLSRV2_CLASS_ENDPOINT,
   .size = sizeof(struct olsrv2_tc_endpoint),
+  .cb_pressure = _cb_tc_endpoint_pressure,
 };
 
 /* keep track of direct neighbors */
@@ -99,6 +110,20 @@ static struct oonf_timer_class _validity_info = {
   .callback = _cb_tc_node_timeout,
 };
 
+/* delayed removal of tc nodes and endpoints because of memory pressure */
+static struct oonf_timer_class _evict_info = {
+  .name = "olsrv2 tc eviction",
+  .callback = _cb_tc_evict,
+};
+
+static struct oonf_timer_instance _evict_timer = {
+  .class = &_evict_info,
+};
+
+/* number of tc nodes and endpoints that should be removed */
+static uint32_t _evict_node_count;
+static uint32_t _evict_endpoint_count;
+
 /* global trees for tc nodes and endpoints */
 static struct avl_tree _tc_tree;
 static struct avl_tree _tc_endpoint_tree;
@@ -112,6 +137,7 @@ olsrv2_tc_init(void) {
   oonf_class_add(&_tc_edge_class);
   oonf_class_add(&_tc_attached_class);
   oonf_class_add(&_tc_endpoint_class);
+  oonf_timer_add(&_evict_info);
 
   oonf_class_extension_add(&_nhdp_neighbor_extension);
 
@@ -128,6 +154,8 @@ olsrv2_tc_cleanup(void) {
   struct olsrv2_tc_edge *edge, *e_it;
   struct olsrv2_tc_attachment *a_end, *ae_it;
 
+  oonf_timer_stop(&_evict_timer);
+
   avl_for_each_element(&_tc_tree, node, _originator_node) {
     avl_for_each_element_safe(&node->_edges, edge, _node, e_it) {
       /* remove edge without cleaning up the node */
@@ -149,6 +177,7 @@ olsrv2_tc_cleanup(void) {
   oonf_class_remove(&_tc_attached_class);
   oonf_class_remove(&_tc_edge_class);
   oonf_class_remove(&_tc_node_class);
+  oonf_timer_remove(&_evict_info);
 }
 
 /**
@@ -570,3 +599,166 @@ _cb_neighbor_remove(void *ptr) {
     olsrv2_tc_node_remove(tc_node);
   }
 }
+
+/**
+ * Callback for memory pressure of tc node class. The caller of
+ * oonf_class_malloc() might still use a tc node, so the nodes are
+ * removed by a timer.
+ * @param cl tc node class
+ * @param count number of nodes to remove
+ */
+static void
+_cb_tc_node_pressure(struct oonf_class *cl __attribute__((unused)), uint32_t count) {
+  if (count > _evict_node_count) {
+    _evict_node_count = count;
+  }
+  if (!oonf_timer_is_active(&_evict_timer)) {
+    oonf_timer_set(&_evict_timer, 1);
+  }
+}
+
+/**
+ * Callback for memory pressure of tc endpoint class. Endpoints
+ * are removed by the same timer as the tc nodes.
+ * @param cl tc endpoint class
+ * @param count number of endpoints to remove
+ */
+static void
+_cb_tc_endpoint_pressure(struct oonf_class *cl __attribute__((unused)), uint32_t count) {
+  if (count > _evict_endpoint_count) {
+    _evict_endpoint_count = count;
+  }
+  if (!oonf_timer_is_active(&_evict_timer)) {
+    oonf_timer_set(&_evict_timer, 1);
+  }
+}
+
+/**
+ * Callback to remove tc endpoints and nodes because of memory pressure.
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_tc_evict(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  bool changed;
+
+  changed = _evict_endpoints(_evict_endpoint_count);
+  changed |= _evict_nodes(_evict_node_count);
+
+  _evict_endpoint_count = 0;
+  _evict_node_count = 0;
+
+  if (changed) {
+    olsrv2_routing_trigger_update();
+  }
+}
+
+/**
+ * Remove tc endpoints farthest away (by the result of the last
+ * Dijkstra run) first, endpoints attached to direct neighbors are kept.
+ * @param count number of endpoints to remove
+ * @return true if an endpoint was removed
+ */
+static bool
+_evict_endpoints(uint32_t count) {
+  struct olsrv2_tc_target **targets;
+  struct olsrv2_tc_endpoint *end;
+  struct olsrv2_tc_attachment *net, *net_it;
+  size_t i, n;
+  bool keep;
+
+  if (count == 0 || _tc_endpoint_tree.count == 0) {
+    return false;
+  }
+
+  targets = calloc(_tc_endpoint_tree.count, sizeof(*targets));
+  if (targets == NULL) {
+    return false;
+  }
+
+  n = 0;
+  avl_for_each_element(&_tc_endpoint_tree, end, _node) {
+    keep = false;
+    avl_for_each_element(&end->_attached_networks, net, _endpoint_node) {
+      keep |= net->src->direct_neighbor;
+    }
+    if (!keep) {
+      targets[n++] = &end->target;
+    }
+  }
+
+  qsort(targets, n, sizeof(*targets), _cb_compare_target_distance);
+
+  /* the last removed attachment frees the endpoint */
+  oonf_class_set_evicting(&_tc_endpoint_class, true);
+  for (i = 0; i < n && i < count; i++) {
+    end = container_of(targets[i], struct olsrv2_tc_endpoint, target);
+    avl_for_each_element_safe(&end->_attached_networks, net, _endpoint_node, net_it) {
+      olsrv2_tc_endpoint_remove(net);
+    }
+  }
+  oonf_class_set_evicting(&_tc_endpoint_class, false);
+  free(targets);
+
+  return i > 0;
+}
+
+/**
+ * Remove tc nodes farthest away (by the result of the last Dijkstra
+ * run) first, direct neighbors and virtual nodes are kept.
+ * @param count number of nodes to remove
+ * @return true if a node was removed
+ */
+static bool
+_evict_nodes(uint32_t count) {
+  struct olsrv2_tc_target **targets;
+  struct olsrv2_tc_node *node;
+  size_t i, n;
+
+  if (count == 0 || _tc_tree.count == 0) {
+    return false;
+  }
+
+  targets = calloc(_tc_tree.count, sizeof(*targets));
+  if (targets == NULL) {
+    return false;
+  }
+
+  n = 0;
+  avl_for_each_element(&_tc_tree, node, _originator_node) {
+    if (!node->direct_neighbor && !olsrv2_tc_is_node_virtual(node)) {
+      targets[n++] = &node->target;
+    }
+  }
+
+  qsort(targets, n, sizeof(*targets), _cb_compare_target_distance);
+
+  /* removing a node only frees virtual nodes, which are not in the array */
+  oonf_class_set_evicting(&_tc_node_class, true);
+  for (i = 0; i < n && i < count; i++) {
+    olsrv2_tc_node_remove(container_of(targets[i], struct olsrv2_tc_node, target));
+  }
+  oonf_class_set_evicting(&_tc_node_class, false);
+  free(targets);
+
+  return i > 0;
+}
+
+/**
+ * Compare two Dijkstra targets by their distance, farthest target first
+ * @param p1 pointer to pointer to first target
+ * @param p2 pointer to pointer to second target
+ * @return -1 if first target is farther away, 1 if second one, 0 otherwise
+ */
+static int
+_cb_compare_target_distance(const void *p1, const void *p2) {
+  const struct olsrv2_tc_target *t1 = *((struct olsrv2_tc_target * const *)p1);
+  const struct olsrv2_tc_target *t2 = *((struct olsrv2_tc_target * const *)p2);
+
+  if (t1->_dijkstra.path_cost != t2->_dijkstra.path_cost) {
+    return t1->_dijkstra.path_cost > t2->_dijkstra.path_cost ? -1 : 1;
+  }
+  if (t1->_dijkstra.path_hops != t2->_dijkstra.path_hops) {
+    return t1->_dijkstra.path_hops > t2->_dijkstra.path_hops ? -1 : 1;
+  }
+  return 0;
+}
@@ -184,6 +184,9 @@ olsrv2_writer_send_tc(void) {
     return;
   }
 
+  /* the TC advertises the neighbor metrics, apply pending changes */
+  nhdp_domain_flush_changes();
+
   _send_tc(AF_INET);
   _send_tc(AF_INET6);
 }
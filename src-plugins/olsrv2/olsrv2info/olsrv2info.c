@@ -50,6 +50,8 @@
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_duplicate_set.h"
+#include "subsystems/oonf_rfc5444.h"
 #include "subsystems/oonf_telnet.h"
 #include "subsystems/oonf_viewer.h"
 
@@ -83,6 +85,7 @@ static void _initialize_node_values(struct olsrv2_tc_node *);
 static void _initialize_attached_network_values(struct olsrv2_tc_attachment *edge);
 static void _initialize_edge_values(struct olsrv2_tc_edge *edge);
 static void _initialize_route_values(struct olsrv2_routing_entry *route);
+static void _initialize_dupset_values(const char *name, struct oonf_duplicate_set *set);
 
 static int _cb_create_text_originator(struct oonf_viewer_template *);
 static int _cb_create_text_old_originator(struct oonf_viewer_template *);
@@ -91,6 +94,7 @@ static int _cb_create_text_node(struct oonf_viewer_template *);
 static int _cb_create_text_attached_network(struct oonf_viewer_template *);
 static int _cb_create_text_edge(struct oonf_viewer_template *);
 static int _cb_create_text_route(struct oonf_viewer_template *);
+static int _cb_create_text_dupset(struct oonf_viewer_template *);
 
 /*
  * list of template keys and corresponding buffers for values.
@@ -197,6 +201,24 @@ static int _cb_create_text_route(struct oonf_viewer_template *);
 /*! template key for the last hop before the route destination */
 #define KEY_ROUTE_LASTHOP           "route_lasthop"
 
+/*! template key for name of duplicate set */
+#define KEY_DUPSET                  "dupset"
+
+/*! template key for sliding window size of duplicate set */
+#define KEY_DUPSET_WINDOW           "dupset_window"
+
+/*! template key for number of originators in duplicate set */
+#define KEY_DUPSET_SIZE             "dupset_size"
+
+/*! template key for number of duplicate messages */
+#define KEY_DUPSET_DUPLICATES       "dupset_duplicates"
+
+/*! template key for number of too old messages */
+#define KEY_DUPSET_TOO_OLD          "dupset_too_old"
+
+/*! template key for number of originator resets */
+#define KEY_DUPSET_RESETS           "dupset_resets"
+
 /*
  * buffer space for values that will be assembled
  * into the output of the plugin
@@ -240,6 +262,13 @@ static char                       _value_route_if[IF_NAMESIZE];
 static char                       _value_route_ifindex[12];
 static struct netaddr_str         _value_route_lasthop;
 
+static char                       _value_dupset[10];
+static char                       _value_dupset_window[6];
+static char                       _value_dupset_size[11];
+static char                       _value_dupset_duplicates[11];
+static char                       _value_dupset_too_old[11];
+static char                       _value_dupset_resets[11];
+
 /* definition of the template data entries for JSON and table output */
 static struct abuf_template_data_entry _tde_originator[] = {
     { KEY_ORIGINATOR, _value_originator.buf, true },
@@ -309,6 +338,15 @@ static struct abuf_template_data_entry _tde_route[] = {
     { KEY_ROUTE_LASTHOP, _value_route_lasthop.buf, true },
 };
 
+static struct abuf_template_data_entry _tde_dupset[] = {
+    { KEY_DUPSET, _value_dupset, true },
+    { KEY_DUPSET_WINDOW, _value_dupset_window, false },
+    { KEY_DUPSET_SIZE, _value_dupset_size, false },
+    { KEY_DUPSET_DUPLICATES, _value_dupset_duplicates, false },
+    { KEY_DUPSET_TOO_OLD, _value_dupset_too_old, false },
+    { KEY_DUPSET_RESETS, _value_dupset_resets, false },
+};
+
 static struct abuf_template_storage _template_storage;
 
 /* Template Data objects (contain one or more Template Data Entries) */
@@ -346,6 +384,9 @@ static struct abuf_template_data _td_route[] = {
     { _tde_domain_metric_out, ARRAYSIZE(_tde_domain_metric_out) },
     { _tde_domain_path_hops, ARRAYSIZE(_tde_domain_path_hops) },
 };
+static struct abuf_template_data _td_dupset[] = {
+    { _tde_dupset, ARRAYSIZE(_tde_dupset) },
+};
 
 /* OONF viewer templates (based on Template Data arrays) */
 static struct oonf_viewer_template _templates[] = {
@@ -390,7 +431,13 @@ static struct oonf_viewer_template _templates[] = {
         .data_size = ARRAYSIZE(_td_route),
         .json_name = "route",
         .cb_function = _cb_create_text_route,
-    }
+    },
+    {
+        .data = _td_dupset,
+        .data_size = ARRAYSIZE(_td_dupset),
+        .json_name = "dupset",
+        .cb_function = _cb_create_text_dupset,
+    },
 };
 
 /* telnet command of this plugin */
@@ -620,6 +667,26 @@ _initialize_route_values(struct olsrv2_routing_entry *route) {
   netaddr_to_string(&_value_route_lasthop, &route->last_originator);
 }
 
+/**
+ * Initialize the value buffers for a duplicate set
+ * @param name name of duplicate set
+ * @param set duplicate set
+ */
+static void
+_initialize_dupset_values(const char *name, struct oonf_duplicate_set *set) {
+  strscpy(_value_dupset, name, sizeof(_value_dupset));
+  snprintf(_value_dupset_window, sizeof(_value_dupset_window), "%u",
+      oonf_duplicate_set_get_window(set));
+  snprintf(_value_dupset_size, sizeof(_value_dupset_size), "%u",
+      oonf_duplicate_set_get_size(set));
+  snprintf(_value_dupset_duplicates, sizeof(_value_dupset_duplicates), "%u",
+      oonf_duplicate_set_get_duplicates(set));
+  snprintf(_value_dupset_too_old, sizeof(_value_dupset_too_old), "%u",
+      oonf_duplicate_set_get_too_old(set));
+  snprintf(_value_dupset_resets, sizeof(_value_dupset_resets), "%u",
+      oonf_duplicate_set_get_resets(set));
+}
+
 /**
  * Displays the known data about each NHDP interface.
  * @param template oonf viewer template
@@ -800,3 +867,23 @@ _cb_create_text_route(struct oonf_viewer_template *template) {
   }
   return 0;
 }
+
+/**
+ * Display the duplicate sets for processing and forwarding
+ * @param template oonf viewer template
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_cb_create_text_dupset(struct oonf_viewer_template *template) {
+  struct oonf_rfc5444_protocol *protocol;
+
+  protocol = oonf_rfc5444_get_default_protocol();
+
+  _initialize_dupset_values("processed", &protocol->processed_set);
+  oonf_viewer_output_print_line(template);
+
+  _initialize_dupset_values("forwarded", &protocol->forwarded_set);
+  oonf_viewer_output_print_line(template);
+
+  return 0;
+}
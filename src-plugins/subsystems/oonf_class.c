@@ -45,9 +45,17 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
+#include "common/autobuf.h"
 #include "common/avl.h"
 #include "common/avl_comp.h"
+#include "common/isonumber.h"
+#include "common/string.h"
+#include "config/cfg.h"
+#include "config/cfg_schema.h"
+#include "config/cfg_validate.h"
 #include "core/oonf_logging.h"
 #include "core/oonf_subsystem.h"
 
@@ -56,18 +64,96 @@
 /* Definitions */
 #define LOG_CLASS (_oonf_class_subsystem.logging)
 
+/**
+ * Configuration of memory budgets
+ */
+struct _class_config {
+  /*! memory budget for all classes together */
+  int64_t budget;
+};
+
+/**
+ * Header of a slab. The objects of the slab are stored directly
+ * behind it. Slabs are aligned to their own size, so the header
+ * can be calculated from the address of any object of the slab.
+ */
+struct _oonf_class_slab {
+  /*! node for partial, full or empty slab list of class */
+  struct list_entity _node;
+
+  /*! intrusive list of freed objects, linked by their first pointer */
+  void *free_objects;
+
+  /*! number of objects that have been handed out at least once */
+  uint32_t carved;
+
+  /*! number of objects currently in use */
+  uint32_t used;
+};
+
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
 
 static void _free_freelist(struct oonf_class *);
+static int _reserve_listeners(struct oonf_class *, uint32_t);
+static void _update_extensions(struct oonf_class *);
+static uint32_t _hash_object(const void *);
+static void _remove_from_batch(struct oonf_class *, void *);
+static size_t _compact_batch(void **, size_t);
+static void _dispatch_batch(struct oonf_class *);
+static int _check_budget(struct oonf_class *);
+static void _call_pressure(struct oonf_class *, uint32_t);
+static void _global_pressure(size_t);
+static void _apply_class_budget(struct oonf_class *);
+static int _cb_validate_class_budget(const struct cfg_schema_entry *entry,
+    const char *section_name, const char *value, struct autobuf *out);
+static void _cb_config_changed(void);
+static void _initialize_object(struct oonf_class *, void *);
 static size_t _roundup(size_t);
+static void _calculate_slab_layout(struct oonf_class *);
+static int _add_slab(struct oonf_class *);
+static void _remove_slab(struct oonf_class *, struct _oonf_class_slab *);
+static void *_slab_malloc(struct oonf_class *);
+static void _slab_free(struct oonf_class *, void *);
 static const char *_cb_to_keystring(struct oonf_objectkey_str *,
     struct oonf_class *, void *);
 
 /* list of memory cookies */
 static struct avl_tree _classes_tree;
 
+/* size of a memory page */
+static size_t _page_size;
+
+/* global memory budget */
+static uint64_t _global_budget;
+static uint64_t _global_usage;
+static uint64_t _global_next_pressure;
+static uint32_t _global_pressure_count;
+static uint32_t _global_denied;
+
+/* configured class budgets */
+static struct strarray _class_budgets;
+
+/* configuration of memory budgets */
+static struct cfg_schema_entry _class_entries[] = {
+  CFG_MAP_INT64_MINMAX(_class_config, budget, "budget", "0",
+      "Memory budget for the objects of all classes in bytes, 0 for no limit",
+      0, true, 0, INT64_MAX),
+  _CFG_VALIDATE("class_budget", "", "Memory budget for the objects of a single"
+      " class. Value consists of the budget in bytes followed by the class name",
+      .cb_validate = _cb_validate_class_budget, .list = true),
+};
+
+static struct cfg_schema_section _class_section = {
+  .type = OONF_CLASS_SUBSYSTEM,
+  .mode = CFG_SSMODE_UNNAMED,
+  .help = "Memory budgets for classes of objects",
+  .cb_delta_handler = _cb_config_changed,
+  .entries = _class_entries,
+  .entry_count = ARRAYSIZE(_class_entries),
+};
+
 /* name of event types */
 static const char *OONF_CLASS_EVENT_NAME[] = {
   [OONF_OBJECT_ADDED] = "added",
@@ -78,6 +164,7 @@ static const char *OONF_CLASS_EVENT_NAME[] = {
 /* subsystem definition */
 static struct oonf_subsystem _oonf_class_subsystem = {
   .name = OONF_CLASS_SUBSYSTEM,
+  .cfg_section = &_class_section,
   .init = _init,
   .cleanup = _cleanup,
 };
@@ -89,7 +176,13 @@ DECLARE_OONF_PLUGIN(_oonf_class_subsystem);
  */
 static int
 _init(void) {
+  long page_size;
+
   avl_init(&_classes_tree, avl_comp_strcasecmp, false);
+  strarray_init(&_class_budgets);
+
+  page_size = sysconf(_SC_PAGESIZE);
+  _page_size = page_size > 0 ? (size_t)page_size : 4096;
   return 0;
 }
 
@@ -107,6 +200,7 @@ _cleanup(void)
   avl_for_each_element_safe(&_classes_tree, info, _node, iterator) {
     oonf_class_remove(info);
   }
+  strarray_free(&_class_budgets);
 }
 
 /**
@@ -121,6 +215,7 @@ oonf_class_add(struct oonf_class *ci)
 
   /* round up size to make block extendable */
   ci->total_size = _roundup(ci->size);
+  _calculate_slab_layout(ci);
 
   /* hook into tree */
   ci->_node.key = ci->name;
@@ -132,8 +227,26 @@ oonf_class_add(struct oonf_class *ci)
   }
 
   /* Init list heads */
+  memset(ci->_listeners, 0, sizeof(ci->_listeners));
+  memset(ci->_listener_count, 0, sizeof(ci->_listener_count));
+  ci->_listener_size = 0;
+  ci->_batch = NULL;
+  ci->_batch_count = 0;
+  ci->_batch_size = 0;
+  hash_index_init(&ci->_batch_index);
+  ci->_dispatched = NULL;
+  ci->_dispatched_count = 0;
+  ci->_batch_level = 0;
+  ci->_evicting = false;
+  _apply_class_budget(ci);
+
   list_init_head(&ci->_free_list);
   list_init_head(&ci->_extensions);
+  list_init_head(&ci->_partial_slabs);
+  list_init_head(&ci->_full_slabs);
+  list_init_head(&ci->_empty_slabs);
+
+  _update_extensions(ci);
 
   OONF_DEBUG(LOG_CLASS, "Class %s added: %" PRINTF_SIZE_T_SPECIFIER " bytes\n",
              ci->name, ci->total_size);
@@ -147,6 +260,7 @@ void
 oonf_class_remove(struct oonf_class *ci)
 {
   struct oonf_class_extension *ext, *iterator;
+  size_t i;
 
   /* remove memcookie from tree */
   avl_remove(&_classes_tree, &ci->_node);
@@ -159,6 +273,24 @@ oonf_class_remove(struct oonf_class *ci)
     oonf_class_extension_remove(ext);
   }
 
+  for (i = 0; i < OONF_OBJECT_EVENT_COUNT; i++) {
+    free(ci->_listeners[i]);
+    ci->_listeners[i] = NULL;
+    ci->_listener_count[i] = 0;
+  }
+  ci->_listener_size = 0;
+
+  /* objects still in use are not part of the global budget anymore */
+  _global_usage -= oonf_class_get_memory_usage(ci);
+
+  /* pending change events are dropped */
+  free(ci->_batch);
+  ci->_batch = NULL;
+  ci->_batch_count = 0;
+  ci->_batch_size = 0;
+  ci->_batch_level = 0;
+  hash_index_free(&ci->_batch_index);
+
   OONF_DEBUG(LOG_CLASS, "Class %s removed\n", ci->name);
 }
 
@@ -177,19 +309,37 @@ oonf_class_malloc(struct oonf_class *ci)
   bool reuse = false;
 #endif
 
-  /*
-   * Check first if we have reusable memory.
-   */
-  if (list_is_empty(&ci->_free_list)) {
+  if ((ci->_budget > 0 || _global_budget > 0) && _check_budget(ci)) {
+    return NULL;
+  }
+
+  if (ci->slab) {
+    /* carve block out of a slab */
+    ptr = _slab_malloc(ci);
+    if (ptr == NULL) {
+      OONF_WARN(LOG_CLASS, "Out of memory for: %s", ci->name);
+      return NULL;
+    }
+    _initialize_object(ci, ptr);
+  }
+  else if (list_is_empty(&ci->_free_list)) {
     /*
      * No reusable memory block on the free_list.
      * Allocate a fresh one.
      */
-    ptr = calloc(1, ci->total_size);
+    if (ci->_custom_init) {
+      ptr = malloc(ci->total_size);
+    }
+    else {
+      ptr = calloc(1, ci->total_size);
+    }
     if (ptr == NULL) {
       OONF_WARN(LOG_CLASS, "Out of memory for: %s", ci->name);
       return NULL;
     }
+    if (ci->_custom_init) {
+      _initialize_object(ci, ptr);
+    }
     ci->_allocated++;
   } else {
     /*
@@ -199,8 +349,8 @@ oonf_class_malloc(struct oonf_class *ci)
     entity = ci->_free_list.next;
     list_remove(entity);
 
-    memset(entity, 0, ci->total_size);
     ptr = entity;
+    _initialize_object(ci, ptr);
 
     ci->_free_list_size--;
     ci->_recycled++;
@@ -211,6 +361,7 @@ oonf_class_malloc(struct oonf_class *ci)
 
   /* Stats keeping */
   ci->_current_usage++;
+  _global_usage += ci->total_size;
 
   OONF_DEBUG(LOG_CLASS, "MEMORY: alloc %s, %" PRINTF_SIZE_T_SPECIFIER " bytes%s\n",
              ci->name, ci->total_size, reuse ? ", reuse" : "");
@@ -230,12 +381,16 @@ oonf_class_free(struct oonf_class *ci, void *ptr)
   bool reuse = false;
 #endif
 
+  if (ci->slab) {
+    /* return block to its slab */
+    _slab_free(ci, ptr);
+  }
   /*
    * Rather than freeing the memory right away, try to reuse at a later
    * point. Keep at least ten percent of the active used blocks or at least
    * ten blocks on the free list.
    */
-  if (ci->_free_list_size < ci->min_free_count
+  else if (ci->_free_list_size < ci->min_free_count
       || (ci->_free_list_size < ci->_current_usage / 10)) {
     item = ptr;
 
@@ -253,11 +408,31 @@ oonf_class_free(struct oonf_class *ci, void *ptr)
 
   /* Stats keeping */
   ci->_current_usage--;
+  if (_global_usage >= ci->total_size) {
+    _global_usage -= ci->total_size;
+  }
+  if (ci->_evicting) {
+    ci->_stat_evicted++;
+  }
 
   OONF_DEBUG(LOG_CLASS, "MEMORY: free %s, %"PRINTF_SIZE_T_SPECIFIER" bytes%s\n",
              ci->name, ci->size, reuse ? ", reuse" : "");
 }
 
+/**
+ * Release all unused memory blocks and empty slabs of a class
+ * back to the system.
+ * @param ci pointer to memcookie info
+ */
+void
+oonf_class_reclaim(struct oonf_class *ci) {
+  OONF_DEBUG(LOG_CLASS, "Reclaim %u free blocks and %u empty slabs of %s",
+      list_is_empty(&ci->_free_list) ? 0 : ci->_free_list_size,
+      ci->_slab_empty, ci->name);
+
+  _free_freelist(ci);
+}
+
 /**
  * Register an extension to an existing class without objects.
  * This function can only fail if ext->size is not 0.
@@ -266,7 +441,9 @@ oonf_class_free(struct oonf_class *ci, void *ptr)
  */
 int
 oonf_class_extension_add(struct oonf_class_extension *ext) {
+  struct oonf_class_extension *iterator;
   struct oonf_class *c;
+  uint32_t count;
 
   if (oonf_class_is_extension_registered(ext)) {
     /* already registered */
@@ -286,8 +463,19 @@ oonf_class_extension_add(struct oonf_class_extension *ext) {
     return -1;
   }
 
+  /* make sure the listener arrays can take the new extension */
+  count = 1;
+  list_for_each_element(&c->_extensions, iterator, _node) {
+    count++;
+  }
+  if (_reserve_listeners(c, count)) {
+    OONF_WARN(LOG_CLASS, "Out of memory for listeners of class %s", c->name);
+    return -1;
+  }
+
   /* add to class extension list */
   list_add_tail(&c->_extensions, &ext->_node);
+  _update_extensions(c);
 
   if (ext->size > 0) {
     /* make sure freelist is empty */
@@ -298,6 +486,7 @@ oonf_class_extension_add(struct oonf_class_extension *ext) {
 
     /* calculate new size */
     c->total_size = _roundup(c->total_size + ext->size);
+    _calculate_slab_layout(c);
 
     OONF_DEBUG(LOG_CLASS, "Class %s extended: %" PRINTF_SIZE_T_SPECIFIER " bytes,"
         " '%s' has offset %" PRINTF_SIZE_T_SPECIFIER " and length %" PRINTF_SIZE_T_SPECIFIER "\n",
@@ -313,44 +502,158 @@ oonf_class_extension_add(struct oonf_class_extension *ext) {
  */
 void
 oonf_class_extension_remove(struct oonf_class_extension *ext) {
+  struct oonf_class *c;
+
   if (list_is_node_added(&ext->_node)) {
     list_remove(&ext->_node);
     ext->_offset = 0;
+
+    c = avl_find_element(&_classes_tree, ext->class_name, c, _node);
+    if (c) {
+      _update_extensions(c);
+    }
   }
 }
 
 /**
- * Fire an event for a class
+ * Fire an event for a class. Change events are queued
+ * while a batch is open for the class.
  * @param c pointer to class
  * @param ptr pointer to object
  * @param evt type of event
  */
 void
 oonf_class_event(struct oonf_class *c, void *ptr, enum oonf_class_event evt) {
-  struct oonf_class_extension *ext;
+  struct oonf_class_extension **listeners;
+  uint32_t i, count;
+  void **batch, *queued;
+  size_t size, pos;
+  uint32_t hash;
 #ifdef OONF_LOG_DEBUG_INFO
   struct oonf_objectkey_str buf;
 #endif
 
-  OONF_DEBUG(LOG_CLASS, "Fire '%s' event for %s",
-      OONF_CLASS_EVENT_NAME[evt], c->to_keystring(&buf, c, ptr));
-  list_for_each_element(&c->_extensions, ext, _node) {
-    if (evt == OONF_OBJECT_ADDED && ext->cb_add != NULL) {
-      OONF_DEBUG(LOG_CLASS, "Fire listener %s", ext->ext_name);
-      ext->cb_add(ptr);
+  if (evt == OONF_OBJECT_CHANGED && c->_batch_level > 0) {
+    hash = _hash_object(ptr);
+    hash_index_for_each_match(&c->_batch_index, hash, queued, pos) {
+      if (queued == ptr) {
+        /* object is already part of the batch */
+        return;
+      }
     }
-    else if (evt == OONF_OBJECT_REMOVED && ext->cb_remove != NULL) {
-      OONF_DEBUG(LOG_CLASS, "Fire listener %s", ext->ext_name);
-      ext->cb_remove(ptr);
+
+    if (c->_batch_count == c->_batch_size) {
+      size = c->_batch_size ? c->_batch_size * 2 : 16;
+      batch = realloc(c->_batch, size * sizeof(void *));
+      if (batch) {
+        c->_batch = batch;
+        c->_batch_size = size;
+      }
     }
-    else if (evt == OONF_OBJECT_CHANGED && ext->cb_change != NULL) {
-      OONF_DEBUG(LOG_CLASS, "Fire listener %s", ext->ext_name);
-      ext->cb_change(ptr);
+    if (c->_batch_count < c->_batch_size) {
+      /* without index entry the object might be queued twice, which is harmless */
+      hash_index_add(&c->_batch_index, ptr, hash);
+      c->_batch[c->_batch_count++] = ptr;
+      return;
+    }
+    /* out of memory, deliver event directly */
+  }
+  else if (evt == OONF_OBJECT_REMOVED) {
+    /* drop pending change events of removed object */
+    _remove_from_batch(c, ptr);
+  }
+
+  count = c->_listener_count[evt];
+  if (count == 0) {
+    return;
+  }
+
+  OONF_DEBUG(LOG_CLASS, "Fire '%s' event for %s",
+      OONF_CLASS_EVENT_NAME[evt], c->to_keystring(&buf, c, ptr));
+
+  listeners = c->_listeners[evt];
+  for (i = 0; i < count; i++) {
+    OONF_DEBUG(LOG_CLASS, "Fire listener %s", listeners[i]->ext_name);
+    switch (evt) {
+      case OONF_OBJECT_ADDED:
+        listeners[i]->cb_add(ptr);
+        break;
+      case OONF_OBJECT_REMOVED:
+        listeners[i]->cb_remove(ptr);
+        break;
+      default:
+        if (listeners[i]->cb_change) {
+          listeners[i]->cb_change(ptr);
+        }
+        else {
+          listeners[i]->cb_change_batch(&ptr, 1);
+        }
+        break;
     }
   }
   OONF_DEBUG(LOG_CLASS, "Fire event finished");
 }
 
+/**
+ * Start a batch of change events for a class. Change events
+ * of the class are collected until the batch ends and are then
+ * delivered listener by listener. Batches can be nested.
+ * @param c pointer to class
+ */
+void
+oonf_class_event_batch_begin(struct oonf_class *c) {
+  c->_batch_level++;
+}
+
+/**
+ * End a batch of change events for a class and deliver the
+ * collected events if this was the outermost batch.
+ * @param c pointer to class
+ */
+void
+oonf_class_event_batch_end(struct oonf_class *c) {
+  if (c->_batch_level == 0) {
+    return;
+  }
+
+  c->_batch_level--;
+  if (c->_batch_level == 0 && c->_batch_count > 0) {
+    _dispatch_batch(c);
+  }
+}
+
+/**
+ * @return global memory budget for all classes in bytes, 0 if unlimited
+ */
+uint64_t
+oonf_class_get_global_budget(void) {
+  return _global_budget;
+}
+
+/**
+ * @return number of bytes used by objects of all classes
+ */
+uint64_t
+oonf_class_get_global_usage(void) {
+  return _global_usage;
+}
+
+/**
+ * @return number of times the global budget triggered pressure callbacks
+ */
+uint32_t
+oonf_class_get_global_pressure(void) {
+  return _global_pressure_count;
+}
+
+/**
+ * @return number of allocations rejected because of the global budget
+ */
+uint32_t
+oonf_class_get_global_denied(void) {
+  return _global_denied;
+}
+
 /**
  * get tree of memory classes
  * @return class tree
@@ -383,19 +686,404 @@ _roundup(size_t size) {
 }
 
 /**
- * Free all objects in the free_list of a memory cookie
+ * Free all objects in the free_list and all empty slabs of a memory cookie
  * @param ci pointer to memory cookie
  */
 static void
 _free_freelist(struct oonf_class *ci) {
+  struct _oonf_class_slab *slab, *slab_it;
+
   while (!list_is_empty(&ci->_free_list)) {
     struct list_entity *item;
     item = ci->_free_list.next;
 
     list_remove(item);
     free(item);
+
+    ci->_free_list_size--;
+  }
+
+  list_for_each_element_safe(&ci->_empty_slabs, slab, _node, slab_it) {
+    _remove_slab(ci, slab);
+  }
+}
+
+/**
+ * Make sure the listener arrays of a class have a minimum length
+ * @param ci pointer to memory cookie
+ * @param size minimum number of entries
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_reserve_listeners(struct oonf_class *ci, uint32_t size) {
+  struct oonf_class_extension **array;
+  size_t i;
+
+  if (size <= ci->_listener_size) {
+    return 0;
+  }
+
+  for (i = 0; i < OONF_OBJECT_EVENT_COUNT; i++) {
+    array = realloc(ci->_listeners[i], size * sizeof(*array));
+    if (array == NULL) {
+      return -1;
+    }
+    ci->_listeners[i] = array;
+  }
+  ci->_listener_size = size;
+  return 0;
+}
+
+/**
+ * Rebuild the listener arrays of a class and check if the class
+ * or one of its extensions has an initializer
+ * @param ci pointer to memory cookie
+ */
+static void
+_update_extensions(struct oonf_class *ci) {
+  struct oonf_class_extension *ext;
+
+  ci->_custom_init = ci->init != NULL;
+  memset(ci->_listener_count, 0, sizeof(ci->_listener_count));
+
+  list_for_each_element(&ci->_extensions, ext, _node) {
+    if (ext->init) {
+      ci->_custom_init = true;
+    }
+    if (ext->cb_add) {
+      ci->_listeners[OONF_OBJECT_ADDED][ci->_listener_count[OONF_OBJECT_ADDED]++] = ext;
+    }
+    if (ext->cb_change || ext->cb_change_batch) {
+      ci->_listeners[OONF_OBJECT_CHANGED][ci->_listener_count[OONF_OBJECT_CHANGED]++] = ext;
+    }
+    if (ext->cb_remove) {
+      ci->_listeners[OONF_OBJECT_REMOVED][ci->_listener_count[OONF_OBJECT_REMOVED]++] = ext;
+    }
+  }
+}
+
+/**
+ * @param ptr pointer to object
+ * @return hash value of the object pointer for the batch index
+ */
+static uint32_t
+_hash_object(const void *ptr) {
+  uint32_t hash;
+
+  /* objects are at least 8 byte aligned */
+  hash = (uint32_t)((uintptr_t)ptr >> 3);
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3b;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+/**
+ * Remove an object from the pending and the currently dispatched
+ * batch of change events.
+ * @param ci pointer to memory cookie
+ * @param ptr pointer to object
+ */
+static void
+_remove_from_batch(struct oonf_class *ci, void *ptr) {
+  size_t i;
+
+  hash_index_remove(&ci->_batch_index, ptr, _hash_object(ptr));
+  for (i = 0; i < ci->_batch_count; i++) {
+    if (ci->_batch[i] == ptr) {
+      ci->_batch[i] = NULL;
+    }
+  }
+  for (i = 0; i < ci->_dispatched_count; i++) {
+    if (ci->_dispatched[i] == ptr) {
+      ci->_dispatched[i] = NULL;
+    }
+  }
+}
+
+/**
+ * Remove NULL pointers from an array of objects
+ * @param array pointer to array
+ * @param count number of array elements
+ * @return new number of array elements
+ */
+static size_t
+_compact_batch(void **array, size_t count) {
+  size_t i, j;
+
+  for (i = 0, j = 0; i < count; i++) {
+    if (array[i]) {
+      array[j++] = array[i];
+    }
+  }
+  return j;
+}
+
+/**
+ * Deliver the collected change events of a class. Listeners might
+ * start a new batch or remove objects of the current one, so the
+ * array being dispatched is detached from the class first.
+ * @param ci pointer to memory cookie
+ */
+static void
+_dispatch_batch(struct oonf_class *ci) {
+  struct oonf_class_extension *ext;
+  void **batch, **outer_batch;
+  size_t batch_size, outer_count;
+  uint32_t i;
+  size_t j;
+
+  /* a listener might end a nested batch during dispatch */
+  outer_batch = ci->_dispatched;
+  outer_count = ci->_dispatched_count;
+
+  batch = ci->_batch;
+  batch_size = ci->_batch_size;
+
+  /* objects changed during dispatch are queued again */
+  for (j = 0; j < ci->_batch_count; j++) {
+    if (batch[j]) {
+      hash_index_remove(&ci->_batch_index, batch[j], _hash_object(batch[j]));
+    }
+  }
+
+  ci->_dispatched = batch;
+  ci->_dispatched_count = ci->_batch_count;
+  ci->_batch = NULL;
+  ci->_batch_count = 0;
+  ci->_batch_size = 0;
+
+  OONF_DEBUG(LOG_CLASS, "Fire batch of %" PRINTF_SIZE_T_SPECIFIER " '%s' events for %s",
+      ci->_dispatched_count, OONF_CLASS_EVENT_NAME[OONF_OBJECT_CHANGED], ci->name);
+
+  for (i = 0; i < ci->_listener_count[OONF_OBJECT_CHANGED]; i++) {
+    ci->_dispatched_count = _compact_batch(ci->_dispatched, ci->_dispatched_count);
+    if (ci->_dispatched_count == 0) {
+      break;
+    }
+
+    ext = ci->_listeners[OONF_OBJECT_CHANGED][i];
+    OONF_DEBUG(LOG_CLASS, "Fire listener %s", ext->ext_name);
+
+    if (ext->cb_change_batch) {
+      ext->cb_change_batch(ci->_dispatched, ci->_dispatched_count);
+    }
+    else {
+      for (j = 0; j < ci->_dispatched_count; j++) {
+        if (ci->_dispatched[j]) {
+          ext->cb_change(ci->_dispatched[j]);
+        }
+      }
+    }
+  }
+
+  ci->_dispatched = outer_batch;
+  ci->_dispatched_count = outer_count;
+
+  if (ci->_batch == NULL) {
+    /* keep array for the next batch */
+    ci->_batch = batch;
+    ci->_batch_size = batch_size;
+  }
+  else {
+    free(batch);
+  }
+}
+
+/**
+ * Initialize a new memory block. Without initializers the whole block
+ * is zeroed, otherwise only the parts without initializer are zeroed
+ * before the initializers are called.
+ * @param ci pointer to memory cookie
+ * @param ptr pointer to memory block
+ */
+static void
+_initialize_object(struct oonf_class *ci, void *ptr) {
+  struct oonf_class_extension *ext;
+
+  if (!ci->_custom_init) {
+    memset(ptr, 0, ci->total_size);
+    return;
+  }
+
+  if (ci->init) {
+    ci->init(ptr);
+  }
+  else {
+    memset(ptr, 0, ci->size);
+  }
+
+  list_for_each_element(&ci->_extensions, ext, _node) {
+    if (ext->init) {
+      ext->init(ptr);
+    }
+    else if (ext->size > 0) {
+      memset(oonf_class_get_extension(ext, ptr), 0, ext->size);
+    }
+  }
+}
+
+/**
+ * Calculate size of slabs and number of objects per slab. A slab
+ * is at least one memory page and large enough to store
+ * OONF_CLASS_SLAB_MIN_OBJECTS objects.
+ * @param ci pointer to memory cookie
+ */
+static void
+_calculate_slab_layout(struct oonf_class *ci) {
+  size_t header, size;
+
+  header = _roundup(sizeof(struct _oonf_class_slab));
+
+  size = ci->slab_hugepage ? OONF_CLASS_SLAB_HUGEPAGE_SIZE : _page_size;
+  while (size < header + OONF_CLASS_SLAB_MIN_OBJECTS * ci->total_size) {
+    size <<= 1;
+  }
+
+  ci->_slab_size = size;
+  ci->_slab_capacity = (size - header) / ci->total_size;
+}
+
+/**
+ * Allocate a new slab and add it to the empty slabs of a class
+ * @param ci pointer to memory cookie
+ * @return -1 if an error happened, 0 otherwise
+ */
+static int
+_add_slab(struct oonf_class *ci) {
+  struct _oonf_class_slab *slab;
+  void *ptr;
+
+  if (posix_memalign(&ptr, ci->_slab_size, ci->_slab_size)) {
+    return -1;
+  }
+
+#ifdef MADV_HUGEPAGE
+  if (ci->slab_hugepage) {
+    /* failure just means we get normal pages */
+    madvise(ptr, ci->_slab_size, MADV_HUGEPAGE);
+  }
+#endif
+
+  slab = ptr;
+  memset(slab, 0, sizeof(*slab));
+  list_add_tail(&ci->_empty_slabs, &slab->_node);
+
+  ci->_slab_count++;
+  ci->_slab_empty++;
+  ci->_free_list_size += ci->_slab_capacity;
+
+  OONF_DEBUG(LOG_CLASS, "Class %s: new slab with %u objects"
+      " (%" PRINTF_SIZE_T_SPECIFIER " bytes)",
+      ci->name, ci->_slab_capacity, ci->_slab_size);
+  return 0;
+}
+
+/**
+ * Release an empty slab back to the system
+ * @param ci pointer to memory cookie
+ * @param slab pointer to slab
+ */
+static void
+_remove_slab(struct oonf_class *ci, struct _oonf_class_slab *slab) {
+  list_remove(&slab->_node);
+
+  ci->_slab_count--;
+  ci->_slab_empty--;
+  ci->_free_list_size -= ci->_slab_capacity;
+
+  free(slab);
+}
+
+/**
+ * Get a memory block from the slabs of a class. Partially used slabs
+ * are filled before an empty slab is used.
+ * @param ci pointer to memory cookie
+ * @return pointer to memory block, NULL if out of memory
+ */
+static void *
+_slab_malloc(struct oonf_class *ci) {
+  struct _oonf_class_slab *slab;
+  void **obj;
+
+  if (!list_is_empty(&ci->_partial_slabs)) {
+    slab = list_first_element(&ci->_partial_slabs, slab, _node);
+  }
+  else {
+    if (list_is_empty(&ci->_empty_slabs) && _add_slab(ci)) {
+      return NULL;
+    }
+    slab = list_first_element(&ci->_empty_slabs, slab, _node);
+    ci->_slab_empty--;
+  }
+
+  if (slab->free_objects) {
+    /* reuse a freed block */
+    obj = slab->free_objects;
+    slab->free_objects = *obj;
+    ci->_recycled++;
+  }
+  else {
+    /* use the next block that was never handed out */
+    obj = (void **)((char *)slab + _roundup(sizeof(*slab))
+        + (size_t)slab->carved * ci->total_size);
+    slab->carved++;
+    ci->_allocated++;
+  }
+
+  slab->used++;
+  ci->_free_list_size--;
+
+  if (slab->used == ci->_slab_capacity) {
+    list_remove(&slab->_node);
+    list_add_tail(&ci->_full_slabs, &slab->_node);
+  }
+  else if (slab->used == 1) {
+    list_remove(&slab->_node);
+    list_add_head(&ci->_partial_slabs, &slab->_node);
+  }
+  return obj;
+}
+
+/**
+ * Return a memory block to its slab. Empty slabs are kept for reuse
+ * as long as they contain less than ten percent of the used blocks
+ * (or min_free_count blocks), otherwise they are released.
+ * @param ci pointer to memory cookie
+ * @param ptr pointer to memory block
+ */
+static void
+_slab_free(struct oonf_class *ci, void *ptr) {
+  struct _oonf_class_slab *slab;
+
+  slab = (struct _oonf_class_slab *)((size_t)ptr & ~(ci->_slab_size - 1));
+
+  *((void **)ptr) = slab->free_objects;
+  slab->free_objects = ptr;
+
+  if (slab->used == ci->_slab_capacity) {
+    /* reuse the block while it is still in the cache */
+    list_remove(&slab->_node);
+    list_add_head(&ci->_partial_slabs, &slab->_node);
+  }
+
+  slab->used--;
+  ci->_free_list_size++;
+
+  if (slab->used > 0) {
+    return;
+  }
+
+  list_remove(&slab->_node);
+  list_add_tail(&ci->_empty_slabs, &slab->_node);
+  ci->_slab_empty++;
+
+  /* release the oldest empty slabs, keep at least one */
+  while (ci->_slab_empty > 1
+      && ci->_slab_empty * ci->_slab_capacity > ci->min_free_count
+      && ci->_slab_empty * ci->_slab_capacity > ci->_current_usage / 10) {
+    _remove_slab(ci, list_first_element(&ci->_empty_slabs, slab, _node));
   }
-  ci->_free_list_size = 0;
 }
 
 /**
@@ -413,3 +1101,191 @@ _cb_to_keystring(struct oonf_objectkey_str *buf,
 
   return buf->buf;
 }
+
+/**
+ * Check the class and the global memory budget before a new object
+ * is allocated. Pressure callbacks are called when a budget is nearly
+ * exhausted. If they could not free enough memory, they are not called
+ * again before the usage has grown by another five percent of the budget.
+ * @param ci pointer to memory cookie
+ * @return -1 if allocation would exceed a budget, 0 otherwise
+ */
+static int
+_check_budget(struct oonf_class *ci) {
+  size_t usage, target;
+
+  if (ci->_budget > 0) {
+    usage = oonf_class_get_memory_usage(ci) + ci->total_size;
+
+    if (usage >= ci->_budget / 100 * OONF_CLASS_BUDGET_PRESSURE
+        && usage >= ci->_next_pressure && ci->cb_pressure && !ci->_evicting) {
+      target = ci->_budget / 100 * OONF_CLASS_BUDGET_TARGET;
+      _call_pressure(ci, (usage - target + ci->total_size - 1) / ci->total_size);
+
+      ci->_next_pressure = oonf_class_get_memory_usage(ci) + ci->_budget / 20;
+      usage = oonf_class_get_memory_usage(ci) + ci->total_size;
+    }
+
+    if (usage > ci->_budget) {
+      ci->_stat_denied++;
+      OONF_INFO(LOG_CLASS, "Memory budget of class %s exhausted", ci->name);
+      return -1;
+    }
+  }
+
+  if (_global_budget > 0) {
+    usage = _global_usage + ci->total_size;
+
+    if (usage >= _global_budget / 100 * OONF_CLASS_BUDGET_PRESSURE
+        && usage >= _global_next_pressure) {
+      _global_pressure(usage - _global_budget / 100 * OONF_CLASS_BUDGET_TARGET);
+
+      _global_next_pressure = _global_usage + _global_budget / 20;
+      usage = _global_usage + ci->total_size;
+    }
+
+    if (usage > _global_budget) {
+      ci->_stat_denied++;
+      _global_denied++;
+      OONF_INFO(LOG_CLASS, "Global memory budget exhausted, cannot allocate %s",
+          ci->name);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Ask a class to remove some of its objects
+ * @param ci pointer to memory cookie
+ * @param count number of objects to remove
+ */
+static void
+_call_pressure(struct oonf_class *ci, uint32_t count) {
+  uint32_t evicted;
+
+  OONF_INFO(LOG_CLASS, "Memory pressure for class %s: remove %u of %u objects",
+      ci->name, count, ci->_current_usage);
+
+  evicted = ci->_stat_evicted;
+
+  ci->_stat_pressure++;
+  ci->_evicting = true;
+  ci->cb_pressure(ci, count);
+  ci->_evicting = false;
+
+  OONF_INFO(LOG_CLASS, "Class %s: %u objects removed",
+      ci->name, ci->_stat_evicted - evicted);
+}
+
+/**
+ * Distribute the global memory pressure over all classes with
+ * a pressure callback, proportional to their memory usage.
+ * @param bytes number of bytes that should be freed
+ */
+static void
+_global_pressure(size_t bytes) {
+  struct oonf_class *ci;
+  uint64_t evictable, share;
+
+  _global_pressure_count++;
+
+  evictable = 0;
+  avl_for_each_element(&_classes_tree, ci, _node) {
+    if (ci->cb_pressure && !ci->_evicting) {
+      evictable += oonf_class_get_memory_usage(ci);
+    }
+  }
+  if (evictable == 0) {
+    return;
+  }
+
+  avl_for_each_element(&_classes_tree, ci, _node) {
+    if (ci->cb_pressure && !ci->_evicting && ci->_current_usage > 0) {
+      share = (uint64_t)bytes * oonf_class_get_memory_usage(ci) / evictable;
+      _call_pressure(ci, (share + ci->total_size - 1) / ci->total_size);
+    }
+  }
+}
+
+/**
+ * Set memory budget of a class to the configured or default value
+ * @param ci pointer to memory cookie
+ */
+static void
+_apply_class_budget(struct oonf_class *ci) {
+  struct isonumber_str sbuf;
+  const char *name, *ptr;
+  uint64_t budget;
+
+  ci->_budget = ci->budget;
+
+  strarray_for_each_element(&_class_budgets, ptr) {
+    name = str_cpynextword(sbuf.buf, ptr, sizeof(sbuf));
+    if (name != NULL && strcasecmp(name, ci->name) == 0
+        && isonumber_to_u64(&budget, sbuf.buf, 0, true) == 0) {
+      ci->_budget = budget;
+    }
+  }
+  ci->_next_pressure = 0;
+}
+
+/**
+ * Validate a class budget setting
+ * @param entry configuration schema entry
+ * @param section_name name of configuration section
+ * @param value value of setting
+ * @param out buffer for validation errors
+ * @return -1 if setting is invalid, 0 otherwise
+ */
+static int
+_cb_validate_class_budget(const struct cfg_schema_entry *entry,
+      const char *section_name, const char *value, struct autobuf *out) {
+  struct isonumber_str sbuf;
+  const char *ptr;
+
+  /* test if first word is a human readable number */
+  ptr = str_cpynextword(sbuf.buf, value, sizeof(sbuf));
+  if (cfg_validate_int(out, section_name, entry->key.entry, sbuf.buf,
+      0, INT64_MAX, 8, 0, true)) {
+    return -1;
+  }
+
+  if (ptr == NULL) {
+    cfg_append_printable_line(out, "Value '%s' for entry '%s'"
+        " in section %s needs a class name after the budget",
+        value, entry->key.entry, section_name);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Callback triggered when configuration changes
+ */
+static void
+_cb_config_changed(void) {
+  struct _class_config config;
+  const struct const_strarray *array;
+  struct oonf_class *ci;
+
+  memset(&config, 0, sizeof(config));
+  if (cfg_schema_tobin(&config, _class_section.post,
+      _class_entries, ARRAYSIZE(_class_entries))) {
+    OONF_WARN(LOG_CLASS, "Cannot convert " OONF_CLASS_SUBSYSTEM " configuration.");
+    return;
+  }
+
+  _global_budget = config.budget;
+  _global_next_pressure = 0;
+
+  strarray_free(&_class_budgets);
+  array = cfg_db_get_schema_entry_value(_class_section.post, &_class_entries[1]);
+  if (array) {
+    strarray_copy_c(&_class_budgets, array);
+  }
+
+  avl_for_each_element(&_classes_tree, ci, _node) {
+    _apply_class_budget(ci);
+  }
+}
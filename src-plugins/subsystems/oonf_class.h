@@ -49,10 +49,25 @@
 #include "common/common_types.h"
 #include "common/list.h"
 #include "common/avl.h"
+#include "common/hash_index.h"
 
 /*! subsystem identifier */
 #define OONF_CLASS_SUBSYSTEM "class"
 
+enum {
+  /*! minimum number of objects stored in a slab */
+  OONF_CLASS_SLAB_MIN_OBJECTS = 8,
+
+  /*! size of a slab backed by a transparent hugepage */
+  OONF_CLASS_SLAB_HUGEPAGE_SIZE = 2 * 1024 * 1024,
+
+  /*! percentage of a memory budget that triggers the pressure callbacks */
+  OONF_CLASS_BUDGET_PRESSURE = 90,
+
+  /*! percentage of a memory budget the pressure callbacks should reach */
+  OONF_CLASS_BUDGET_TARGET = 80,
+};
+
 /**
  * Events triggered for memory class members
  */
@@ -65,6 +80,9 @@ enum oonf_class_event {
 
   /*! an object will be removed */
   OONF_OBJECT_REMOVED,
+
+  /*! number of event types */
+  OONF_OBJECT_EVENT_COUNT,
 };
 
 /**
@@ -91,6 +109,15 @@ struct oonf_class {
    */
   uint32_t min_free_count;
 
+  /**
+   * true if objects should be carved out of page sized slabs
+   * instead of allocating each of them from the heap
+   */
+  bool slab;
+
+  /*! true if slabs should be backed by transparent hugepages */
+  bool slab_hugepage;
+
   /**
    * Callback to convert object pointer into a human readable string
    * @param buf output buffer for text
@@ -101,6 +128,32 @@ struct oonf_class {
   const char *(*to_keystring)(
       struct oonf_objectkey_str *buf, struct oonf_class *cl, void *ptr);
 
+  /**
+   * Optional callback to initialize a new object. If set, the memory
+   * of the class (without extensions) is not zeroed by the allocator,
+   * so the callback (or the code calling oonf_class_malloc())
+   * must initialize every field.
+   * @param ptr pointer to object
+   */
+  void (*init)(void *ptr);
+
+  /**
+   * default memory budget for the objects of this class in bytes,
+   * 0 for no limit. Can be overwritten by configuration.
+   */
+  size_t budget;
+
+  /**
+   * Optional callback to reduce the number of objects of this class
+   * when the class or the global memory budget is nearly exhausted.
+   * The callback should remove the least valuable objects first.
+   * It is called from oonf_class_malloc(), objects the caller might
+   * still use must only be removed asynchronously.
+   * @param cl oonf class
+   * @param count number of objects that should be removed
+   */
+  void (*cb_pressure)(struct oonf_class *cl, uint32_t count);
+
   /*! Size of class including extensions in bytes */
   size_t total_size;
 
@@ -113,9 +166,81 @@ struct oonf_class {
   /*! extensions of this class */
   struct list_entity _extensions;
 
-  /*! Length of free list */
+  /*! slabs with free and used objects */
+  struct list_entity _partial_slabs;
+
+  /*! slabs without free objects */
+  struct list_entity _full_slabs;
+
+  /*! slabs without used objects */
+  struct list_entity _empty_slabs;
+
+  /*! size of a slab in bytes */
+  size_t _slab_size;
+
+  /*! number of objects in a slab */
+  uint32_t _slab_capacity;
+
+  /*! true if class or one of its extensions has an initializer */
+  bool _custom_init;
+
+  /*! arrays of extensions with a listener for each event type */
+  struct oonf_class_extension **_listeners[OONF_OBJECT_EVENT_COUNT];
+
+  /*! number of extensions in each listener array */
+  uint32_t _listener_count[OONF_OBJECT_EVENT_COUNT];
+
+  /*! allocated length of each listener array */
+  uint32_t _listener_size;
+
+  /*! objects with pending change events of an open batch */
+  void **_batch;
+
+  /*! number of objects in batch array */
+  size_t _batch_count;
+
+  /*! allocated length of batch array */
+  size_t _batch_size;
+
+  /*! index of the objects in the batch array, to queue each object only once */
+  struct hash_index _batch_index;
+
+  /*! objects of the batch that is currently dispatched */
+  void **_dispatched;
+
+  /*! number of objects in dispatched array */
+  size_t _dispatched_count;
+
+  /*! nesting level of open batches */
+  uint32_t _batch_level;
+
+  /*! memory budget in bytes (default or configured), 0 for no limit */
+  size_t _budget;
+
+  /*! class usage in bytes that must be reached before the next pressure callback */
+  size_t _next_pressure;
+
+  /*! true while the pressure callback is running */
+  bool _evicting;
+
+  /*! Stats, number of pressure callbacks */
+  uint32_t _stat_pressure;
+
+  /*! Stats, number of objects freed by pressure callbacks */
+  uint32_t _stat_evicted;
+
+  /*! Stats, number of allocations rejected because of a memory budget */
+  uint32_t _stat_denied;
+
+  /*! Length of free list (or number of unused objects in slabs) */
   uint32_t _free_list_size;
 
+  /*! Stats, number of slabs */
+  uint32_t _slab_count;
+
+  /*! Stats, number of empty slabs */
+  uint32_t _slab_empty;
+
   /*! Stats, resource usage */
   uint32_t _current_usage;
 
@@ -146,6 +271,13 @@ struct oonf_class_extension {
   /*! offset of the extension within the memory block */
   size_t _offset;
 
+  /**
+   * Optional callback to initialize the extension memory of a new object.
+   * If set, the extension memory is not zeroed by the allocator.
+   * @param ptr pointer to object
+   */
+  void (*init)(void *ptr);
+
   /**
    * Callback to notify that a class object was added
    * @param ptr pointer to object
@@ -164,6 +296,20 @@ struct oonf_class_extension {
    */
   void (*cb_remove)(void *ptr);
 
+  /**
+   * Optional callback to notify that a batch of class objects was changed.
+   * If set, it is used instead of cb_change for batched change events.
+   * Each changed object is part of the batch only once.
+   * The array contains no NULL pointers when the callback is called,
+   * but if an object of the batch is removed during the callback
+   * (by the callback itself or by code it triggers), its entry is
+   * set to NULL. The callback must check each entry for NULL before
+   * using it.
+   * @param ptr array of pointers to objects
+   * @param count number of objects in array
+   */
+  void (*cb_change_batch)(void **ptr, size_t count);
+
   /*! node for hooking the consumer into the provider */
   struct list_entity _node;
 };
@@ -175,11 +321,19 @@ EXPORT void oonf_class_remove(struct oonf_class *);
 EXPORT void *oonf_class_malloc(struct oonf_class *)
     __attribute__((warn_unused_result));
 EXPORT void oonf_class_free(struct oonf_class *, void *);
+EXPORT void oonf_class_reclaim(struct oonf_class *);
 
 EXPORT int oonf_class_extension_add(struct oonf_class_extension *);
 EXPORT void oonf_class_extension_remove(struct oonf_class_extension *);
 
 EXPORT void oonf_class_event(struct oonf_class *, void *, enum oonf_class_event);
+EXPORT void oonf_class_event_batch_begin(struct oonf_class *);
+EXPORT void oonf_class_event_batch_end(struct oonf_class *);
+
+EXPORT uint64_t oonf_class_get_global_budget(void);
+EXPORT uint64_t oonf_class_get_global_usage(void);
+EXPORT uint32_t oonf_class_get_global_pressure(void);
+EXPORT uint32_t oonf_class_get_global_denied(void);
 
 EXPORT struct avl_tree *oonf_class_get_tree(void);
 EXPORT const char *oonf_class_get_event_name(enum oonf_class_event);
@@ -220,6 +374,93 @@ oonf_class_get_recycled(struct oonf_class *ci) {
   return ci->_recycled;
 }
 
+/**
+ * @param ci pointer to class
+ * @return number of slabs allocated by class
+ */
+static INLINE uint32_t
+oonf_class_get_slabs(struct oonf_class *ci) {
+  return ci->_slab_count;
+}
+
+/**
+ * @param ci pointer to class
+ * @return number of slabs without used objects
+ */
+static INLINE uint32_t
+oonf_class_get_empty_slabs(struct oonf_class *ci) {
+  return ci->_slab_empty;
+}
+
+/**
+ * @param ci pointer to class
+ * @return percentage of slab objects in use, 0 if class has no slabs
+ */
+static INLINE uint32_t
+oonf_class_get_slab_occupancy(struct oonf_class *ci) {
+  if (ci->_slab_count == 0) {
+    return 0;
+  }
+  return (uint32_t)((uint64_t)ci->_current_usage * 100ull
+      / ((uint64_t)ci->_slab_count * ci->_slab_capacity));
+}
+
+/**
+ * @param ci pointer to class
+ * @return memory budget of class in bytes, 0 if unlimited
+ */
+static INLINE size_t
+oonf_class_get_budget(struct oonf_class *ci) {
+  return ci->_budget;
+}
+
+/**
+ * @param ci pointer to class
+ * @return number of bytes used by objects of the class
+ */
+static INLINE size_t
+oonf_class_get_memory_usage(struct oonf_class *ci) {
+  return ci->_current_usage * ci->total_size;
+}
+
+/**
+ * @param ci pointer to class
+ * @return number of pressure callbacks triggered by memory budgets
+ */
+static INLINE uint32_t
+oonf_class_get_pressure(struct oonf_class *ci) {
+  return ci->_stat_pressure;
+}
+
+/**
+ * @param ci pointer to class
+ * @return number of objects freed by pressure callbacks
+ */
+static INLINE uint32_t
+oonf_class_get_evicted(struct oonf_class *ci) {
+  return ci->_stat_evicted;
+}
+
+/**
+ * @param ci pointer to class
+ * @return number of allocations rejected because of memory budgets
+ */
+static INLINE uint32_t
+oonf_class_get_denied(struct oonf_class *ci) {
+  return ci->_stat_denied;
+}
+
+/**
+ * Mark objects freed from now on as evicted because of memory pressure.
+ * Used by pressure callbacks that remove objects asynchronously.
+ * @param ci pointer to class
+ * @param evicting true to start eviction, false to stop it
+ */
+static INLINE void
+oonf_class_set_evicting(struct oonf_class *ci, bool evicting) {
+  ci->_evicting = evicting;
+}
+
 /**
  * @param ext extension data structure
  * @param ptr pointer to base block
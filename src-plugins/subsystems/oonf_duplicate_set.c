@@ -43,13 +43,16 @@
  * @file
  */
 
-#include "common/avl.h"
+#include <stdlib.h>
+
 #include "common/avl_comp.h"
 #include "common/common_types.h"
+#include "common/list.h"
 #include "common/netaddr.h"
 #include "rfc5444/rfc5444.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/oonf_class.h"
+#include "subsystems/oonf_clock.h"
 #include "subsystems/oonf_timer.h"
 
 #include "subsystems/oonf_duplicate_set.h"
@@ -63,21 +66,62 @@ static void _cleanup(void);
 
 static enum oonf_duplicate_result _test(struct oonf_duplicate_set *,
     struct oonf_duplicate_entry *, uint64_t seqno, bool set);
-static int _avl_cmp_dupkey(const void *, const void*);
-
-static void _cb_vtime(struct oonf_timer_instance *);
+static enum oonf_duplicate_result _test_wide(struct oonf_duplicate_set *,
+    struct oonf_duplicate_entry *, uint64_t seqno, bool set);
+static void _clear_window_bits(uint64_t *words, uint32_t window,
+    uint64_t first, uint32_t count);
+static struct oonf_class *_get_class(struct oonf_duplicate_set *);
+static void _remove_all_entries(struct oonf_duplicate_set *);
+static uint32_t _hash_dupkey(const struct oonf_duplicate_entry_key *);
+static bool _is_equal_dupkey(const struct oonf_duplicate_entry_key *,
+    const struct oonf_duplicate_entry_key *);
+static struct oonf_duplicate_entry *_find_duplicate_entry(
+    struct oonf_duplicate_set *, const struct oonf_duplicate_entry_key *, uint32_t hash);
+static int _grow_buckets(struct oonf_duplicate_set *);
+static void _add_to_wheel(struct oonf_duplicate_set *, struct oonf_duplicate_entry *);
+
+static void _cb_sweep(struct oonf_timer_instance *);
+static void _cb_pressure(struct oonf_class *, uint32_t);
 static void _remove_duplicate_entry(struct oonf_duplicate_entry *entry);
 
-static struct oonf_timer_class _vtime_info = {
-  .name = "Valdity time for duplicate set",
-  .callback = _cb_vtime,
+static struct oonf_timer_class _sweep_info = {
+  .name = "Validity time sweep for duplicate set",
+  .callback = _cb_sweep,
+  .periodic = true,
 };
 
 static struct oonf_class _dupset_class = {
   .name = "Duplicate set",
   .size = sizeof(struct oonf_duplicate_entry),
+  .slab = true,
+  .cb_pressure = _cb_pressure,
 };
 
+/* entries of duplicate sets with 256, 512 and 1024 bit sliding windows */
+static struct oonf_class _wide_dupset_classes[] = {
+  {
+    .name = "Duplicate set 256",
+    .size = sizeof(struct oonf_duplicate_entry) + 1 * sizeof(struct bitmap256),
+    .slab = true,
+    .cb_pressure = _cb_pressure,
+  },
+  {
+    .name = "Duplicate set 512",
+    .size = sizeof(struct oonf_duplicate_entry) + 2 * sizeof(struct bitmap256),
+    .slab = true,
+    .cb_pressure = _cb_pressure,
+  },
+  {
+    .name = "Duplicate set 1024",
+    .size = sizeof(struct oonf_duplicate_entry) + 4 * sizeof(struct bitmap256),
+    .slab = true,
+    .cb_pressure = _cb_pressure,
+  },
+};
+
+/* list of all duplicate sets */
+static struct list_entity _dupset_list;
+
 /* dupset result names */
 static const char *OONF_DUPSET_RESULT_STR[] = {
   [OONF_DUPSET_TOO_OLD]   = "too old",
@@ -116,8 +160,15 @@ static const int64_t _mask_values[] = {
  */
 static int
 _init(void) {
+  size_t i;
+
+  list_init_head(&_dupset_list);
+
   oonf_class_add(&_dupset_class);
-  oonf_timer_add(&_vtime_info);
+  for (i=0; i<ARRAYSIZE(_wide_dupset_classes); i++) {
+    oonf_class_add(&_wide_dupset_classes[i]);
+  }
+  oonf_timer_add(&_sweep_info);
   return 0;
 }
 
@@ -126,7 +177,12 @@ _init(void) {
  */
 static void
 _cleanup(void) {
-  oonf_timer_remove(&_vtime_info);
+  size_t i;
+
+  oonf_timer_remove(&_sweep_info);
+  for (i=0; i<ARRAYSIZE(_wide_dupset_classes); i++) {
+    oonf_class_remove(&_wide_dupset_classes[i]);
+  }
   oonf_class_remove(&_dupset_class);
 }
 
@@ -137,8 +193,14 @@ _cleanup(void) {
  */
 void
 oonf_duplicate_set_add(struct oonf_duplicate_set *set, enum oonf_dupset_type type) {
+  size_t i;
+
   memset(set, 0, sizeof(*set));
-  avl_init(&set->_tree, _avl_cmp_dupkey, false);
+  for (i=0; i<OONF_DUPSET_WHEEL_SLOTS; i++) {
+    list_init_head(&set->_wheel[i]);
+  }
+  set->_sweep_timer.class = &_sweep_info;
+  list_add_tail(&_dupset_list, &set->_node);
 
   if (type != OONF_DUPSET_64BIT) {
     set->_mask   = _mask_values[type];
@@ -153,11 +215,52 @@ oonf_duplicate_set_add(struct oonf_duplicate_set *set, enum oonf_dupset_type typ
  */
 void
 oonf_duplicate_set_remove(struct oonf_duplicate_set *set) {
-  struct oonf_duplicate_entry *entry, *it;
+  _remove_all_entries(set);
+
+  oonf_timer_stop(&set->_sweep_timer);
+  free(set->_buckets);
+  set->_buckets = NULL;
+  set->_bucket_count = 0;
+
+  if (list_is_node_added(&set->_node)) {
+    list_remove(&set->_node);
+  }
+}
+
+/**
+ * Set the number of sequence numbers a duplicate set keeps track of
+ * for each originator. Window sizes larger than the default are
+ * rounded up to 256, 512 or 1024. The window must be smaller than
+ * half of the sequence number space, otherwise the default history
+ * is used. Changing the window size removes all entries of the set.
+ * @param set pointer to duplicate set
+ * @param window number of sequence numbers in sliding window,
+ *   0 for default history
+ */
+void
+oonf_duplicate_set_set_window(struct oonf_duplicate_set *set, uint16_t window) {
+  uint16_t wide = 0;
+
+  if (window > OONF_DUPSET_DEFAULT_WINDOW) {
+    wide = 256;
+    while (wide < window && wide < OONF_DUPSET_MAXIMUM_WINDOW) {
+      wide *= 2;
+    }
+
+    if (set->_mask != 0 && wide > set->_limit) {
+      OONF_WARN(LOG_DUPLICATE_SET, "Sliding window of %u is too large for"
+          " sequence number space, using default history", wide);
+      wide = 0;
+    }
+  }
 
-  avl_for_each_element_safe(&set->_tree, entry, _node, it) {
-    _remove_duplicate_entry(entry);
+  if (wide == set->_window) {
+    return;
   }
+
+  /* entries have a different size now */
+  _remove_all_entries(set);
+  set->_window = wide;
 }
 
 /**
@@ -179,6 +282,7 @@ oonf_duplicate_entry_add(struct oonf_duplicate_set *set, uint8_t msg_type,
   struct oonf_duplicate_entry *entry;
   struct oonf_duplicate_entry_key key;
   enum oonf_duplicate_result result;
+  uint32_t hash;
 
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str nbuf;
@@ -187,10 +291,18 @@ oonf_duplicate_entry_add(struct oonf_duplicate_set *set, uint8_t msg_type,
   /* generate combined key */
   memcpy(&key.addr, originator, sizeof(*originator));
   key.msg_type = msg_type;
+  hash = _hash_dupkey(&key);
 
-  entry = avl_find_element(&set->_tree, &key, entry, _node);
+  entry = _find_duplicate_entry(set, &key, hash);
   if (!entry) {
-    entry = oonf_class_malloc(&_dupset_class);
+    if (set->_entry_count >= set->_bucket_count * OONF_DUPSET_MAX_LOAD) {
+      /* a failed resize only matters if there is no hash table yet */
+      if (_grow_buckets(set) && set->_buckets == NULL) {
+        return OONF_DUPSET_TOO_OLD;
+      }
+    }
+
+    entry = oonf_class_malloc(_get_class(set));
     if (entry == NULL) {
       return OONF_DUPSET_TOO_OLD;
     }
@@ -198,32 +310,42 @@ oonf_duplicate_entry_add(struct oonf_duplicate_set *set, uint8_t msg_type,
     /* initialize history and current sequence number */
     entry->current = seqno;
     entry->history = 1;
+    if (set->_window) {
+      bitmap256_set(&entry->_window[(seqno & (set->_window - 1)) >> 8], seqno & 255);
+    }
 
     /* initialize backpointer */
     entry->set = set;
 
-    /* initialize vtime */
-    entry->_vtime.class = &_vtime_info;
-
-    oonf_timer_start(&entry->_vtime, vtime);
-
     /* set key and link entry to set */
     memcpy(&entry->key, &key, sizeof(key));
-    entry->_node.key = &entry->key;
-    avl_insert(&set->_tree, &entry->_node);
+    entry->_hash = hash;
+    list_add_tail(&set->_buckets[hash & (set->_bucket_count - 1)], &entry->_hash_node);
+    set->_entry_count++;
+
+    /* initialize vtime */
+    entry->_expires = oonf_clock_get_absolute(vtime);
+    _add_to_wheel(set, entry);
 
     result = OONF_DUPSET_FIRST;
   }
   else {
     result = _test(set, entry, seqno, true);
+
+    if (result == OONF_DUPSET_DUPLICATE || result == OONF_DUPSET_CURRENT) {
+      set->_stat_duplicate++;
+    }
+    else if (result == OONF_DUPSET_TOO_OLD) {
+      set->_stat_too_old++;
+    }
   }
   OONF_DEBUG(LOG_DUPLICATE_SET, "Test/Add msgtype %u, originator %s, seqno %"PRIu64": %s",
       msg_type, netaddr_to_string(&nbuf, originator), seqno,
       OONF_DUPSET_RESULT_STR[result]);
 
   if (oonf_duplicate_is_new(result)) {
-    /* reset validity timer */
-    oonf_timer_set(&entry->_vtime, vtime);
+    /* reset validity time, the sweep moves the entry to its new wheel slot */
+    entry->_expires = oonf_clock_get_absolute(vtime);
   }
   return result;
 }
@@ -254,7 +376,7 @@ oonf_duplicate_test(struct oonf_duplicate_set *set, uint8_t msg_type,
   memcpy(&key.addr, originator, sizeof(*originator));
   key.msg_type = msg_type;
 
-  entry = avl_find_element(&set->_tree, &key, entry, _node);
+  entry = _find_duplicate_entry(set, &key, _hash_dupkey(&key));
   if (!entry) {
     result = OONF_DUPSET_FIRST;
   }
@@ -304,6 +426,10 @@ _test(struct oonf_duplicate_set *dupset,
     uint64_t seqno, bool set) {
   int64_t diff;
 
+  if (dupset->_window) {
+    return _test_wide(dupset, entry, seqno, set);
+  }
+
   if (seqno == entry->current) {
     return OONF_DUPSET_CURRENT;
   }
@@ -321,6 +447,7 @@ _test(struct oonf_duplicate_set *dupset,
       entry->too_old_count = 0;
       entry->current = seqno;
 
+      dupset->_stat_reset++;
       return OONF_DUPSET_NEWEST;
     }
     return OONF_DUPSET_TOO_OLD;
@@ -357,6 +484,142 @@ _test(struct oonf_duplicate_set *dupset,
   return OONF_DUPSET_NEWEST;
 }
 
+/**
+ * Test a sequence number against a duplicate set entry with
+ * a wide sliding window. The window is a ring buffer indexed
+ * by the lower bits of the sequence number.
+ * @param dupset duplicate set
+ * @param entry duplicate set entry
+ * @param seqno sequence number
+ * @param set true to add the sequence number to the entry, false
+ *   to leave the entry unchanged.
+ * @return duplicate test result, see _test()
+ */
+static enum oonf_duplicate_result
+_test_wide(struct oonf_duplicate_set *dupset,
+    struct oonf_duplicate_entry *entry,
+    uint64_t seqno, bool set) {
+  uint64_t *words;
+  uint32_t bit;
+  int64_t diff;
+
+  if (seqno == entry->current) {
+    return OONF_DUPSET_CURRENT;
+  }
+
+  words = entry->_window[0].b;
+  bit = seqno & (dupset->_window - 1);
+
+  /* eliminate rollover */
+  diff = _seqno_difference(dupset, seqno, entry->current);
+  if (diff <= -(int64_t)dupset->_window) {
+    entry->too_old_count++;
+    if (entry->too_old_count > OONF_DUPSET_MAXIMUM_TOO_OLD) {
+      /* originator most likely restarted its sequence numbers */
+      memset(words, 0, dupset->_window / 8);
+      bitmap256_set(&entry->_window[bit >> 8], bit & 255);
+      entry->too_old_count = 0;
+      entry->current = seqno;
+
+      dupset->_stat_reset++;
+      return OONF_DUPSET_NEWEST;
+    }
+    return OONF_DUPSET_TOO_OLD;
+  }
+
+  /* reset counter of too old messages */
+  entry->too_old_count = 0;
+
+  if (diff < 0) {
+    if (bitmap256_get(&entry->_window[bit >> 8], bit & 255)) {
+      return OONF_DUPSET_DUPLICATE;
+    }
+
+    if (set) {
+      bitmap256_set(&entry->_window[bit >> 8], bit & 255);
+    }
+    return OONF_DUPSET_NEW;
+  }
+
+  if (set) {
+    /* forget the sequence numbers the window is moving over */
+    if (diff >= dupset->_window) {
+      memset(words, 0, dupset->_window / 8);
+    }
+    else {
+      _clear_window_bits(words, dupset->_window, entry->current + 1, (uint32_t)diff);
+    }
+
+    bitmap256_set(&entry->_window[bit >> 8], bit & 255);
+    entry->current = seqno;
+  }
+  return OONF_DUPSET_NEWEST;
+}
+
+/**
+ * Clear a range of bits of a sliding window ring buffer
+ * @param words array of 64 bit words of the ring buffer
+ * @param window number of bits of the ring buffer
+ * @param first first sequence number to clear
+ * @param count number of sequence numbers to clear,
+ *   must be smaller than the window
+ */
+static void
+_clear_window_bits(uint64_t *words, uint32_t window, uint64_t first, uint32_t count) {
+  uint32_t bit, len;
+  uint64_t mask;
+
+  while (count > 0) {
+    bit = first & (window - 1);
+
+    /* clear up to the end of the current word */
+    len = 64 - (bit & 63);
+    if (len > count) {
+      len = count;
+    }
+
+    mask = len == 64 ? ~0ull : ((1ull << len) - 1) << (bit & 63);
+    words[bit >> 6] &= ~mask;
+
+    first += len;
+    count -= len;
+  }
+}
+
+/**
+ * @param set duplicate set
+ * @return memory class for the entries of the set
+ */
+static struct oonf_class *
+_get_class(struct oonf_duplicate_set *set) {
+  switch (set->_window) {
+    case 256:
+      return &_wide_dupset_classes[0];
+    case 512:
+      return &_wide_dupset_classes[1];
+    case 1024:
+      return &_wide_dupset_classes[2];
+    default:
+      return &_dupset_class;
+  }
+}
+
+/**
+ * Remove all entries of a duplicate set
+ * @param set duplicate set
+ */
+static void
+_remove_all_entries(struct oonf_duplicate_set *set) {
+  struct oonf_duplicate_entry *entry, *it;
+  size_t i;
+
+  for (i=0; i<OONF_DUPSET_WHEEL_SLOTS; i++) {
+    list_for_each_element_safe(&set->_wheel[i], entry, _wheel_node, it) {
+      _remove_duplicate_entry(entry);
+    }
+  }
+}
+
 /**
  * Get text representation of duplicate check result
  * @param result duplicate check result
@@ -368,41 +631,173 @@ oonf_duplicate_get_result_str(enum oonf_duplicate_result result) {
 }
 
 /**
- * Comparator for duplicate entry keys
- * @param p1 key1
- * @param p2 key2
- * @return <0 if p1<p2, 0 if p1==p2, >0 if p1>p2
+ * Calculate the hash value of a duplicate entry key
+ * @param key duplicate entry key
+ * @return hash value
+ */
+static uint32_t
+_hash_dupkey(const struct oonf_duplicate_entry_key *key) {
+  const uint8_t *ptr;
+  uint32_t hash;
+  size_t i, len;
+
+  ptr = netaddr_get_binptr(&key->addr);
+  len = netaddr_get_binlength(&key->addr);
+
+  /* Jenkins one-at-a-time hash over message type and address */
+  hash = key->msg_type;
+  hash += hash << 10;
+  hash ^= hash >> 6;
+  for (i=0; i<len; i++) {
+    hash += ptr[i];
+    hash += hash << 10;
+    hash ^= hash >> 6;
+  }
+  hash += hash << 3;
+  hash ^= hash >> 11;
+  hash += hash << 15;
+  return hash;
+}
+
+/**
+ * Compare two duplicate entry keys
+ * @param k1 key1
+ * @param k2 key2
+ * @return true if both keys are equal, false otherwise
+ */
+static bool
+_is_equal_dupkey(const struct oonf_duplicate_entry_key *k1,
+    const struct oonf_duplicate_entry_key *k2) {
+  return k1->msg_type == k2->msg_type
+      && avl_comp_netaddr(&k1->addr, &k2->addr) == 0;
+}
+
+/**
+ * Lookup a duplicate entry in the hash table of a set
+ * @param set duplicate set
+ * @param key duplicate entry key
+ * @param hash hash value of key
+ * @return duplicate entry, NULL if not found
+ */
+static struct oonf_duplicate_entry *
+_find_duplicate_entry(struct oonf_duplicate_set *set,
+    const struct oonf_duplicate_entry_key *key, uint32_t hash) {
+  struct oonf_duplicate_entry *entry;
+
+  if (set->_buckets == NULL) {
+    return NULL;
+  }
+
+  list_for_each_element(&set->_buckets[hash & (set->_bucket_count - 1)], entry, _hash_node) {
+    if (entry->_hash == hash && _is_equal_dupkey(&entry->key, key)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Double the number of hash buckets of a duplicate set
+ * and rehash all entries.
+ * @param set duplicate set
+ * @return -1 if out of memory, 0 otherwise
  */
 static int
-_avl_cmp_dupkey(const void *p1, const void *p2) {
-  const struct oonf_duplicate_entry_key *k1, *k2;
+_grow_buckets(struct oonf_duplicate_set *set) {
+  struct oonf_duplicate_entry *entry, *it;
+  struct list_entity *buckets;
+  uint32_t i, count;
+
+  count = set->_bucket_count ? set->_bucket_count * 2 : OONF_DUPSET_MIN_BUCKETS;
+  buckets = calloc(count, sizeof(*buckets));
+  if (buckets == NULL) {
+    OONF_WARN(LOG_DUPLICATE_SET, "Out of memory for %u duplicate set buckets", count);
+    return -1;
+  }
 
-  k1 = p1;
-  k2 = p2;
+  for (i=0; i<count; i++) {
+    list_init_head(&buckets[i]);
+  }
 
-  if (k1->msg_type != k2->msg_type) {
-    return (int)(k1->msg_type) - (int)(k2->msg_type);
+  for (i=0; i<set->_bucket_count; i++) {
+    list_for_each_element_safe(&set->_buckets[i], entry, _hash_node, it) {
+      list_add_tail(&buckets[entry->_hash & (count - 1)], &entry->_hash_node);
+    }
   }
 
-  return avl_comp_netaddr(&k1->addr, &k2->addr);
+  free(set->_buckets);
+  set->_buckets = buckets;
+  set->_bucket_count = count;
+  return 0;
 }
 
 /**
- * Callback fired when duplicate entry times out
+ * Add a duplicate entry to the expiry wheel slot of its validity time
+ * and start the sweep timer if necessary.
+ * @param set duplicate set
+ * @param entry duplicate entry
+ */
+static void
+_add_to_wheel(struct oonf_duplicate_set *set, struct oonf_duplicate_entry *entry) {
+  uint64_t tick;
+
+  if (!oonf_timer_is_active(&set->_sweep_timer)) {
+    set->_wheel_tick = oonf_clock_getNow() / OONF_DUPSET_WHEEL_TICK;
+    oonf_timer_set(&set->_sweep_timer, OONF_DUPSET_WHEEL_TICK);
+  }
+
+  /* first tick at which the entry has expired */
+  tick = (entry->_expires + OONF_DUPSET_WHEEL_TICK - 1) / OONF_DUPSET_WHEEL_TICK;
+  if (tick < set->_wheel_tick) {
+    tick = set->_wheel_tick;
+  }
+
+  list_add_tail(&set->_wheel[tick % OONF_DUPSET_WHEEL_SLOTS], &entry->_wheel_node);
+}
+
+/**
+ * Callback to sweep the expired slots of the expiry wheel of a set.
+ * Entries that got a new validity time are moved to their new slot.
  * @param ptr timer instance that fired
  */
 static void
-_cb_vtime(struct oonf_timer_instance *ptr) {
-  struct oonf_duplicate_entry *entry;
+_cb_sweep(struct oonf_timer_instance *ptr) {
+  struct oonf_duplicate_set *set;
+  struct oonf_duplicate_entry *entry, *it;
+  struct list_entity slot;
+  uint64_t now, now_tick;
 #ifdef OONF_LOG_DEBUG_INFO
   struct netaddr_str nbuf;
 #endif
 
-  entry = container_of(ptr, struct oonf_duplicate_entry, _vtime);
-  OONF_DEBUG(LOG_DUPLICATE_SET, "Duplicate entry timed out: %s/%u",
-      netaddr_to_string(&nbuf, &entry->key.addr), entry->key.msg_type);
+  set = container_of(ptr, struct oonf_duplicate_set, _sweep_timer);
+
+  now = oonf_clock_getNow();
+  now_tick = now / OONF_DUPSET_WHEEL_TICK;
 
-  _remove_duplicate_entry(entry);
+  /* one turn of the wheel is enough, even if the timer was delayed */
+  if (now_tick >= set->_wheel_tick + OONF_DUPSET_WHEEL_SLOTS) {
+    set->_wheel_tick = now_tick - OONF_DUPSET_WHEEL_SLOTS + 1;
+  }
+
+  for (; set->_wheel_tick <= now_tick; set->_wheel_tick++) {
+    /* take the slot out of the wheel, entries might be added to it again */
+    list_init_head(&slot);
+    list_merge(&slot, &set->_wheel[set->_wheel_tick % OONF_DUPSET_WHEEL_SLOTS]);
+
+    list_for_each_element_safe(&slot, entry, _wheel_node, it) {
+      if (entry->_expires > now) {
+        /* validity time was refreshed */
+        list_remove(&entry->_wheel_node);
+        _add_to_wheel(set, entry);
+        continue;
+      }
+
+      OONF_DEBUG(LOG_DUPLICATE_SET, "Duplicate entry timed out: %s/%u",
+          netaddr_to_string(&nbuf, &entry->key.addr), entry->key.msg_type);
+      _remove_duplicate_entry(entry);
+    }
+  }
 }
 
 /**
@@ -411,8 +806,49 @@ _cb_vtime(struct oonf_timer_instance *ptr) {
  */
 static void
 _remove_duplicate_entry(struct oonf_duplicate_entry *entry) {
-  oonf_timer_stop(&entry->_vtime);
-  avl_remove(&entry->set->_tree, &entry->_node);
+  struct oonf_duplicate_set *set;
+
+  set = entry->set;
+  list_remove(&entry->_hash_node);
+  list_remove(&entry->_wheel_node);
+  set->_entry_count--;
 
-  oonf_class_free(&_dupset_class, entry);
+  oonf_class_free(_get_class(set), entry);
+
+  if (set->_entry_count == 0) {
+    /* no need to sweep an empty set */
+    oonf_timer_stop(&set->_sweep_timer);
+  }
+}
+
+/**
+ * Callback to remove entries of duplicate sets because of memory
+ * pressure. Entries closest to their expiration are removed first,
+ * so the wheel slots of all sets using the class are walked in
+ * parallel starting with the next slot to be swept.
+ * @param cl class of duplicate entries
+ * @param count number of entries to remove
+ */
+static void
+_cb_pressure(struct oonf_class *cl, uint32_t count) {
+  struct oonf_duplicate_set *set, *set_it;
+  struct oonf_duplicate_entry *entry, *it;
+  size_t i;
+
+  for (i=0; i<OONF_DUPSET_WHEEL_SLOTS; i++) {
+    list_for_each_element_safe(&_dupset_list, set, _node, set_it) {
+      if (_get_class(set) != cl) {
+        continue;
+      }
+
+      list_for_each_element_safe(&set->_wheel[(set->_wheel_tick + i) % OONF_DUPSET_WHEEL_SLOTS],
+          entry, _wheel_node, it) {
+        if (count == 0) {
+          return;
+        }
+        _remove_duplicate_entry(entry);
+        count--;
+      }
+    }
+  }
 }
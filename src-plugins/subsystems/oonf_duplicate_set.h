@@ -46,8 +46,9 @@
 #ifndef OONF_DUPLICATE_SET_H_
 #define OONF_DUPLICATE_SET_H_
 
-#include "common/avl.h"
+#include "common/bitmap256.h"
 #include "common/common_types.h"
+#include "common/list.h"
 #include "common/netaddr.h"
 #include "subsystems/oonf_timer.h"
 
@@ -62,7 +63,25 @@ enum {
    * number of consecutive 'too old' sequence numbers before
    * algorithm resets
    */
-  OONF_DUPSET_MAXIMUM_TOO_OLD = 8
+  OONF_DUPSET_MAXIMUM_TOO_OLD = 8,
+
+  /*! number of hash buckets allocated for the first entry of a set */
+  OONF_DUPSET_MIN_BUCKETS = 64,
+
+  /*! number of entries per bucket before the hash table is doubled */
+  OONF_DUPSET_MAX_LOAD = 2,
+
+  /*! number of slots of the expiry wheel */
+  OONF_DUPSET_WHEEL_SLOTS = 64,
+
+  /*! time interval covered by one slot of the expiry wheel in milliseconds */
+  OONF_DUPSET_WHEEL_TICK = 1000,
+
+  /*! number of sequence numbers tracked by the default history bitmap */
+  OONF_DUPSET_DEFAULT_WINDOW = 32,
+
+  /*! maximum number of sequence numbers tracked by a wide sliding window */
+  OONF_DUPSET_MAXIMUM_WINDOW = 1024,
 };
 
 /**
@@ -92,8 +111,30 @@ enum oonf_duplicate_result {
  * session data for detecting duplicate sequence numbers for addresses
  */
 struct oonf_duplicate_set {
-  /*! tree of duplicate entries */
-  struct avl_tree _tree;
+  /*! hash buckets of duplicate entries, NULL if set is empty */
+  struct list_entity *_buckets;
+
+  /*! number of hash buckets, always a power of two */
+  uint32_t _bucket_count;
+
+  /*! number of entries in duplicate set */
+  uint32_t _entry_count;
+
+  /**
+   * expiry wheel, each slot contains the entries that expire during
+   * one OONF_DUPSET_WHEEL_TICK interval (or a multiple of
+   * OONF_DUPSET_WHEEL_SLOTS intervals later)
+   */
+  struct list_entity _wheel[OONF_DUPSET_WHEEL_SLOTS];
+
+  /*! number of the next tick of the expiry wheel to be swept */
+  uint64_t _wheel_tick;
+
+  /*! periodic timer for sweeping the expiry wheel */
+  struct oonf_timer_instance _sweep_timer;
+
+  /*! node for global list of duplicate sets */
+  struct list_entity _node;
 
   /*! mask for detecting overflow */
   int64_t _mask;
@@ -103,6 +144,18 @@ struct oonf_duplicate_set {
 
   /*! offset to fix overflow */
   int64_t _offset;
+
+  /*! size of the wide sliding window, 0 for the default history */
+  uint16_t _window;
+
+  /*! number of duplicate sequence numbers */
+  uint32_t _stat_duplicate;
+
+  /*! number of too old sequence numbers */
+  uint32_t _stat_too_old;
+
+  /*! number of entries reset because of too many old sequence numbers */
+  uint32_t _stat_reset;
 };
 
 /**
@@ -135,11 +188,20 @@ struct oonf_duplicate_entry {
   /*! back pointer to duplicate set */
   struct oonf_duplicate_set *set;
 
-  /*! node for tree of duplicate set */
-  struct avl_node _node;
+  /*! absolute time when the entry becomes outdated */
+  uint64_t _expires;
+
+  /*! hash value of the key */
+  uint32_t _hash;
+
+  /*! node for hash bucket of duplicate set */
+  struct list_entity _hash_node;
+
+  /*! node for expiry wheel slot of duplicate set */
+  struct list_entity _wheel_node;
 
-  /*! timer for removing outdated duplicate set data */
-  struct oonf_timer_instance _vtime;
+  /*! ring buffer of received sequence numbers for wide sliding windows */
+  struct bitmap256 _window[];
 };
 
 /**
@@ -161,6 +223,7 @@ enum oonf_dupset_type {
 
 EXPORT void oonf_duplicate_set_add(struct oonf_duplicate_set *, enum oonf_dupset_type type);
 EXPORT void oonf_duplicate_set_remove(struct oonf_duplicate_set *);
+EXPORT void oonf_duplicate_set_set_window(struct oonf_duplicate_set *, uint16_t window);
 
 EXPORT enum oonf_duplicate_result oonf_duplicate_entry_add(
     struct oonf_duplicate_set *, uint8_t msg_type,
@@ -184,4 +247,51 @@ oonf_duplicate_is_new(enum oonf_duplicate_result result) {
       || result == OONF_DUPSET_FIRST;
 }
 
+/**
+ * @param set duplicate set
+ * @return number of sequence numbers tracked by the set
+ */
+static INLINE uint16_t
+oonf_duplicate_set_get_window(const struct oonf_duplicate_set *set) {
+  return set->_window ? set->_window : OONF_DUPSET_DEFAULT_WINDOW;
+}
+
+/**
+ * @param set duplicate set
+ * @return number of entries of the set
+ */
+static INLINE uint32_t
+oonf_duplicate_set_get_size(const struct oonf_duplicate_set *set) {
+  return set->_entry_count;
+}
+
+/**
+ * @param set duplicate set
+ * @return number of duplicate (or current) sequence numbers
+ *   added to the set
+ */
+static INLINE uint32_t
+oonf_duplicate_set_get_duplicates(const struct oonf_duplicate_set *set) {
+  return set->_stat_duplicate;
+}
+
+/**
+ * @param set duplicate set
+ * @return number of too old sequence numbers added to the set
+ */
+static INLINE uint32_t
+oonf_duplicate_set_get_too_old(const struct oonf_duplicate_set *set) {
+  return set->_stat_too_old;
+}
+
+/**
+ * @param set duplicate set
+ * @return number of entries that were reset because of a
+ *   continuous series of too old sequence numbers
+ */
+static INLINE uint32_t
+oonf_duplicate_set_get_resets(const struct oonf_duplicate_set *set) {
+  return set->_stat_reset;
+}
+
 #endif /* OONF_DUPLICATE_SET_H_ */
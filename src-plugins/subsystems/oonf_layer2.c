@@ -43,13 +43,19 @@
  * @file
  */
 
+#include <stdlib.h>
+
 #include "common/avl.h"
 #include "common/avl_comp.h"
 #include "common/common_types.h"
 #include "common/netaddr.h"
+#include "common/string.h"
+#include "config/cfg.h"
 #include "config/cfg_schema.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/oonf_class.h"
+#include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_timer.h"
 #include "subsystems/os_interface.h"
 
 #include "subsystems/oonf_layer2.h"
@@ -57,6 +63,20 @@
 /* Definitions */
 #define LOG_LAYER2 _oonf_layer2_subsystem.logging
 
+/**
+ * Configuration of the layer2 database
+ */
+struct _layer2_config {
+  /*! time to collect changes before notifying the layer2 listeners */
+  uint64_t notify_window;
+};
+
+/*! index of history_net entry in configuration schema */
+#define _CFG_HISTORY_NET   1
+
+/*! index of history_neigh entry in configuration schema */
+#define _CFG_HISTORY_NEIGH 2
+
 /* prototypes */
 static int _init(void);
 static void _cleanup(void);
@@ -64,14 +84,62 @@ static void _cleanup(void);
 static void _net_remove(struct oonf_layer2_net *l2net);
 static void _neigh_remove(struct oonf_layer2_neigh *l2neigh);
 
+static int _cb_net_if_changed(struct os_interface_listener *);
+static void _update_net_index(struct oonf_layer2_net *l2net);
+
+static uint32_t _update_committed(const struct oonf_layer2_data *data,
+    int64_t *committed, uint32_t *committed_set, size_t count);
+static void _trigger_notification(void);
+static void _record_history(struct list_entity *history,
+    const struct oonf_layer2_data *data, uint32_t mask, size_t count);
+static const struct oonf_layer2_history *_get_history(
+    const struct list_entity *history, uint32_t idx);
+static void _cleanup_history(struct list_entity *history, uint32_t mask);
+static int _get_net_index(const char *key);
+static int _get_neigh_index(const char *key);
+static int _cb_validate_history_net(const struct cfg_schema_entry *entry,
+    const char *section_name, const char *value, struct autobuf *out);
+static int _cb_validate_history_neigh(const struct cfg_schema_entry *entry,
+    const char *section_name, const char *value, struct autobuf *out);
+static void _cb_notify_listeners(struct oonf_timer_instance *);
+static void _cb_config_changed(void);
+static void _cb_neigh_pressure(struct oonf_class *, uint32_t);
+static void _cb_neigh_evict(struct oonf_timer_instance *);
+static int _cb_compare_neigh_last_seen(const void *, const void *);
+
+/* configuration */
+static struct cfg_schema_entry _layer2_entries[] = {
+  CFG_MAP_CLOCK(_layer2_config, notify_window, "notify_window", "0.0",
+      "Time to collect layer2 data changes before the layer2 listeners are"
+      " notified, 0 means notification in the next time slice."),
+  _CFG_VALIDATE("history_net", "", "Key of a network data entry (e.g. 'noise')"
+      " whose recent values should be stored in a history",
+      .cb_validate = _cb_validate_history_net, .list = true),
+  _CFG_VALIDATE("history_neigh", "", "Key of a neighbor data entry (e.g."
+      " 'rx_bitrate') whose recent values should be stored in a history",
+      .cb_validate = _cb_validate_history_neigh, .list = true),
+};
+
+static struct cfg_schema_section _layer2_section = {
+  .type = OONF_LAYER2_SUBSYSTEM,
+  .mode = CFG_SSMODE_UNNAMED,
+  .help = "Settings of the layer2 database",
+  .cb_delta_handler = _cb_config_changed,
+  .entries = _layer2_entries,
+  .entry_count = ARRAYSIZE(_layer2_entries),
+};
+
 /* subsystem definition */
 static const char *_dependencies[] = {
   OONF_CLASS_SUBSYSTEM,
+  OONF_CLOCK_SUBSYSTEM,
   OONF_OS_INTERFACE_SUBSYSTEM,
+  OONF_TIMER_SUBSYSTEM,
 };
 
 static struct oonf_subsystem _oonf_layer2_subsystem = {
   .name = OONF_LAYER2_SUBSYSTEM,
+  .cfg_section = &_layer2_section,
   .dependencies = _dependencies,
   .dependencies_count = ARRAYSIZE(_dependencies),
   .init = _init,
@@ -129,16 +197,63 @@ static struct oonf_class _l2network_class = {
 static struct oonf_class _l2neighbor_class = {
   .name = LAYER2_CLASS_NEIGHBOR,
   .size = sizeof(struct oonf_layer2_neigh),
+  .cb_pressure = _cb_neigh_pressure,
 };
 static struct oonf_class _l2dst_class = {
   .name = LAYER2_CLASS_DESTINATION,
   .size = sizeof(struct oonf_layer2_destination),
 };
+static struct oonf_class _l2history_class = {
+  .name = LAYER2_CLASS_HISTORY,
+  .size = sizeof(struct oonf_layer2_history),
+};
 
 static struct avl_tree _oonf_layer2_net_tree;
+static struct hash_index _oonf_layer2_net_index;
 
 static struct avl_tree _oonf_originator_tree;
 
+/* listeners for coalesced data changes */
+static struct list_entity _listeners;
+
+/* networks and neighbors with changes that are not yet delivered */
+static struct list_entity _dirty_nets;
+static struct list_entity _dirty_neighs;
+
+/* objects that are currently delivered to the listeners */
+static struct oonf_layer2_net *_notified_net;
+static struct oonf_layer2_neigh *_notified_neigh;
+
+/* time to collect changes before notifying the listeners */
+static uint64_t _notify_window = 0;
+
+/* data indices with a history */
+static uint32_t _history_net_mask = 0;
+static uint32_t _history_neigh_mask = 0;
+
+/* timer to deliver coalesced changes */
+static struct oonf_timer_class _notify_timer_info = {
+  .name = "layer2 change notification",
+  .callback = _cb_notify_listeners,
+};
+
+static struct oonf_timer_instance _notify_timer = {
+  .class = &_notify_timer_info,
+};
+
+/* delayed removal of neighbors because of memory pressure */
+static struct oonf_timer_class _evict_timer_info = {
+  .name = "layer2 neighbor eviction",
+  .callback = _cb_neigh_evict,
+};
+
+static struct oonf_timer_instance _evict_timer = {
+  .class = &_evict_timer_info,
+};
+
+/* number of neighbors that should be removed */
+static uint32_t _evict_count;
+
 /**
  * Subsystem constructor
  * @return always returns 0
@@ -148,9 +263,17 @@ _init(void) {
   oonf_class_add(&_l2network_class);
   oonf_class_add(&_l2neighbor_class);
   oonf_class_add(&_l2dst_class);
+  oonf_class_add(&_l2history_class);
 
   avl_init(&_oonf_layer2_net_tree, avl_comp_strcasecmp, false);
+  hash_index_init(&_oonf_layer2_net_index);
   avl_init(&_oonf_originator_tree, avl_comp_strcasecmp, false);
+
+  list_init_head(&_listeners);
+  list_init_head(&_dirty_nets);
+  list_init_head(&_dirty_neighs);
+  oonf_timer_add(&_notify_timer_info);
+  oonf_timer_add(&_evict_timer_info);
   return 0;
 }
 
@@ -161,10 +284,17 @@ static void
 _cleanup(void) {
   struct oonf_layer2_net *l2net, *l2n_it;
 
+  oonf_timer_stop(&_evict_timer);
+
   avl_for_each_element_safe(&_oonf_layer2_net_tree, l2net, _node, l2n_it) {
     _net_remove(l2net);
   }
+  hash_index_free(&_oonf_layer2_net_index);
 
+  oonf_timer_remove(&_evict_timer_info);
+  oonf_timer_remove(&_notify_timer_info);
+
+  oonf_class_remove(&_l2history_class);
   oonf_class_remove(&_l2dst_class);
   oonf_class_remove(&_l2neighbor_class);
   oonf_class_remove(&_l2network_class);
@@ -199,6 +329,125 @@ oonf_layer2_remove_origin(struct oonf_layer2_origin *origin) {
   avl_remove(&_oonf_originator_tree, &origin->_node);
 }
 
+/**
+ * Register a listener for coalesced layer2 data changes
+ * @param listener layer2 listener
+ */
+void
+oonf_layer2_add_listener(struct oonf_layer2_listener *listener) {
+  list_add_tail(&_listeners, &listener->_node);
+}
+
+/**
+ * Unregister a listener for coalesced layer2 data changes
+ * @param listener layer2 listener
+ */
+void
+oonf_layer2_remove_listener(struct oonf_layer2_listener *listener) {
+  if (list_is_node_added(&listener->_node)) {
+    list_remove(&listener->_node);
+  }
+}
+
+/**
+ * Deliver all pending layer2 data changes to the listeners
+ * immediately instead of waiting for the notification timer.
+ */
+void
+oonf_layer2_flush_changes(void) {
+  struct oonf_layer2_listener *listener, *l_it;
+  struct oonf_layer2_net *l2net;
+  struct oonf_layer2_neigh *l2neigh;
+  uint32_t data_changed, neighdata_changed;
+
+  oonf_timer_stop(&_notify_timer);
+
+  while (!list_is_empty(&_dirty_nets)) {
+    l2net = list_first_element(&_dirty_nets, l2net, _dirty_node);
+    list_remove(&l2net->_dirty_node);
+
+    data_changed = l2net->_dirty_data;
+    neighdata_changed = l2net->_dirty_neighdata;
+    l2net->_dirty_data = 0;
+    l2net->_dirty_neighdata = 0;
+
+    /* a listener might remove the network, so stop when it is gone */
+    _notified_net = l2net;
+    list_for_each_element_safe(&_listeners, listener, _node, l_it) {
+      if (_notified_net == NULL) {
+        break;
+      }
+      if (listener->cb_net_changed
+          && ((data_changed & listener->net_mask) != 0
+              || (neighdata_changed & listener->neighdata_mask) != 0)) {
+        listener->cb_net_changed(l2net, data_changed, neighdata_changed);
+      }
+    }
+    _notified_net = NULL;
+  }
+
+  while (!list_is_empty(&_dirty_neighs)) {
+    l2neigh = list_first_element(&_dirty_neighs, l2neigh, _dirty_node);
+    list_remove(&l2neigh->_dirty_node);
+
+    data_changed = l2neigh->_dirty_data;
+    l2neigh->_dirty_data = 0;
+
+    /* a listener might remove the neighbor, so stop when it is gone */
+    _notified_neigh = l2neigh;
+    list_for_each_element_safe(&_listeners, listener, _node, l_it) {
+      if (_notified_neigh == NULL) {
+        break;
+      }
+      if (listener->cb_neigh_changed
+          && (data_changed & listener->neigh_mask) != 0) {
+        listener->cb_neigh_changed(l2neigh, data_changed);
+      }
+    }
+    _notified_neigh = NULL;
+  }
+}
+
+/**
+ * Set the time to collect layer2 data changes before the listeners
+ * are notified.
+ * @param window notification window in milliseconds, 0 for the
+ *   next time slice
+ */
+void
+oonf_layer2_set_notify_window(uint64_t window) {
+  _notify_window = window;
+
+  if (oonf_timer_is_active(&_notify_timer)) {
+    oonf_timer_stop(&_notify_timer);
+    _trigger_notification();
+  }
+}
+
+/**
+ * Select the layer2 data entries whose recent values are stored
+ * in a history. Histories of data entries not selected anymore
+ * are removed.
+ * @param net_mask bitmask of network data indices
+ * @param neigh_mask bitmask of neighbor data indices
+ */
+void
+oonf_layer2_set_history_mask(uint32_t net_mask, uint32_t neigh_mask) {
+  struct oonf_layer2_net *l2net;
+  struct oonf_layer2_neigh *l2neigh;
+
+  _history_net_mask = net_mask;
+  _history_neigh_mask = neigh_mask;
+
+  avl_for_each_element(&_oonf_layer2_net_tree, l2net, _node) {
+    _cleanup_history(&l2net->history, net_mask);
+
+    avl_for_each_element(&l2net->neighbors, l2neigh, _node) {
+      _cleanup_history(&l2neigh->history, neigh_mask);
+    }
+  }
+}
+
 /**
  * Add a layer-2 network to the database
  * @param ifname name of interface
@@ -231,10 +480,16 @@ oonf_layer2_net_add(const char *ifname) {
 
   /* initialize tree of neighbors and proxies */
   avl_init(&l2net->neighbors, avl_comp_netaddr, false);
+  hash_index_init(&l2net->_neigh_index);
+
+  list_init_node(&l2net->_dirty_node);
+  list_init_head(&l2net->history);
 
   /* initialize interface listener */
   l2net->if_listener.name = l2net->name;
+  l2net->if_listener.if_changed = _cb_net_if_changed;
   os_interface_add(&l2net->if_listener);
+  _update_net_index(l2net);
 
   oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_ADDED);
 
@@ -313,29 +568,37 @@ oonf_layer2_net_remove(struct oonf_layer2_net *l2net,
  */
 bool
 oonf_layer2_net_commit(struct oonf_layer2_net *l2net) {
-  size_t i;
-
-  if (l2net->neighbors.count > 0) {
-    oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_CHANGED);
-    return false;
+  uint32_t data_changed, neighdata_changed;
+
+  data_changed = _update_committed(l2net->data,
+      l2net->_committed_data, &l2net->_committed_data_set,
+      OONF_LAYER2_NET_COUNT);
+  neighdata_changed = _update_committed(l2net->neighdata,
+      l2net->_committed_neighdata, &l2net->_committed_neighdata_set,
+      OONF_LAYER2_NEIGH_COUNT);
+
+  if (_history_net_mask) {
+    _record_history(&l2net->history, l2net->data,
+        _history_net_mask, OONF_LAYER2_NET_COUNT);
   }
 
-  for (i=0; i<OONF_LAYER2_NET_COUNT; i++) {
-    if (oonf_layer2_has_value(&l2net->data[i])) {
-      oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_CHANGED);
-      return false;
-    }
+  if (l2net->neighbors.count == 0 && l2net->_committed_data_set == 0
+      && l2net->_committed_neighdata_set == 0) {
+    _net_remove(l2net);
+    return true;
   }
 
-  for (i=0; i<OONF_LAYER2_NEIGH_COUNT; i++) {
-    if (oonf_layer2_has_value(&l2net->neighdata[i])) {
-      oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_CHANGED);
-      return false;
+  oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_CHANGED);
+
+  if ((data_changed | neighdata_changed) != 0 && !list_is_empty(&_listeners)) {
+    l2net->_dirty_data |= data_changed;
+    l2net->_dirty_neighdata |= neighdata_changed;
+    if (!list_is_node_added(&l2net->_dirty_node)) {
+      list_add_tail(&_dirty_nets, &l2net->_dirty_node);
+      _trigger_notification();
     }
   }
-
-  _net_remove(l2net);
-  return true;
+  return false;
 }
 
 /**
@@ -398,7 +661,13 @@ oonf_layer2_neigh_add(struct oonf_layer2_net *l2net,
   memcpy(&l2neigh->addr, neigh, sizeof(*neigh));
   l2neigh->_node.key = &l2neigh->addr;
   l2neigh->network = l2net;
+  list_init_node(&l2neigh->_dirty_node);
+  list_init_head(&l2neigh->history);
 
+  if (hash_index_add(&l2net->_neigh_index, l2neigh, netaddr_hash(&l2neigh->addr))) {
+    oonf_class_free(&_l2neighbor_class, l2neigh);
+    return NULL;
+  }
   avl_insert(&l2net->neighbors, &l2neigh->_node);
 
   avl_init(&l2neigh->destinations, avl_comp_netaddr, false);
@@ -470,22 +739,32 @@ oonf_layer2_neigh_remove(struct oonf_layer2_neigh *l2neigh,
  */
 bool
 oonf_layer2_neigh_commit(struct oonf_layer2_neigh *l2neigh) {
-  size_t i;
+  uint32_t data_changed;
 
-  if (l2neigh->destinations.count > 0) {
-    oonf_class_event(&_l2neighbor_class, l2neigh, OONF_OBJECT_CHANGED);
-    return false;
+  data_changed = _update_committed(l2neigh->data,
+      l2neigh->_committed_data, &l2neigh->_committed_data_set,
+      OONF_LAYER2_NEIGH_COUNT);
+
+  if (_history_neigh_mask) {
+    _record_history(&l2neigh->history, l2neigh->data,
+        _history_neigh_mask, OONF_LAYER2_NEIGH_COUNT);
   }
 
-  for (i=0; i<OONF_LAYER2_NEIGH_COUNT; i++) {
-    if (oonf_layer2_has_value(&l2neigh->data[i])) {
-      oonf_class_event(&_l2neighbor_class, l2neigh, OONF_OBJECT_CHANGED);
-      return false;
-    }
+  if (l2neigh->destinations.count == 0 && l2neigh->_committed_data_set == 0) {
+    _neigh_remove(l2neigh);
+    return true;
   }
 
-  _neigh_remove(l2neigh);
-  return true;
+  oonf_class_event(&_l2neighbor_class, l2neigh, OONF_OBJECT_CHANGED);
+
+  if (data_changed != 0 && !list_is_empty(&_listeners)) {
+    l2neigh->_dirty_data |= data_changed;
+    if (!list_is_node_added(&l2neigh->_dirty_node)) {
+      list_add_tail(&_dirty_neighs, &l2neigh->_dirty_node);
+      _trigger_notification();
+    }
+  }
+  return false;
 }
 
 /**
@@ -646,6 +925,119 @@ oonf_layer2_change_value(struct oonf_layer2_data *l2data,
   return changed;
 }
 
+/**
+ * Get the history of a network data entry
+ * @param l2net layer2 network
+ * @param idx network data index
+ * @return history, NULL if no history is stored for this data
+ */
+const struct oonf_layer2_history *
+oonf_layer2_net_get_history(const struct oonf_layer2_net *l2net,
+    enum oonf_layer2_network_index idx) {
+  return _get_history(&l2net->history, idx);
+}
+
+/**
+ * Get the history of a neighbor data entry
+ * @param l2neigh layer2 neighbor
+ * @param idx neighbor data index
+ * @return history, NULL if no history is stored for this data
+ */
+const struct oonf_layer2_history *
+oonf_layer2_neigh_get_history(const struct oonf_layer2_neigh *l2neigh,
+    enum oonf_layer2_neighbor_index idx) {
+  return _get_history(&l2neigh->history, idx);
+}
+
+/**
+ * @param history layer2 data history
+ * @return smallest value of history, 0 if history is empty
+ */
+int64_t
+oonf_layer2_history_get_min(const struct oonf_layer2_history *history) {
+  int64_t min;
+  size_t i;
+
+  if (history->count == 0) {
+    return 0;
+  }
+
+  min = INT64_MAX;
+  for (i=0; i<history->count; i++) {
+    if (history->samples[i].value < min) {
+      min = history->samples[i].value;
+    }
+  }
+  return min;
+}
+
+/**
+ * @param history layer2 data history
+ * @return largest value of history, 0 if history is empty
+ */
+int64_t
+oonf_layer2_history_get_max(const struct oonf_layer2_history *history) {
+  int64_t max;
+  size_t i;
+
+  if (history->count == 0) {
+    return 0;
+  }
+
+  max = INT64_MIN;
+  for (i=0; i<history->count; i++) {
+    if (history->samples[i].value > max) {
+      max = history->samples[i].value;
+    }
+  }
+  return max;
+}
+
+/**
+ * @param history layer2 data history
+ * @return average of all values of history, 0 if history is empty
+ */
+int64_t
+oonf_layer2_history_get_average(const struct oonf_layer2_history *history) {
+  int64_t sum;
+  size_t i;
+
+  if (history->count == 0) {
+    return 0;
+  }
+
+  sum = 0;
+  for (i=0; i<history->count; i++) {
+    sum += history->samples[i].value;
+  }
+  return sum / (int64_t)history->count;
+}
+
+/**
+ * Calculate the rate of change between the oldest and the most
+ * recent sample of a history, e.g. a throughput from a byte counter
+ * @param history layer2 data history
+ * @return change of the value per second, 0 if history has
+ *   less than two samples
+ */
+int64_t
+oonf_layer2_history_get_rate(const struct oonf_layer2_history *history) {
+  const struct oonf_layer2_sample *first, *last;
+
+  if (history->count < 2) {
+    return 0;
+  }
+
+  first = oonf_layer2_history_get_sample(history, 0);
+  last = oonf_layer2_history_get_last(history);
+  if (last->timestamp <= first->timestamp) {
+    return 0;
+  }
+
+  return (last->value - first->value) * 1000
+      / (int64_t)(last->timestamp - first->timestamp);
+}
+
 /**
  * get neighbor metric metadata
  * @param idx neighbor metric index
@@ -685,6 +1077,15 @@ oonf_layer2_get_network_tree(void) {
   return &_oonf_layer2_net_tree;
 }
 
+/**
+ * get hash index of layer2 networks by interface index
+ * @return network index
+ */
+struct hash_index *
+oonf_layer2_get_network_index(void) {
+  return &_oonf_layer2_net_index;
+}
+
 /**
  * get tree of layer2 originators
  * @return originator tree
@@ -709,10 +1110,24 @@ _net_remove(struct oonf_layer2_net *l2net) {
 
   oonf_class_event(&_l2network_class, l2net, OONF_OBJECT_REMOVED);
 
+  /* drop pending change notifications */
+  if (list_is_node_added(&l2net->_dirty_node)) {
+    list_remove(&l2net->_dirty_node);
+  }
+  if (_notified_net == l2net) {
+    _notified_net = NULL;
+  }
+
   /* remove interface listener */
   os_interface_remove(&l2net->if_listener);
 
+  _cleanup_history(&l2net->history, 0);
+
   /* free addr */
+  if (l2net->if_index) {
+    hash_index_remove(&_oonf_layer2_net_index, l2net, l2net->if_index);
+  }
+  hash_index_free(&l2net->_neigh_index);
   avl_remove(&_oonf_layer2_net_tree, &l2net->_node);
   oonf_class_free(&_l2network_class, l2net);
 }
@@ -733,7 +1148,394 @@ _neigh_remove(struct oonf_layer2_neigh *l2neigh) {
   /* inform user that mac entry will be removed */
   oonf_class_event(&_l2neighbor_class, l2neigh, OONF_OBJECT_REMOVED);
 
+  /* drop pending change notifications */
+  if (list_is_node_added(&l2neigh->_dirty_node)) {
+    list_remove(&l2neigh->_dirty_node);
+  }
+  if (_notified_neigh == l2neigh) {
+    _notified_neigh = NULL;
+  }
+
   /* free resources for mac entry */
+  _cleanup_history(&l2neigh->history, 0);
+  hash_index_remove(&l2neigh->network->_neigh_index,
+      l2neigh, netaddr_hash(&l2neigh->addr));
   avl_remove(&l2neigh->network->neighbors, &l2neigh->_node);
   oonf_class_free(&_l2neighbor_class, l2neigh);
 }
+
+/**
+ * Callback for interface changes of a layer-2 network
+ * @param if_listener interface listener of the layer-2 network
+ * @return always 0
+ */
+static int
+_cb_net_if_changed(struct os_interface_listener *if_listener) {
+  struct oonf_layer2_net *l2net;
+
+  l2net = container_of(if_listener, struct oonf_layer2_net, if_listener);
+  _update_net_index(l2net);
+  return 0;
+}
+
+/**
+ * Keep the interface index of a layer-2 network and the
+ * interface index hash in sync with the operation system
+ * @param l2net layer-2 network
+ */
+static void
+_update_net_index(struct oonf_layer2_net *l2net) {
+  unsigned if_index;
+
+  if_index = l2net->if_listener.data ? l2net->if_listener.data->index : 0;
+  if (if_index == l2net->if_index) {
+    return;
+  }
+
+  if (l2net->if_index) {
+    hash_index_remove(&_oonf_layer2_net_index, l2net, l2net->if_index);
+  }
+
+  l2net->if_index = if_index;
+  if (if_index && hash_index_add(&_oonf_layer2_net_index, l2net, if_index)) {
+    OONF_WARN(LOG_LAYER2, "Could not index layer2 network %s", l2net->name);
+    l2net->if_index = 0;
+  }
+}
+
+/**
+ * Compare layer2 data with the values of the last commit and
+ * remember the current values for the next commit.
+ * @param data array of layer2 data
+ * @param committed array of values of the last commit
+ * @param committed_set pointer to bitmask of data with a value
+ *   at the last commit
+ * @param count number of elements in the arrays, at most 32
+ * @return bitmask of changed data indices
+ */
+static uint32_t
+_update_committed(const struct oonf_layer2_data *data,
+    int64_t *committed, uint32_t *committed_set, size_t count) {
+  uint32_t changed, value_set, bit;
+  size_t i;
+
+  changed = 0;
+  value_set = 0;
+  for (i=0; i<count; i++) {
+    bit = OONF_LAYER2_MASK(i);
+    if (oonf_layer2_has_value(&data[i])) {
+      value_set |= bit;
+      if ((*committed_set & bit) == 0
+          || committed[i] != oonf_layer2_get_value(&data[i])) {
+        committed[i] = oonf_layer2_get_value(&data[i]);
+        changed |= bit;
+      }
+    }
+    else if (*committed_set & bit) {
+      changed |= bit;
+    }
+  }
+
+  *committed_set = value_set;
+  return changed;
+}
+
+/**
+ * Add a sample of the current value of all selected data entries
+ * to their histories.
+ * @param history list of histories of network or neighbor
+ * @param data array of layer2 data
+ * @param mask bitmask of data indices with a history
+ * @param count number of elements in data array
+ */
+static void
+_record_history(struct list_entity *history,
+    const struct oonf_layer2_data *data, uint32_t mask, size_t count) {
+  struct oonf_layer2_history *h;
+  struct oonf_layer2_sample *sample;
+  uint64_t now;
+  size_t i;
+
+  now = oonf_clock_getNow();
+  for (i=0; i<count; i++) {
+    if ((mask & OONF_LAYER2_MASK(i)) == 0 || !oonf_layer2_has_value(&data[i])) {
+      continue;
+    }
+
+    h = (struct oonf_layer2_history *)_get_history(history, i);
+    if (!h) {
+      h = oonf_class_malloc(&_l2history_class);
+      if (!h) {
+        continue;
+      }
+      h->index = i;
+      list_add_tail(history, &h->_node);
+    }
+
+    if (h->count > 0
+        && oonf_layer2_history_get_last(h)->timestamp == now) {
+      /* only keep the last value of multiple commits in one time slice */
+      sample = (struct oonf_layer2_sample *)oonf_layer2_history_get_last(h);
+    }
+    else {
+      sample = &h->samples[h->next];
+      h->next = (h->next + 1) % OONF_LAYER2_HISTORY_LENGTH;
+      if (h->count < OONF_LAYER2_HISTORY_LENGTH) {
+        h->count++;
+      }
+    }
+    sample->timestamp = now;
+    sample->value = oonf_layer2_get_value(&data[i]);
+  }
+}
+
+/**
+ * Get the history of a data index
+ * @param history list of histories of network or neighbor
+ * @param idx data index
+ * @return history, NULL if not found
+ */
+static const struct oonf_layer2_history *
+_get_history(const struct list_entity *history, uint32_t idx) {
+  struct oonf_layer2_history *h;
+
+  list_for_each_element(history, h, _node) {
+    if (h->index == idx) {
+      return h;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Remove all histories of unselected data indices
+ * @param history list of histories of network or neighbor
+ * @param mask bitmask of data indices whose histories are kept
+ */
+static void
+_cleanup_history(struct list_entity *history, uint32_t mask) {
+  struct oonf_layer2_history *h, *h_it;
+
+  list_for_each_element_safe(history, h, _node, h_it) {
+    if ((mask & OONF_LAYER2_MASK(h->index)) == 0) {
+      list_remove(&h->_node);
+      oonf_class_free(&_l2history_class, h);
+    }
+  }
+}
+
+/**
+ * @param key key of network data entry
+ * @return network data index, -1 if key is unknown
+ */
+static int
+_get_net_index(const char *key) {
+  int i;
+
+  for (i=0; i<OONF_LAYER2_NET_COUNT; i++) {
+    if (strcasecmp(key, _oonf_layer2_metadata_net[i].key) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @param key key of neighbor data entry
+ * @return neighbor data index, -1 if key is unknown
+ */
+static int
+_get_neigh_index(const char *key) {
+  int i;
+
+  for (i=0; i<OONF_LAYER2_NEIGH_COUNT; i++) {
+    if (strcasecmp(key, _oonf_layer2_metadata_neigh[i].key) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Validate a network history setting
+ * @param entry configuration schema entry
+ * @param section_name name of configuration section
+ * @param value value of setting
+ * @param out buffer for validation errors
+ * @return -1 if setting is invalid, 0 otherwise
+ */
+static int
+_cb_validate_history_net(const struct cfg_schema_entry *entry,
+      const char *section_name, const char *value, struct autobuf *out) {
+  if (_get_net_index(value) < 0) {
+    cfg_append_printable_line(out, "Value '%s' for entry '%s'"
+        " in section %s is no layer2 network data key",
+        value, entry->key.entry, section_name);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Validate a neighbor history setting
+ * @param entry configuration schema entry
+ * @param section_name name of configuration section
+ * @param value value of setting
+ * @param out buffer for validation errors
+ * @return -1 if setting is invalid, 0 otherwise
+ */
+static int
+_cb_validate_history_neigh(const struct cfg_schema_entry *entry,
+      const char *section_name, const char *value, struct autobuf *out) {
+  if (_get_neigh_index(value) < 0) {
+    cfg_append_printable_line(out, "Value '%s' for entry '%s'"
+        " in section %s is no layer2 neighbor data key",
+        value, entry->key.entry, section_name);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Start the timer to notify the layer2 listeners about changes
+ */
+static void
+_trigger_notification(void) {
+  if (!oonf_timer_is_active(&_notify_timer)) {
+    oonf_timer_set(&_notify_timer, _notify_window > 0 ? _notify_window : 1);
+  }
+}
+
+/**
+ * Callback to deliver coalesced changes to the layer2 listeners
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_notify_listeners(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  oonf_layer2_flush_changes();
+}
+
+/**
+ * Callback triggered when configuration changes
+ */
+static void
+_cb_config_changed(void) {
+  struct _layer2_config config;
+  const struct const_strarray *array;
+  uint32_t net_mask, neigh_mask;
+  const char *key;
+  int idx;
+
+  memset(&config, 0, sizeof(config));
+  if (cfg_schema_tobin(&config, _layer2_section.post,
+      _layer2_entries, ARRAYSIZE(_layer2_entries))) {
+    OONF_WARN(LOG_LAYER2, "Cannot convert " OONF_LAYER2_SUBSYSTEM " configuration.");
+    return;
+  }
+
+  oonf_layer2_set_notify_window(config.notify_window);
+
+  net_mask = 0;
+  array = cfg_db_get_schema_entry_value(
+      _layer2_section.post, &_layer2_entries[_CFG_HISTORY_NET]);
+  if (array) {
+    strarray_for_each_element(array, key) {
+      if ((idx = _get_net_index(key)) >= 0) {
+        net_mask |= OONF_LAYER2_MASK(idx);
+      }
+    }
+  }
+
+  neigh_mask = 0;
+  array = cfg_db_get_schema_entry_value(
+      _layer2_section.post, &_layer2_entries[_CFG_HISTORY_NEIGH]);
+  if (array) {
+    strarray_for_each_element(array, key) {
+      if ((idx = _get_neigh_index(key)) >= 0) {
+        neigh_mask |= OONF_LAYER2_MASK(idx);
+      }
+    }
+  }
+
+  oonf_layer2_set_history_mask(net_mask, neigh_mask);
+}
+
+/**
+ * Callback for memory pressure of layer2 neighbor class. The caller
+ * of oonf_class_malloc() might still use a neighbor, so the neighbors
+ * are removed by a timer.
+ * @param cl layer2 neighbor class
+ * @param count number of neighbors to remove
+ */
+static void
+_cb_neigh_pressure(struct oonf_class *cl __attribute__((unused)), uint32_t count) {
+  if (count > _evict_count) {
+    _evict_count = count;
+  }
+  if (!oonf_timer_is_active(&_evict_timer)) {
+    oonf_timer_set(&_evict_timer, 1);
+  }
+}
+
+/**
+ * Callback to remove layer2 neighbors because of memory pressure.
+ * Neighbors that have not been active for the longest time are
+ * removed first.
+ * @param ptr timer instance that fired
+ */
+static void
+_cb_neigh_evict(struct oonf_timer_instance *ptr __attribute__((unused))) {
+  struct oonf_layer2_neigh **neighs, *l2neigh;
+  struct oonf_layer2_net *l2net;
+  uint32_t count;
+  size_t i, n;
+
+  count = _evict_count;
+  _evict_count = 0;
+
+  n = 0;
+  avl_for_each_element(&_oonf_layer2_net_tree, l2net, _node) {
+    n += l2net->neighbors.count;
+  }
+  if (n == 0) {
+    return;
+  }
+
+  neighs = calloc(n, sizeof(*neighs));
+  if (neighs == NULL) {
+    return;
+  }
+
+  n = 0;
+  avl_for_each_element(&_oonf_layer2_net_tree, l2net, _node) {
+    avl_for_each_element(&l2net->neighbors, l2neigh, _node) {
+      neighs[n++] = l2neigh;
+    }
+  }
+
+  qsort(neighs, n, sizeof(*neighs), _cb_compare_neigh_last_seen);
+
+  oonf_class_set_evicting(&_l2neighbor_class, true);
+  for (i = 0; i < n && i < count; i++) {
+    _neigh_remove(neighs[i]);
+  }
+  oonf_class_set_evicting(&_l2neighbor_class, false);
+  free(neighs);
+}
+
+/**
+ * Compare two layer2 neighbors by their last activity, oldest one first
+ * @param p1 pointer to pointer to first layer2 neighbor
+ * @param p2 pointer to pointer to second layer2 neighbor
+ * @return -1 if first neighbor is older, 1 if second one, 0 otherwise
+ */
+static int
+_cb_compare_neigh_last_seen(const void *p1, const void *p2) {
+  const struct oonf_layer2_neigh *n1 = *((struct oonf_layer2_neigh * const *)p1);
+  const struct oonf_layer2_neigh *n2 = *((struct oonf_layer2_neigh * const *)p2);
+
+  if (n1->last_seen != n2->last_seen) {
+    return n1->last_seen < n2->last_seen ? -1 : 1;
+  }
+  return 0;
+}
@@ -48,6 +48,9 @@
 
 #include "common/avl.h"
 #include "common/common_types.h"
+#include "common/hash_index.h"
+#include "common/list.h"
+#include "common/netaddr.h"
 #include "core/oonf_subsystem.h"
 #include "subsystems/os_interface.h"
 
@@ -63,6 +66,15 @@
 /*! memory class for layer2 destination */
 #define LAYER2_CLASS_DESTINATION "layer2_destination"
 
+/*! memory class for layer2 data history */
+#define LAYER2_CLASS_HISTORY     "layer2_history"
+
+/*! number of samples stored in a layer2 data history */
+#define OONF_LAYER2_HISTORY_LENGTH 16
+
+/*! bitmask for a single layer2 network or neighbor data index */
+#define OONF_LAYER2_MASK(idx) (UINT32_C(1) << (idx))
+
 /**
  * priorities of layer2 originators
  */
@@ -103,6 +115,38 @@ struct oonf_layer2_data {
   const struct oonf_layer2_origin *_origin;
 };
 
+/**
+ * Timestamped sample of a layer2 data value
+ */
+struct oonf_layer2_sample {
+  /*! absolute timestamp of the sample */
+  uint64_t timestamp;
+
+  /*! value of the sample */
+  int64_t value;
+};
+
+/**
+ * Ringbuffer with the recent values of a single layer2 data entry
+ * of a network or neighbor
+ */
+struct oonf_layer2_history {
+  /*! data index (network or neighbor index, depending on the owner) */
+  uint32_t index;
+
+  /*! number of valid samples in ringbuffer */
+  uint32_t count;
+
+  /*! position of the next sample in ringbuffer */
+  uint32_t next;
+
+  /*! ringbuffer of samples */
+  struct oonf_layer2_sample samples[OONF_LAYER2_HISTORY_LENGTH];
+
+  /*! node for list of histories of network or neighbor */
+  struct list_entity _node;
+};
+
 /**
  * list of layer2 network metrics
  */
@@ -138,6 +182,9 @@ enum oonf_layer2_network_index {
   OONF_LAYER2_NET_COUNT,
 };
 
+/*! bitmask of all layer2 network data indices */
+#define OONF_LAYER2_NET_MASK_ALL (OONF_LAYER2_MASK(OONF_LAYER2_NET_COUNT) - 1)
+
 /**
  * list with types of layer2 networks
  */
@@ -212,6 +259,9 @@ enum oonf_layer2_neighbor_index {
   OONF_LAYER2_NEIGH_COUNT,
 };
 
+/*! bitmask of all layer2 neighbor data indices */
+#define OONF_LAYER2_NEIGH_MASK_ALL (OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_COUNT) - 1)
+
 /**
  * representation of a layer2 interface
  */
@@ -234,6 +284,12 @@ struct oonf_layer2_net {
   /*! tree of remote neighbors */
   struct avl_tree neighbors;
 
+  /*! hash index of remote neighbors by MAC address */
+  struct hash_index _neigh_index;
+
+  /*! interface index of the network, 0 if not known yet */
+  unsigned if_index;
+
   /*! absolute timestamp when network has been active last */
   uint64_t last_seen;
 
@@ -243,8 +299,32 @@ struct oonf_layer2_net {
   /*! default values of neighbor layer2 data */
   struct oonf_layer2_data neighdata[OONF_LAYER2_NEIGH_COUNT];
 
+  /*! network data values of the last commit */
+  int64_t _committed_data[OONF_LAYER2_NET_COUNT];
+
+  /*! neighbor default values of the last commit */
+  int64_t _committed_neighdata[OONF_LAYER2_NEIGH_COUNT];
+
+  /*! bitmask of network data with a value at the last commit */
+  uint32_t _committed_data_set;
+
+  /*! bitmask of neighbor defaults with a value at the last commit */
+  uint32_t _committed_neighdata_set;
+
+  /*! bitmask of network data changed since the last notification */
+  uint32_t _dirty_data;
+
+  /*! bitmask of neighbor defaults changed since the last notification */
+  uint32_t _dirty_neighdata;
+
+  /*! list of histories of network data */
+  struct list_entity history;
+
   /*! node to hook into global l2network tree */
   struct avl_node _node;
+
+  /*! member entry for list of networks waiting for notification */
+  struct list_entity _dirty_node;
 };
 
 /**
@@ -266,8 +346,23 @@ struct oonf_layer2_neigh {
   /*! neigbor layer 2 data */
   struct oonf_layer2_data data[OONF_LAYER2_NEIGH_COUNT];
 
+  /*! neighbor data values of the last commit */
+  int64_t _committed_data[OONF_LAYER2_NEIGH_COUNT];
+
+  /*! bitmask of neighbor data with a value at the last commit */
+  uint32_t _committed_data_set;
+
+  /*! bitmask of neighbor data changed since the last notification */
+  uint32_t _dirty_data;
+
+  /*! list of histories of neighbor data */
+  struct list_entity history;
+
   /*! node to hook into tree of layer2 network */
   struct avl_node _node;
+
+  /*! member entry for list of neighbors waiting for notification */
+  struct list_entity _dirty_node;
 };
 
 /**
@@ -304,9 +399,56 @@ struct oonf_layer2_metadata {
   const bool binary;
 };
 
+/**
+ * Listener for coalesced changes of layer2 data. All commits of
+ * a network or neighbor between two notifications are merged into
+ * a single callback with a bitmask of the changed data indices.
+ * Addition and removal of objects are still reported through the
+ * class events of the layer2 memory classes.
+ */
+struct oonf_layer2_listener {
+  /*! name of the listener */
+  const char *name;
+
+  /*! bitmask of network data (enum oonf_layer2_network_index) of interest */
+  uint32_t net_mask;
+
+  /*! bitmask of network neighbor defaults (enum oonf_layer2_neighbor_index) of interest */
+  uint32_t neighdata_mask;
+
+  /*! bitmask of neighbor data (enum oonf_layer2_neighbor_index) of interest */
+  uint32_t neigh_mask;
+
+  /**
+   * Callback for changed network data
+   * @param l2net layer2 network
+   * @param data_changed bitmask of changed network data
+   * @param neighdata_changed bitmask of changed neighbor defaults
+   */
+  void (*cb_net_changed)(struct oonf_layer2_net *l2net,
+      uint32_t data_changed, uint32_t neighdata_changed);
+
+  /**
+   * Callback for changed neighbor data
+   * @param l2neigh layer2 neighbor
+   * @param data_changed bitmask of changed neighbor data
+   */
+  void (*cb_neigh_changed)(struct oonf_layer2_neigh *l2neigh,
+      uint32_t data_changed);
+
+  /*! node for list of listeners */
+  struct list_entity _node;
+};
+
 EXPORT void oonf_layer2_add_origin(struct oonf_layer2_origin *origin);
 EXPORT void oonf_layer2_remove_origin(struct oonf_layer2_origin *origin);
 
+EXPORT void oonf_layer2_add_listener(struct oonf_layer2_listener *listener);
+EXPORT void oonf_layer2_remove_listener(struct oonf_layer2_listener *listener);
+EXPORT void oonf_layer2_flush_changes(void);
+EXPORT void oonf_layer2_set_notify_window(uint64_t window);
+EXPORT void oonf_layer2_set_history_mask(uint32_t net_mask, uint32_t neigh_mask);
+
 EXPORT struct oonf_layer2_net *oonf_layer2_net_add(const char *ifname);
 EXPORT bool oonf_layer2_net_remove(
     struct oonf_layer2_net *, const struct oonf_layer2_origin *origin);
@@ -343,14 +485,55 @@ EXPORT const struct oonf_layer2_data *oonf_layer2_neigh_get_value(
 EXPORT bool oonf_layer2_change_value(struct oonf_layer2_data *l2data,
     const struct oonf_layer2_origin *origin, int64_t value);
 
+EXPORT const struct oonf_layer2_history *oonf_layer2_net_get_history(
+    const struct oonf_layer2_net *l2net, enum oonf_layer2_network_index idx);
+EXPORT const struct oonf_layer2_history *oonf_layer2_neigh_get_history(
+    const struct oonf_layer2_neigh *l2neigh, enum oonf_layer2_neighbor_index idx);
+EXPORT int64_t oonf_layer2_history_get_min(const struct oonf_layer2_history *);
+EXPORT int64_t oonf_layer2_history_get_max(const struct oonf_layer2_history *);
+EXPORT int64_t oonf_layer2_history_get_average(const struct oonf_layer2_history *);
+EXPORT int64_t oonf_layer2_history_get_rate(const struct oonf_layer2_history *);
+
 EXPORT const struct oonf_layer2_metadata *oonf_layer2_get_neigh_metadata(
     enum oonf_layer2_neighbor_index);
 EXPORT const struct oonf_layer2_metadata *oonf_layer2_get_net_metadata(
     enum oonf_layer2_network_index);
 EXPORT const char *oonf_layer2_get_network_type(enum oonf_layer2_network_type);
 EXPORT struct avl_tree *oonf_layer2_get_network_tree(void);
+EXPORT struct hash_index *oonf_layer2_get_network_index(void);
 EXPORT struct avl_tree *oonf_layer2_get_origin_tree(void);
 
+/**
+ * @param history layer2 data history
+ * @return number of samples in history
+ */
+static INLINE size_t
+oonf_layer2_history_get_count(const struct oonf_layer2_history *history) {
+  return history->count;
+}
+
+/**
+ * Get a sample of a layer2 data history
+ * @param history layer2 data history
+ * @param i number of the sample, 0 is the oldest one,
+ *     must be smaller than the number of samples
+ * @return pointer to sample
+ */
+static INLINE const struct oonf_layer2_sample *
+oonf_layer2_history_get_sample(const struct oonf_layer2_history *history, size_t i) {
+  return &history->samples[(history->next + OONF_LAYER2_HISTORY_LENGTH
+      - history->count + i) % OONF_LAYER2_HISTORY_LENGTH];
+}
+
+/**
+ * @param history layer2 data history
+ * @return pointer to most recent sample
+ */
+static INLINE const struct oonf_layer2_sample *
+oonf_layer2_history_get_last(const struct oonf_layer2_history *history) {
+  return oonf_layer2_history_get_sample(history, history->count - 1);
+}
+
 /**
  * Checks if a layer2 originator is registered
  * @param origin originator
@@ -372,6 +555,25 @@ oonf_layer2_net_get(const char *ifname) {
   return avl_find_element(oonf_layer2_get_network_tree(), ifname, l2net, _node);
 }
 
+/**
+ * Get a layer-2 interface object from the database
+ * @param if_index interface index
+ * @return layer-2 addr object, NULL if not found
+ */
+static INLINE struct oonf_layer2_net *
+oonf_layer2_net_get_by_index(unsigned if_index) {
+  struct oonf_layer2_net *l2net;
+  size_t pos;
+
+  /* interface indices are small unique numbers, use them as hash */
+  hash_index_for_each_match(oonf_layer2_get_network_index(), if_index, l2net, pos) {
+    if (l2net->if_index == if_index) {
+      return l2net;
+    }
+  }
+  return NULL;
+}
+
 /**
  * Get a layer-2 neighbor object from the database
  * @param l2net layer-2 addr object
@@ -382,7 +584,57 @@ static INLINE struct oonf_layer2_neigh *
 oonf_layer2_neigh_get(const struct oonf_layer2_net *l2net,
     const struct netaddr *addr) {
   struct oonf_layer2_neigh *l2neigh;
-  return avl_find_element(&l2net->neighbors, addr, l2neigh, _node);
+  size_t pos;
+
+  hash_index_for_each_match(&l2net->_neigh_index, netaddr_hash(addr), l2neigh, pos) {
+    if (netaddr_cmp(&l2neigh->addr, addr) == 0) {
+      return l2neigh;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Get a layer-2 neighbor object from the database
+ * @param l2net layer-2 addr object
+ * @param mac binary MAC address of neighbor
+ * @param mac_len length of MAC address, 6 (MAC48) or 8 (EUI64)
+ * @return layer-2 neighbor object, NULL if not found
+ */
+static INLINE struct oonf_layer2_neigh *
+oonf_layer2_neigh_get_by_mac(const struct oonf_layer2_net *l2net,
+    const void *mac, size_t mac_len) {
+  struct netaddr addr;
+
+  if (mac_len != 6 && mac_len != 8) {
+    return NULL;
+  }
+
+  /* build the address inline, this is a hot path */
+  memset(&addr, 0, sizeof(addr));
+  memcpy(addr._addr, mac, mac_len);
+  addr._type = mac_len == 6 ? AF_MAC48 : AF_EUI64;
+  addr._prefix_len = mac_len * 8;
+  return oonf_layer2_neigh_get(l2net, &addr);
+}
+
+/**
+ * Get a layer-2 neighbor object from the database
+ * @param if_index interface index of the layer-2 network
+ * @param mac binary MAC address of neighbor
+ * @param mac_len length of MAC address, 6 (MAC48) or 8 (EUI64)
+ * @return layer-2 neighbor object, NULL if not found
+ */
+static INLINE struct oonf_layer2_neigh *
+oonf_layer2_neigh_get_by_index(unsigned if_index,
+    const void *mac, size_t mac_len) {
+  struct oonf_layer2_net *l2net;
+
+  l2net = oonf_layer2_net_get_by_index(if_index);
+  if (l2net == NULL) {
+    return NULL;
+  }
+  return oonf_layer2_neigh_get_by_mac(l2net, mac, mac_len);
 }
 
 static INLINE struct oonf_layer2_destination *
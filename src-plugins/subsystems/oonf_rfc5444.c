@@ -74,6 +74,12 @@ struct _rfc5444_config {
 
   /*! IP protocol number to be used for RFC5444 communication */
   int ip_proto;
+
+  /*! true if the writer should use sorted address compression */
+  bool sorted_addr_compression;
+
+  /*! number of sequence numbers tracked per originator for duplicate detection */
+  int32_t duplicate_window;
 };
 
 /**
@@ -180,6 +186,13 @@ static struct cfg_schema_entry _rfc5444_entries[] = {
     "UDP port for RFC5444 interface", 0, false, 1, 65535),
   CFG_MAP_INT32_MINMAX(_rfc5444_config, ip_proto, "ip_proto", RFC5444_MANET_IPPROTO_TXT,
     "IP protocol for RFC5444 interface", 0, false, 1, 255),
+  CFG_MAP_BOOL(_rfc5444_config, sorted_addr_compression, "sorted_addr_compression", "false",
+    "Sort outgoing addresses and group them by common prefix instead of"
+    " testing all head lengths during address compression (faster for large messages)"),
+  CFG_MAP_INT32_MINMAX(_rfc5444_config, duplicate_window, "duplicate_window", "32",
+    "Number of sequence numbers per originator tracked for duplicate detection of"
+    " processed and forwarded messages, larger values (up to 1024) are rounded up"
+    " to 256, 512 or 1024", 0, false, 32, OONF_DUPSET_MAXIMUM_WINDOW),
 };
 
 static struct cfg_schema_section _rfc5444_section = {
@@ -1421,6 +1434,9 @@ _cb_cfg_rfc5444_changed(void) {
   }
 
   /* apply values */
+  _rfc5444_protocol->writer.sorted_addr_compression = config.sorted_addr_compression;
+  oonf_duplicate_set_set_window(&_rfc5444_protocol->processed_set, config.duplicate_window);
+  oonf_duplicate_set_set_window(&_rfc5444_protocol->forwarded_set, config.duplicate_window);
   oonf_rfc5444_reconfigure_protocol(_rfc5444_protocol,
       config.port, config.ip_proto);
 }
@@ -72,6 +72,7 @@ static const char *_rfc5444_negative_result_texts[] = {
   [-RFC5444_FW_BAD_SIZE]          = "Bad length field of message to be forwarded",
   [-RFC5444_TOO_LARGE]            = "RFC5444 packet larger than 64k",
   [-RFC5444_FW_BAD_TRANSFORM]     = "RFC5444 transformer failed",
+  [-RFC5444_BAD_ADDR_HEADTAIL]    = "Address head and tail longer than address",
 };
 
 /**
@@ -128,8 +128,11 @@ enum rfc5444_result {
   /*! transformer failed for forwarded message */
   RFC5444_FW_BAD_TRANSFORM     = -17,
 
+  /*! address head and tail are longer than the address */
+  RFC5444_BAD_ADDR_HEADTAIL    = -18,
+
   /*! minimal value of result */
-  RFC5444_RESULT_MIN           = -17,
+  RFC5444_RESULT_MIN           = -18,
 };
 
 EXPORT const char *rfc5444_strerror(enum rfc5444_result result);
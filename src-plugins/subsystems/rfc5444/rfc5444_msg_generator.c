@@ -80,6 +80,29 @@ struct _rfc5444_internal_addr_compress_session {
   bool closed;
 };
 
+/**
+ * data necessary for address compression of a sorted address list
+ */
+struct _rfc5444_internal_addr_sorted_session {
+  /*! address at the start of the current block */
+  struct rfc5444_writer_address *ptr;
+
+  /*! total number of bytes of the fragment including the current block */
+  int total;
+
+  /*! number of bytes of the address part of the current block */
+  int block_size;
+
+  /*! head length of the current block */
+  int headlen;
+
+  /*! number of addresses in the current block */
+  int count;
+
+  /*! true if address block has multiple prefix lengths */
+  bool multiplen;
+};
+
 static void _close_addrblock(struct _rfc5444_internal_addr_compress_session *acs,
     struct rfc5444_writer *writer, struct rfc5444_writer_address *last_addr, int);
 static void _finalize_message_fragment(struct rfc5444_writer *writer,
@@ -87,6 +110,11 @@ static void _finalize_message_fragment(struct rfc5444_writer *writer,
     rfc5444_writer_targetselector useIf, void *param);
 static int _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
     struct rfc5444_writer *writer, struct list_entity *addr_list, int same_prefixlen);
+static void _sort_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg);
+static int _compress_sorted_address(struct _rfc5444_internal_addr_sorted_session *scs,
+    struct rfc5444_writer *writer, struct list_entity *addr_list);
+static void _calculate_tlv_flags(struct rfc5444_writer_address *addr,
+    struct rfc5444_writer_address *last_addr);
 static void _write_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg,
     struct list_entity *fragment_addrs);
 static void _write_msgheader(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg);
@@ -125,6 +153,7 @@ rfc5444_writer_create_message(struct rfc5444_writer *writer, uint8_t msgid,
   size_t processor_preallocation;
 
   struct _rfc5444_internal_addr_compress_session acs[RFC5444_MAX_ADDRLEN];
+  struct _rfc5444_internal_addr_sorted_session scs;
   int best_size, best_head, same_prefixlen;
   int i, idx, non_mandatory;
   bool first;
@@ -256,6 +285,10 @@ rfc5444_writer_create_message(struct rfc5444_writer *writer, uint8_t msgid,
   /* join mandatory and normal address list */
   list_merge(&msg->_addr_head, &msg->_non_mandatory_addr_head);
 
+  if (writer->sorted_addr_compression) {
+    _sort_addresses(writer, msg);
+  }
+
   /* initialize list of current addresses */
   list_init_head(&current_list);
   not_fragmented = true;
@@ -308,32 +341,45 @@ rfc5444_writer_create_message(struct rfc5444_writer *writer, uint8_t msgid,
       }
 
       /* clear address compression session */
-      memset(acs, 0, sizeof(acs));
+      if (writer->sorted_addr_compression) {
+        memset(&scs, 0, sizeof(scs));
+      }
+      else {
+        memset(acs, 0, sizeof(acs));
+      }
       same_prefixlen = 1;
 
       first_processed = addr;
     }
 
     addr->index = idx++;
+    addr->_block_start = NULL;
     list_add_tail(&current_list, &addr->_addr_fragment_node);
 
-    /* update session with address */
-    same_prefixlen = _compress_address(acs, writer, &current_list, same_prefixlen);
-    first = false;
+    if (writer->sorted_addr_compression) {
+      /* update sorted session with address, head length is stored in the address */
+      best_size = _compress_sorted_address(&scs, writer, &current_list);
+      best_head = best_size <= (int)max_msg_size ? 0 : -1;
+    }
+    else {
+      /* update session with address */
+      same_prefixlen = _compress_address(acs, writer, &current_list, same_prefixlen);
+
+      /* look for best current compression */
+      best_head = -1;
+      best_size = max_msg_size + 1;
+      for (i = 0; i < writer->msg_addr_len; i++) {
+        int size = acs[i].total + acs[i].current;
+        int count = addr->index - acs[i].ptr->index;
 
-    /* look for best current compression */
-    best_head = -1;
-    best_size = max_msg_size + 1;
-    for (i = 0; i < writer->msg_addr_len; i++) {
-      int size = acs[i].total + acs[i].current;
-      int count = addr->index - acs[i].ptr->index;
-
-      /* a block of 255 addresses have an index difference of 254 */
-      if (size < best_size && count <= 254) {
-        best_head = i;
-        best_size = size;
+        /* a block of 255 addresses have an index difference of 254 */
+        if (size < best_size && count <= 254) {
+          best_head = i;
+          best_size = size;
+        }
       }
     }
+    first = false;
 
     /* fragmentation necessary ? */
     if (best_head == -1) {
@@ -350,7 +396,9 @@ rfc5444_writer_create_message(struct rfc5444_writer *writer, uint8_t msgid,
       /* one address too many */
       list_remove(&addr->_addr_fragment_node);
 
-      _close_addrblock(acs, writer, last_processed, 0);
+      if (!writer->sorted_addr_compression) {
+        _close_addrblock(acs, writer, last_processed, 0);
+      }
 #ifdef DEBUG_OUTPUT
       printf("Finalize with head length: %d\n", last_processed->_block_headlen);
 #endif
@@ -366,7 +414,7 @@ rfc5444_writer_create_message(struct rfc5444_writer *writer, uint8_t msgid,
       continue;
     } else {
       /* add cost for this address to total costs */
-      for (i = 0; i < writer->msg_addr_len; i++) {
+      for (i = 0; !writer->sorted_addr_compression && i < writer->msg_addr_len; i++) {
         acs[i].total += acs[i].current;
 
 #if DEBUG_CLEANUP == true
@@ -388,7 +436,9 @@ rfc5444_writer_create_message(struct rfc5444_writer *writer, uint8_t msgid,
   }
 
   if (last_processed) {
-    _close_addrblock(acs, writer, last_processed, 0);
+    if (!writer->sorted_addr_compression) {
+      _close_addrblock(acs, writer, last_processed, 0);
+    }
 
     /* write message fragment */
     _finalize_message_fragment(writer, msg, &current_list, not_fragmented, useIf, param);
@@ -857,7 +907,7 @@ _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
     struct rfc5444_writer *writer, struct list_entity *addr_list,
     int same_prefixlen) {
   struct rfc5444_writer_address *addr, *last_addr;
-  struct rfc5444_writer_addrtlv *tlv, *last_tlv;
+  struct rfc5444_writer_addrtlv *tlv;
   struct rfc5444_writer_tlvtype *tlvtype;
   uint32_t i, common_head;
   const uint8_t *addrptr, *last_addrptr;
@@ -915,21 +965,7 @@ _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
   }
 
   /* calculate tlv flags */
-  avl_for_each_element(&addr->_addrtlv_tree, tlv, addrtlv_node) {
-    tlvtype = tlv->tlvtype;
-
-    tlv->_same_length = false;
-    tlv->_same_value = false;
-
-    if (last_addr) {
-      last_tlv = avl_find_element(&last_addr->_addrtlv_tree,
-          &tlvtype->_full_type, last_tlv, addrtlv_node);
-      if (last_tlv && last_tlv->length == tlv->length) {
-        tlv->_same_length = true;
-        tlv->_same_value = memcmp(tlv->value, last_tlv->value, tlv->length) == 0;
-      }
-    }
-  }
+  _calculate_tlv_flags(addr, last_addr);
 
   /* calculate new costs for next address including tlvs */
   for (i = 0; i < addrlen; i++) {
@@ -956,7 +992,7 @@ _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
       }
       else if (same_prefixlen == 1) {
         /* will become multi_prefixlen */
-        continue_cost += (acs[i].ptr->index - addr->index + 1);
+        continue_cost += (addr->index - acs[i].ptr->index + 1);
         acs[i].multiplen = true;
       }
     }
@@ -1011,18 +1047,25 @@ _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
         /* ups, value changed. Change cost estimate to multivalue TLV */
         continue_cost += tlv->length * tlvtype->_tlvblock_count[i];
       }
+      else {
+        continue;
+      }
+
+      if (tlv->length * tlvtype->_tlvblock_count[i] <= 255
+          && tlv->length * (tlvtype->_tlvblock_count[i] + 1) > 255) {
+        /* multivalue TLV needs an extended length field */
+        continue_cost++;
+      }
     }
 #ifdef DEBUG_OUTPUT
     printf(" %2d/%2d", continue_cost, closed ? -1 : new_cost);
 #endif
     if (closed || acs[i].total + continue_cost > acs[addrlen-1].total + new_cost) {
-      /* forget the last addresses, longer prefix is better. */
-      /* store address block for later binary generation */
-      if (last_addr) {
-        last_addr->_block_start = acs[addrlen-1].ptr;
-        last_addr->_block_multiple_prefixlen = acs[addrlen-1].multiplen;
-        last_addr->_block_headlen = addrlen-1;
-      }
+      /*
+       * forget the last addresses, longer prefix is better.
+       * The address block of the last address has already been
+       * stored by _close_addrblock()
+       */
 
       /* Create a new address block */
       acs[i].ptr = addr;
@@ -1062,6 +1105,286 @@ _compress_address(struct _rfc5444_internal_addr_compress_session *acs,
   return same_prefixlen;
 }
 
+/**
+ * Calculate if the TLVs of an address continue the TLVs
+ * of the previous address with the same length/value.
+ * @param addr pointer to address
+ * @param last_addr pointer to previous address, NULL if none
+ */
+static void
+_calculate_tlv_flags(struct rfc5444_writer_address *addr,
+    struct rfc5444_writer_address *last_addr) {
+  struct rfc5444_writer_addrtlv *tlv, *last_tlv;
+  struct rfc5444_writer_tlvtype *tlvtype;
+
+  avl_for_each_element(&addr->_addrtlv_tree, tlv, addrtlv_node) {
+    tlvtype = tlv->tlvtype;
+
+    tlv->_same_length = false;
+    tlv->_same_value = false;
+
+    if (last_addr) {
+      last_tlv = avl_find_element(&last_addr->_addrtlv_tree,
+          &tlvtype->_full_type, last_tlv, addrtlv_node);
+      if (last_tlv && last_tlv->length == tlv->length) {
+        tlv->_same_length = true;
+        tlv->_same_value = memcmp(tlv->value, last_tlv->value, tlv->length) == 0;
+      }
+    }
+  }
+}
+
+/**
+ * @param addrlen length of addresses in bytes
+ * @param ptr1 pointer to first binary address
+ * @param ptr2 pointer to second binary address
+ * @return number of common leading bytes, at most addrlen-1
+ */
+static INLINE int
+_get_common_headlen(int addrlen, const uint8_t *ptr1, const uint8_t *ptr2) {
+  int i;
+
+  for (i = 0; i < addrlen - 1; i++) {
+    if (ptr1[i] != ptr2[i]) {
+      break;
+    }
+  }
+  return i;
+}
+
+/**
+ * Calculate the size of the address part of an address block
+ * (without the address TLVs).
+ * @param addrlen length of addresses in bytes
+ * @param headlen length of common head
+ * @param count number of addresses in block
+ * @param multiplen true if block has multiple prefix lengths
+ * @param prefixlen prefix length of the first address of the block
+ * @return number of bytes of address block
+ */
+static int
+_get_addrblock_size(int addrlen, int headlen, int count,
+    bool multiplen, uint8_t prefixlen) {
+  int size;
+
+  /* number of addresses and flags */
+  size = 2;
+
+  if (count == 1) {
+    /* single address blocks never use a head */
+    headlen = 0;
+  }
+  else if (headlen > 0) {
+    /* head length and head */
+    size += 1 + headlen;
+  }
+
+  /* mid part of all addresses */
+  size += count * (addrlen - headlen);
+
+  if (multiplen) {
+    size += count;
+  }
+  else if (prefixlen != addrlen * 8) {
+    size++;
+  }
+  return size;
+}
+
+/**
+ * Sort the address list of a message by the binary address value
+ * and precalculate the common head length between neighbors.
+ * This moves addresses with a common prefix next to each other.
+ * Mandatory and non-mandatory addresses are sorted separately,
+ * the fragmentation code needs all mandatory addresses at the
+ * head of the list.
+ * @param writer pointer to rfc5444 writer
+ * @param msg pointer to message
+ */
+static void
+_sort_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg) {
+  struct rfc5444_writer_address *addr, *last_addr;
+  int i;
+
+  list_init_head(&msg->_addr_head);
+
+  last_addr = NULL;
+
+  /* the address tree is already sorted by the binary address */
+  for (i = 0; i < 2; i++) {
+    avl_for_each_element(&msg->_addr_tree, addr, _addr_tree_node) {
+      if (addr->_mandatory_addr != (i == 0)) {
+        continue;
+      }
+
+      list_add_tail(&msg->_addr_head, &addr->_addr_list_node);
+
+      if (last_addr) {
+        addr->_common_headlen = _get_common_headlen(writer->msg_addr_len,
+            netaddr_get_binptr(&last_addr->address),
+            netaddr_get_binptr(&addr->address));
+      }
+      else {
+        addr->_common_headlen = 0;
+      }
+      last_addr = addr;
+    }
+  }
+}
+
+/**
+ * Update the sorted address compression session with a new address.
+ * The address is either appended to the current address block, using
+ * the common head length with the previous address, or starts a new
+ * address block, whichever needs less space.
+ * The block layout is stored in the new address, so it is always
+ * valid for the last address of the fragment.
+ *
+ * @param scs pointer to sorted address compression session
+ * @param writer pointer to rfc5444 writer
+ * @param addr_list list of addresses of current fragment
+ * @return number of bytes of address blocks (including TLVs)
+ *   of the fragment after adding the address
+ */
+static int
+_compress_sorted_address(struct _rfc5444_internal_addr_sorted_session *scs,
+    struct rfc5444_writer *writer, struct list_entity *addr_list) {
+  struct rfc5444_writer_address *addr, *last_addr;
+  struct rfc5444_writer_addrtlv *tlv;
+  struct rfc5444_writer_tlvtype *tlvtype;
+  int new_cost, continue_cost, tlv_new_cost, tlv_continue_cost;
+  int cost, headlen, cont_size, count;
+  uint8_t addrlen, prefixlen;
+  bool multiplen, new_block;
+
+  addr = list_last_element(addr_list, addr, _addr_fragment_node);
+  if (!list_is_first(addr_list, &addr->_addr_fragment_node)) {
+    last_addr = list_prev_element(addr, _addr_fragment_node);
+  }
+  else {
+    last_addr = NULL;
+  }
+
+  addrlen = writer->msg_addr_len;
+  prefixlen = netaddr_get_prefix_length(&addr->address);
+
+  _calculate_tlv_flags(addr, last_addr);
+
+  /* calculate costs for a new tlv block and for continuing the tlvs */
+  tlv_new_cost = 0;
+  tlv_continue_cost = 0;
+  avl_for_each_element(&addr->_addrtlv_tree, tlv, addrtlv_node) {
+    tlvtype = tlv->tlvtype;
+
+    /* type, flags and (worst case) two index bytes */
+    cost = 4;
+    if (tlvtype->exttype > 0) {
+      cost++;
+    }
+    if (tlv->length > 255) {
+      cost++;
+    }
+    if (tlv->length > 0) {
+      cost++;
+    }
+    cost += tlv->length;
+
+    tlv_new_cost += cost;
+
+    if (last_addr == NULL || !tlv->_same_length) {
+      tlv_continue_cost += cost;
+      continue;
+    }
+
+    count = tlvtype->_tlvblock_count[0];
+    if (tlvtype->_tlvblock_multi[0]) {
+      /* add another value to a multivalue TLV */
+      tlv_continue_cost += tlv->length;
+    }
+    else if (!tlv->_same_value) {
+      /* convert TLV to multivalue */
+      tlv_continue_cost += tlv->length * count;
+    }
+    else {
+      continue;
+    }
+
+    if (tlv->length * count <= 255 && tlv->length * (count + 1) > 255) {
+      /* multivalue TLV needs an extended length field */
+      tlv_continue_cost++;
+    }
+  }
+
+  /* cost of a new address block including the tlv-block length */
+  new_cost = _get_addrblock_size(addrlen, 0, 1, false, prefixlen) + 2 + tlv_new_cost;
+
+  new_block = true;
+  headlen = 0;
+  multiplen = false;
+  cont_size = 0;
+  if (last_addr != NULL && scs->count < 255) {
+    /* calculate cost of appending address to current block */
+    if (list_prev_element(addr, _addr_list_node) == last_addr) {
+      headlen = addr->_common_headlen;
+    }
+    else {
+      headlen = _get_common_headlen(addrlen,
+          netaddr_get_binptr(&last_addr->address), netaddr_get_binptr(&addr->address));
+    }
+    if (headlen > scs->headlen) {
+      headlen = scs->headlen;
+    }
+
+    multiplen = scs->multiplen
+        || prefixlen != netaddr_get_prefix_length(&scs->ptr->address);
+
+    cont_size = _get_addrblock_size(addrlen, headlen, scs->count + 1, multiplen,
+        netaddr_get_prefix_length(&scs->ptr->address));
+    continue_cost = cont_size - scs->block_size + tlv_continue_cost;
+
+    new_block = continue_cost > new_cost;
+  }
+
+  if (new_block) {
+    scs->ptr = addr;
+    scs->headlen = addrlen - 1;
+    scs->count = 1;
+    scs->multiplen = false;
+    scs->block_size = new_cost - 2 - tlv_new_cost;
+    scs->total += new_cost;
+  }
+  else {
+    scs->headlen = headlen;
+    scs->count++;
+    scs->multiplen = multiplen;
+    scs->block_size = cont_size;
+    scs->total += continue_cost;
+  }
+
+  /* update internal tlv calculation */
+  avl_for_each_element(&addr->_addrtlv_tree, tlv, addrtlv_node) {
+    tlvtype = tlv->tlvtype;
+
+    if (new_block || !tlv->_same_length) {
+      tlvtype->_tlvblock_count[0] = 1;
+      tlvtype->_tlvblock_multi[0] = false;
+    }
+    else {
+      tlvtype->_tlvblock_count[0]++;
+      if (!tlv->_same_value) {
+        tlvtype->_tlvblock_multi[0] = true;
+      }
+    }
+  }
+
+  /* store address block for later binary generation */
+  addr->_block_start = scs->ptr;
+  addr->_block_headlen = scs->count > 1 ? scs->headlen : 0;
+  addr->_block_multiple_prefixlen = scs->multiplen;
+
+  return scs->total;
+}
+
 static uint8_t *
 _write_addresstlv(struct rfc5444_writer_tlvtype *tlvtype,
     struct rfc5444_writer_address *addr_first,
@@ -831,6 +831,10 @@ _parse_addrblock(struct rfc5444_reader_addrblock_entry *addr_entry,
   /* check for head flag */
   if ((flags & RFC5444_ADDR_FLAG_HEAD) != 0) {
     addr_entry->mid_start = _rfc5444_get_u8(ptr, eob, &result);
+    if (addr_entry->mid_start > addr_entry->mid_len) {
+      /* head is longer than address */
+      return RFC5444_BAD_ADDR_HEADTAIL;
+    }
     if (*ptr + addr_entry->mid_start > eob) {
       /* not enough buffer for head */
       return RFC5444_END_OF_BUFFER;
@@ -845,10 +849,19 @@ _parse_addrblock(struct rfc5444_reader_addrblock_entry *addr_entry,
   /* check for tail flags */
   masked = flags & (RFC5444_ADDR_FLAG_FULLTAIL | RFC5444_ADDR_FLAG_ZEROTAIL);
   if (masked == RFC5444_ADDR_FLAG_ZEROTAIL) {
-    addr_entry->mid_len -= _rfc5444_get_u8(ptr, eob, &result);
+    tail_len = _rfc5444_get_u8(ptr, eob, &result);
+    if (tail_len > addr_entry->mid_len) {
+      /* head and tail are longer than address */
+      return RFC5444_BAD_ADDR_HEADTAIL;
+    }
+    addr_entry->mid_len -= tail_len;
   }
   else if (masked == RFC5444_ADDR_FLAG_FULLTAIL) {
     tail_len = _rfc5444_get_u8(ptr, eob, &result);
+    if (tail_len > addr_entry->mid_len) {
+      /* head and tail are longer than address */
+      return RFC5444_BAD_ADDR_HEADTAIL;
+    }
     if (*ptr + tail_len > eob) {
       /* not enough buffer for head */
       return RFC5444_END_OF_BUFFER;
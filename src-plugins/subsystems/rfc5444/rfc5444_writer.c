@@ -65,6 +65,10 @@ static struct rfc5444_writer_address *_malloc_address_entry(void);
 static struct rfc5444_writer_addrtlv *_malloc_addrtlv_entry(void);
 static void _free_address_entry(struct rfc5444_writer_address *addr);
 static void _free_addrtlv_entry(struct rfc5444_writer_addrtlv *addrtlv);
+static struct rfc5444_writer_address *_get_address_entry(struct rfc5444_writer *writer);
+static struct rfc5444_writer_addrtlv *_get_addrtlv_entry(struct rfc5444_writer *writer);
+static void _recycle_address_entry(struct rfc5444_writer *writer, struct rfc5444_writer_address *addr);
+static void _recycle_addrtlv_entry(struct rfc5444_writer *writer, struct rfc5444_writer_addrtlv *addrtlv);
 
 /**
  * @param type TLV type
@@ -95,6 +99,12 @@ rfc5444_writer_init(struct rfc5444_writer *writer) {
   if (!writer->free_addrtlv_entry)
     writer->free_addrtlv_entry = _free_addrtlv_entry;
 
+  /* set default size of the recycling lists */
+  if (!writer->max_free_addresses)
+    writer->max_free_addresses = RFC5444_WRITER_MAX_FREE_ADDRESSES;
+  if (!writer->max_free_addrtlvs)
+    writer->max_free_addrtlvs = RFC5444_WRITER_MAX_FREE_ADDRTLVS;
+
   list_init_head(&writer->_targets);
 
   /* initialize packet buffer */
@@ -105,6 +115,13 @@ rfc5444_writer_init(struct rfc5444_writer *writer) {
   list_init_head(&writer->_targets);
   list_init_head(&writer->_addr_tlvtype_head);
 
+  list_init_head(&writer->_free_addresses);
+  list_init_head(&writer->_free_addrtlvs);
+  writer->_free_address_count = 0;
+  writer->_free_addrtlv_count = 0;
+  writer->_address_count = 0;
+  writer->_addrtlv_count = 0;
+
   avl_init(&writer->_msgcreators, avl_comp_uint8, false);
   avl_init(&writer->_processors, avl_comp_int32, true);
   avl_init(&writer->_forwarding_processors, avl_comp_int32, true);
@@ -128,6 +145,8 @@ rfc5444_writer_cleanup(struct rfc5444_writer *writer) {
   struct rfc5444_writer_tlvtype *tlvtype, *safe_tt;
   struct rfc5444_writer_target *interf, *safe_interf;
   struct rfc5444_writer_postprocessor *processor, *safe_proc;
+  struct rfc5444_writer_address *addr, *safe_addr;
+  struct rfc5444_writer_addrtlv *addrtlv, *safe_addrtlv;
 
   assert(writer);
 #if WRITER_STATE_MACHINE == true
@@ -172,6 +191,20 @@ rfc5444_writer_cleanup(struct rfc5444_writer *writer) {
     /* remove message and addresses */
     rfc5444_writer_unregister_message(writer, msg);
   }
+
+  /* release recycled address and address tlv objects */
+  list_for_each_element_safe(&writer->_free_addrtlvs, addrtlv, _current_tlv_node, safe_addrtlv) {
+    list_remove(&addrtlv->_current_tlv_node);
+    writer->free_addrtlv_entry(addrtlv);
+    writer->_addrtlv_count--;
+  }
+  list_for_each_element_safe(&writer->_free_addresses, addr, _addr_list_node, safe_addr) {
+    list_remove(&addr->_addr_list_node);
+    writer->free_address_entry(addr);
+    writer->_address_count--;
+  }
+  writer->_free_address_count = 0;
+  writer->_free_addrtlv_count = 0;
 }
 
 /**
@@ -201,7 +234,7 @@ rfc5444_writer_add_addrtlv(struct rfc5444_writer *writer, struct rfc5444_writer_
     return RFC5444_DUPLICATE_TLV;
   }
 
-  if ((addrtlv = writer->malloc_addrtlv_entry()) == NULL) {
+  if ((addrtlv = _get_addrtlv_entry(writer)) == NULL) {
     /* out of memory error */
     return RFC5444_OUT_OF_MEMORY;
   }
@@ -213,7 +246,7 @@ rfc5444_writer_add_addrtlv(struct rfc5444_writer *writer, struct rfc5444_writer_
   /* copy value(length) */
   addrtlv->length = length;
   if (length > 0 && (addrtlv->value = _copy_addrtlv_value(writer, value, length)) == NULL) {
-    writer->free_addrtlv_entry(addrtlv);
+    _recycle_addrtlv_entry(writer, addrtlv);
     return RFC5444_OUT_OF_ADDRTLV_MEM;
   }
 
@@ -235,7 +268,7 @@ rfc5444_writer_add_addrtlv(struct rfc5444_writer *writer, struct rfc5444_writer_
  * @return pointer to address object, NULL if an error happened
  */
 struct rfc5444_writer_address *
-rfc5444_writer_add_address(struct rfc5444_writer *writer __attribute__ ((unused)),
+rfc5444_writer_add_address(struct rfc5444_writer *writer,
     struct rfc5444_writer_message *msg, const struct netaddr *naddr, bool mandatory) {
   struct rfc5444_writer_address *address;
 
@@ -245,7 +278,7 @@ rfc5444_writer_add_address(struct rfc5444_writer *writer __attribute__ ((unused)
 
   address = avl_find_element(&msg->_addr_tree, naddr, address, _addr_tree_node);
   if (address == NULL) {
-    if ((address = writer->malloc_address_entry()) == NULL) {
+    if ((address = _get_address_entry(writer)) == NULL) {
       return NULL;
     }
 
@@ -671,7 +704,8 @@ _copy_addrtlv_value(struct rfc5444_writer *writer, const void *value, size_t len
 }
 
 /**
- * Free all allocated addresses in a writers context
+ * Free all allocated addresses in a writers context. The address
+ * and address tlv objects are kept by the writer for the next message.
  * @param writer pointer to writer context
  * @param msg pointer to message object
  */
@@ -685,9 +719,9 @@ _rfc5444_writer_free_addresses(struct rfc5444_writer *writer, struct rfc5444_wri
     list_remove(&addr->_addr_list_node);
 
     avl_remove_all_elements(&addr->_addrtlv_tree, addrtlv, addrtlv_node, safe_addrtlv) {
-      writer->free_addrtlv_entry(addrtlv);
+      _recycle_addrtlv_entry(writer, addrtlv);
     }
-    writer->free_address_entry(addr);
+    _recycle_address_entry(writer, addr);
   }
 
   /* allow overwriting of addrtlv-value buffer */
@@ -710,6 +744,92 @@ _lazy_free_message(struct rfc5444_writer *writer, struct rfc5444_writer_message
   }
 }
 
+/**
+ * Get a cleaned address object, either recycled from an earlier
+ * message or from the address allocator
+ * @param writer pointer to writer context
+ * @return pointer to cleaned address object, NULL if an error happened
+ */
+static struct rfc5444_writer_address *
+_get_address_entry(struct rfc5444_writer *writer) {
+  struct rfc5444_writer_address *addr;
+
+  if (list_is_empty(&writer->_free_addresses)) {
+    addr = writer->malloc_address_entry();
+    if (addr) {
+      writer->_address_count++;
+    }
+    return addr;
+  }
+
+  addr = list_first_element(&writer->_free_addresses, addr, _addr_list_node);
+  list_remove(&addr->_addr_list_node);
+  writer->_free_address_count--;
+
+  memset(addr, 0, sizeof(*addr));
+  return addr;
+}
+
+/**
+ * Get a cleaned address tlv object, either recycled from an earlier
+ * message or from the address tlv allocator
+ * @param writer pointer to writer context
+ * @return pointer to cleaned address tlv object, NULL if an error happened
+ */
+static struct rfc5444_writer_addrtlv *
+_get_addrtlv_entry(struct rfc5444_writer *writer) {
+  struct rfc5444_writer_addrtlv *addrtlv;
+
+  if (list_is_empty(&writer->_free_addrtlvs)) {
+    addrtlv = writer->malloc_addrtlv_entry();
+    if (addrtlv) {
+      writer->_addrtlv_count++;
+    }
+    return addrtlv;
+  }
+
+  addrtlv = list_first_element(&writer->_free_addrtlvs, addrtlv, _current_tlv_node);
+  list_remove(&addrtlv->_current_tlv_node);
+  writer->_free_addrtlv_count--;
+
+  memset(addrtlv, 0, sizeof(*addrtlv));
+  return addrtlv;
+}
+
+/**
+ * Keep an address object for the next message or free it
+ * if the writer already keeps enough of them
+ * @param writer pointer to writer context
+ * @param addr pointer to address object
+ */
+static void
+_recycle_address_entry(struct rfc5444_writer *writer, struct rfc5444_writer_address *addr) {
+  if (writer->_free_address_count >= writer->max_free_addresses) {
+    writer->free_address_entry(addr);
+    writer->_address_count--;
+    return;
+  }
+  list_add_tail(&writer->_free_addresses, &addr->_addr_list_node);
+  writer->_free_address_count++;
+}
+
+/**
+ * Keep an address tlv object for the next message or free it
+ * if the writer already keeps enough of them
+ * @param writer pointer to writer context
+ * @param addrtlv pointer to address tlv object
+ */
+static void
+_recycle_addrtlv_entry(struct rfc5444_writer *writer, struct rfc5444_writer_addrtlv *addrtlv) {
+  if (writer->_free_addrtlv_count >= writer->max_free_addrtlvs) {
+    writer->free_addrtlv_entry(addrtlv);
+    writer->_addrtlv_count--;
+    return;
+  }
+  list_add_tail(&writer->_free_addrtlvs, &addrtlv->_current_tlv_node);
+  writer->_free_addrtlv_count++;
+}
+
 /**
  * Default allocater for address objects
  * @return pointer to cleaned address object, NULL if an error happened
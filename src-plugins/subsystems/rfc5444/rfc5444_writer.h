@@ -87,6 +87,12 @@ enum {
 
   /*! msg_type id for packet post-processor */
   RFC5444_WRITER_PKT_POSTPROCESSOR = -1,
+
+  /*! default number of address objects a writer keeps for recycling */
+  RFC5444_WRITER_MAX_FREE_ADDRESSES = 1024,
+
+  /*! default number of address tlv objects a writer keeps for recycling */
+  RFC5444_WRITER_MAX_FREE_ADDRTLVS = 4096,
 };
 
 /**
@@ -155,6 +161,12 @@ struct rfc5444_writer_address {
   /*! true if addresses have multiple prefix lengths */
   bool _block_multiple_prefixlen;
 
+  /**
+   * number of leading bytes shared with the previous address
+   * of the message address list (only used for sorted compression)
+   */
+  uint8_t _common_headlen;
+
   /*! pointer to end of the block, NULL if this is not the start address */
   struct rfc5444_writer_address *_block_end;
 
@@ -517,6 +529,26 @@ struct rfc5444_writer_forward_handler {
 };
 
 
+/**
+ * Statistics of the address and address tlv objects of a writer.
+ * Instead of a message-lifetime arena the writer keeps the objects
+ * of finished messages in two capped free lists and reuses them for
+ * the next message, so a message of known size does no allocation.
+ */
+struct rfc5444_writer_allocator_stats {
+  /*! number of address objects used by the current message */
+  size_t addr_in_use;
+
+  /*! number of address objects kept for the next message */
+  size_t addr_free;
+
+  /*! number of address tlv objects used by the current message */
+  size_t addrtlv_in_use;
+
+  /*! number of address tlv objects kept for the next message */
+  size_t addrtlv_free;
+};
+
 /**
  * This struct represents the internal state of a
  * rfc5444 writer.
@@ -537,6 +569,25 @@ struct rfc5444_writer {
   /*! length of addrtlv buffer */
   size_t addrtlv_size;
 
+  /**
+   * true to sort the addresses of a message and group them by their
+   * common prefix before compression, false to use the exhaustive
+   * per head-length compression
+   */
+  bool sorted_addr_compression;
+
+  /**
+   * maximum number of address objects kept for the next message,
+   * 0 for RFC5444_WRITER_MAX_FREE_ADDRESSES
+   */
+  size_t max_free_addresses;
+
+  /**
+   * maximum number of address tlv objects kept for the next message,
+   * 0 for RFC5444_WRITER_MAX_FREE_ADDRTLVS
+   */
+  size_t max_free_addrtlvs;
+
   /**
    * Callback to notify an instance that a message was put into a
    * target buffer
@@ -546,7 +597,11 @@ struct rfc5444_writer {
   void (*message_generation_notifier)(struct rfc5444_writer_target *target);
 
   /**
-   * Callback to allocate a writer_address, NULL for use calloc()
+   * Callback to allocate a writer_address, NULL for use calloc().
+   * The writer recycles up to max_free_addresses address and
+   * max_free_addrtlvs address tlv objects between messages, so the
+   * allocation callbacks are only called when a message needs more
+   * objects than the writer kept from the messages before.
    * @return writer address, NULL if out of memory
    */
   struct rfc5444_writer_address * (*malloc_address_entry)(void);
@@ -599,6 +654,24 @@ struct rfc5444_writer {
   /*! number of bytes of addrtlv buffer currently used */
   size_t _addrtlv_used;
 
+  /*! address objects of earlier messages, reused before allocating new ones */
+  struct list_entity _free_addresses;
+
+  /*! address tlv objects of earlier messages, reused before allocating new ones */
+  struct list_entity _free_addrtlvs;
+
+  /*! number of objects in _free_addresses list */
+  size_t _free_address_count;
+
+  /*! number of objects in _free_addrtlvs list */
+  size_t _free_addrtlv_count;
+
+  /*! number of address objects allocated by the writer and not freed yet */
+  size_t _address_count;
+
+  /*! number of address tlv objects allocated by the writer and not freed yet */
+  size_t _addrtlv_count;
+
   /*! internal state of writer */
   enum rfc5444_internal_state _state;
 };
@@ -712,6 +785,19 @@ EXPORT void rfc5444_writer_flush(struct rfc5444_writer *, struct rfc5444_writer_
 EXPORT void rfc5444_writer_init(struct rfc5444_writer *);
 EXPORT void rfc5444_writer_cleanup(struct rfc5444_writer *writer);
 
+/**
+ * @param writer pointer to writer context
+ * @param stats pointer to buffer for address/addrtlv allocation statistics
+ */
+static INLINE void
+rfc5444_writer_get_allocator_stats(struct rfc5444_writer *writer,
+    struct rfc5444_writer_allocator_stats *stats) {
+  stats->addr_free = writer->_free_address_count;
+  stats->addr_in_use = writer->_address_count - writer->_free_address_count;
+  stats->addrtlv_free = writer->_free_addrtlv_count;
+  stats->addrtlv_in_use = writer->_addrtlv_count - writer->_free_addrtlv_count;
+}
+
 /* internal functions that are not exported to the user */
 void _rfc5444_writer_free_addresses(struct rfc5444_writer *writer, struct rfc5444_writer_message *msg);
 void _rfc5444_writer_begin_packet(struct rfc5444_writer *writer, struct rfc5444_writer_target *target);
@@ -0,0 +1,212 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "common/hash_index.h"
+#include "common/netaddr.h"
+#include "cunit/cunit.h"
+
+struct hash_element {
+  uint32_t key;
+  bool added;
+};
+
+#define COUNT 1000
+
+static struct hash_index idx;
+static struct hash_element elements[COUNT];
+
+static void clear_elements(void) {
+  int i;
+
+  hash_index_init(&idx);
+  memset(elements, 0, sizeof(elements));
+
+  for (i=0; i<COUNT; i++) {
+    elements[i].key = i;
+  }
+}
+
+/* only 64 different hash values to get lots of collisions */
+static uint32_t hash_key(uint32_t key) {
+  return (key * 2654435761u) >> 26;
+}
+
+static struct hash_element *find(uint32_t key) {
+  struct hash_element *e;
+  size_t pos;
+
+  hash_index_for_each_match(&idx, hash_key(key), e, pos) {
+    if (e->key == key) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+static int check_elements(void) {
+  int i, errors = 0;
+
+  for (i=0; i<COUNT; i++) {
+    if (elements[i].added != (find(i) == &elements[i])) {
+      errors++;
+    }
+  }
+  return errors;
+}
+
+static void test_add_find(void) {
+  int i;
+
+  START_TEST();
+
+  CHECK_TRUE(find(0) == NULL, "lookup in empty index failed");
+
+  for (i=0; i<COUNT; i++) {
+    CHECK_TRUE(hash_index_add(&idx, &elements[i], hash_key(i)) == 0, "add %d failed", i);
+    elements[i].added = true;
+  }
+  CHECK_TRUE(idx.count == COUNT, "index has %zu elements", idx.count);
+  CHECK_TRUE(check_elements() == 0, "%d elements not found", check_elements());
+
+  hash_index_free(&idx);
+  CHECK_TRUE(idx.count == 0 && find(0) == NULL, "index not empty after free");
+  END_TEST();
+}
+
+static void test_remove(void) {
+  uint32_t rnd = 1;
+  int i, j;
+
+  START_TEST();
+
+  for (i=0; i<COUNT; i++) {
+    hash_index_add(&idx, &elements[i], hash_key(i));
+    elements[i].added = true;
+  }
+
+  /* remove elements in pseudo random order and check the rest */
+  for (i=0; i<COUNT; i++) {
+    rnd = rnd * 1103515245 + 12345;
+    j = (rnd >> 8) % COUNT;
+    while (!elements[j].added) {
+      j = (j + 1) % COUNT;
+    }
+
+    hash_index_remove(&idx, &elements[j], hash_key(j));
+    elements[j].added = false;
+
+    if (i % 50 == 0) {
+      CHECK_TRUE(check_elements() == 0, "%d elements wrong after %d removals",
+          check_elements(), i+1);
+    }
+  }
+
+  CHECK_TRUE(idx.count == 0, "index has %zu elements", idx.count);
+  CHECK_TRUE(idx._slots == NULL, "memory of empty index was not freed");
+
+  /* removing an unknown element must not change anything */
+  hash_index_add(&idx, &elements[0], hash_key(0));
+  hash_index_remove(&idx, &elements[1], hash_key(0));
+  CHECK_TRUE(idx.count == 1 && find(0) == &elements[0], "remove of unknown element");
+  hash_index_remove(&idx, &elements[0], hash_key(0));
+  END_TEST();
+}
+
+static void test_resize(void) {
+  size_t size;
+  int i;
+
+  START_TEST();
+
+  for (i=0; i<COUNT; i++) {
+    hash_index_add(&idx, &elements[i], hash_key(i));
+    elements[i].added = true;
+    CHECK_TRUE(idx.count * 2 <= idx._size, "index too full: %zu of %zu",
+        idx.count, idx._size);
+  }
+
+  size = idx._size;
+  for (i=0; i<COUNT-10; i++) {
+    hash_index_remove(&idx, &elements[i], hash_key(i));
+    elements[i].added = false;
+  }
+  CHECK_TRUE(idx._size < size, "index did not shrink: %zu slots", idx._size);
+  CHECK_TRUE(check_elements() == 0, "%d elements wrong after shrinking", check_elements());
+
+  hash_index_free(&idx);
+  END_TEST();
+}
+
+static void test_netaddr_hash(void) {
+  struct netaddr a1, a2;
+
+  START_TEST();
+
+  CHECK_TRUE(netaddr_from_string(&a1, "10.0.0.1") == 0, "parse a1");
+  CHECK_TRUE(netaddr_from_string(&a2, "10.0.0.1") == 0, "parse a2");
+  CHECK_TRUE(netaddr_hash(&a1) == netaddr_hash(&a2), "equal addresses have different hash");
+
+  CHECK_TRUE(netaddr_from_string(&a2, "10.0.0.2") == 0, "parse a2");
+  CHECK_TRUE(netaddr_hash(&a1) != netaddr_hash(&a2), "hash does not depend on address");
+
+  CHECK_TRUE(netaddr_from_string(&a2, "10.0.0.1/24") == 0, "parse a2");
+  CHECK_TRUE(netaddr_hash(&a1) != netaddr_hash(&a2), "hash does not depend on prefix length");
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  BEGIN_TESTING(clear_elements);
+
+  test_add_find();
+  test_remove();
+  test_resize();
+  test_netaddr_hash();
+
+  return FINISH_TESTING();
+}
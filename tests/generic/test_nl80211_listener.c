@@ -0,0 +1,738 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+/*
+ * The listener sources are compiled directly into the test, its query
+ * state is accessed through the internal header. The kernel side of netlink
+ * and the interface subsystem are replaced by the fake functions below,
+ * which record the requests of the listener so the test can answer them
+ * with recorded nl80211 replies.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <linux/types.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include "nl80211_listener/nl80211.h"
+#include <netlink/attr.h>
+#include <netlink/msg.h>
+#include <netlink/genl/genl.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_layer2.h"
+#include "subsystems/os_interface.h"
+#include "subsystems/os_system.h"
+
+#include "nl80211_listener/nl80211_internal.h"
+#include "nl80211_listener/nl80211_listener.h"
+
+#include "cunit/cunit.h"
+
+/*! nl80211 generic netlink family id used by the test */
+#define TEST_NL80211_ID 28
+
+/*! frequency of all test radios in MHz */
+#define TEST_FREQUENCY 2412
+
+/*! maximum vht rx rate of all test radios in MBit/s */
+#define TEST_VHT_RX_RATE 433
+
+/*! maximum number of outstanding requests the fake kernel can track */
+#define TEST_MAX_REQUESTS 16
+
+/**
+ * netlink request of the listener waiting for an answer
+ */
+struct test_request {
+  /*! netlink socket the request was sent on */
+  struct os_system_netlink *nl;
+
+  /*! sequence number of request */
+  uint32_t seq;
+
+  /*! nl80211 command of request */
+  uint8_t cmd;
+
+  /*! interface index of request */
+  uint32_t ifindex;
+};
+
+/**
+ * recorded entry of a nl80211 station dump
+ */
+struct test_station {
+  /*! interface index of station */
+  uint32_t ifindex;
+
+  /*! mac address of station */
+  uint8_t mac[6];
+
+  /*! signal strength in dBm */
+  int8_t signal;
+
+  /*! received bytes */
+  uint64_t rx_bytes;
+};
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "test_nl80211_listener",
+};
+
+/* station dumps recorded on three radios */
+static const struct test_station _stations[] = {
+  { 1, { 0x02, 0x00, 0x00, 0x00, 0x01, 0x01 }, -41, 1000 },
+  { 1, { 0x02, 0x00, 0x00, 0x00, 0x01, 0x02 }, -52, 2000 },
+  { 1, { 0x02, 0x00, 0x00, 0x00, 0x01, 0x03 }, -63, 3000 },
+  { 2, { 0x02, 0x00, 0x00, 0x00, 0x02, 0x01 }, -44, 4000 },
+  { 3, { 0x02, 0x00, 0x00, 0x00, 0x03, 0x01 }, -75, 5000 },
+  { 3, { 0x02, 0x00, 0x00, 0x00, 0x03, 0x02 }, -86, 6000 },
+};
+
+/* interfaces known to the fake interface subsystem */
+static struct os_interface _interfaces[] = {
+  { .name = "wlan0", .index = 1, .base_index = 1 },
+  { .name = "wlan1", .index = 2, .base_index = 2 },
+  { .name = "wlan2", .index = 3, .base_index = 3 },
+};
+
+/* requests sent by the listener, waiting for an answer */
+static struct test_request _requests[TEST_MAX_REQUESTS];
+static size_t _request_count;
+
+static uint32_t _last_seq;
+static size_t _max_in_flight;
+static bool _socket_reused;
+static size_t _get_if_requests;
+
+/* noise level reported by the survey replies */
+static int8_t _noise = -90;
+
+static uint32_t _reply_buffer[1024];
+
+/* fake os_interface and os_system subsystems */
+static struct oonf_subsystem _fake_os_interface_subsystem = {
+  .name = OONF_OS_INTERFACE_SUBSYSTEM,
+};
+DECLARE_OONF_PLUGIN(_fake_os_interface_subsystem);
+
+static struct oonf_subsystem _fake_os_system_subsystem = {
+  .name = OONF_OS_SYSTEM_SUBSYSTEM,
+};
+DECLARE_OONF_PLUGIN(_fake_os_system_subsystem);
+
+struct os_interface *
+os_interface_linux_add(struct os_interface_listener *listener) {
+  size_t i;
+
+  for (i=0; i<ARRAYSIZE(_interfaces); i++) {
+    if (strcmp(_interfaces[i].name, listener->name) == 0) {
+      listener->data = &_interfaces[i];
+      return listener->data;
+    }
+  }
+  return NULL;
+}
+
+void
+os_interface_linux_remove(struct os_interface_listener *listener) {
+  listener->data = NULL;
+}
+
+int
+os_system_linux_netlink_add(struct os_system_netlink *nl __attribute__((unused)),
+    int protocol __attribute__((unused))) {
+  return 0;
+}
+
+void
+os_system_linux_netlink_remove(struct os_system_netlink *nl __attribute__((unused))) {
+}
+
+int
+os_system_linux_netlink_add_mc(struct os_system_netlink *nl __attribute__((unused)),
+    const uint32_t *groups __attribute__((unused)),
+    size_t groupcount __attribute__((unused))) {
+  return 0;
+}
+
+int
+os_system_linux_netlink_addreq(struct os_system_netlink *nl __attribute__((unused)),
+    struct nlmsghdr *n, int type, const void *data, int len) {
+  struct nlattr *nl_attr;
+
+  nl_attr = (struct nlattr *) ((uint8_t *)n + NLMSG_ALIGN(n->nlmsg_len));
+  nl_attr->nla_type = type;
+  nl_attr->nla_len = NLA_HDRLEN + len;
+  if (len) {
+    memcpy((uint8_t *)nl_attr + NLA_HDRLEN, data, len);
+  }
+
+  n->nlmsg_len = NLMSG_ALIGN(n->nlmsg_len) + NLA_ALIGN(nl_attr->nla_len);
+  return 0;
+}
+
+int
+os_system_linux_netlink_send(struct os_system_netlink *nl, struct nlmsghdr *nl_hdr) {
+  struct genlmsghdr *gen_hdr;
+  struct test_request *request;
+  struct nlattr *nl_attr;
+  size_t i;
+
+  for (i=0; i<_request_count; i++) {
+    if (_requests[i].nl == nl) {
+      _socket_reused = true;
+    }
+  }
+
+  nl_hdr->nlmsg_seq = ++_last_seq;
+  gen_hdr = NLMSG_DATA(nl_hdr);
+
+  request = &_requests[_request_count++];
+  request->nl = nl;
+  request->seq = nl_hdr->nlmsg_seq;
+  request->cmd = gen_hdr->cmd;
+  request->ifindex = 0;
+
+  nl_attr = nla_find((struct nlattr *)((uint8_t *)gen_hdr + GENL_HDRLEN),
+      nl_hdr->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN), NL80211_ATTR_IFINDEX);
+  if (!nl_attr) {
+    /* the test radios use the interface index as wiphy index */
+    nl_attr = nla_find((struct nlattr *)((uint8_t *)gen_hdr + GENL_HDRLEN),
+        nl_hdr->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN), NL80211_ATTR_WIPHY);
+  }
+  if (nl_attr) {
+    request->ifindex = nla_get_u32(nl_attr);
+  }
+
+  if (request->cmd == NL80211_CMD_GET_INTERFACE) {
+    _get_if_requests++;
+  }
+
+  if (_request_count > _max_in_flight) {
+    _max_in_flight = _request_count;
+  }
+  return nl_hdr->nlmsg_seq;
+}
+
+static void
+_clear_elements(void) {
+  _request_count = 0;
+  _max_in_flight = 0;
+  _socket_reused = false;
+  _get_if_requests = 0;
+}
+
+/**
+ * Initialize a nl80211 reply message
+ * @param cmd nl80211 command of reply
+ * @param seq sequence number of the request
+ * @return netlink message
+ */
+static struct nlmsghdr *
+_init_reply(uint8_t cmd, uint32_t seq) {
+  struct nlmsghdr *hdr = (void *)_reply_buffer;
+  struct genlmsghdr *gen_hdr;
+
+  memset(_reply_buffer, 0, sizeof(_reply_buffer));
+  hdr->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+  hdr->nlmsg_type = TEST_NL80211_ID;
+  hdr->nlmsg_flags = NLM_F_MULTI;
+  hdr->nlmsg_seq = seq;
+
+  gen_hdr = NLMSG_DATA(hdr);
+  gen_hdr->cmd = cmd;
+  return hdr;
+}
+
+/**
+ * Start a nested attribute in a reply message
+ * @param hdr netlink message
+ * @param type attribute type
+ * @return pointer to nested attribute, length is fixed by _end_nested()
+ */
+static struct nlattr *
+_start_nested(struct nlmsghdr *hdr, int type) {
+  struct nlattr *nested;
+
+  nested = (struct nlattr *) ((uint8_t *)hdr + NLMSG_ALIGN(hdr->nlmsg_len));
+  os_system_linux_netlink_addreq(NULL, hdr, type | NLA_F_NESTED, NULL, 0);
+  return nested;
+}
+
+/**
+ * Finish a nested attribute in a reply message
+ * @param hdr netlink message
+ * @param nested pointer to nested attribute
+ */
+static void
+_end_nested(struct nlmsghdr *hdr, struct nlattr *nested) {
+  nested->nla_len = (uint8_t *)hdr + hdr->nlmsg_len - (uint8_t *)nested;
+}
+
+/**
+ * Generate a NL80211_CMD_NEW_INTERFACE reply for a test radio
+ * @param ifindex interface index
+ * @param seq sequence number of the request
+ * @return netlink message
+ */
+static struct nlmsghdr *
+_generate_interface_reply(uint32_t ifindex, uint32_t seq) {
+  struct nlmsghdr *hdr;
+  uint32_t freq = TEST_FREQUENCY;
+
+  hdr = _init_reply(NL80211_CMD_NEW_INTERFACE, seq);
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_ATTR_IFINDEX,
+      &ifindex, sizeof(ifindex));
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_ATTR_IFNAME,
+      _interfaces[ifindex-1].name, strlen(_interfaces[ifindex-1].name) + 1);
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_ATTR_WIPHY,
+      &ifindex, sizeof(ifindex));
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_ATTR_WIPHY_FREQ,
+      &freq, sizeof(freq));
+  return hdr;
+}
+
+/**
+ * Generate a NL80211_CMD_NEW_WIPHY reply with a single vht band
+ * @param wiphy physical interface index
+ * @param seq sequence number of the request
+ * @return netlink message
+ */
+static struct nlmsghdr *
+_generate_wiphy_reply(uint32_t wiphy, uint32_t seq) {
+  struct nlmsghdr *hdr;
+  struct nlattr *bands, *band;
+  uint8_t vht_mcs[8];
+
+  memset(vht_mcs, 0, sizeof(vht_mcs));
+  vht_mcs[4] = TEST_VHT_RX_RATE & 255;
+  vht_mcs[5] = TEST_VHT_RX_RATE >> 8;
+
+  hdr = _init_reply(NL80211_CMD_NEW_WIPHY, seq);
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_ATTR_WIPHY,
+      &wiphy, sizeof(wiphy));
+
+  bands = _start_nested(hdr, NL80211_ATTR_WIPHY_BANDS);
+  band = _start_nested(hdr, NL80211_BAND_2GHZ);
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_BAND_ATTR_VHT_MCS_SET,
+      vht_mcs, sizeof(vht_mcs));
+  _end_nested(hdr, band);
+  _end_nested(hdr, bands);
+  return hdr;
+}
+
+/**
+ * Generate a NL80211_CMD_NEW_SURVEY_RESULTS reply for the channel in use
+ * @param ifindex interface index
+ * @param seq sequence number of the request
+ * @return netlink message
+ */
+static struct nlmsghdr *
+_generate_survey_reply(uint32_t ifindex, uint32_t seq) {
+  struct nlmsghdr *hdr;
+  struct nlattr *survey;
+  uint8_t noise;
+
+  hdr = _init_reply(NL80211_CMD_NEW_SURVEY_RESULTS, seq);
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_ATTR_IFINDEX,
+      &ifindex, sizeof(ifindex));
+
+  survey = _start_nested(hdr, NL80211_ATTR_SURVEY_INFO);
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_SURVEY_INFO_IN_USE, NULL, 0);
+
+  noise = (uint8_t)_noise;
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_SURVEY_INFO_NOISE,
+      &noise, sizeof(noise));
+  _end_nested(hdr, survey);
+  return hdr;
+}
+
+/**
+ * Generate the recorded NL80211_CMD_NEW_STATION reply for a station
+ * @param station recorded station
+ * @param seq sequence number of the station dump request
+ * @return netlink message
+ */
+static struct nlmsghdr *
+_generate_station_reply(const struct test_station *station, uint32_t seq) {
+  struct nlmsghdr *hdr;
+  struct nlattr *sta_info;
+  uint8_t signal;
+
+  hdr = _init_reply(NL80211_CMD_NEW_STATION, seq);
+
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_ATTR_IFINDEX,
+      &station->ifindex, sizeof(station->ifindex));
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_ATTR_MAC,
+      station->mac, sizeof(station->mac));
+
+  /* nested station info */
+  sta_info = _start_nested(hdr, NL80211_ATTR_STA_INFO);
+
+  signal = (uint8_t)station->signal;
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_STA_INFO_SIGNAL,
+      &signal, sizeof(signal));
+  os_system_linux_netlink_addreq(NULL, hdr, NL80211_STA_INFO_RX_BYTES64,
+      &station->rx_bytes, sizeof(station->rx_bytes));
+
+  _end_nested(hdr, sta_info);
+  return hdr;
+}
+
+/**
+ * Remove a request from the list of outstanding requests
+ * @param seq sequence number of request
+ */
+static void
+_remove_request(uint32_t seq) {
+  size_t i;
+
+  for (i=0; i<_request_count; i++) {
+    if (_requests[i].seq == seq) {
+      _requests[i] = _requests[--_request_count];
+      return;
+    }
+  }
+}
+
+/**
+ * Answer all outstanding requests of the listener. The replies of the
+ * station dumps are interleaved and the requests are completed in
+ * reverse order, the listener has to sort them by sequence number.
+ * Interface, wiphy and survey requests get a single reply.
+ */
+static void
+_answer_requests(void) {
+  struct test_request requests[TEST_MAX_REQUESTS];
+  size_t count, i, j, s, sent;
+  bool more;
+
+  count = _request_count;
+  memcpy(requests, _requests, sizeof(requests[0]) * count);
+
+  for (j=0; j<count; j++) {
+    if (requests[j].ifindex < 1 || requests[j].ifindex > ARRAYSIZE(_interfaces)) {
+      continue;
+    }
+
+    switch (requests[j].cmd) {
+      case NL80211_CMD_GET_INTERFACE:
+        requests[j].nl->cb_message(
+            _generate_interface_reply(requests[j].ifindex, requests[j].seq));
+        break;
+      case NL80211_CMD_GET_WIPHY:
+        requests[j].nl->cb_message(
+            _generate_wiphy_reply(requests[j].ifindex, requests[j].seq));
+        break;
+      case NL80211_CMD_GET_SURVEY:
+        requests[j].nl->cb_message(
+            _generate_survey_reply(requests[j].ifindex, requests[j].seq));
+        break;
+      default:
+        break;
+    }
+  }
+
+  /* one station of each running dump after the other */
+  for (i=0, more=true; more; i++) {
+    more = false;
+    for (j=0; j<count; j++) {
+      if (requests[j].cmd != NL80211_CMD_GET_STATION) {
+        continue;
+      }
+
+      sent = 0;
+      for (s=0; s<ARRAYSIZE(_stations); s++) {
+        if (_stations[s].ifindex != requests[j].ifindex) {
+          continue;
+        }
+        if (sent++ == i) {
+          requests[j].nl->cb_message(_generate_station_reply(&_stations[s], requests[j].seq));
+          more = true;
+        }
+      }
+    }
+  }
+
+  /* finish requests, this triggers the next ones */
+  for (i=count; i>0; i--) {
+    _remove_request(requests[i-1].seq);
+    requests[i-1].nl->cb_done(requests[i-1].seq);
+  }
+}
+
+/**
+ * Setup listener for a series of queries
+ * @param max_pending maximum number of parallel queries
+ */
+static void
+_setup_listener(int32_t max_pending) {
+  nl80211_set_query_limits(max_pending, 10000);
+  nl80211_set_family(TEST_NL80211_ID, 1, false);
+}
+
+static void
+test_parallel_queries(void) {
+  struct oonf_layer2_neigh *l2neigh;
+  struct oonf_layer2_net *l2net;
+  struct netaddr mac;
+  size_t i, series;
+
+  START_TEST();
+
+  _setup_listener(2);
+  for (i=0; i<ARRAYSIZE(_interfaces); i++) {
+    CHECK_TRUE(nl80211_if_add(_interfaces[i].name) != NULL,
+        "Could not add interface %s", _interfaces[i].name);
+  }
+
+  for (series=0; series<2; series++) {
+    nl80211_trigger_next_query();
+    CHECK_TRUE(_request_count == 2, "series %"PRINTF_SIZE_T_SPECIFIER
+        " started %"PRINTF_SIZE_T_SPECIFIER" queries", series, _request_count);
+
+    while (_request_count) {
+      _answer_requests();
+    }
+
+    CHECK_TRUE(nl80211_is_query_series_finished(),
+        "series %"PRINTF_SIZE_T_SPECIFIER" not finished", series);
+  }
+  CHECK_TRUE(_max_in_flight == 2, "%"PRINTF_SIZE_T_SPECIFIER" parallel queries",
+      _max_in_flight);
+  CHECK_TRUE(!_socket_reused, "Two outstanding queries on one netlink socket");
+
+  /* check merged station dumps */
+  for (i=0; i<ARRAYSIZE(_stations); i++) {
+    l2net = oonf_layer2_net_get(_interfaces[_stations[i].ifindex - 1].name);
+    CHECK_TRUE(l2net != NULL, "layer2 network %u missing", _stations[i].ifindex);
+    if (!l2net) {
+      continue;
+    }
+
+    netaddr_from_binary(&mac, _stations[i].mac, 6, AF_MAC48);
+    l2neigh = oonf_layer2_neigh_get(l2net, &mac);
+    CHECK_TRUE(l2neigh != NULL, "station %"PRINTF_SIZE_T_SPECIFIER" missing", i);
+    if (!l2neigh) {
+      continue;
+    }
+
+    CHECK_TRUE(oonf_layer2_get_value(&l2neigh->data[OONF_LAYER2_NEIGH_RX_SIGNAL])
+        == _stations[i].signal * 1000ll, "station %"PRINTF_SIZE_T_SPECIFIER
+        " has wrong signal", i);
+    CHECK_TRUE(oonf_layer2_get_value(&l2neigh->data[OONF_LAYER2_NEIGH_RX_BYTES])
+        == (int64_t)_stations[i].rx_bytes, "station %"PRINTF_SIZE_T_SPECIFIER
+        " has wrong rx bytes", i);
+  }
+
+  for (i=0; i<ARRAYSIZE(_interfaces); i++) {
+    l2net = oonf_layer2_net_get(_interfaces[i].name);
+    CHECK_TRUE(l2net != NULL && l2net->neighbors.count
+        == (i == 0 ? 3u : i == 1 ? 1u : 2u),
+        "wrong number of stations on %s", _interfaces[i].name);
+  }
+
+  END_TEST();
+}
+
+static void
+test_remove_during_query(void) {
+  struct nl80211_if *interf;
+  size_t i;
+
+  START_TEST();
+
+  _setup_listener(2);
+  for (i=0; i<ARRAYSIZE(_interfaces); i++) {
+    nl80211_if_add(_interfaces[i].name);
+  }
+
+  nl80211_trigger_next_query();
+  CHECK_TRUE(_request_count == 2, "%"PRINTF_SIZE_T_SPECIFIER" queries started",
+      _request_count);
+
+  /* remove an interface with an outstanding query and the next one of the series */
+  interf = nl80211_if_get(_interfaces[0].name);
+  CHECK_TRUE(interf != NULL, "Interface %s missing", _interfaces[0].name);
+  if (interf) {
+    nl80211_if_remove(interf);
+  }
+  interf = nl80211_if_get(_interfaces[2].name);
+  CHECK_TRUE(interf != NULL, "Interface %s missing", _interfaces[2].name);
+  if (interf) {
+    nl80211_if_remove(interf);
+  }
+
+  while (_request_count) {
+    _answer_requests();
+  }
+
+  CHECK_TRUE(nl80211_is_query_series_finished(), "series not finished");
+  CHECK_TRUE(!_socket_reused, "Two outstanding queries on one netlink socket");
+
+  END_TEST();
+}
+
+static void
+test_static_data_survives(void) {
+  struct oonf_layer2_net *l2net;
+  struct nl80211_if *interf;
+  size_t i, series;
+
+  START_TEST();
+
+  _setup_listener(2);
+  for (i=0; i<ARRAYSIZE(_interfaces); i++) {
+    nl80211_if_add(_interfaces[i].name);
+  }
+  interf = nl80211_if_get(_interfaces[0].name);
+  CHECK_TRUE(interf != NULL, "Interface %s missing", _interfaces[0].name);
+  if (!interf) {
+    END_TEST();
+    return;
+  }
+
+  /* first series is a full one, the others only query dynamic data */
+  for (series=0; series<3; series++) {
+    nl80211_set_family(TEST_NL80211_ID, 1, series > 0);
+    _noise = -90 + (int8_t)series;
+    _get_if_requests = 0;
+
+    nl80211_trigger_next_query();
+    while (_request_count) {
+      _answer_requests();
+    }
+    CHECK_TRUE(nl80211_is_query_series_finished(),
+        "series %"PRINTF_SIZE_T_SPECIFIER" not finished", series);
+    CHECK_TRUE(_get_if_requests == (series == 0 ? ARRAYSIZE(_interfaces) : 0),
+        "series %"PRINTF_SIZE_T_SPECIFIER" sent %"PRINTF_SIZE_T_SPECIFIER
+        " interface queries", series, _get_if_requests);
+
+    l2net = interf->l2net;
+    CHECK_TRUE(oonf_layer2_get_value(&l2net->data[OONF_LAYER2_NET_NOISE])
+        == _noise * 1000ll, "series %"PRINTF_SIZE_T_SPECIFIER" has wrong noise", series);
+    CHECK_TRUE(oonf_layer2_has_value(&l2net->data[OONF_LAYER2_NET_FREQUENCY_1])
+        && oonf_layer2_get_value(&l2net->data[OONF_LAYER2_NET_FREQUENCY_1])
+        == TEST_FREQUENCY * 1000000ll,
+        "series %"PRINTF_SIZE_T_SPECIFIER" lost frequency", series);
+    CHECK_TRUE(oonf_layer2_has_value(&l2net->neighdata[OONF_LAYER2_NEIGH_RX_MAX_BITRATE])
+        && oonf_layer2_get_value(&l2net->neighdata[OONF_LAYER2_NEIGH_RX_MAX_BITRATE])
+        == TEST_VHT_RX_RATE * 1024ll * 1024ll,
+        "series %"PRINTF_SIZE_T_SPECIFIER" lost maximum rx bitrate", series);
+  }
+
+  nl80211_set_family(TEST_NL80211_ID, 1, false);
+
+  END_TEST();
+}
+
+static void
+test_if_index(void) {
+  struct nl80211_if *interf;
+  size_t i;
+
+  START_TEST();
+
+  for (i=0; i<ARRAYSIZE(_interfaces); i++) {
+    nl80211_if_add(_interfaces[i].name);
+  }
+
+  for (i=0; i<ARRAYSIZE(_interfaces); i++) {
+    interf = nl80211_if_get_by_index(_interfaces[i].base_index);
+    CHECK_TRUE(interf != NULL && strcmp(interf->name, _interfaces[i].name) == 0,
+        "Interface index %u not found", _interfaces[i].base_index);
+  }
+
+  /* interface changes its index */
+  interf = nl80211_if_get(_interfaces[1].name);
+  CHECK_TRUE(interf != NULL, "Interface %s missing", _interfaces[1].name);
+  if (interf) {
+    _interfaces[1].index = _interfaces[1].base_index = 42;
+    interf->if_listener.if_changed(&interf->if_listener);
+
+    CHECK_TRUE(nl80211_if_get_by_index(2) == NULL, "Old interface index still found");
+    CHECK_TRUE(nl80211_if_get_by_index(42) == interf, "New interface index not found");
+
+    nl80211_if_remove(interf);
+    CHECK_TRUE(nl80211_if_get_by_index(42) == NULL, "Removed interface still found");
+
+    _interfaces[1].index = _interfaces[1].base_index = 2;
+  }
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *nl80211;
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  /* initialize listener with all of its dependencies */
+  nl80211 = oonf_subsystem_get(OONF_NL80211_LISTENER_SUBSYSTEM);
+  if (nl80211 == NULL || oonf_subsystem_call_init(nl80211)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_NL80211_LISTENER_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  BEGIN_TESTING(_clear_elements);
+
+  test_parallel_queries();
+  test_remove_during_query();
+  test_static_data_survives();
+  test_if_index();
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,415 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/avl.h"
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "cunit/cunit.h"
+
+#include "nhdp/nhdp.h"
+#include "nhdp/nhdp_db.h"
+#include "nhdp/nhdp_interfaces.h"
+
+/*! number of one-hop neighbors */
+#define NEIGHBOR_COUNT 200
+
+/*! number of addresses of each neighbor (and its link) */
+#define ADDRESS_COUNT 4
+
+/*! number of two-hop neighbors of each link */
+#define TWOHOP_COUNT 40
+
+/*! default number of lookup rounds for measurement */
+#define DEFAULT_ITERATIONS 200
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "bench_nhdp_db",
+};
+
+static struct nhdp_interface *_interf;
+static struct nhdp_link *_links[NEIGHBOR_COUNT];
+static struct netaddr _addresses[NEIGHBOR_COUNT][ADDRESS_COUNT];
+static struct netaddr _twohops[NEIGHBOR_COUNT][TWOHOP_COUNT];
+
+static void
+_clear_elements(void) {
+}
+
+/**
+ * @return monotonic time in microseconds
+ */
+static uint64_t
+_get_time(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/**
+ * Create an IPv4 or IPv6 address for a node number
+ * @param dst pointer to target address
+ * @param node node number
+ * @param idx address index of node
+ */
+static void
+_make_address(struct netaddr *dst, int node, int idx) {
+  uint8_t bin[16];
+
+  memset(bin, 0, sizeof(bin));
+  if (idx & 1) {
+    bin[0] = 0xfd;
+    bin[13] = (uint8_t)idx;
+    bin[14] = (uint8_t)(node >> 8);
+    bin[15] = (uint8_t)node;
+    netaddr_from_binary(dst, bin, 16, AF_INET6);
+  }
+  else {
+    bin[0] = 10;
+    bin[1] = (uint8_t)idx;
+    bin[2] = (uint8_t)(node >> 8);
+    bin[3] = (uint8_t)node;
+    netaddr_from_binary(dst, bin, 4, AF_INET);
+  }
+}
+
+/**
+ * Fill the NHDP database with neighbors, links, addresses and
+ * two-hop neighbors. Two-hop neighbors are the addresses of other
+ * one-hop neighbors and of nodes further away, like in a dense mesh.
+ */
+static void
+_fill_db(void) {
+  struct nhdp_neighbor *neigh;
+  int i, j, node;
+
+  for (i = 0; i < NEIGHBOR_COUNT; i++) {
+    neigh = nhdp_db_neighbor_add();
+    _links[i] = nhdp_db_link_add(neigh, _interf);
+
+    for (j = 0; j < ADDRESS_COUNT; j++) {
+      _make_address(&_addresses[i][j], i, j);
+      nhdp_db_neighbor_addr_add(neigh, &_addresses[i][j]);
+      nhdp_db_link_addr_add(_links[i], &_addresses[i][j]);
+    }
+
+    for (j = 0; j < TWOHOP_COUNT; j++) {
+      node = (i * 7 + j * 13) % (NEIGHBOR_COUNT * 4);
+      _make_address(&_twohops[i][j], node, j % ADDRESS_COUNT);
+      if (ndhp_db_link_2hop_get(_links[i], &_twohops[i][j]) == NULL) {
+        nhdp_db_link_2hop_add(_links[i], &_twohops[i][j]);
+      }
+    }
+  }
+}
+
+/**
+ * Remove all neighbors from the NHDP database
+ */
+static void
+_clear_db(void) {
+  struct nhdp_neighbor *neigh, *n_it;
+
+  list_for_each_element_safe(nhdp_db_get_neigh_list(), neigh, _global_node, n_it) {
+    nhdp_db_neighbor_remove(neigh);
+  }
+}
+
+/**
+ * Print lookup rate
+ * @param what name of lookup
+ * @param lookups number of lookups
+ * @param start start timestamp
+ * @param end end timestamp
+ */
+static void
+_print_rate(const char *what, int lookups, uint64_t start, uint64_t end) {
+  printf("\t%-28s %.0f lookups/s\n", what,
+      end > start ? lookups * 1000000.0 / (end - start) : 0.0);
+}
+
+/**
+ * Measure neighbor address lookups with the hash index and
+ * the ordered avl tree
+ * @param iterations number of lookup rounds
+ */
+static void
+_bench_naddr(int iterations) {
+  struct nhdp_naddr *naddr;
+  uint64_t start, mid, end;
+  int i, n, a, bad;
+
+  START_TEST();
+
+  bad = 0;
+  start = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NEIGHBOR_COUNT; n++) {
+      for (a = 0; a < ADDRESS_COUNT; a++) {
+        naddr = nhdp_db_neighbor_addr_get(&_addresses[n][a]);
+        if (naddr == NULL || naddr->neigh != _links[n]->neigh) {
+          bad++;
+        }
+      }
+    }
+  }
+  mid = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NEIGHBOR_COUNT; n++) {
+      for (a = 0; a < ADDRESS_COUNT; a++) {
+        naddr = avl_find_element(nhdp_db_get_naddr_tree(), &_addresses[n][a], naddr, _global_node);
+        if (naddr == NULL) {
+          bad++;
+        }
+      }
+    }
+  }
+  end = _get_time();
+
+  CHECK_TRUE(bad == 0, "%d neighbor address lookups failed", bad);
+
+  _print_rate("naddr (hash index)", iterations * NEIGHBOR_COUNT * ADDRESS_COUNT, start, mid);
+  _print_rate("naddr (avl tree)", iterations * NEIGHBOR_COUNT * ADDRESS_COUNT, mid, end);
+
+  END_TEST();
+}
+
+/**
+ * Measure link address lookups of an interface with the
+ * hash index and the ordered avl tree
+ * @param iterations number of lookup rounds
+ */
+static void
+_bench_laddr(int iterations) {
+  struct nhdp_laddr *laddr;
+  uint64_t start, mid, end;
+  int i, n, a, bad;
+
+  START_TEST();
+
+  bad = 0;
+  start = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NEIGHBOR_COUNT; n++) {
+      for (a = 0; a < ADDRESS_COUNT; a++) {
+        laddr = nhdp_interface_get_link_addr(_interf, &_addresses[n][a]);
+        if (laddr == NULL || laddr->link != _links[n]) {
+          bad++;
+        }
+      }
+    }
+  }
+  mid = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NEIGHBOR_COUNT; n++) {
+      for (a = 0; a < ADDRESS_COUNT; a++) {
+        laddr = avl_find_element(&_interf->_link_addresses, &_addresses[n][a], laddr, _if_node);
+        if (laddr == NULL) {
+          bad++;
+        }
+      }
+    }
+  }
+  end = _get_time();
+
+  CHECK_TRUE(bad == 0, "%d link address lookups failed", bad);
+
+  _print_rate("laddr (hash index)", iterations * NEIGHBOR_COUNT * ADDRESS_COUNT, start, mid);
+  _print_rate("laddr (avl tree)", iterations * NEIGHBOR_COUNT * ADDRESS_COUNT, mid, end);
+
+  END_TEST();
+}
+
+/**
+ * Measure two-hop lookups of links with the hash index and
+ * the ordered avl tree
+ * @param iterations number of lookup rounds
+ */
+static void
+_bench_l2hop(int iterations) {
+  struct nhdp_l2hop *l2hop;
+  uint64_t start, mid, end;
+  int i, n, t, bad;
+
+  START_TEST();
+
+  bad = 0;
+  start = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NEIGHBOR_COUNT; n++) {
+      for (t = 0; t < TWOHOP_COUNT; t++) {
+        l2hop = ndhp_db_link_2hop_get(_links[n], &_twohops[n][t]);
+        if (l2hop == NULL || l2hop->link != _links[n]) {
+          bad++;
+        }
+      }
+    }
+  }
+  mid = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NEIGHBOR_COUNT; n++) {
+      for (t = 0; t < TWOHOP_COUNT; t++) {
+        l2hop = avl_find_element(&_links[n]->_2hop, &_twohops[n][t], l2hop, _link_node);
+        if (l2hop == NULL) {
+          bad++;
+        }
+      }
+    }
+  }
+  end = _get_time();
+
+  CHECK_TRUE(bad == 0, "%d two-hop lookups failed", bad);
+
+  _print_rate("l2hop (hash index)", iterations * NEIGHBOR_COUNT * TWOHOP_COUNT, start, mid);
+  _print_rate("l2hop (avl tree)", iterations * NEIGHBOR_COUNT * TWOHOP_COUNT, mid, end);
+
+  END_TEST();
+}
+
+/**
+ * Remove part of the database and check that the indexes
+ * still match the trees
+ */
+static void
+_test_remove(void) {
+  struct nhdp_l2hop *l2hop, *l2_it;
+  struct nhdp_naddr *naddr;
+  struct nhdp_laddr *laddr;
+  int n, t, bad;
+
+  START_TEST();
+
+  /* remove every second two-hop neighbor of every link */
+  for (n = 0; n < NEIGHBOR_COUNT; n++) {
+    t = 0;
+    avl_for_each_element_safe(&_links[n]->_2hop, l2hop, _link_node, l2_it) {
+      if (t++ & 1) {
+        nhdp_db_link_2hop_remove(l2hop);
+      }
+    }
+  }
+
+  /* remove every second neighbor */
+  for (n = 0; n < NEIGHBOR_COUNT; n += 2) {
+    nhdp_db_neighbor_remove(_links[n]->neigh);
+    _links[n] = NULL;
+  }
+
+  bad = 0;
+  for (n = 0; n < NEIGHBOR_COUNT; n++) {
+    naddr = nhdp_db_neighbor_addr_get(&_addresses[n][0]);
+    if ((naddr != NULL) != (_links[n] != NULL)) {
+      bad++;
+    }
+    if (nhdp_interface_get_link_addr(_interf, &_addresses[n][1])
+        != avl_find_element(&_interf->_link_addresses, &_addresses[n][1], laddr, _if_node)) {
+      bad++;
+    }
+    if (_links[n] == NULL) {
+      continue;
+    }
+
+    for (t = 0; t < TWOHOP_COUNT; t++) {
+      if (ndhp_db_link_2hop_get(_links[n], &_twohops[n][t])
+          != avl_find_element(&_links[n]->_2hop, &_twohops[n][t], l2hop, _link_node)) {
+        bad++;
+      }
+    }
+  }
+  CHECK_TRUE(bad == 0, "%d lookups differ between hash index and tree", bad);
+
+  END_TEST();
+}
+
+int
+main(int argc, char **argv) {
+  struct oonf_subsystem *nhdp;
+  int iterations;
+
+  iterations = DEFAULT_ITERATIONS;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  /* initialize NHDP with all of its dependencies */
+  nhdp = oonf_subsystem_get(OONF_NHDP_SUBSYSTEM);
+  if (nhdp == NULL || oonf_subsystem_call_init(nhdp)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_NHDP_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  _interf = nhdp_interface_add("bench0");
+  if (_interf == NULL) {
+    fprintf(stderr, "Could not create NHDP interface\n");
+    return 1;
+  }
+  _fill_db();
+
+  BEGIN_TESTING(_clear_elements);
+
+  _bench_naddr(iterations);
+  _bench_laddr(iterations);
+  _bench_l2hop(iterations);
+  _test_remove();
+
+  _clear_db();
+  nhdp_interface_remove(_interf);
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,510 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common_types.h"
+#include "subsystems/rfc5444/rfc5444.h"
+
+#include "ff_dat_metric/ff_dat_cost.h"
+#include "ff_dat_metric/ff_dat_history.h"
+#include "ff_dat_metric/ff_dat_metric.h"
+
+#include "cunit/cunit.h"
+
+/*! number of random sequences compared */
+#define RANDOM_SEQUENCES 200
+
+/*! number of sampling intervals per random sequence */
+#define RANDOM_INTERVALS 500
+
+/**
+ * One recorded sampling interval of a link
+ */
+struct recorded_interval {
+  /*! number of received packets */
+  uint32_t received;
+
+  /*! number of lost packets */
+  uint32_t lost;
+
+  /*! scaled link speed reported by layer2 */
+  uint32_t speed;
+};
+
+/**
+ * Reference implementation of the sampling history, uses the
+ * original summing loops and the sorted copy for the median
+ */
+struct reference_history {
+  /*! history ringbuffer */
+  struct link_datff_bucket buckets[DAT_SAMPLING_COUNT];
+
+  /*! current position in history ringbuffer */
+  uint16_t activePtr;
+};
+
+/**
+ * Metric parameters of a link and the packet loss hysteresis
+ * of both implementations
+ */
+struct metric_state {
+  /*! exponent of the packet loss influence */
+  int32_t loss_exponent;
+
+  /*! MIC factor of the link, 1 if not used */
+  int32_t neighborhood;
+
+  /*! last packet success rate of the sampling under test */
+  int64_t last_success;
+
+  /*! last packet success rate of the reference */
+  int64_t ref_last_success;
+};
+
+/*
+ * recorded trace of a link, starts with a missing layer2 speed,
+ * then a stable link with a rate change, a burst of losses and
+ * a speed dropping back to zero
+ */
+static const struct recorded_interval _trace[] = {
+  { 1, 0, 0 }, { 4, 0, 0 }, { 5, 0, 0 }, { 5, 0, 54 }, { 5, 0, 54 },
+  { 5, 1, 54 }, { 4, 0, 54 }, { 5, 0, 48 }, { 5, 0, 48 }, { 5, 0, 36 },
+  { 5, 0, 36 }, { 3, 2, 36 }, { 2, 3, 24 }, { 0, 0, 24 }, { 0, 0, 24 },
+  { 1, 4, 18 }, { 4, 1, 24 }, { 5, 0, 36 }, { 5, 0, 54 }, { 5, 0, 54 },
+  { 5, 0, 54 }, { 5, 0, 54 }, { 6, 0, 54 }, { 5, 0, 54 }, { 4, 0, 54 },
+  { 5, 0, 54 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 54 }, { 5, 0, 54 },
+  { 5, 0, 48 }, { 5, 0, 48 }, { 5, 0, 48 }, { 5, 0, 48 }, { 5, 0, 48 },
+  { 5, 0, 1 }, { 5, 0, 1 }, { 0, 5, 1 }, { 0, 5, 0 }, { 0, 5, 0 },
+  { 0, 5, 0 }, { 2, 3, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 },
+  { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 },
+  { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 },
+  { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 },
+  { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 },
+  { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 0 }, { 5, 0, 65535 },
+};
+
+static uint32_t _random_state;
+
+static void
+_clear_elements(void) {
+}
+
+static uint32_t
+_random(void) {
+  /* xorshift32, the tests must be reproducible */
+  _random_state ^= _random_state << 13;
+  _random_state ^= _random_state >> 17;
+  _random_state ^= _random_state << 5;
+  return _random_state;
+}
+
+static int
+_int_comparator(const void *p1, const void *p2) {
+  const uint32_t *i1 = p1;
+  const uint32_t *i2 = p2;
+
+  if (*i1 > *i2) {
+    return 1;
+  }
+  else if (*i1 < *i2) {
+    return -1;
+  }
+  return 0;
+}
+
+static void
+_ref_init(struct reference_history *ref) {
+  size_t i;
+
+  for (i = 0; i<DAT_SAMPLING_COUNT; i++) {
+    ref->buckets[i].received = 0;
+    ref->buckets[i].total = 1;
+    ref->buckets[i].scaled_speed = 0;
+  }
+  ref->activePtr = 0;
+}
+
+static void
+_ref_start(struct reference_history *ref) {
+  ref->activePtr = 0;
+  ref->buckets[0].received = 1;
+  ref->buckets[0].total = 1;
+}
+
+static void
+_ref_next(struct reference_history *ref) {
+  ref->activePtr++;
+  if (ref->activePtr >= DAT_SAMPLING_COUNT) {
+    ref->activePtr = 0;
+  }
+  ref->buckets[ref->activePtr].received = 0;
+  ref->buckets[ref->activePtr].total = 0;
+}
+
+static uint32_t
+_ref_get_received(struct reference_history *ref) {
+  uint32_t received = 0;
+  size_t i;
+
+  for (i = 0; i<DAT_SAMPLING_COUNT; i++) {
+    received += ref->buckets[i].received;
+  }
+  return received;
+}
+
+static uint32_t
+_ref_get_total(struct reference_history *ref) {
+  uint32_t total = 0;
+  size_t i;
+
+  for (i = 0; i<DAT_SAMPLING_COUNT; i++) {
+    total += ref->buckets[i].total;
+  }
+  return total;
+}
+
+static uint32_t
+_ref_get_median_speed(struct reference_history *ref) {
+  uint32_t sorted[DAT_SAMPLING_COUNT];
+  size_t zero_count, window;
+  size_t i;
+
+  zero_count = 0;
+  for (i = 0; i<DAT_SAMPLING_COUNT; i++) {
+    sorted[i] = ref->buckets[i].scaled_speed;
+    if (sorted[i] == 0) {
+      zero_count++;
+    }
+  }
+
+  window = DAT_SAMPLING_COUNT - zero_count;
+  if (window == 0) {
+    return 1;
+  }
+
+  qsort(sorted, DAT_SAMPLING_COUNT, sizeof(uint32_t), _int_comparator);
+  return sorted[zero_count + window/2];
+}
+
+static void
+_metric_init(struct metric_state *state, int32_t loss_exponent, int32_t neighborhood) {
+  state->loss_exponent = loss_exponent;
+  state->neighborhood = neighborhood;
+  state->last_success = 1000ll;
+  state->ref_last_success = 1000ll;
+}
+
+/**
+ * Calculate the link metric from the sampling history the same
+ * way the ff_dat metric sampling does
+ * @param history history under test
+ * @param state metric parameters and hysteresis
+ * @return link metric
+ */
+static uint32_t
+_get_metric(struct link_datff_history *history, struct metric_state *state) {
+  struct ff_dat_sample sample;
+  uint32_t received, total;
+  int64_t success_scaled_by_1000;
+
+  received = ff_dat_history_get_received(history);
+  total = ff_dat_history_get_total(history);
+
+  sample.rx_bitrate = ff_dat_history_get_median_speed(history);
+
+  if (total == 0 || received == 0
+      || received * DATFF_FRAME_SUCCESS_RANGE <= total) {
+    sample.success_scaled_by_1000 = 0;
+    sample.loss_exponent = 0;
+    sample.neighborhood = 1;
+  }
+  else {
+    success_scaled_by_1000 = (((int64_t)DATFF_FRAME_SUCCESS_RANGE * 1000ll) * received) / total;
+    if (success_scaled_by_1000 >= state->last_success - 750
+        && success_scaled_by_1000 <= state->last_success + 750) {
+      success_scaled_by_1000 = state->last_success;
+    }
+    else {
+      state->last_success = success_scaled_by_1000;
+    }
+
+    sample.success_scaled_by_1000 = success_scaled_by_1000;
+    sample.loss_exponent = state->loss_exponent;
+    sample.neighborhood = state->neighborhood;
+  }
+
+  return ff_dat_cost_encode(ff_dat_cost_calculate(&sample));
+}
+
+/**
+ * Calculate the link metric with the original array based
+ * sampling and metric calculation
+ * @param ref reference history
+ * @param state metric parameters and hysteresis
+ * @return link metric
+ */
+static uint32_t
+_ref_get_metric(struct reference_history *ref, struct metric_state *state) {
+  struct rfc7181_metric_field encoded_metric;
+  uint32_t received, total;
+  uint32_t rx_bitrate;
+  int64_t success_scaled_by_1000;
+  int64_t metric;
+  int loss_exponent;
+
+  received = _ref_get_received(ref);
+  total = _ref_get_total(ref);
+
+  rx_bitrate = _ref_get_median_speed(ref);
+  if (rx_bitrate > DATFF_LINKSPEED_RANGE) {
+    metric = 1;
+  }
+  else {
+    metric = DATFF_LINKSPEED_RANGE / rx_bitrate;
+  }
+
+  if (total == 0 || received == 0
+      || received * DATFF_FRAME_SUCCESS_RANGE <= total) {
+    metric *= DATFF_FRAME_SUCCESS_RANGE;
+  }
+  else {
+    success_scaled_by_1000 = (((int64_t)DATFF_FRAME_SUCCESS_RANGE * 1000ll) * received) / total;
+    if (success_scaled_by_1000 >= state->ref_last_success - 750
+        && success_scaled_by_1000 <= state->ref_last_success + 750) {
+      success_scaled_by_1000 = state->ref_last_success;
+    }
+    else {
+      state->ref_last_success = success_scaled_by_1000;
+    }
+
+    for (loss_exponent = state->loss_exponent; loss_exponent > 0; loss_exponent--) {
+      metric = (metric * (int64_t)DATFF_FRAME_SUCCESS_RANGE * 1000ll + 500ll) / success_scaled_by_1000;
+    }
+    if (state->neighborhood > 1) {
+      metric = metric * (int64_t)state->neighborhood;
+    }
+    if (metric > RFC7181_METRIC_MAX) {
+      metric = RFC7181_METRIC_MAX;
+    }
+  }
+
+  if (metric > RFC7181_METRIC_MAX) {
+    return RFC7181_METRIC_MAX;
+  }
+  if (metric < RFC7181_METRIC_MIN) {
+    return RFC7181_METRIC_MIN;
+  }
+  if (rfc7181_metric_encode(&encoded_metric, metric)) {
+    return RFC7181_METRIC_MAX;
+  }
+  return rfc7181_metric_decode(&encoded_metric);
+}
+
+/**
+ * Feed one sampling interval into both implementations, packet
+ * by packet like the RFC5444 packet processing does, and compare
+ * the results of the metric sampling and the final link metric
+ * @param history history under test
+ * @param ref reference history
+ * @param state metric parameters and hysteresis
+ * @param interval recorded interval
+ * @param started true if the link already received a packet
+ * @return true if both implementations agree
+ */
+static bool
+_feed_interval(struct link_datff_history *history, struct reference_history *ref,
+    struct metric_state *state, const struct recorded_interval *interval, bool *started) {
+  uint32_t i, lost;
+  bool same;
+
+  lost = interval->lost;
+  for (i = 0; i < interval->received; i++) {
+    if (!*started) {
+      *started = true;
+      ff_dat_history_start(history);
+      _ref_start(ref);
+      continue;
+    }
+
+    /* attach lost packets to the next received one, like a sequence number gap */
+    ff_dat_history_add_packets(history, 1, 1 + lost);
+    ref->buckets[ref->activePtr].received++;
+    ref->buckets[ref->activePtr].total += 1 + lost;
+    lost = 0;
+  }
+
+  if (!*started) {
+    /* sampling ignores links without data */
+    return true;
+  }
+
+  ff_dat_history_set_speed(history, interval->speed);
+  ref->buckets[ref->activePtr].scaled_speed = interval->speed;
+
+  same = ff_dat_history_get_received(history) == _ref_get_received(ref)
+      && ff_dat_history_get_total(history) == _ref_get_total(ref)
+      && ff_dat_history_get_speed(history) == interval->speed
+      && ff_dat_history_get_median_speed(history) == _ref_get_median_speed(ref);
+
+  /* both sides have to run to keep their hysteresis in sync */
+  if (_get_metric(history, state) != _ref_get_metric(ref, state)) {
+    same = false;
+  }
+
+  ff_dat_history_next(history);
+  _ref_next(ref);
+  return same;
+}
+
+static void
+test_initial_history(void) {
+  struct link_datff_history history;
+
+  START_TEST();
+
+  ff_dat_history_init(&history);
+
+  CHECK_TRUE(ff_dat_history_get_received(&history) == 0,
+      "received is %u", ff_dat_history_get_received(&history));
+  CHECK_TRUE(ff_dat_history_get_total(&history) == DAT_SAMPLING_COUNT,
+      "total is %u", ff_dat_history_get_total(&history));
+  CHECK_TRUE(ff_dat_history_get_median_speed(&history) == 1,
+      "median speed is %u", ff_dat_history_get_median_speed(&history));
+
+  ff_dat_history_start(&history);
+  CHECK_TRUE(ff_dat_history_get_received(&history) == 1,
+      "received is %u", ff_dat_history_get_received(&history));
+  CHECK_TRUE(ff_dat_history_get_total(&history) == DAT_SAMPLING_COUNT,
+      "total is %u", ff_dat_history_get_total(&history));
+
+  ff_dat_history_set_speed(&history, 54);
+  CHECK_TRUE(ff_dat_history_get_median_speed(&history) == 54,
+      "median speed is %u", ff_dat_history_get_median_speed(&history));
+
+  END_TEST();
+}
+
+static void
+test_recorded_trace(void) {
+  struct link_datff_history history;
+  struct reference_history ref;
+  struct metric_state state;
+  bool started = false;
+  size_t i, failed;
+
+  START_TEST();
+
+  ff_dat_history_init(&history);
+  _ref_init(&ref);
+  _metric_init(&state, 1, 1);
+
+  failed = 0;
+  for (i = 0; i < ARRAYSIZE(_trace); i++) {
+    if (!_feed_interval(&history, &ref, &state, &_trace[i], &started)) {
+      failed++;
+    }
+  }
+
+  CHECK_TRUE(failed == 0, "Results differ in %"PRINTF_SIZE_T_SPECIFIER" of %"
+      PRINTF_SIZE_T_SPECIFIER" intervals", failed, ARRAYSIZE(_trace));
+
+  END_TEST();
+}
+
+static void
+test_random_sequences(void) {
+  struct link_datff_history history;
+  struct reference_history ref;
+  struct recorded_interval interval;
+  struct metric_state state;
+  uint32_t speed_range;
+  bool started;
+  size_t i, j, failed;
+
+  START_TEST();
+
+  _random_state = 0x12345678;
+  failed = 0;
+
+  for (i = 0; i < RANDOM_SEQUENCES; i++) {
+    ff_dat_history_init(&history);
+    _ref_init(&ref);
+    started = false;
+
+    /* small ranges produce many duplicate speeds */
+    speed_range = (_random() & 1) ? 4 : 100000;
+
+    /* cover all loss exponents, with and without MIC factor */
+    _metric_init(&state, 1 + _random() % 4, 1 + _random() % 6);
+
+    for (j = 0; j < RANDOM_INTERVALS; j++) {
+      interval.received = _random() % 8;
+      interval.lost = (_random() % 4 == 0) ? _random() % 6 : 0;
+      interval.speed = (_random() % 5 == 0) ? 0 : 1 + _random() % speed_range;
+
+      if (!_feed_interval(&history, &ref, &state, &interval, &started)) {
+        failed++;
+      }
+    }
+  }
+
+  CHECK_TRUE(failed == 0, "Results differ in %"PRINTF_SIZE_T_SPECIFIER" intervals", failed);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  BEGIN_TESTING(_clear_elements);
+
+  test_initial_history();
+  test_recorded_trace();
+  test_random_sequences();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,421 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common/common_types.h"
+#include "common/avl.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "rfc5444/rfc5444.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "cunit/cunit.h"
+
+#include "nhdp/nhdp.h"
+#include "nhdp/nhdp_db.h"
+#include "nhdp/nhdp_domain.h"
+#include "nhdp/nhdp_interfaces.h"
+
+#include "mpr/neighbor-graph.h"
+#include "mpr/neighbor-graph-routing.h"
+#include "mpr/selection-incremental.h"
+#include "mpr/selection-rfc7181.h"
+
+/*! number of one-hop neighbors the test can create */
+#define MAX_N1 12
+
+/*! number of two-hop addresses the test can create */
+#define MAX_N2 24
+
+/*! number of random changes applied to the neighborhood */
+#define RANDOM_STEPS 1000
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "test_mpr_incremental",
+};
+
+static struct nhdp_domain_metric _test_metric = {
+  .name = "test_metric",
+};
+
+static struct nhdp_domain *_domain;
+static struct nhdp_interface *_interf;
+
+/* links of the one-hop neighbors, NULL if the neighbor does not exist */
+static struct nhdp_link *_links[MAX_N1];
+
+static struct mpr_incremental_state _state;
+static uint32_t _random_state;
+
+static void
+_clear_elements(void) {
+}
+
+static uint32_t
+_random(void) {
+  /* xorshift32, the tests must be reproducible */
+  _random_state ^= _random_state << 13;
+  _random_state ^= _random_state >> 17;
+  _random_state ^= _random_state << 5;
+  return _random_state;
+}
+
+/**
+ * Create the address of a one-hop neighbor or a two-hop address
+ * @param addr pointer to target address
+ * @param net 0 for one-hop neighbors, 1 for two-hop addresses
+ * @param idx index of neighbor or two-hop address
+ */
+static void
+_make_addr(struct netaddr *addr, uint8_t net, uint32_t idx) {
+  uint8_t bin[4] = { 10, net, 0, idx + 1 };
+
+  netaddr_from_binary(addr, bin, sizeof(bin), AF_INET);
+}
+
+/**
+ * Set the incoming link cost of a neighbor
+ * @param idx neighbor index
+ * @param cost incoming link cost
+ */
+static void
+_set_link_cost(uint32_t idx, uint32_t cost) {
+  nhdp_domain_set_incoming_metric(&_test_metric, _links[idx], cost);
+  nhdp_domain_neighbor_changed(_links[idx]->neigh);
+}
+
+/**
+ * Add a symmetric one-hop neighbor
+ * @param idx neighbor index
+ * @param cost incoming link cost
+ */
+static void
+_add_neighbor(uint32_t idx, uint32_t cost) {
+  struct nhdp_neighbor *neigh;
+  struct nhdp_link *lnk;
+  struct netaddr addr;
+  uint8_t mac[6] = { 0x02, 0, 0, 0, 0, idx + 1 };
+
+  _make_addr(&addr, 0, idx);
+
+  neigh = nhdp_db_neighbor_add();
+  lnk = nhdp_db_link_add(neigh, _interf);
+
+  nhdp_db_neighbor_set_originator(neigh, &addr);
+  nhdp_db_neighbor_addr_add(neigh, &addr);
+  nhdp_db_link_addr_add(lnk, &addr);
+
+  memcpy(&lnk->if_addr, &addr, sizeof(addr));
+  netaddr_from_binary(&lnk->remote_mac, mac, sizeof(mac), AF_MAC48);
+  nhdp_db_link_set_symtime(lnk, 3600000);
+
+  _links[idx] = lnk;
+  _set_link_cost(idx, cost);
+}
+
+/**
+ * Remove a one-hop neighbor
+ * @param idx neighbor index
+ */
+static void
+_remove_neighbor(uint32_t idx) {
+  nhdp_db_neighbor_remove(_links[idx]->neigh);
+  _links[idx] = NULL;
+}
+
+/**
+ * Add a two-hop address to a neighbor or change its cost
+ * @param idx neighbor index
+ * @param addr two-hop address
+ * @param cost incoming two-hop cost
+ */
+static void
+_set_twohop(uint32_t idx, const struct netaddr *addr, uint32_t cost) {
+  struct nhdp_l2hop *l2hop;
+
+  l2hop = ndhp_db_link_2hop_get(_links[idx], addr);
+  if (l2hop == NULL) {
+    l2hop = nhdp_db_link_2hop_add(_links[idx], addr);
+  }
+  nhdp_domain_get_l2hopdata(_domain, l2hop)->metric.in = cost;
+}
+
+/**
+ * Remove a two-hop address of a neighbor
+ * @param idx neighbor index
+ * @param addr two-hop address
+ */
+static void
+_remove_twohop(uint32_t idx, const struct netaddr *addr) {
+  struct nhdp_l2hop *l2hop;
+
+  l2hop = ndhp_db_link_2hop_get(_links[idx], addr);
+  if (l2hop) {
+    nhdp_db_link_2hop_remove(l2hop);
+  }
+}
+
+/**
+ * @return random link cost, sometimes infinite
+ */
+static uint32_t
+_random_cost(void) {
+  if (_random() % 10 == 0) {
+    return RFC7181_METRIC_INFINITE;
+  }
+  return RFC7181_METRIC_MIN + _random() % 4096;
+}
+
+/**
+ * Random two-hop address. Some of them are the addresses of
+ * one-hop neighbors to exercise d1(y).
+ * @param addr pointer to target address
+ */
+static void
+_random_twohop(struct netaddr *addr) {
+  if (_random() % 4 == 0) {
+    _make_addr(addr, 0, _random() % MAX_N1);
+  }
+  else {
+    _make_addr(addr, 1, _random() % MAX_N2);
+  }
+}
+
+/**
+ * Update the incremental MPR set and cross-check it against
+ * the coverage of a full RFC 7181 calculation
+ * @return true if the incremental set is valid
+ */
+static bool
+_update_and_validate(void) {
+  struct neighbor_graph graph;
+  bool valid;
+
+  nhdp_domain_flush_changes();
+  mpr_incremental_update(_domain, &_state);
+
+  mpr_calculate_neighbor_graph_routing(_domain, &graph);
+  mpr_calculate_mpr_rfc7181(_domain, &graph);
+
+  valid = mpr_incremental_validate(_domain, &_state, &graph);
+
+  mpr_clear_neighbor_graph(&graph);
+  return valid;
+}
+
+/**
+ * Remove all neighbors and reset the incremental state
+ */
+static void
+_clear_neighborhood(void) {
+  uint32_t i;
+
+  for (i = 0; i < MAX_N1; i++) {
+    if (_links[i]) {
+      _remove_neighbor(i);
+    }
+  }
+  mpr_incremental_clear(&_state);
+}
+
+static void
+test_basic_changes(void) {
+  struct netaddr twohop[3];
+  uint32_t i;
+
+  START_TEST();
+
+  for (i = 0; i < ARRAYSIZE(twohop); i++) {
+    _make_addr(&twohop[i], 1, i);
+  }
+
+  /* two neighbors, only the first one reaches all two-hop addresses */
+  _add_neighbor(0, 1000);
+  _add_neighbor(1, 1000);
+  _set_twohop(0, &twohop[0], 1000);
+  _set_twohop(0, &twohop[1], 1000);
+  _set_twohop(1, &twohop[1], 1000);
+
+  CHECK_TRUE(_update_and_validate(), "initial MPR set invalid");
+  CHECK_TRUE(_state.set_n1.count == 2, "N1 has %u elements", _state.set_n1.count);
+  CHECK_TRUE(mpr_incremental_is_mpr(&_state, _links[0]->neigh),
+      "neighbor 0 is the only path to a two-hop address");
+
+  /* a better path over the second neighbor */
+  _set_twohop(1, &twohop[1], 10);
+  _set_twohop(1, &twohop[2], 1000);
+  CHECK_TRUE(_update_and_validate(), "MPR set invalid after new two-hop path");
+  CHECK_TRUE(mpr_incremental_is_mpr(&_state, _links[1]->neigh),
+      "neighbor 1 is the only path to a new two-hop address");
+
+  /* neighbor 0 loses its link metric */
+  _set_link_cost(0, RFC7181_METRIC_INFINITE);
+  CHECK_TRUE(_update_and_validate(), "MPR set invalid after infinite link metric");
+  CHECK_TRUE(!mpr_incremental_is_mpr(&_state, _links[0]->neigh),
+      "unreachable neighbor 0 is still MPR");
+
+  _set_link_cost(0, 1000);
+  CHECK_TRUE(_update_and_validate(), "MPR set invalid after link metric is back");
+
+  /* willingness always selects a neighbor without need */
+  _add_neighbor(2, 1000);
+  nhdp_domain_get_neighbordata(_domain, _links[2]->neigh)->willingness =
+      RFC7181_WILLINGNESS_ALWAYS;
+  CHECK_TRUE(_update_and_validate(), "MPR set invalid after new neighbor");
+  CHECK_TRUE(mpr_incremental_is_mpr(&_state, _links[2]->neigh),
+      "neighbor with willingness always is not MPR");
+
+  /* removal of the only path to a two-hop address */
+  _remove_twohop(0, &twohop[0]);
+  CHECK_TRUE(_update_and_validate(), "MPR set invalid after two-hop removal");
+
+  _remove_neighbor(1);
+  CHECK_TRUE(_update_and_validate(), "MPR set invalid after neighbor removal");
+  CHECK_TRUE(_state.set_n1.count == 2, "N1 has %u elements", _state.set_n1.count);
+
+  _clear_neighborhood();
+  END_TEST();
+}
+
+static void
+test_random_changes(void) {
+  struct netaddr addr;
+  uint32_t step, idx, invalid, first_invalid;
+
+  START_TEST();
+
+  _random_state = 0x4d505221;
+  invalid = 0;
+  first_invalid = 0;
+
+  for (step = 0; step < RANDOM_STEPS; step++) {
+    idx = _random() % MAX_N1;
+
+    if (_links[idx] == NULL) {
+      _add_neighbor(idx, _random_cost());
+    }
+    else {
+      switch (_random() % 8) {
+        case 0:
+          _remove_neighbor(idx);
+          break;
+        case 1:
+          nhdp_domain_get_neighbordata(_domain, _links[idx]->neigh)->willingness =
+              (_random() % 4 == 0) ? RFC7181_WILLINGNESS_ALWAYS : 1 + _random() % 14;
+          break;
+        case 2:
+          _set_link_cost(idx, _random_cost());
+          break;
+        case 3:
+        case 4:
+          _random_twohop(&addr);
+          _remove_twohop(idx, &addr);
+          break;
+        default:
+          _random_twohop(&addr);
+          _set_twohop(idx, &addr, _random_cost());
+          break;
+      }
+    }
+
+    if (!_update_and_validate()) {
+      if (invalid++ == 0) {
+        first_invalid = step;
+      }
+    }
+  }
+
+  CHECK_TRUE(invalid == 0, "%u of %u incremental MPR sets invalid, first at step %u",
+      invalid, RANDOM_STEPS, first_invalid);
+  CHECK_TRUE(_state.incremental_count >= RANDOM_STEPS,
+      "only %u incremental updates", _state.incremental_count);
+
+  _clear_neighborhood();
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *nhdp;
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  /* initialize NHDP with all of its dependencies */
+  nhdp = oonf_subsystem_get(OONF_NHDP_SUBSYSTEM);
+  if (nhdp == NULL || oonf_subsystem_call_init(nhdp)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_NHDP_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  nhdp_domain_metric_add(&_test_metric);
+  _domain = nhdp_domain_configure(0, _test_metric.name,
+      CFG_DOMAIN_NO_METRIC_MPR, RFC7181_WILLINGNESS_DEFAULT);
+  _interf = nhdp_interface_add("test0");
+  if (_domain == NULL || _interf == NULL) {
+    fprintf(stderr, "Could not create NHDP domain and interface\n");
+    return 1;
+  }
+
+  mpr_incremental_init(&_state);
+
+  BEGIN_TESTING(_clear_elements);
+
+  test_basic_changes();
+  test_random_changes();
+
+  mpr_incremental_clear(&_state);
+  nhdp_interface_remove(_interf);
+  nhdp_domain_metric_remove(&_test_metric);
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,397 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common/common_types.h"
+#include "common/avl.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "rfc5444/rfc5444.h"
+#include "rfc5444/rfc5444_iana.h"
+
+#include "nhdp/nhdp_db.h"
+#include "nhdp/nhdp_domain.h"
+
+#include "mpr/neighbor-graph.h"
+#include "mpr/selection-matrix.h"
+#include "mpr/selection-rfc7181.h"
+
+#include "cunit/cunit.h"
+
+/*! maximum number of one-hop neighbors in a test graph */
+#define MAX_N1 80
+
+/*! maximum number of two-hop addresses in a test graph */
+#define MAX_N2 240
+
+/*! number of random graphs compared */
+#define RANDOM_GRAPHS 200
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "test_mpr_selection",
+};
+
+/* synthetic neighborhood, indexed by the last bytes of the addresses */
+static uint32_t _d1_x[MAX_N1];
+static uint32_t _d2_x_y[MAX_N1][MAX_N2];
+static uint32_t _d1_y[MAX_N2];
+static uint32_t _willingness[MAX_N1];
+
+static struct nhdp_neighbor _neighbors[MAX_N1];
+static struct nhdp_domain _domain;
+
+static uint32_t _random_state;
+
+static uint32_t _calculate_d1_x_of_n2_addr(const struct nhdp_domain *,
+    struct neighbor_graph *, struct addr_node *);
+static uint32_t _calculate_d_x_y(const struct nhdp_domain *,
+    struct neighbor_graph *, struct n1_node *, struct addr_node *);
+static uint32_t _calculate_d2_x_y(const struct nhdp_domain *,
+    struct n1_node *, struct addr_node *);
+static uint32_t _get_willingness_n1(const struct nhdp_domain *, struct n1_node *);
+
+static struct neighbor_graph_interface _test_interface = {
+  .calculate_d1_x_of_n2_addr = _calculate_d1_x_of_n2_addr,
+  .calculate_d_x_y           = _calculate_d_x_y,
+  .calculate_d2_x_y          = _calculate_d2_x_y,
+  .get_willingness_n1        = _get_willingness_n1,
+};
+
+static uint32_t
+_random(void) {
+  /* xorshift32, the tests must be reproducible */
+  _random_state ^= _random_state << 13;
+  _random_state ^= _random_state >> 17;
+  _random_state ^= _random_state << 5;
+  return _random_state;
+}
+
+static void
+_make_addr(struct netaddr *addr, uint8_t net, uint32_t idx) {
+  uint8_t bin[4] = { 10, net, idx >> 8, idx & 255 };
+
+  netaddr_from_binary(addr, bin, sizeof(bin), AF_INET);
+}
+
+static uint32_t
+_get_idx(const struct netaddr *addr) {
+  const uint8_t *bin = netaddr_get_binptr(addr);
+
+  return (bin[2] << 8) | bin[3];
+}
+
+static uint32_t
+_calculate_d1_x_of_n2_addr(const struct nhdp_domain *domain __attribute__((unused)),
+    struct neighbor_graph *graph __attribute__((unused)), struct addr_node *y) {
+  return _d1_y[_get_idx(&y->addr)];
+}
+
+static uint32_t
+_calculate_d2_x_y(const struct nhdp_domain *domain __attribute__((unused)),
+    struct n1_node *x, struct addr_node *y) {
+  return _d2_x_y[_get_idx(&x->addr)][_get_idx(&y->addr)];
+}
+
+static uint32_t
+_calculate_d_x_y(const struct nhdp_domain *domain,
+    struct neighbor_graph *graph __attribute__((unused)),
+    struct n1_node *x, struct addr_node *y) {
+  uint32_t d1, d2;
+
+  d1 = _d1_x[_get_idx(&x->addr)];
+  d2 = _calculate_d2_x_y(domain, x, y);
+  if (d1 > RFC7181_METRIC_MAX || d2 > RFC7181_METRIC_MAX) {
+    return RFC7181_METRIC_INFINITE_PATH;
+  }
+  return d1 + d2;
+}
+
+static uint32_t
+_get_willingness_n1(const struct nhdp_domain *domain __attribute__((unused)),
+    struct n1_node *x) {
+  return _willingness[_get_idx(&x->addr)];
+}
+
+/**
+ * Create a neighbor graph from the synthetic neighborhood
+ * @param graph neighbor graph
+ * @param n1_count number of one-hop neighbors
+ * @param n2_count number of two-hop addresses
+ */
+static void
+_build_graph(struct neighbor_graph *graph, uint32_t n1_count, uint32_t n2_count) {
+  struct netaddr addr;
+  uint32_t i;
+
+  memset(graph, 0, sizeof(*graph));
+  mpr_init_neighbor_graph(graph, &_test_interface);
+
+  for (i = 0; i < n1_count; i++) {
+    _neighbors[i].selection_is_mpr = false;
+    mpr_add_n1_node_to_set(&graph->set_n1, &_neighbors[i], NULL, 0);
+  }
+  for (i = 0; i < n2_count; i++) {
+    _make_addr(&addr, 2, i);
+    mpr_add_addr_node_to_set(&graph->set_n2, addr, 0);
+  }
+}
+
+/**
+ * Fill the synthetic neighborhood with a random graph
+ * @param n1_count number of one-hop neighbors
+ * @param n2_count number of two-hop addresses
+ */
+static void
+_random_neighborhood(uint32_t n1_count, uint32_t n2_count) {
+  uint32_t i, j, density, metric_range;
+
+  density = 1 + _random() % 60;
+  /* a small metric range creates a lot of ties */
+  metric_range = (_random() & 1) ? 4 : 100000;
+
+  for (i = 0; i < n1_count; i++) {
+    _d1_x[i] = RFC7181_METRIC_MIN + _random() % metric_range;
+    _willingness[i] = (_random() % 20 == 0)
+        ? RFC7181_WILLINGNESS_ALWAYS : RFC7181_WILLINGNESS_DEFAULT;
+
+    for (j = 0; j < n2_count; j++) {
+      _d2_x_y[i][j] = (_random() % 100 < density)
+          ? RFC7181_METRIC_MIN + _random() % metric_range : RFC7181_METRIC_INFINITE;
+    }
+  }
+
+  for (j = 0; j < n2_count; j++) {
+    /* every two-hop address is reachable over at least one neighbor */
+    i = _random() % n1_count;
+    if (_d2_x_y[i][j] == RFC7181_METRIC_INFINITE) {
+      _d2_x_y[i][j] = RFC7181_METRIC_MIN + _random() % metric_range;
+    }
+
+    /* some two-hop addresses are also one-hop neighbors */
+    _d1_y[j] = (_random() % 10 == 0)
+        ? RFC7181_METRIC_MIN + _random() % (2 * metric_range) : RFC7181_METRIC_INFINITE;
+  }
+}
+
+/**
+ * @param set1 first tree
+ * @param set2 second tree
+ * @return true if both trees contain the same addresses
+ */
+static bool
+_same_n1_set(struct avl_tree *set1, struct avl_tree *set2) {
+  struct n1_node *node1, *node2;
+
+  if (set1->count != set2->count) {
+    return false;
+  }
+
+  node2 = avl_first_element(set2, node2, _avl_node);
+  avl_for_each_element(set1, node1, _avl_node) {
+    if (netaddr_cmp(&node1->addr, &node2->addr) != 0) {
+      return false;
+    }
+    node2 = avl_next_element(node2, _avl_node);
+  }
+  return true;
+}
+
+/**
+ * @param set1 first tree
+ * @param set2 second tree
+ * @return true if both trees contain the same addresses
+ */
+static bool
+_same_addr_set(struct avl_tree *set1, struct avl_tree *set2) {
+  struct addr_node *node1, *node2;
+
+  if (set1->count != set2->count) {
+    return false;
+  }
+
+  node2 = avl_first_element(set2, node2, _avl_node);
+  avl_for_each_element(set1, node1, _avl_node) {
+    if (netaddr_cmp(&node1->addr, &node2->addr) != 0) {
+      return false;
+    }
+    node2 = avl_next_element(node2, _avl_node);
+  }
+  return true;
+}
+
+/**
+ * Calculate the MPR sets of the current synthetic neighborhood
+ * with both implementations and compare them
+ * @param n1_count number of one-hop neighbors
+ * @param n2_count number of two-hop addresses
+ * @param graph_rfc7181 graph for list based implementation
+ * @param graph_matrix graph for matrix based implementation
+ */
+static void
+_calculate_both(uint32_t n1_count, uint32_t n2_count,
+    struct neighbor_graph *graph_rfc7181, struct neighbor_graph *graph_matrix) {
+  _build_graph(graph_rfc7181, n1_count, n2_count);
+  mpr_calculate_mpr_rfc7181(&_domain, graph_rfc7181);
+
+  _build_graph(graph_matrix, n1_count, n2_count);
+  mpr_calculate_mpr_matrix(&_domain, graph_matrix);
+}
+
+static void
+_clear_elements(void) {
+  memset(_d1_x, 0, sizeof(_d1_x));
+  memset(_d2_x_y, 0, sizeof(_d2_x_y));
+  memset(_d1_y, 0, sizeof(_d1_y));
+  memset(_willingness, 0, sizeof(_willingness));
+}
+
+static void
+test_known_graph(void) {
+  struct neighbor_graph graph_rfc7181, graph_matrix;
+  struct netaddr addr;
+  uint32_t i, j;
+
+  /*
+   * x0 covers y0, y1, y2, x1 covers y2, y3 and x2 covers y3.
+   * x0 is the only neighbor for y0, x1 and x2 tie for y3.
+   */
+  static const bool covers[3][4] = {
+    { true, true, true, false },
+    { false, false, true, true },
+    { false, false, false, true },
+  };
+
+  START_TEST();
+
+  for (i = 0; i < 3; i++) {
+    _d1_x[i] = 100;
+    _willingness[i] = RFC7181_WILLINGNESS_DEFAULT;
+    for (j = 0; j < 4; j++) {
+      _d2_x_y[i][j] = covers[i][j] ? 100 : RFC7181_METRIC_INFINITE;
+    }
+  }
+  for (j = 0; j < 4; j++) {
+    _d1_y[j] = RFC7181_METRIC_INFINITE;
+  }
+
+  _calculate_both(3, 4, &graph_rfc7181, &graph_matrix);
+
+  CHECK_TRUE(graph_matrix.set_n.count == 4, "N has %u elements", graph_matrix.set_n.count);
+  CHECK_TRUE(graph_matrix.set_mpr.count == 2, "M has %u elements", graph_matrix.set_mpr.count);
+
+  _make_addr(&addr, 1, 0);
+  CHECK_TRUE(mpr_is_mpr(&graph_matrix, &addr), "x0 is not an MPR");
+  _make_addr(&addr, 1, 1);
+  CHECK_TRUE(mpr_is_mpr(&graph_matrix, &addr), "x1 is not an MPR");
+
+  CHECK_TRUE(_same_n1_set(&graph_rfc7181.set_mpr, &graph_matrix.set_mpr),
+      "MPR sets differ");
+
+  mpr_clear_neighbor_graph(&graph_rfc7181);
+  mpr_clear_neighbor_graph(&graph_matrix);
+
+  END_TEST();
+}
+
+static void
+test_random_graphs(void) {
+  struct neighbor_graph graph_rfc7181, graph_matrix;
+  uint32_t i, n1_count, n2_count, failed_n, failed_mpr;
+
+  START_TEST();
+
+  _random_state = 0x12345678;
+  failed_n = 0;
+  failed_mpr = 0;
+
+  for (i = 0; i < RANDOM_GRAPHS; i++) {
+    n1_count = 1 + _random() % MAX_N1;
+    n2_count = 1 + _random() % MAX_N2;
+
+    _random_neighborhood(n1_count, n2_count);
+    _calculate_both(n1_count, n2_count, &graph_rfc7181, &graph_matrix);
+
+    if (!_same_addr_set(&graph_rfc7181.set_n, &graph_matrix.set_n)) {
+      failed_n++;
+    }
+    if (!_same_n1_set(&graph_rfc7181.set_mpr, &graph_matrix.set_mpr)) {
+      failed_mpr++;
+    }
+
+    mpr_clear_neighbor_graph(&graph_rfc7181);
+    mpr_clear_neighbor_graph(&graph_matrix);
+  }
+
+  CHECK_TRUE(failed_n == 0, "N differs in %u of %u graphs", failed_n, RANDOM_GRAPHS);
+  CHECK_TRUE(failed_mpr == 0, "MPR set differs in %u of %u graphs",
+      failed_mpr, RANDOM_GRAPHS);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  uint32_t i;
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN)) {
+    return 1;
+  }
+
+  for (i = 0; i < MAX_N1; i++) {
+    _make_addr(&_neighbors[i].originator, 1, i);
+  }
+
+  BEGIN_TESTING(_clear_elements);
+
+  test_known_graph();
+  test_random_graphs();
+
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,345 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/common_types.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_timer.h"
+#include "cunit/cunit.h"
+
+#include "nhdp/nhdp.h"
+#include "nhdp/nhdp_db.h"
+#include "nhdp/nhdp_domain.h"
+#include "nhdp/nhdp_interfaces.h"
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "test_nhdp_metric_filter",
+};
+
+static void _cb_calculate_batch(uint32_t *costs, const void *samples, size_t count);
+
+static struct nhdp_domain_metric _test_metric = {
+  .name = "test_metric",
+
+  .batch_sample_size = sizeof(uint32_t),
+  .calculate_batch = _cb_calculate_batch,
+};
+
+static struct nhdp_domain *_domain;
+static struct nhdp_interface *_interf;
+static struct nhdp_link *_lnk;
+
+static void
+_clear_elements(void) {
+}
+
+static void
+_cb_calculate_batch(uint32_t *costs, const void *samples, size_t count) {
+  const uint32_t *values = samples;
+  size_t i;
+
+  /* the test samples are the doubled link cost */
+  for (i = 0; i < count; i++) {
+    costs[i] = values[i] / 2;
+  }
+}
+
+/**
+ * Create a new link and apply a metric filter
+ * @param relative relative threshold in 1/1000
+ * @param absolute absolute threshold
+ * @param hold_down hold-down time in milliseconds
+ */
+static void
+_setup_link(int32_t relative, int32_t absolute, uint64_t hold_down) {
+  struct nhdp_domain_metric_filter filter;
+
+  memset(&filter, 0, sizeof(filter));
+  filter.threshold_relative = relative;
+  filter.threshold_absolute = absolute;
+  filter.hold_down = hold_down;
+  nhdp_domain_set_metric_filter(_domain, &filter);
+
+  _lnk = nhdp_db_link_add(nhdp_db_neighbor_add(), _interf);
+
+  _domain->metric_updates = 0;
+  _domain->metric_changes = 0;
+  _domain->metric_suppressed = 0;
+  _domain->metric_deferred = 0;
+}
+
+static void
+_remove_link(void) {
+  nhdp_db_neighbor_remove(_lnk->neigh);
+  _lnk = NULL;
+}
+
+static uint32_t
+_get_metric_in(void) {
+  return nhdp_domain_get_linkdata(_domain, _lnk)->metric.in;
+}
+
+static void
+test_no_filter(void) {
+  START_TEST();
+
+  _setup_link(0, 0, 0);
+
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 1000),
+      "first metric not applied");
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 1001),
+      "small change not applied");
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 1001),
+      "same metric reported as change");
+  CHECK_TRUE(_get_metric_in() == 1001, "metric is %u", _get_metric_in());
+
+  CHECK_TRUE(_domain->metric_updates == 3, "%"PRIu64" updates", _domain->metric_updates);
+  CHECK_TRUE(_domain->metric_changes == 2, "%"PRIu64" changes", _domain->metric_changes);
+  CHECK_TRUE(_domain->metric_suppressed == 0, "%"PRIu64" suppressed", _domain->metric_suppressed);
+
+  _remove_link();
+  END_TEST();
+}
+
+static void
+test_thresholds(void) {
+  START_TEST();
+
+  /* 10 percent, but at least 50 */
+  _setup_link(100, 50, 0);
+
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 1000),
+      "first metric not applied");
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 1099),
+      "change below relative threshold applied");
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 901),
+      "change below relative threshold applied");
+  CHECK_TRUE(_get_metric_in() == 1000, "metric is %u", _get_metric_in());
+
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 1100),
+      "change at relative threshold not applied");
+  CHECK_TRUE(_get_metric_in() == 1100, "metric is %u", _get_metric_in());
+
+  /* absolute threshold is larger than relative one for small metrics */
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 200),
+      "large change not applied");
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 240),
+      "change below absolute threshold applied");
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 250),
+      "change at absolute threshold not applied");
+
+  /* losing the link must never be filtered */
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, RFC7181_METRIC_INFINITE),
+      "infinite metric not applied");
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 251),
+      "metric after infinite not applied");
+
+  CHECK_TRUE(_domain->metric_changes == 6, "%"PRIu64" changes", _domain->metric_changes);
+  CHECK_TRUE(_domain->metric_suppressed == 3, "%"PRIu64" suppressed", _domain->metric_suppressed);
+
+  _remove_link();
+  END_TEST();
+}
+
+static void
+test_hold_down(void) {
+  struct nhdp_link_domaindata *linkdata;
+  int i;
+
+  START_TEST();
+
+  _setup_link(0, 0, 200);
+  linkdata = nhdp_domain_get_linkdata(_domain, _lnk);
+
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 1000),
+      "first metric not applied");
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 2000),
+      "change during hold-down applied");
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 3000),
+      "change during hold-down applied");
+  CHECK_TRUE(_get_metric_in() == 1000, "metric is %u", _get_metric_in());
+  CHECK_TRUE(linkdata->metric_pending && linkdata->pending_metric_in == 3000,
+      "pending metric is %u", linkdata->pending_metric_in);
+  CHECK_TRUE(_domain->metric_deferred == 2, "%"PRIu64" deferred", _domain->metric_deferred);
+
+  /* wait for the hold-down timer */
+  for (i = 0; i < 10 && linkdata->metric_pending; i++) {
+    usleep(100000);
+    if (oonf_clock_update()) {
+      break;
+    }
+    oonf_timer_walk();
+  }
+
+  CHECK_TRUE(!linkdata->metric_pending, "metric still pending");
+  CHECK_TRUE(_get_metric_in() == 3000, "metric is %u", _get_metric_in());
+  CHECK_TRUE(_domain->metric_changes == 2, "%"PRIu64" changes", _domain->metric_changes);
+
+  /* going back to the old value cancels a pending change */
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 2000),
+      "change during hold-down applied");
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 3000),
+      "same metric reported as change");
+  CHECK_TRUE(!linkdata->metric_pending, "metric still pending");
+
+  /* losing the link ignores the hold-down time */
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, RFC7181_METRIC_INFINITE),
+      "infinite metric not applied");
+
+  _remove_link();
+  END_TEST();
+}
+
+static void
+test_hold_down_first_metric(void) {
+  struct nhdp_link_domaindata *linkdata;
+
+  START_TEST();
+
+  _setup_link(0, 0, 200);
+  linkdata = nhdp_domain_get_linkdata(_domain, _lnk);
+
+  /* link starts with a finite default metric */
+  linkdata->metric.in = RFC7181_METRIC_MAX;
+
+  CHECK_TRUE(nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 1000),
+      "first metric held down");
+  CHECK_TRUE(_get_metric_in() == 1000, "metric is %u", _get_metric_in());
+  CHECK_TRUE(!nhdp_domain_set_incoming_metric(&_test_metric, _lnk, 3000),
+      "change during hold-down applied");
+  CHECK_TRUE(linkdata->metric_pending, "second metric not pending");
+
+  _remove_link();
+  END_TEST();
+}
+
+static void
+test_batch(void) {
+  struct nhdp_link *links[NHDP_DOMAIN_METRIC_BATCH_SIZE * 2 + 3];
+  uint32_t samples[ARRAYSIZE(links)];
+  size_t i, changed, wrong;
+
+  START_TEST();
+
+  _setup_link(0, 0, 0);
+  _remove_link();
+
+  for (i = 0; i < ARRAYSIZE(links); i++) {
+    links[i] = nhdp_db_link_add(nhdp_db_neighbor_add(), _interf);
+    samples[i] = 2000 + 2 * i;
+  }
+
+  changed = nhdp_domain_calculate_incoming_metrics(
+      &_test_metric, links, samples, ARRAYSIZE(links));
+  CHECK_TRUE(changed == ARRAYSIZE(links), "%"PRINTF_SIZE_T_SPECIFIER" links changed", changed);
+
+  wrong = 0;
+  for (i = 0; i < ARRAYSIZE(links); i++) {
+    if (nhdp_domain_get_linkdata(_domain, links[i])->metric.in != 1000 + i) {
+      wrong++;
+    }
+  }
+  CHECK_TRUE(wrong == 0, "%"PRINTF_SIZE_T_SPECIFIER" links have a wrong metric", wrong);
+
+  /* only the link with a different sample changes */
+  samples[NHDP_DOMAIN_METRIC_BATCH_SIZE + 1] += 10;
+  changed = nhdp_domain_calculate_incoming_metrics(
+      &_test_metric, links, samples, ARRAYSIZE(links));
+  CHECK_TRUE(changed == 1, "%"PRINTF_SIZE_T_SPECIFIER" links changed", changed);
+  CHECK_TRUE(_domain->metric_updates == 2 * ARRAYSIZE(links),
+      "%"PRIu64" updates", _domain->metric_updates);
+
+  for (i = 0; i < ARRAYSIZE(links); i++) {
+    nhdp_db_neighbor_remove(links[i]->neigh);
+  }
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *nhdp;
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  /* initialize NHDP with all of its dependencies */
+  nhdp = oonf_subsystem_get(OONF_NHDP_SUBSYSTEM);
+  if (nhdp == NULL || oonf_subsystem_call_init(nhdp)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_NHDP_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  nhdp_domain_metric_add(&_test_metric);
+  _domain = nhdp_domain_configure(0, _test_metric.name,
+      CFG_DOMAIN_NO_METRIC_MPR, RFC7181_WILLINGNESS_DEFAULT);
+  _interf = nhdp_interface_add("test0");
+  if (_domain == NULL || _interf == NULL) {
+    fprintf(stderr, "Could not create NHDP domain and interface\n");
+    return 1;
+  }
+
+  BEGIN_TESTING(_clear_elements);
+
+  test_no_filter();
+  test_thresholds();
+  test_hold_down();
+  test_hold_down_first_metric();
+  test_batch();
+
+  nhdp_interface_remove(_interf);
+  nhdp_domain_metric_remove(&_test_metric);
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
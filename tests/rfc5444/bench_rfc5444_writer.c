@@ -0,0 +1,492 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "rfc5444/rfc5444_writer.h"
+#include "cunit/cunit.h"
+
+/*! number of addresses in each generated message */
+#define ADDRESS_COUNT 1000
+
+/*! default number of generated messages per measurement */
+#define DEFAULT_ITERATIONS 100
+
+static void _cb_add_tc_addresses(struct rfc5444_writer *wr);
+static void _cb_add_hello_addresses(struct rfc5444_writer *wr);
+static int _cb_add_msg_header(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg);
+static void _cb_send_packet(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, void *, size_t);
+static enum rfc5444_result _cb_addr_block(struct rfc5444_reader_tlvblock_context *cont);
+static struct rfc5444_writer_address *_cb_malloc_address(void);
+static struct rfc5444_writer_addrtlv *_cb_malloc_addrtlv(void);
+static void _cb_free_address(struct rfc5444_writer_address *);
+static void _cb_free_addrtlv(struct rfc5444_writer_addrtlv *);
+
+static uint8_t _msg_buffer[RFC5444_MAX_MESSAGE_SIZE];
+static uint8_t _msg_addrtlvs[65536];
+
+static struct rfc5444_writer _writer = {
+  .msg_buffer = _msg_buffer,
+  .msg_size = sizeof(_msg_buffer),
+  .addrtlv_buffer = _msg_addrtlvs,
+  .addrtlv_size = sizeof(_msg_addrtlvs),
+
+  .malloc_address_entry = _cb_malloc_address,
+  .malloc_addrtlv_entry = _cb_malloc_addrtlv,
+  .free_address_entry = _cb_free_address,
+  .free_addrtlv_entry = _cb_free_addrtlv,
+};
+
+static uint8_t _packet_buffer[RFC5444_MAX_PACKET_SIZE];
+static struct rfc5444_writer_target _target = {
+  .packet_buffer = _packet_buffer,
+  .packet_size = sizeof(_packet_buffer),
+  .sendPacket = _cb_send_packet,
+};
+
+static struct rfc5444_writer_content_provider _tc_provider = {
+  .msg_type = RFC7181_MSGTYPE_TC,
+  .addAddresses = _cb_add_tc_addresses,
+};
+
+static struct rfc5444_writer_tlvtype _tc_addrtlvs[] = {
+  { .type = RFC7181_ADDRTLV_NBR_ADDR_TYPE },
+  { .type = RFC7181_ADDRTLV_LINK_METRIC },
+  { .type = RFC7181_ADDRTLV_GATEWAY },
+};
+
+static struct rfc5444_writer_content_provider _hello_provider = {
+  .msg_type = RFC6130_MSGTYPE_HELLO,
+  .addAddresses = _cb_add_hello_addresses,
+};
+
+static struct rfc5444_writer_tlvtype _hello_addrtlvs[] = {
+  { .type = RFC6130_ADDRTLV_LINK_STATUS },
+  { .type = RFC7181_ADDRTLV_LINK_METRIC },
+};
+
+/* reader to verify the generated messages */
+static struct rfc5444_reader _reader;
+
+static struct rfc5444_reader_tlvblock_consumer_entry _tc_entries[] = {
+  { .type = RFC7181_ADDRTLV_LINK_METRIC, .mandatory = true },
+};
+
+static struct rfc5444_reader_tlvblock_consumer_entry _hello_entries[] = {
+  { .type = RFC7181_ADDRTLV_LINK_METRIC, .mandatory = true },
+};
+
+static struct rfc5444_reader_tlvblock_consumer _tc_consumer = {
+  .msg_id = RFC7181_MSGTYPE_TC,
+  .addrblock_consumer = true,
+  .block_callback = _cb_addr_block,
+};
+
+static struct rfc5444_reader_tlvblock_consumer _hello_consumer = {
+  .msg_id = RFC6130_MSGTYPE_HELLO,
+  .addrblock_consumer = true,
+  .block_callback = _cb_addr_block,
+};
+
+/* generated addresses and their metrics */
+static struct netaddr _tc_addr[ADDRESS_COUNT];
+static struct netaddr _hello_addr[ADDRESS_COUNT];
+static uint16_t _metric[ADDRESS_COUNT];
+
+/* state of the current measurement */
+static struct netaddr *_current_addr;
+static bool _verify;
+static int _seen[ADDRESS_COUNT];
+static int _bad_metric;
+static size_t _packet_count, _packet_bytes;
+
+/* number of address/addrtlv objects allocated and freed by the writer */
+static size_t _addr_allocs, _addr_frees, _addrtlv_allocs, _addrtlv_frees;
+
+static void
+_clear_elements(void) {
+  memset(_seen, 0, sizeof(_seen));
+  _bad_metric = 0;
+  _packet_count = 0;
+  _packet_bytes = 0;
+}
+
+static struct rfc5444_writer_address *
+_cb_malloc_address(void) {
+  _addr_allocs++;
+  return calloc(1, sizeof(struct rfc5444_writer_address));
+}
+
+static struct rfc5444_writer_addrtlv *
+_cb_malloc_addrtlv(void) {
+  _addrtlv_allocs++;
+  return calloc(1, sizeof(struct rfc5444_writer_addrtlv));
+}
+
+static void
+_cb_free_address(struct rfc5444_writer_address *addr) {
+  _addr_frees++;
+  free(addr);
+}
+
+static void
+_cb_free_addrtlv(struct rfc5444_writer_addrtlv *addrtlv) {
+  _addrtlv_frees++;
+  free(addrtlv);
+}
+
+/**
+ * Generate address sets with a mixture of common prefixes,
+ * inserted in a pseudo random order.
+ */
+static void
+_generate_addresses(void) {
+  uint32_t rnd, i, j;
+
+  rnd = 0x12345678;
+  for (i = 0; i < ADDRESS_COUNT; i++) {
+    rnd = rnd * 1103515245 + 12345;
+    j = (rnd >> 8);
+
+    /* metrics are the same for groups of addresses */
+    _metric[i] = 0x1000 + (j & 0x3);
+
+    if (i % 10 == 9) {
+      /* attached networks */
+      _tc_addr[i]._type = AF_INET;
+      _tc_addr[i]._prefix_len = 24;
+      _tc_addr[i]._addr[0] = 192;
+      _tc_addr[i]._addr[1] = 168;
+      _tc_addr[i]._addr[2] = i / 10;
+    }
+    else {
+      /* routable addresses of 20 different /16 networks */
+      _tc_addr[i]._type = AF_INET;
+      _tc_addr[i]._prefix_len = 32;
+      _tc_addr[i]._addr[0] = 10;
+      _tc_addr[i]._addr[1] = j % 20;
+      _tc_addr[i]._addr[2] = i >> 8;
+      _tc_addr[i]._addr[3] = i & 255;
+    }
+
+    /* link-local and 8 global IPv6 prefixes */
+    _hello_addr[i]._type = AF_INET6;
+    _hello_addr[i]._prefix_len = 128;
+    if (j % 9 == 0) {
+      _hello_addr[i]._addr[0] = 0xfe;
+      _hello_addr[i]._addr[1] = 0x80;
+    }
+    else {
+      _hello_addr[i]._addr[0] = 0xfd;
+      _hello_addr[i]._addr[1] = 0x00;
+      _hello_addr[i]._addr[7] = j % 9;
+    }
+    _hello_addr[i]._addr[8] = 0x02;
+    _hello_addr[i]._addr[13] = (j >> 16) & 255;
+    _hello_addr[i]._addr[14] = i >> 8;
+    _hello_addr[i]._addr[15] = i & 255;
+  }
+}
+
+static int
+_cb_add_msg_header(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  rfc5444_writer_set_msg_header(wr, msg, false, false, false, false);
+  return RFC5444_OKAY;
+}
+
+static void
+_cb_add_tc_addresses(struct rfc5444_writer *wr) {
+  struct rfc5444_writer_address *addr;
+  uint8_t value;
+  int i;
+
+  for (i = 0; i < ADDRESS_COUNT; i++) {
+    addr = rfc5444_writer_add_address(wr, _tc_provider.creator, &_tc_addr[i], false);
+    if (addr == NULL) {
+      continue;
+    }
+
+    if (netaddr_get_prefix_length(&_tc_addr[i]) == 32) {
+      value = RFC7181_NBR_ADDR_TYPE_ROUTABLE;
+      rfc5444_writer_add_addrtlv(wr, addr, &_tc_addrtlvs[0], &value, sizeof(value), false);
+    }
+    else {
+      value = 1;
+      rfc5444_writer_add_addrtlv(wr, addr, &_tc_addrtlvs[2], &value, sizeof(value), false);
+    }
+    rfc5444_writer_add_addrtlv(wr, addr, &_tc_addrtlvs[1], &_metric[i], sizeof(_metric[i]), false);
+  }
+}
+
+static void
+_cb_add_hello_addresses(struct rfc5444_writer *wr) {
+  struct rfc5444_writer_address *addr;
+  uint8_t value;
+  int i;
+
+  for (i = 0; i < ADDRESS_COUNT; i++) {
+    addr = rfc5444_writer_add_address(wr, _hello_provider.creator, &_hello_addr[i], false);
+    if (addr == NULL) {
+      continue;
+    }
+
+    value = RFC6130_LINKSTATUS_SYMMETRIC;
+    rfc5444_writer_add_addrtlv(wr, addr, &_hello_addrtlvs[0], &value, sizeof(value), false);
+    rfc5444_writer_add_addrtlv(wr, addr, &_hello_addrtlvs[1], &_metric[i], sizeof(_metric[i]), false);
+  }
+}
+
+static void
+_cb_send_packet(struct rfc5444_writer *wr __attribute__ ((unused)),
+    struct rfc5444_writer_target *target __attribute__ ((unused)),
+    void *ptr, size_t len) {
+  _packet_count++;
+  _packet_bytes += len;
+
+  if (_verify) {
+    rfc5444_reader_handle_packet(&_reader, ptr, len);
+  }
+}
+
+static enum rfc5444_result
+_cb_addr_block(struct rfc5444_reader_tlvblock_context *cont) {
+  uint16_t metric;
+  int i;
+
+  for (i = 0; i < ADDRESS_COUNT; i++) {
+    if (netaddr_cmp(&_current_addr[i], &cont->addr) == 0) {
+      break;
+    }
+  }
+  if (i == ADDRESS_COUNT) {
+    return RFC5444_OKAY;
+  }
+
+  _seen[i]++;
+
+  if (cont->msg_type == RFC7181_MSGTYPE_TC) {
+    memcpy(&metric, _tc_entries[0].tlv->single_value, sizeof(metric));
+  }
+  else {
+    memcpy(&metric, _hello_entries[0].tlv->single_value, sizeof(metric));
+  }
+  if (metric != _metric[i]) {
+    _bad_metric++;
+  }
+  return RFC5444_OKAY;
+}
+
+/**
+ * @return monotonic time in microseconds
+ */
+static uint64_t
+_get_time(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/**
+ * Generate a message, check its content and measure
+ * the time for generating it.
+ * @param name name of test
+ * @param msg_type message type
+ * @param addrs array of generated addresses
+ * @param sorted true to use sorted address compression
+ * @param iterations number of generated messages for measurement
+ */
+static void
+_run_bench(const char *name, uint8_t msg_type, struct netaddr *addrs,
+    bool sorted, int iterations) {
+  size_t addr_allocs, addrtlv_allocs;
+  size_t bytes, packets;
+  uint64_t start, end;
+  int i, missing, duplicate;
+
+  cunit_start_test(name);
+
+  _writer.sorted_addr_compression = sorted;
+  _current_addr = addrs;
+
+  /* check that every address is transmitted exactly once */
+  _verify = true;
+  CHECK_TRUE(rfc5444_writer_create_message_alltarget(&_writer, msg_type, addrs[0]._type == AF_INET ? 4 : 16) == RFC5444_OKAY,
+      "Could not create message");
+  rfc5444_writer_flush(&_writer, &_target, false);
+  _verify = false;
+
+  missing = 0;
+  duplicate = 0;
+  for (i = 0; i < ADDRESS_COUNT; i++) {
+    if (_seen[i] == 0) {
+      missing++;
+    }
+    else if (_seen[i] > 1) {
+      duplicate++;
+    }
+  }
+  CHECK_TRUE(missing == 0, "%d addresses missing", missing);
+  CHECK_TRUE(duplicate == 0, "%d addresses duplicated", duplicate);
+  CHECK_TRUE(_bad_metric == 0, "%d addresses with bad metric", _bad_metric);
+
+  bytes = _packet_bytes;
+  packets = _packet_count;
+
+  /* the verification run already allocated all objects the message needs */
+  addr_allocs = _addr_allocs;
+  addrtlv_allocs = _addrtlv_allocs;
+
+  start = _get_time();
+  for (i = 0; i < iterations; i++) {
+    rfc5444_writer_create_message_alltarget(&_writer, msg_type, addrs[0]._type == AF_INET ? 4 : 16);
+    rfc5444_writer_flush(&_writer, &_target, false);
+  }
+  end = _get_time();
+
+  CHECK_TRUE(_addr_allocs == addr_allocs,
+      "%zu address allocations in steady state", _addr_allocs - addr_allocs);
+  CHECK_TRUE(_addrtlv_allocs == addrtlv_allocs,
+      "%zu address tlv allocations in steady state", _addrtlv_allocs - addrtlv_allocs);
+
+  printf("\t%s compression: %zu bytes in %zu packets, %.1f us per message\n",
+      sorted ? "sorted" : "exhaustive", bytes, packets,
+      iterations > 0 ? (double)(end - start) / iterations : 0.0);
+
+  cunit_end_test(name);
+}
+
+/**
+ * Check that the writer does not keep more recycled objects
+ * than configured after a large message.
+ */
+static void
+test_free_limit(void) {
+  struct rfc5444_writer_allocator_stats stats;
+  size_t max_addresses, max_addrtlvs;
+
+  START_TEST();
+
+  max_addresses = _writer.max_free_addresses;
+  max_addrtlvs = _writer.max_free_addrtlvs;
+  _writer.max_free_addresses = 10;
+  _writer.max_free_addrtlvs = 20;
+  _writer.sorted_addr_compression = true;
+  _current_addr = _tc_addr;
+
+  CHECK_TRUE(rfc5444_writer_create_message_alltarget(&_writer, RFC7181_MSGTYPE_TC, 4) == RFC5444_OKAY,
+      "Could not create message");
+  rfc5444_writer_flush(&_writer, &_target, false);
+
+  CHECK_TRUE(_addr_allocs - _addr_frees == 10,
+      "%zu address objects kept", _addr_allocs - _addr_frees);
+  CHECK_TRUE(_addrtlv_allocs - _addrtlv_frees == 20,
+      "%zu address tlv objects kept", _addrtlv_allocs - _addrtlv_frees);
+
+  rfc5444_writer_get_allocator_stats(&_writer, &stats);
+  CHECK_TRUE(stats.addr_free == 10 && stats.addr_in_use == 0,
+      "%zu address objects free, %zu in use", stats.addr_free, stats.addr_in_use);
+  CHECK_TRUE(stats.addrtlv_free == 20 && stats.addrtlv_in_use == 0,
+      "%zu address tlv objects free, %zu in use", stats.addrtlv_free, stats.addrtlv_in_use);
+
+  _writer.max_free_addresses = max_addresses;
+  _writer.max_free_addrtlvs = max_addrtlvs;
+
+  END_TEST();
+}
+
+int
+main(int argc, char **argv) {
+  struct rfc5444_writer_message *msg;
+  int iterations;
+
+  iterations = DEFAULT_ITERATIONS;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  _generate_addresses();
+
+  rfc5444_reader_init(&_reader);
+  rfc5444_reader_add_message_consumer(&_reader, &_tc_consumer,
+      _tc_entries, ARRAYSIZE(_tc_entries));
+  rfc5444_reader_add_message_consumer(&_reader, &_hello_consumer,
+      _hello_entries, ARRAYSIZE(_hello_entries));
+
+  rfc5444_writer_init(&_writer);
+  rfc5444_writer_register_target(&_writer, &_target);
+
+  msg = rfc5444_writer_register_message(&_writer, RFC7181_MSGTYPE_TC, false);
+  msg->addMessageHeader = _cb_add_msg_header;
+  rfc5444_writer_register_msgcontentprovider(&_writer,
+      &_tc_provider, _tc_addrtlvs, ARRAYSIZE(_tc_addrtlvs));
+
+  msg = rfc5444_writer_register_message(&_writer, RFC6130_MSGTYPE_HELLO, false);
+  msg->addMessageHeader = _cb_add_msg_header;
+  rfc5444_writer_register_msgcontentprovider(&_writer,
+      &_hello_provider, _hello_addrtlvs, ARRAYSIZE(_hello_addrtlvs));
+
+  BEGIN_TESTING(_clear_elements);
+
+  _run_bench("bench_tc_exhaustive", RFC7181_MSGTYPE_TC, _tc_addr, false, iterations);
+  _run_bench("bench_tc_sorted", RFC7181_MSGTYPE_TC, _tc_addr, true, iterations);
+  _run_bench("bench_hello_exhaustive", RFC6130_MSGTYPE_HELLO, _hello_addr, false, iterations);
+  _run_bench("bench_hello_sorted", RFC6130_MSGTYPE_HELLO, _hello_addr, true, iterations);
+
+  test_free_limit();
+
+  rfc5444_writer_cleanup(&_writer);
+  rfc5444_reader_cleanup(&_reader);
+
+  return FINISH_TESTING();
+}
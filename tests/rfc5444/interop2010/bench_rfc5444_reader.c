@@ -0,0 +1,621 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "common/avl.h"
+#include "common/avl_comp.h"
+#include "common/netaddr.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "rfc5444/rfc5444_writer.h"
+#include "test_rfc5444_interop.h"
+
+#include "cunit/cunit.h"
+
+/*! default number of parsed corpus rounds per measurement */
+#define DEFAULT_ITERATIONS 1000
+
+/*! maximum number of packets in the corpus */
+#define MAX_CORPUS_SIZE 512
+
+/*! packet size of the synthetic TC packets */
+#define SYNTHETIC_PACKET_SIZE 1500
+
+/**
+ * A single packet of the benchmark corpus
+ */
+struct _corpus_packet {
+  /*! binary packet */
+  uint8_t *data;
+
+  /*! length of packet in bytes */
+  size_t length;
+};
+
+static enum rfc5444_result _cb_msg_start(struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_addr_start(struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_hello_msg(struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_hello_addr(struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_tc_msg(struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_tc_addr(struct rfc5444_reader_tlvblock_context *context);
+static struct rfc5444_reader_tlvblock_entry *_cb_malloc_tlvblock_entry(void);
+static struct rfc5444_reader_addrblock_entry *_cb_malloc_addrblock_entry(void);
+
+static int _cb_add_msg_header(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg);
+static void _cb_add_tc_msgtlvs(struct rfc5444_writer *wr);
+static void _cb_add_tc_addresses(struct rfc5444_writer *wr);
+static void _cb_send_packet(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, void *, size_t);
+
+/* reader with consumers similar to the NHDP and OLSRv2 ones */
+static struct rfc5444_reader _reader = {
+  .malloc_tlvblock_entry = _cb_malloc_tlvblock_entry,
+  .malloc_addrblock_entry = _cb_malloc_addrblock_entry,
+};
+
+static struct rfc5444_reader_tlvblock_consumer _msg_consumer = {
+  .default_msg_consumer = true,
+  .start_callback = _cb_msg_start,
+};
+static struct rfc5444_reader_tlvblock_consumer _addr_consumer = {
+  .default_msg_consumer = true,
+  .addrblock_consumer = true,
+  .start_callback = _cb_addr_start,
+};
+
+static struct rfc5444_reader_tlvblock_consumer_entry _hello_msg_entries[] = {
+  { .type = RFC5497_MSGTLV_INTERVAL_TIME, .min_length = 1 },
+  { .type = RFC5497_MSGTLV_VALIDITY_TIME, .min_length = 1 },
+};
+static struct rfc5444_reader_tlvblock_consumer_entry _hello_addr_entries[] = {
+  { .type = RFC6130_ADDRTLV_LOCAL_IF, .min_length = 1 },
+  { .type = RFC6130_ADDRTLV_LINK_STATUS, .min_length = 1 },
+  { .type = RFC6130_ADDRTLV_OTHER_NEIGHB, .min_length = 1 },
+  { .type = RFC7181_ADDRTLV_LINK_METRIC, .min_length = 2 },
+};
+static struct rfc5444_reader_tlvblock_consumer _hello_msg_consumer = {
+  .msg_id = RFC6130_MSGTYPE_HELLO,
+  .block_callback = _cb_hello_msg,
+};
+static struct rfc5444_reader_tlvblock_consumer _hello_addr_consumer = {
+  .msg_id = RFC6130_MSGTYPE_HELLO,
+  .addrblock_consumer = true,
+  .block_callback = _cb_hello_addr,
+};
+
+static struct rfc5444_reader_tlvblock_consumer_entry _tc_msg_entries[] = {
+  { .type = RFC5497_MSGTLV_VALIDITY_TIME, .min_length = 1 },
+  { .type = RFC7181_MSGTLV_CONT_SEQ_NUM, .min_length = 2 },
+};
+static struct rfc5444_reader_tlvblock_consumer_entry _tc_addr_entries[] = {
+  { .type = RFC7181_ADDRTLV_LINK_METRIC, .min_length = 2 },
+  { .type = RFC7181_ADDRTLV_NBR_ADDR_TYPE, .min_length = 1 },
+  { .type = RFC7181_ADDRTLV_GATEWAY, .min_length = 1 },
+};
+static struct rfc5444_reader_tlvblock_consumer _tc_msg_consumer = {
+  .msg_id = RFC7181_MSGTYPE_TC,
+  .block_callback = _cb_tc_msg,
+};
+static struct rfc5444_reader_tlvblock_consumer _tc_addr_consumer = {
+  .msg_id = RFC7181_MSGTYPE_TC,
+  .addrblock_consumer = true,
+  .block_callback = _cb_tc_addr,
+};
+
+/* writer for the synthetic TCs */
+static uint8_t _msg_buffer[RFC5444_MAX_MESSAGE_SIZE];
+static uint8_t _msg_addrtlvs[65536];
+
+static struct rfc5444_writer _writer = {
+  .msg_buffer = _msg_buffer,
+  .msg_size = sizeof(_msg_buffer),
+  .addrtlv_buffer = _msg_addrtlvs,
+  .addrtlv_size = sizeof(_msg_addrtlvs),
+};
+
+static uint8_t _packet_buffer[SYNTHETIC_PACKET_SIZE];
+static struct rfc5444_writer_target _target = {
+  .packet_buffer = _packet_buffer,
+  .packet_size = sizeof(_packet_buffer),
+  .sendPacket = _cb_send_packet,
+};
+
+static struct rfc5444_writer_content_provider _tc_provider = {
+  .msg_type = RFC7181_MSGTYPE_TC,
+  .addMessageTLVs = _cb_add_tc_msgtlvs,
+  .addAddresses = _cb_add_tc_addresses,
+};
+
+static struct rfc5444_writer_tlvtype _tc_addrtlvs[] = {
+  { .type = RFC7181_ADDRTLV_NBR_ADDR_TYPE },
+  { .type = RFC7181_ADDRTLV_LINK_METRIC },
+  { .type = RFC7181_ADDRTLV_GATEWAY },
+};
+
+/* interop test packets, sorted by name */
+static struct avl_tree _test_tree;
+
+/* benchmark corpus, interop packets first, then synthetic TCs */
+static struct _corpus_packet _corpus[MAX_CORPUS_SIZE];
+static size_t _corpus_size, _interop_size;
+
+/* parameters of the synthetic TC that is generated */
+static int _tc_addr_count, _tc_af;
+
+/* state of the interop verification run */
+static struct test_packet *_packet;
+static struct test_message *_current_msg;
+static bool _verify;
+static size_t _bad_addr_count;
+
+/* counters of the reader callbacks */
+static size_t _msg_count, _addr_count, _tc_addr_total, _bad_metric_count;
+static size_t _alloc_count;
+static uint32_t _checksum;
+
+/**
+ * Count tlvblock entry allocations of the reader
+ * @return pointer to cleaned tlvblock entry, NULL if out of memory
+ */
+static struct rfc5444_reader_tlvblock_entry *
+_cb_malloc_tlvblock_entry(void) {
+  _alloc_count++;
+  return calloc(1, sizeof(struct rfc5444_reader_tlvblock_entry));
+}
+
+/**
+ * Count addrblock entry allocations of the reader
+ * @return pointer to cleaned addrblock entry, NULL if out of memory
+ */
+static struct rfc5444_reader_addrblock_entry *
+_cb_malloc_addrblock_entry(void) {
+  _alloc_count++;
+  return calloc(1, sizeof(struct rfc5444_reader_addrblock_entry));
+}
+
+/**
+ * Count messages and remember the test description of the
+ * current message during the interop verification run
+ * @param context rfc5444 context
+ * @return always RFC5444_OKAY
+ */
+static enum rfc5444_result
+_cb_msg_start(struct rfc5444_reader_tlvblock_context *context) {
+  size_t i;
+
+  _msg_count++;
+
+  _current_msg = NULL;
+  if (!_verify || _packet == NULL) {
+    return RFC5444_OKAY;
+  }
+
+  for (i=0; i<_packet->msg_count; i++) {
+    if (_packet->msgs[i].type == context->msg_type) {
+      _current_msg = &_packet->msgs[i];
+      break;
+    }
+  }
+  return RFC5444_OKAY;
+}
+
+/**
+ * Count decoded addresses and compare them with the
+ * test description during the interop verification run
+ * @param context rfc5444 context
+ * @return always RFC5444_OKAY
+ */
+static enum rfc5444_result
+_cb_addr_start(struct rfc5444_reader_tlvblock_context *context) {
+  size_t i;
+
+  _addr_count++;
+  if (!_verify || _packet == NULL) {
+    return RFC5444_OKAY;
+  }
+
+  if (_current_msg != NULL) {
+    for (i=0; i<_current_msg->address_count; i++) {
+      if (memcmp(_current_msg->addrs[i].addr,
+          netaddr_get_binptr(&context->addr), _current_msg->addrlen) == 0
+          && netaddr_get_prefix_length(&context->addr) == _current_msg->addrs[i].plen) {
+        return RFC5444_OKAY;
+      }
+    }
+  }
+  _bad_addr_count++;
+  return RFC5444_OKAY;
+}
+
+/**
+ * Touch the value of all TLVs found by a consumer, like the
+ * NHDP/OLSRv2 readers do
+ * @param entries array of consumer entries
+ * @param count number of consumer entries
+ */
+static void
+_read_entries(struct rfc5444_reader_tlvblock_consumer_entry *entries, size_t count) {
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    if (entries[i].tlv && entries[i].tlv->length > 0) {
+      _checksum += entries[i].tlv->single_value[0];
+    }
+  }
+}
+
+static enum rfc5444_result
+_cb_hello_msg(struct rfc5444_reader_tlvblock_context *context __attribute__((unused))) {
+  _read_entries(_hello_msg_entries, ARRAYSIZE(_hello_msg_entries));
+  return RFC5444_OKAY;
+}
+
+static enum rfc5444_result
+_cb_hello_addr(struct rfc5444_reader_tlvblock_context *context __attribute__((unused))) {
+  _read_entries(_hello_addr_entries, ARRAYSIZE(_hello_addr_entries));
+  return RFC5444_OKAY;
+}
+
+static enum rfc5444_result
+_cb_tc_msg(struct rfc5444_reader_tlvblock_context *context __attribute__((unused))) {
+  _read_entries(_tc_msg_entries, ARRAYSIZE(_tc_msg_entries));
+  return RFC5444_OKAY;
+}
+
+/**
+ * Check the metric of the synthetic TC addresses, which is
+ * a copy of the last two bytes of the address
+ * @param context rfc5444 context
+ * @return always RFC5444_OKAY
+ */
+static enum rfc5444_result
+_cb_tc_addr(struct rfc5444_reader_tlvblock_context *context) {
+  const uint8_t *addr;
+
+  _read_entries(_tc_addr_entries, ARRAYSIZE(_tc_addr_entries));
+
+  if (_verify && _packet == NULL) {
+    _tc_addr_total++;
+
+    addr = netaddr_get_binptr(&context->addr);
+    if (_tc_addr_entries[0].tlv == NULL
+        || memcmp(_tc_addr_entries[0].tlv->single_value, &addr[context->addr_len - 2], 2) != 0) {
+      _bad_metric_count++;
+    }
+  }
+  return RFC5444_OKAY;
+}
+
+static int
+_cb_add_msg_header(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  static const uint8_t originator[16] = { 10, 0, 0, 1 };
+  static uint16_t seqno = 0;
+
+  rfc5444_writer_set_msg_header(wr, msg, true, true, true, true);
+  rfc5444_writer_set_msg_originator(wr, msg, originator);
+  rfc5444_writer_set_msg_hopcount(wr, msg, 0);
+  rfc5444_writer_set_msg_hoplimit(wr, msg, 255);
+  rfc5444_writer_set_msg_seqno(wr, msg, seqno++);
+  return RFC5444_OKAY;
+}
+
+static void
+_cb_add_tc_msgtlvs(struct rfc5444_writer *wr) {
+  uint8_t vtime = 0x64;
+  uint16_t ansn = 0x1234;
+
+  rfc5444_writer_add_messagetlv(wr, RFC5497_MSGTLV_VALIDITY_TIME, 0, &vtime, sizeof(vtime));
+  rfc5444_writer_add_messagetlv(wr, RFC7181_MSGTLV_CONT_SEQ_NUM,
+      RFC7181_CONT_SEQ_NUM_COMPLETE, &ansn, sizeof(ansn));
+}
+
+/**
+ * Add the addresses of the synthetic TC in a scrambled order,
+ * every tenth address is an attached network
+ * @param wr rfc5444 writer
+ */
+static void
+_cb_add_tc_addresses(struct rfc5444_writer *wr) {
+  struct rfc5444_writer_address *addr;
+  struct netaddr naddr;
+  uint8_t value;
+  int i, idx;
+
+  for (i = 0; i < _tc_addr_count; i++) {
+    idx = (i * 7919) % _tc_addr_count;
+
+    memset(&naddr, 0, sizeof(naddr));
+    naddr._type = _tc_af;
+    if (_tc_af == AF_INET && idx % 10 == 9) {
+      naddr._prefix_len = 24;
+      naddr._addr[0] = 192;
+      naddr._addr[1] = 168;
+      naddr._addr[2] = idx / 10;
+    }
+    else if (_tc_af == AF_INET) {
+      naddr._prefix_len = 32;
+      naddr._addr[0] = 10;
+      naddr._addr[1] = idx >> 16;
+      naddr._addr[2] = idx >> 8;
+      naddr._addr[3] = idx;
+    }
+    else {
+      naddr._prefix_len = 128;
+      naddr._addr[0] = 0xfd;
+      naddr._addr[7] = idx % 7;
+      naddr._addr[14] = idx >> 8;
+      naddr._addr[15] = idx;
+    }
+
+    addr = rfc5444_writer_add_address(wr, _tc_provider.creator, &naddr, false);
+    if (addr == NULL) {
+      continue;
+    }
+
+    if (netaddr_get_prefix_length(&naddr) == netaddr_get_af_maxprefix(_tc_af)) {
+      value = RFC7181_NBR_ADDR_TYPE_ROUTABLE;
+      rfc5444_writer_add_addrtlv(wr, addr, &_tc_addrtlvs[0], &value, sizeof(value), false);
+    }
+    else {
+      value = 1;
+      rfc5444_writer_add_addrtlv(wr, addr, &_tc_addrtlvs[2], &value, sizeof(value), false);
+    }
+    rfc5444_writer_add_addrtlv(wr, addr, &_tc_addrtlvs[1],
+        &naddr._addr[netaddr_get_binlength(&naddr) - 2], 2, false);
+  }
+}
+
+/**
+ * Store a generated packet in the corpus
+ */
+static void
+_cb_send_packet(struct rfc5444_writer *wr __attribute__ ((unused)),
+    struct rfc5444_writer_target *target __attribute__ ((unused)),
+    void *ptr, size_t len) {
+  if (_corpus_size == MAX_CORPUS_SIZE) {
+    return;
+  }
+
+  _corpus[_corpus_size].data = malloc(len);
+  if (_corpus[_corpus_size].data) {
+    memcpy(_corpus[_corpus_size].data, ptr, len);
+    _corpus[_corpus_size].length = len;
+    _corpus_size++;
+  }
+}
+
+/**
+ * @return monotonic time in microseconds
+ */
+static uint64_t
+_get_time(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/**
+ * Generate a synthetic TC and add its packets to the corpus
+ * @param addr_count number of addresses in TC
+ * @param af address family of TC
+ * @return number of generated addresses
+ */
+static int
+_generate_tc(int addr_count, int af) {
+  _tc_addr_count = addr_count;
+  _tc_af = af;
+
+  rfc5444_writer_create_message_alltarget(&_writer, RFC7181_MSGTYPE_TC, af == AF_INET ? 4 : 16);
+  rfc5444_writer_flush(&_writer, &_target, false);
+  return addr_count;
+}
+
+/**
+ * Build the corpus from the interop packets and from synthetic TCs,
+ * then parse all packets once and check the decoded content
+ */
+static void
+_generate_corpus(void) {
+  struct test_packet *packet;
+  size_t expected, i;
+
+  cunit_start_test(__func__);
+
+  /* parse interop packets and check the decoded addresses */
+  expected = 0;
+  _addr_count = 0;
+  _bad_addr_count = 0;
+  _verify = true;
+
+  avl_for_each_element(&_test_tree, packet, _node) {
+    for (i=0; i<packet->msg_count; i++) {
+      expected += packet->msgs[i].address_count;
+    }
+
+    _packet = packet;
+    CHECK_TRUE(rfc5444_reader_handle_packet(&_reader, packet->binary, packet->binlen) == RFC5444_OKAY,
+        "Could not parse %s", packet->test);
+
+    if (_corpus_size < MAX_CORPUS_SIZE) {
+      _corpus[_corpus_size].data = packet->binary;
+      _corpus[_corpus_size].length = packet->binlen;
+      _corpus_size++;
+    }
+  }
+  _packet = NULL;
+  _interop_size = _corpus_size;
+
+  CHECK_TRUE(_addr_count == expected, "Decoded %zu interop addresses (should be %zu)",
+      _addr_count, expected);
+  CHECK_TRUE(_bad_addr_count == 0, "%zu interop addresses decoded wrong", _bad_addr_count);
+
+  /* generate synthetic TCs */
+  expected = 0;
+  expected += _generate_tc(50, AF_INET);
+  expected += _generate_tc(500, AF_INET);
+  expected += _generate_tc(2000, AF_INET);
+  expected += _generate_tc(500, AF_INET6);
+
+  CHECK_TRUE(_corpus_size < MAX_CORPUS_SIZE, "Corpus too small");
+
+  /* parse synthetic TCs and check all addresses and metrics */
+  _tc_addr_total = 0;
+  _bad_metric_count = 0;
+  for (i = _interop_size; i < _corpus_size; i++) {
+    CHECK_TRUE(rfc5444_reader_handle_packet(&_reader, _corpus[i].data, _corpus[i].length) == RFC5444_OKAY,
+        "Could not parse synthetic packet %zu", i - _interop_size);
+  }
+  _verify = false;
+
+  CHECK_TRUE(_tc_addr_total == expected, "Decoded %zu TC addresses (should be %zu)",
+      _tc_addr_total, expected);
+  CHECK_TRUE(_bad_metric_count == 0, "%zu TC addresses with bad metric", _bad_metric_count);
+
+  cunit_end_test(__func__);
+}
+
+/**
+ * Measure the reader throughput over a part of the corpus
+ * @param name name of measurement
+ * @param first index of first packet
+ * @param last index after the last packet
+ * @param iterations number of rounds over the packets
+ */
+static void
+_bench_corpus(const char *name, size_t first, size_t last, int iterations) {
+  size_t packets, i;
+  uint64_t start, end;
+  double seconds;
+  int j;
+
+  cunit_start_test(name);
+
+  packets = 0;
+  _msg_count = 0;
+  _addr_count = 0;
+  _alloc_count = 0;
+
+  start = _get_time();
+  for (j = 0; j < iterations; j++) {
+    for (i = first; i < last; i++) {
+      rfc5444_reader_handle_packet(&_reader, _corpus[i].data, _corpus[i].length);
+      packets++;
+    }
+  }
+  end = _get_time();
+
+  seconds = (double)(end - start) / 1000000.0;
+  if (seconds <= 0.0) {
+    seconds = 0.000001;
+  }
+  printf("\t%zu packets, %zu messages, %zu addresses: %.0f packets/s, %.0f messages/s,"
+      " %.1f allocations per packet\n",
+      packets, _msg_count, _addr_count, packets / seconds, _msg_count / seconds,
+      packets > 0 ? (double)_alloc_count / packets : 0.0);
+
+  cunit_end_test(name);
+}
+
+void
+add_test(struct test_packet *p) {
+  if (_test_tree.comp == NULL) {
+    avl_init(&_test_tree, avl_comp_strcasecmp, false);
+  }
+
+  p->_node.key = p->test;
+  avl_insert(&_test_tree, &p->_node);
+}
+
+int
+main(int argc, char **argv) {
+  struct rfc5444_writer_message *msg;
+  int iterations;
+  size_t i;
+
+  iterations = DEFAULT_ITERATIONS;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  rfc5444_reader_init(&_reader);
+  rfc5444_reader_add_message_consumer(&_reader, &_msg_consumer, NULL, 0);
+  rfc5444_reader_add_message_consumer(&_reader, &_addr_consumer, NULL, 0);
+  rfc5444_reader_add_message_consumer(&_reader, &_hello_msg_consumer,
+      _hello_msg_entries, ARRAYSIZE(_hello_msg_entries));
+  rfc5444_reader_add_message_consumer(&_reader, &_hello_addr_consumer,
+      _hello_addr_entries, ARRAYSIZE(_hello_addr_entries));
+  rfc5444_reader_add_message_consumer(&_reader, &_tc_msg_consumer,
+      _tc_msg_entries, ARRAYSIZE(_tc_msg_entries));
+  rfc5444_reader_add_message_consumer(&_reader, &_tc_addr_consumer,
+      _tc_addr_entries, ARRAYSIZE(_tc_addr_entries));
+
+  rfc5444_writer_init(&_writer);
+  rfc5444_writer_register_target(&_writer, &_target);
+  msg = rfc5444_writer_register_message(&_writer, RFC7181_MSGTYPE_TC, false);
+  msg->addMessageHeader = _cb_add_msg_header;
+  rfc5444_writer_register_msgcontentprovider(&_writer,
+      &_tc_provider, _tc_addrtlvs, ARRAYSIZE(_tc_addrtlvs));
+
+  BEGIN_TESTING(NULL);
+
+  _generate_corpus();
+  _bench_corpus("bench_interop2010", 0, _interop_size, iterations);
+  _bench_corpus("bench_synthetic_tc", _interop_size, _corpus_size, iterations);
+
+  for (i = _interop_size; i < _corpus_size; i++) {
+    free(_corpus[i].data);
+  }
+
+  rfc5444_writer_cleanup(&_writer);
+  rfc5444_reader_cleanup(&_reader);
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,285 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/common_types.h"
+#include "common/avl.h"
+#include "common/avl_comp.h"
+#include "common/netaddr.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "rfc5444/rfc5444_reader.h"
+#include "test_rfc5444_interop.h"
+
+/*! maximum size of a rfc5444 packet */
+#define MAX_INPUT_SIZE 65535
+
+/*
+ * libFuzzer entry point for the rfc5444 reader.
+ *
+ * With OONF_FUZZING the file is linked against libFuzzer, otherwise
+ * it contains a main() that feeds all truncations and single byte
+ * mutations of the interop2010 packets (or the files given on the
+ * command line) into the same entry point.
+ */
+
+EXPORT int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static enum rfc5444_result _cb_start(struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_tlv(struct rfc5444_reader_tlvblock_entry *entry,
+    struct rfc5444_reader_tlvblock_context *context);
+static enum rfc5444_result _cb_block(struct rfc5444_reader_tlvblock_context *context);
+
+static struct rfc5444_reader_tlvblock_consumer _pkt_consumer = {
+  .start_callback = _cb_start,
+  .tlv_callback = _cb_tlv,
+};
+static struct rfc5444_reader_tlvblock_consumer _msg_consumer = {
+  .default_msg_consumer = true,
+  .start_callback = _cb_start,
+  .tlv_callback = _cb_tlv,
+};
+static struct rfc5444_reader_tlvblock_consumer _addr_consumer = {
+  .default_msg_consumer = true,
+  .addrblock_consumer = true,
+  .start_callback = _cb_start,
+  .tlv_callback = _cb_tlv,
+};
+
+static struct rfc5444_reader_tlvblock_consumer_entry _hello_addr_entries[] = {
+  { .type = RFC6130_ADDRTLV_LOCAL_IF, .min_length = 1, .match_length = true },
+  { .type = RFC6130_ADDRTLV_LINK_STATUS, .min_length = 1, .match_length = true },
+  { .type = RFC7181_ADDRTLV_LINK_METRIC, .min_length = 2, .match_length = true },
+};
+static struct rfc5444_reader_tlvblock_consumer _hello_addr_consumer = {
+  .msg_id = RFC6130_MSGTYPE_HELLO,
+  .addrblock_consumer = true,
+  .block_callback = _cb_block,
+};
+
+static struct rfc5444_reader_tlvblock_consumer_entry _tc_addr_entries[] = {
+  { .type = RFC7181_ADDRTLV_LINK_METRIC, .min_length = 2, .match_length = true },
+  { .type = RFC7181_ADDRTLV_NBR_ADDR_TYPE, .min_length = 1, .match_length = true },
+};
+static struct rfc5444_reader_tlvblock_consumer _tc_addr_consumer = {
+  .msg_id = RFC7181_MSGTYPE_TC,
+  .addrblock_consumer = true,
+  .block_callback = _cb_block,
+};
+
+static struct rfc5444_reader _reader;
+static bool _initialized = false;
+
+static struct avl_tree _test_tree;
+
+/* sum of all read bytes, makes sure the callbacks touch the data */
+static uint32_t _checksum;
+
+static enum rfc5444_result
+_cb_start(struct rfc5444_reader_tlvblock_context *context) {
+  const uint8_t *ptr;
+
+  if (context->type == RFC5444_CONTEXT_ADDRESS) {
+    ptr = netaddr_get_binptr(&context->addr);
+    _checksum += ptr[context->addr_len - 1];
+  }
+  else if (context->type == RFC5444_CONTEXT_MESSAGE && context->has_origaddr) {
+    ptr = netaddr_get_binptr(&context->orig_addr);
+    _checksum += ptr[0];
+  }
+  return RFC5444_OKAY;
+}
+
+static enum rfc5444_result
+_cb_tlv(struct rfc5444_reader_tlvblock_entry *entry,
+    struct rfc5444_reader_tlvblock_context *context __attribute__((unused))) {
+  uint16_t i;
+
+  for (i = 0; i < entry->length; i++) {
+    _checksum += entry->single_value[i];
+  }
+  return RFC5444_OKAY;
+}
+
+static enum rfc5444_result
+_cb_block(struct rfc5444_reader_tlvblock_context *context) {
+  struct rfc5444_reader_tlvblock_consumer_entry *entries;
+  size_t count, i;
+
+  if (context->msg_type == RFC6130_MSGTYPE_HELLO) {
+    entries = _hello_addr_entries;
+    count = ARRAYSIZE(_hello_addr_entries);
+  }
+  else {
+    entries = _tc_addr_entries;
+    count = ARRAYSIZE(_tc_addr_entries);
+  }
+
+  for (i = 0; i < count; i++) {
+    if (entries[i].tlv) {
+      _checksum += entries[i].tlv->single_value[entries[i].tlv->length - 1];
+    }
+  }
+  return RFC5444_OKAY;
+}
+
+/**
+ * Parse a single input with the rfc5444 reader
+ * @param data pointer to input
+ * @param size length of input
+ * @return always 0
+ */
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  uint8_t *copy;
+
+  if (!_initialized) {
+    rfc5444_reader_init(&_reader);
+    rfc5444_reader_add_packet_consumer(&_reader, &_pkt_consumer, NULL, 0);
+    rfc5444_reader_add_message_consumer(&_reader, &_msg_consumer, NULL, 0);
+    rfc5444_reader_add_message_consumer(&_reader, &_addr_consumer, NULL, 0);
+    rfc5444_reader_add_message_consumer(&_reader, &_hello_addr_consumer,
+        _hello_addr_entries, ARRAYSIZE(_hello_addr_entries));
+    rfc5444_reader_add_message_consumer(&_reader, &_tc_addr_consumer,
+        _tc_addr_entries, ARRAYSIZE(_tc_addr_entries));
+    _initialized = true;
+  }
+
+  /* use an exactly sized heap copy so that overreads are detected */
+  copy = malloc(size > 0 ? size : 1);
+  if (copy == NULL) {
+    return 0;
+  }
+  memcpy(copy, data, size);
+
+  rfc5444_reader_handle_packet(&_reader, copy, size);
+
+  free(copy);
+  return 0;
+}
+
+void
+add_test(struct test_packet *p) {
+  if (_test_tree.comp == NULL) {
+    avl_init(&_test_tree, avl_comp_strcasecmp, false);
+  }
+
+  p->_node.key = p->test;
+  avl_insert(&_test_tree, &p->_node);
+}
+
+#ifndef OONF_FUZZING
+/**
+ * Feed all truncations and all single byte mutations
+ * of a packet into the fuzzer entry point
+ * @param data pointer to packet
+ * @param size length of packet
+ * @return number of inputs
+ */
+static size_t
+_mutate_packet(const uint8_t *data, size_t size) {
+  static uint8_t buffer[MAX_INPUT_SIZE];
+  size_t i, count;
+
+  if (size > sizeof(buffer)) {
+    size = sizeof(buffer);
+  }
+  memcpy(buffer, data, size);
+
+  count = 0;
+  for (i = 0; i <= size; i++) {
+    LLVMFuzzerTestOneInput(buffer, i);
+    count++;
+  }
+
+  for (i = 0; i < size; i++) {
+    buffer[i] ^= 0xff;
+    LLVMFuzzerTestOneInput(buffer, size);
+    buffer[i] ^= 0x80;
+    LLVMFuzzerTestOneInput(buffer, size);
+    buffer[i] ^= 0x7f;
+    count += 2;
+  }
+  return count;
+}
+
+int
+main(int argc, char **argv) {
+  static uint8_t buffer[MAX_INPUT_SIZE];
+  struct test_packet *packet;
+  size_t count, len;
+  FILE *f;
+  int i;
+
+  count = 0;
+  if (argc > 1) {
+    /* replay files, e.g. a crash found by libFuzzer */
+    for (i = 1; i < argc; i++) {
+      if ((f = fopen(argv[i], "rb")) == NULL) {
+        fprintf(stderr, "Cannot open %s\n", argv[i]);
+        return 1;
+      }
+      len = fread(buffer, 1, sizeof(buffer), f);
+      fclose(f);
+
+      count += _mutate_packet(buffer, len);
+    }
+  }
+  else {
+    avl_for_each_element(&_test_tree, packet, _node) {
+      count += _mutate_packet(packet->binary, packet->binlen);
+    }
+  }
+
+  printf("Parsed %zu inputs\n", count);
+
+  if (_initialized) {
+    rfc5444_reader_cleanup(&_reader);
+  }
+  return 0;
+}
+#endif
@@ -0,0 +1,448 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "rfc5444/rfc5444_writer.h"
+#include "cunit/cunit.h"
+
+#define MSG_TYPE 1
+
+static void write_packet(struct rfc5444_writer *,
+    struct rfc5444_writer_target *, void *, size_t);
+static void addAddresses(struct rfc5444_writer *wr);
+
+/* message buffer with a guard area to detect overflows */
+static struct {
+  uint8_t buffer[256];
+  uint8_t guard[256];
+} msg_mem;
+static uint8_t msg_addrtlvs[4096];
+
+static struct rfc5444_writer writer = {
+  .msg_buffer = msg_mem.buffer,
+  .msg_size = sizeof(msg_mem.buffer),
+  .addrtlv_buffer = msg_addrtlvs,
+  .addrtlv_size = sizeof(msg_addrtlvs),
+};
+
+static struct rfc5444_writer_content_provider cpr = {
+  .msg_type = MSG_TYPE,
+  .addAddresses = addAddresses,
+};
+
+static struct rfc5444_writer_tlvtype addrtlvs[] = {
+  { .type = 1 },
+  { .type = 2 },
+};
+
+static uint8_t packet_buffer[1024];
+static struct rfc5444_writer_target out_if = {
+  .packet_buffer = packet_buffer,
+  .packet_size = sizeof(packet_buffer),
+  .sendPacket = write_packet,
+};
+
+/* addresses of the current message */
+static struct netaddr *addresses;
+static size_t address_count;
+
+/* concatenated packets of the current message */
+static uint8_t output[4096];
+static size_t output_len;
+
+static int addMessageHeader(struct rfc5444_writer *wr, struct rfc5444_writer_message *msg) {
+  rfc5444_writer_set_msg_header(wr, msg, false, false, false, false);
+  return RFC5444_OKAY;
+}
+
+static void addAddresses(struct rfc5444_writer *wr) {
+  struct rfc5444_writer_address *addr;
+  uint8_t status, metric[2];
+  size_t i;
+
+  for (i = 0; i < address_count; i++) {
+    addr = rfc5444_writer_add_address(wr, cpr.creator, &addresses[i], false);
+
+    /* a tlv with few different values and one with many */
+    status = (uint8_t)(i % 3 == 0);
+    metric[0] = (uint8_t)(i / 7);
+    metric[1] = (uint8_t)(i * 13);
+    rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[0], &status, sizeof(status), false);
+    rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[1], metric, sizeof(metric), false);
+  }
+}
+
+static void write_packet(struct rfc5444_writer *w __attribute__ ((unused)),
+    struct rfc5444_writer_target *iface __attribute__ ((unused)),
+    void *buffer, size_t length) {
+  if (output_len + length <= sizeof(output)) {
+    memcpy(&output[output_len], buffer, length);
+  }
+  output_len += length;
+}
+
+static void clear_elements(void) {
+  output_len = 0;
+  memset(msg_mem.guard, 0xaa, sizeof(msg_mem.guard));
+}
+
+/**
+ * @return true if the guard area behind the message buffer is unchanged
+ */
+static bool
+guard_intact(void) {
+  size_t i;
+
+  for (i = 0; i < sizeof(msg_mem.guard); i++) {
+    if (msg_mem.guard[i] != 0xaa) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Generate addresses with a mixture of common prefixes
+ * in a pseudo random order
+ * @param addrs array for addresses
+ * @param count number of addresses
+ * @param af address family
+ * @param seed seed of random generator
+ * @param mixed true to give some addresses a shorter prefix
+ */
+static void
+generate_addresses(struct netaddr *addrs, size_t count, int af, uint32_t seed,
+    bool mixed) {
+  uint8_t bin[16];
+  size_t i, len;
+
+  len = af == AF_INET ? 4 : 16;
+  for (i = 0; i < count; i++) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    memset(bin, 0, sizeof(bin));
+    bin[0] = af == AF_INET ? 10 : 0xfd;
+    bin[len - 3] = (uint8_t)(seed & 3);
+    bin[len - 2] = (uint8_t)((seed >> 8) & 7);
+    bin[len - 1] = (uint8_t)(seed >> 16);
+
+    netaddr_from_binary(&addrs[i], bin, len, af);
+    if (mixed && (seed >> 24) % 5 == 0) {
+      /* some addresses with a shorter prefix */
+      addrs[i]._prefix_len = af == AF_INET ? 24 : 64;
+    }
+  }
+}
+
+/**
+ * Generate a message with the exhaustive compressor and compare
+ * the packets with the recorded output
+ * @param addrs array of addresses
+ * @param count number of addresses
+ * @param addrlen address length in bytes
+ * @param expected expected packet bytes
+ * @param expected_len length of expected packet bytes
+ */
+static void
+check_output(struct netaddr *addrs, size_t count, uint8_t addrlen,
+    const uint8_t *expected, size_t expected_len) {
+  size_t i;
+
+  addresses = addrs;
+  address_count = count;
+  writer.sorted_addr_compression = false;
+
+  CHECK_TRUE(rfc5444_writer_create_message_alltarget(&writer, MSG_TYPE, addrlen) == RFC5444_OKAY,
+      "Could not create message");
+  rfc5444_writer_flush(&writer, &out_if, false);
+
+  CHECK_TRUE(guard_intact(), "message buffer overflow");
+
+  CHECK_TRUE(output_len == expected_len, "output has %zu bytes, expected %zu",
+      output_len, expected_len);
+  for (i = 0; i < output_len && i < expected_len; i++) {
+    if (output[i] != expected[i]) {
+      break;
+    }
+  }
+  CHECK_TRUE(i == expected_len && i == output_len, "output differs at byte %zu", i);
+}
+
+/*
+ * output of the exhaustive compressor, recorded before the sorted
+ * address compression was added to the writer
+ */
+static const uint8_t expected_ipv4_single[] = {
+  0x00, 0x01, 0x03, 0x00, 0x66, 0x00, 0x00, 0x0c, 0x88, 0x01, 0x0a, 0x01,
+  0x02, 0x98, 0x03, 0x04, 0x5b, 0x00, 0x04, 0x20, 0x00, 0x04, 0xb3, 0x00,
+  0x07, 0x3a, 0x01, 0x02, 0xa8, 0x01, 0x07, 0xca, 0x01, 0x06, 0x18, 0x03,
+  0x02, 0x78, 0x01, 0x03, 0xb1, 0x00, 0x05, 0xbf, 0x00, 0x05, 0x0f, 0x18,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x18, 0x20, 0x00,
+  0x2a, 0x01, 0x14, 0x0c, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x02, 0x14, 0x18, 0x00, 0x00, 0x00, 0x0d, 0x00,
+  0x1a, 0x00, 0x27, 0x00, 0x34, 0x00, 0x41, 0x00, 0x4e, 0x01, 0x5b, 0x01,
+  0x68, 0x01, 0x75, 0x01, 0x82, 0x01, 0x8f
+};
+
+static const uint8_t expected_ipv4_fragmented[] = {
+  0x00, 0x01, 0x03, 0x00, 0xfc, 0x00, 0x00, 0x27, 0x80, 0x01, 0x0a, 0x02,
+  0x01, 0x09, 0x00, 0x02, 0x95, 0x01, 0x06, 0xb9, 0x02, 0x06, 0xb1, 0x02,
+  0x05, 0x4a, 0x00, 0x03, 0x56, 0x03, 0x02, 0xf6, 0x03, 0x00, 0x9a, 0x02,
+  0x03, 0xe8, 0x02, 0x06, 0x91, 0x02, 0x07, 0x61, 0x00, 0x06, 0x15, 0x00,
+  0x03, 0xe4, 0x02, 0x06, 0x1d, 0x00, 0x00, 0x52, 0x03, 0x04, 0x8d, 0x03,
+  0x04, 0x22, 0x02, 0x02, 0xfe, 0x00, 0x02, 0x35, 0x02, 0x04, 0xf9, 0x01,
+  0x05, 0x88, 0x03, 0x06, 0x8f, 0x01, 0x05, 0xc1, 0x00, 0x04, 0x1d, 0x00,
+  0x02, 0x91, 0x02, 0x04, 0x74, 0x00, 0x01, 0x65, 0x01, 0x00, 0x28, 0x02,
+  0x04, 0xcb, 0x01, 0x03, 0x99, 0x03, 0x04, 0x68, 0x00, 0x01, 0x25, 0x02,
+  0x06, 0x84, 0x00, 0x05, 0xcb, 0x03, 0x03, 0xba, 0x01, 0x03, 0x45, 0x00,
+  0x03, 0x4c, 0x00, 0x02, 0x3c, 0x01, 0x05, 0x2d, 0x00, 0x7b, 0x01, 0x14,
+  0x27, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x02, 0x14, 0x4e, 0x00, 0x00, 0x00, 0x0d, 0x00,
+  0x1a, 0x00, 0x27, 0x00, 0x34, 0x00, 0x41, 0x00, 0x4e, 0x01, 0x5b, 0x01,
+  0x68, 0x01, 0x75, 0x01, 0x82, 0x01, 0x8f, 0x01, 0x9c, 0x01, 0xa9, 0x02,
+  0xb6, 0x02, 0xc3, 0x02, 0xd0, 0x02, 0xdd, 0x02, 0xea, 0x02, 0xf7, 0x02,
+  0x04, 0x03, 0x11, 0x03, 0x1e, 0x03, 0x2b, 0x03, 0x38, 0x03, 0x45, 0x03,
+  0x52, 0x03, 0x5f, 0x04, 0x6c, 0x04, 0x79, 0x04, 0x86, 0x04, 0x93, 0x04,
+  0xa0, 0x04, 0xad, 0x04, 0xba, 0x05, 0xc7, 0x05, 0xd4, 0x05, 0xe1, 0x05,
+  0xee, 0x01, 0x03, 0x00, 0x90, 0x00, 0x00, 0x15, 0x80, 0x01, 0x0a, 0x01,
+  0x02, 0x88, 0x01, 0x02, 0xf3, 0x00, 0x04, 0xd2, 0x00, 0x03, 0x68, 0x03,
+  0x00, 0xe9, 0x02, 0x03, 0x88, 0x00, 0x06, 0x7e, 0x02, 0x04, 0x00, 0x02,
+  0x07, 0x9e, 0x01, 0x04, 0x9e, 0x03, 0x04, 0x85, 0x02, 0x06, 0x53, 0x00,
+  0x06, 0x11, 0x03, 0x04, 0x33, 0x01, 0x00, 0x2a, 0x00, 0x06, 0x77, 0x02,
+  0x00, 0x39, 0x02, 0x06, 0x32, 0x02, 0x04, 0xe7, 0x03, 0x04, 0x04, 0x02,
+  0x03, 0xe3, 0x00, 0x45, 0x01, 0x14, 0x15, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x02, 0x14, 0x2a, 0x05, 0xfb, 0x05, 0x08, 0x05,
+  0x15, 0x06, 0x22, 0x06, 0x2f, 0x06, 0x3c, 0x06, 0x49, 0x06, 0x56, 0x06,
+  0x63, 0x06, 0x70, 0x07, 0x7d, 0x07, 0x8a, 0x07, 0x97, 0x07, 0xa4, 0x07,
+  0xb1, 0x07, 0xbe, 0x07, 0xcb, 0x08, 0xd8, 0x08, 0xe5, 0x08, 0xf2, 0x08,
+  0xff
+};
+
+static const uint8_t expected_ipv4_mixed_fragmented[] = {
+  0x00, 0x01, 0x03, 0x00, 0xf9, 0x00, 0x00, 0x21, 0x88, 0x01, 0x0a, 0x00,
+  0x02, 0x68, 0x03, 0x00, 0xde, 0x00, 0x04, 0x10, 0x02, 0x03, 0x19, 0x00,
+  0x04, 0xe3, 0x00, 0x05, 0x47, 0x01, 0x00, 0x8a, 0x03, 0x00, 0x20, 0x02,
+  0x04, 0x77, 0x01, 0x06, 0x03, 0x01, 0x07, 0xdd, 0x02, 0x03, 0xfd, 0x00,
+  0x05, 0x0a, 0x01, 0x00, 0xf0, 0x02, 0x00, 0x37, 0x01, 0x07, 0xec, 0x00,
+  0x01, 0x58, 0x03, 0x07, 0xaa, 0x00, 0x02, 0x85, 0x02, 0x03, 0x7c, 0x02,
+  0x01, 0x01, 0x00, 0x03, 0x96, 0x00, 0x07, 0xe4, 0x02, 0x01, 0x8e, 0x01,
+  0x04, 0x5e, 0x01, 0x07, 0xc4, 0x00, 0x05, 0x42, 0x03, 0x03, 0x0f, 0x03,
+  0x05, 0x7f, 0x02, 0x05, 0xb9, 0x02, 0x05, 0x03, 0x03, 0x07, 0xe8, 0x00,
+  0x07, 0xfe, 0x20, 0x18, 0x20, 0x20, 0x18, 0x20, 0x20, 0x18, 0x20, 0x20,
+  0x18, 0x20, 0x20, 0x20, 0x20, 0x18, 0x20, 0x20, 0x20, 0x20, 0x18, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x18, 0x20, 0x20, 0x20, 0x00,
+  0x69, 0x01, 0x14, 0x21, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x02, 0x14, 0x42, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x1a, 0x00, 0x27,
+  0x00, 0x34, 0x00, 0x41, 0x00, 0x4e, 0x01, 0x5b, 0x01, 0x68, 0x01, 0x75,
+  0x01, 0x82, 0x01, 0x8f, 0x01, 0x9c, 0x01, 0xa9, 0x02, 0xb6, 0x02, 0xc3,
+  0x02, 0xd0, 0x02, 0xdd, 0x02, 0xea, 0x02, 0xf7, 0x02, 0x04, 0x03, 0x11,
+  0x03, 0x1e, 0x03, 0x2b, 0x03, 0x38, 0x03, 0x45, 0x03, 0x52, 0x03, 0x5f,
+  0x04, 0x6c, 0x04, 0x79, 0x04, 0x86, 0x04, 0x93, 0x04, 0xa0, 0x01, 0x03,
+  0x00, 0xcf, 0x00, 0x00, 0x1b, 0x88, 0x01, 0x0a, 0x00, 0x05, 0x1d, 0x01,
+  0x02, 0xe9, 0x01, 0x05, 0x9c, 0x00, 0x04, 0x51, 0x02, 0x04, 0x42, 0x03,
+  0x04, 0xa2, 0x02, 0x05, 0x52, 0x02, 0x04, 0xcf, 0x03, 0x05, 0x32, 0x00,
+  0x07, 0x41, 0x02, 0x02, 0x03, 0x00, 0x07, 0xe5, 0x03, 0x00, 0xf9, 0x00,
+  0x02, 0x00, 0x00, 0x01, 0x59, 0x02, 0x01, 0xe8, 0x03, 0x00, 0xb4, 0x00,
+  0x03, 0x48, 0x00, 0x03, 0x1f, 0x02, 0x02, 0xc0, 0x00, 0x03, 0x1b, 0x03,
+  0x04, 0x8d, 0x02, 0x00, 0x73, 0x00, 0x02, 0xdc, 0x02, 0x03, 0x06, 0x01,
+  0x00, 0x9b, 0x01, 0x05, 0x9d, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x18, 0x18, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x18, 0x18, 0x18, 0x20,
+  0x20, 0x20, 0x20, 0x18, 0x20, 0x20, 0x20, 0x20, 0x00, 0x57, 0x01, 0x14,
+  0x1b, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x02, 0x14, 0x36, 0x04, 0xad, 0x04, 0xba, 0x05,
+  0xc7, 0x05, 0xd4, 0x05, 0xe1, 0x05, 0xee, 0x05, 0xfb, 0x05, 0x08, 0x05,
+  0x15, 0x06, 0x22, 0x06, 0x2f, 0x06, 0x3c, 0x06, 0x49, 0x06, 0x56, 0x06,
+  0x63, 0x06, 0x70, 0x07, 0x7d, 0x07, 0x8a, 0x07, 0x97, 0x07, 0xa4, 0x07,
+  0xb1, 0x07, 0xbe, 0x07, 0xcb, 0x08, 0xd8, 0x08, 0xe5, 0x08, 0xf2, 0x08,
+  0xff
+};
+
+static const uint8_t expected_ipv6_mixed_fragmented[] = {
+  0x00, 0x01, 0x0f, 0x00, 0xf7, 0x00, 0x00, 0x1f, 0x88, 0x0d, 0xfd, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+  0x06, 0xd7, 0x00, 0x04, 0x86, 0x02, 0x02, 0x8d, 0x01, 0x04, 0x2f, 0x03,
+  0x00, 0x1f, 0x02, 0x00, 0x5c, 0x02, 0x04, 0x78, 0x02, 0x06, 0xea, 0x00,
+  0x03, 0x90, 0x02, 0x02, 0x70, 0x03, 0x04, 0x76, 0x02, 0x01, 0xbf, 0x00,
+  0x05, 0x0b, 0x00, 0x02, 0x9d, 0x02, 0x04, 0x6b, 0x01, 0x04, 0x3d, 0x00,
+  0x06, 0xf7, 0x01, 0x07, 0x46, 0x03, 0x05, 0x1b, 0x00, 0x00, 0x69, 0x03,
+  0x02, 0x80, 0x01, 0x06, 0x75, 0x01, 0x02, 0xa8, 0x00, 0x02, 0xac, 0x00,
+  0x03, 0xc7, 0x02, 0x02, 0x1a, 0x03, 0x02, 0x19, 0x03, 0x04, 0x5b, 0x02,
+  0x07, 0xa9, 0x00, 0x07, 0xe1, 0x00, 0x07, 0x29, 0x40, 0x80, 0x80, 0x80,
+  0x40, 0x80, 0x40, 0x80, 0x80, 0x40, 0x40, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x40, 0x80, 0x80, 0x40, 0x80, 0x80, 0x40, 0x80, 0x80, 0x80, 0x80, 0x40,
+  0x40, 0x80, 0x80, 0x00, 0x63, 0x01, 0x14, 0x1f, 0x01, 0x00, 0x00, 0x01,
+  0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01,
+  0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01,
+  0x00, 0x00, 0x01, 0x02, 0x14, 0x3e, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x1a,
+  0x00, 0x27, 0x00, 0x34, 0x00, 0x41, 0x00, 0x4e, 0x01, 0x5b, 0x01, 0x68,
+  0x01, 0x75, 0x01, 0x82, 0x01, 0x8f, 0x01, 0x9c, 0x01, 0xa9, 0x02, 0xb6,
+  0x02, 0xc3, 0x02, 0xd0, 0x02, 0xdd, 0x02, 0xea, 0x02, 0xf7, 0x02, 0x04,
+  0x03, 0x11, 0x03, 0x1e, 0x03, 0x2b, 0x03, 0x38, 0x03, 0x45, 0x03, 0x52,
+  0x03, 0x5f, 0x04, 0x6c, 0x04, 0x79, 0x04, 0x86, 0x01, 0x0f, 0x00, 0xe9,
+  0x00, 0x00, 0x1d, 0x88, 0x0d, 0xfd, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xd6, 0x01, 0x06, 0x48,
+  0x00, 0x07, 0xff, 0x02, 0x05, 0x8b, 0x02, 0x06, 0x3f, 0x01, 0x04, 0x2a,
+  0x01, 0x04, 0xa1, 0x03, 0x04, 0x88, 0x02, 0x06, 0x6b, 0x02, 0x04, 0xa9,
+  0x02, 0x03, 0x1e, 0x00, 0x07, 0xd9, 0x02, 0x02, 0x85, 0x03, 0x06, 0x8e,
+  0x03, 0x07, 0x6d, 0x02, 0x01, 0xda, 0x00, 0x07, 0x6e, 0x03, 0x02, 0x7a,
+  0x00, 0x01, 0xda, 0x02, 0x07, 0x67, 0x01, 0x01, 0x6f, 0x00, 0x05, 0x39,
+  0x00, 0x05, 0x9f, 0x03, 0x06, 0xdc, 0x02, 0x07, 0x49, 0x01, 0x06, 0x53,
+  0x00, 0x07, 0xe0, 0x00, 0x00, 0x0b, 0x01, 0x06, 0x64, 0x40, 0x80, 0x40,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x40, 0x80, 0x40, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x00, 0x5d, 0x01, 0x14, 0x1d, 0x00, 0x00, 0x01, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00,
+  0x02, 0x14, 0x3a, 0x04, 0x93, 0x04, 0xa0, 0x04, 0xad, 0x04, 0xba, 0x05,
+  0xc7, 0x05, 0xd4, 0x05, 0xe1, 0x05, 0xee, 0x05, 0xfb, 0x05, 0x08, 0x05,
+  0x15, 0x06, 0x22, 0x06, 0x2f, 0x06, 0x3c, 0x06, 0x49, 0x06, 0x56, 0x06,
+  0x63, 0x06, 0x70, 0x07, 0x7d, 0x07, 0x8a, 0x07, 0x97, 0x07, 0xa4, 0x07,
+  0xb1, 0x07, 0xbe, 0x07, 0xcb, 0x08, 0xd8, 0x08, 0xe5, 0x08, 0xf2, 0x08,
+  0xff
+};
+
+static void test_ipv4_single(void) {
+  struct netaddr addrs[12];
+
+  START_TEST();
+  generate_addresses(addrs, ARRAYSIZE(addrs), AF_INET, 0x12345678, true);
+  check_output(addrs, ARRAYSIZE(addrs), 4, expected_ipv4_single, sizeof(expected_ipv4_single));
+  END_TEST();
+}
+
+static void test_ipv4_fragmented(void) {
+  struct netaddr addrs[60];
+
+  START_TEST();
+  generate_addresses(addrs, ARRAYSIZE(addrs), AF_INET, 0xb54cda26, false);
+  check_output(addrs, ARRAYSIZE(addrs), 4, expected_ipv4_fragmented, sizeof(expected_ipv4_fragmented));
+  END_TEST();
+}
+
+static void test_ipv4_mixed_fragmented(void) {
+  struct netaddr addrs[60];
+
+  START_TEST();
+  generate_addresses(addrs, ARRAYSIZE(addrs), AF_INET, 0x17156075, true);
+  check_output(addrs, ARRAYSIZE(addrs), 4, expected_ipv4_mixed_fragmented, sizeof(expected_ipv4_mixed_fragmented));
+  END_TEST();
+}
+
+static void test_ipv6_mixed_fragmented(void) {
+  struct netaddr addrs[60];
+
+  START_TEST();
+  generate_addresses(addrs, ARRAYSIZE(addrs), AF_INET6, 0x81af14c1, true);
+  check_output(addrs, ARRAYSIZE(addrs), 16, expected_ipv6_mixed_fragmented, sizeof(expected_ipv6_mixed_fragmented));
+  END_TEST();
+}
+
+static void test_no_overflow(void) {
+  struct netaddr addrs[60];
+  uint32_t seed;
+  int i, overflows;
+  bool mixed;
+
+  START_TEST();
+
+  overflows = 0;
+  writer.sorted_addr_compression = false;
+  addresses = addrs;
+  address_count = ARRAYSIZE(addrs);
+
+  for (i = 0; i < 400; i++) {
+    seed = (uint32_t)(i + 1) * 2654435761u;
+    mixed = (i & 1) != 0;
+
+    clear_elements();
+    generate_addresses(addrs, ARRAYSIZE(addrs), i < 200 ? AF_INET : AF_INET6, seed, mixed);
+    rfc5444_writer_create_message_alltarget(&writer, MSG_TYPE, i < 200 ? 4 : 16);
+    rfc5444_writer_flush(&writer, &out_if, false);
+
+    if (!guard_intact()) {
+      overflows++;
+    }
+  }
+  CHECK_TRUE(overflows == 0, "%d messages overflowed the message buffer", overflows);
+
+  END_TEST();
+}
+
+int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
+  struct rfc5444_writer_message *msg;
+
+  rfc5444_writer_init(&writer);
+  rfc5444_writer_register_target(&writer, &out_if);
+
+  msg = rfc5444_writer_register_message(&writer, MSG_TYPE, false);
+  msg->addMessageHeader = addMessageHeader;
+
+  rfc5444_writer_register_msgcontentprovider(&writer, &cpr, addrtlvs, ARRAYSIZE(addrtlvs));
+
+  BEGIN_TESTING(clear_elements);
+
+  test_ipv4_single();
+  test_ipv4_fragmented();
+  test_ipv4_mixed_fragmented();
+  test_ipv6_mixed_fragmented();
+  test_no_overflow();
+
+  rfc5444_writer_cleanup(&writer);
+
+  return FINISH_TESTING();
+}
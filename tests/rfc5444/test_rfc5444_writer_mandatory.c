@@ -92,6 +92,7 @@ static struct rfc5444_writer_target large_if = {
 };
 
 static int tlvcount, fragments, packets[2];
+static int mandatory_idx, mandatory_fragments;
 
 static uint8_t tlv_value_buffer[256];
 static uint8_t *tlv_value;
@@ -109,7 +110,18 @@ static void finishMessageHeader(struct rfc5444_writer *wr  __attribute__ ((unuse
     struct rfc5444_writer_address *first_addr __attribute__ ((unused)),
     struct rfc5444_writer_address *last_addr __attribute__ ((unused)),
     bool not_fragmented __attribute__ ((unused))) {
+  struct rfc5444_writer_address *addr;
+
   fragments++;
+
+  for (addr = first_addr; ; addr = list_next_element(addr, _addr_fragment_node)) {
+    if (addr->_mandatory_addr) {
+      mandatory_fragments++;
+    }
+    if (addr == last_addr) {
+      break;
+    }
+  }
 }
 
 static void addAddresses(struct rfc5444_writer *wr) {
@@ -123,7 +135,7 @@ static void addAddresses(struct rfc5444_writer *wr) {
     if (tlv_value) {
       tlv_value[tlv_value_size-1] = (uint8_t)(i & 255);
     }
-    addr = rfc5444_writer_add_address(wr, cpr.creator, &ip, i == 0);
+    addr = rfc5444_writer_add_address(wr, cpr.creator, &ip, i == mandatory_idx);
     if (tlv_value) {
       rfc5444_writer_add_addrtlv(wr, addr, &addrtlvs[0], tlv_value, tlv_value_size, false);
       tlv_value[tlv_value_size-1] = (tlv_value_size-1) & 255;
@@ -152,6 +164,9 @@ static void write_packet(struct rfc5444_writer *w __attribute__ ((unused)),
 
 static void clear_elements(void) {
   fragments = 0;
+  mandatory_idx = 0;
+  mandatory_fragments = 0;
+  writer.sorted_addr_compression = false;
   tlv_value = NULL;
   tlv_value_size = 0;
   packets[0] = packets[1] = 0;
@@ -216,6 +231,29 @@ static void test_frag_50_3(void) {
   END_TEST();
 }
 
+static void test_sorted_mandatory_last(void) {
+  enum rfc5444_result result;
+  START_TEST();
+
+  /* the mandatory address has the highest binary value */
+  tlvcount = 6;
+  mandatory_idx = tlvcount - 1;
+  tlv_value = tlv_value_buffer;
+  tlv_value_size = 20;
+  writer.sorted_addr_compression = true;
+
+  result = rfc5444_writer_create_message_alltarget(&writer, 1, 4);
+  CHECK_TRUE(result == 0 , "Parser should return 0");
+  rfc5444_writer_flush(&writer, &small_if, false);
+  rfc5444_writer_flush(&writer, &large_if, false);
+
+  CHECK_TRUE(fragments > 1, "bad number of fragments: %d\n", fragments);
+  CHECK_TRUE(mandatory_fragments == fragments,
+      "mandatory address only in %d of %d fragments\n", mandatory_fragments, fragments);
+
+  END_TEST();
+}
+
 int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))) {
   struct rfc5444_writer_message *msg;
   size_t i;
@@ -244,6 +282,7 @@ int main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused))
     test_frag_80_2();
   }
   test_frag_50_3();
+  test_sorted_mandatory_last();
 
   rfc5444_writer_cleanup(&writer);
 
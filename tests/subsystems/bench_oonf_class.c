@@ -0,0 +1,278 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+/**
+ * @file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_class.h"
+#include "cunit/cunit.h"
+
+/*! number of objects alive at the same time */
+#define WORKING_SET 1024
+
+/*! default number of object replacements (in thousands) */
+#define DEFAULT_ITERATIONS 2000
+
+/*! number of samples in the extension history */
+#define HISTORY_SIZE 256
+
+/**
+ * Object similar to a NHDP link: a header with list/tree nodes
+ * and a large per-domain array initialized by its creator.
+ */
+struct churn_object {
+  uint32_t index;
+  void *pointers[16];
+  uint64_t domaindata[64];
+};
+
+/**
+ * Extension similar to a link metric with a sample history
+ */
+struct churn_extension {
+  uint32_t active;
+  uint32_t samples[HISTORY_SIZE];
+};
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "bench_oonf_class",
+};
+
+static void _cb_object_init(void *);
+static void _cb_extension_init(void *);
+
+static struct oonf_class _churn_classes[] = {
+  {
+    .name = "churn heap",
+    .size = sizeof(struct churn_object),
+  },
+  {
+    .name = "churn slab",
+    .size = sizeof(struct churn_object),
+    .slab = true,
+  },
+  {
+    .name = "churn slab init",
+    .size = sizeof(struct churn_object),
+    .slab = true,
+    .init = _cb_object_init,
+  },
+};
+
+static struct oonf_class_extension _churn_extensions[] = {
+  {
+    .ext_name = "churn heap history",
+    .class_name = "churn heap",
+    .size = sizeof(struct churn_extension),
+  },
+  {
+    .ext_name = "churn slab history",
+    .class_name = "churn slab",
+    .size = sizeof(struct churn_extension),
+  },
+  {
+    .ext_name = "churn slab init history",
+    .class_name = "churn slab init",
+    .size = sizeof(struct churn_extension),
+    .init = _cb_extension_init,
+  },
+};
+
+static struct churn_object *_objects[WORKING_SET];
+
+static void
+_clear_elements(void) {
+  memset(_objects, 0, sizeof(_objects));
+}
+
+static uint64_t
+_get_time(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/**
+ * Only the header is zeroed, domain data is set by the creator
+ * @param ptr pointer to object
+ */
+static void
+_cb_object_init(void *ptr) {
+  memset(ptr, 0, offsetof(struct churn_object, domaindata));
+}
+
+/**
+ * The sample history is only valid up to the active counter
+ * @param ptr pointer to object
+ */
+static void
+_cb_extension_init(void *ptr) {
+  struct churn_extension *ext;
+
+  ext = oonf_class_get_extension(&_churn_extensions[2], ptr);
+  ext->active = 0;
+}
+
+/**
+ * Create a new object like its owner would do
+ * @param idx index of class
+ * @param i index of object
+ * @return pointer to object
+ */
+static struct churn_object *
+_create(size_t idx, uint32_t i) {
+  struct churn_object *obj;
+  struct churn_extension *ext;
+  size_t d;
+
+  obj = oonf_class_malloc(&_churn_classes[idx]);
+  obj->index = i;
+  for (d = 0; d < ARRAYSIZE(obj->domaindata); d++) {
+    obj->domaindata[d] = d;
+  }
+
+  ext = oonf_class_get_extension(&_churn_extensions[idx], obj);
+  ext->samples[ext->active++] = i;
+  return obj;
+}
+
+/**
+ * Replace random objects of a working set, similar to links and
+ * routing entries coming and going in a dense network.
+ * @param idx index of class
+ * @param iterations number of replacements in thousands
+ */
+static void
+_run_churn(size_t idx, int iterations) {
+  struct oonf_class *c;
+  struct churn_extension *ext;
+  uint64_t start, end;
+  uint32_t slot;
+  int i, j, bad;
+
+  c = &_churn_classes[idx];
+  cunit_start_test(c->name);
+
+  oonf_class_add(c);
+  CHECK_TRUE(oonf_class_extension_add(&_churn_extensions[idx]) == 0,
+      "Could not add extension to %s", c->name);
+
+  srand(42);
+  for (i = 0; i < WORKING_SET; i++) {
+    _objects[i] = _create(idx, i);
+  }
+
+  start = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (j = 0; j < 1000; j++) {
+      slot = rand() % WORKING_SET;
+
+      oonf_class_free(c, _objects[slot]);
+      _objects[slot] = _create(idx, slot);
+    }
+  }
+  end = _get_time();
+
+  bad = 0;
+  for (i = 0; i < WORKING_SET; i++) {
+    ext = oonf_class_get_extension(&_churn_extensions[idx], _objects[i]);
+    if (_objects[i]->index != (uint32_t)i || _objects[i]->pointers[0] != NULL
+        || ext->active != 1 || ext->samples[0] != (uint32_t)i) {
+      bad++;
+    }
+    oonf_class_free(c, _objects[i]);
+  }
+  CHECK_TRUE(bad == 0, "%d objects not initialized correctly", bad);
+
+  printf("\t%" PRINTF_SIZE_T_SPECIFIER " bytes: %.0f replacements/s\n",
+      c->total_size, end > start ? 1000.0 * iterations * 1000000.0 / (end - start) : 0.0);
+
+  oonf_class_extension_remove(&_churn_extensions[idx]);
+  oonf_class_remove(c);
+
+  cunit_end_test(c->name);
+}
+
+int
+main(int argc, char **argv) {
+  struct oonf_subsystem *classes;
+  int iterations;
+  size_t i;
+
+  iterations = DEFAULT_ITERATIONS;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  classes = oonf_subsystem_get(OONF_CLASS_SUBSYSTEM);
+  if (classes == NULL || oonf_subsystem_call_init(classes)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_CLASS_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  BEGIN_TESTING(_clear_elements);
+
+  for (i = 0; i < ARRAYSIZE(_churn_classes); i++) {
+    _run_churn(i, iterations);
+  }
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,277 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "rfc5444/rfc5444_iana.h"
+#include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_duplicate_set.h"
+#include "cunit/cunit.h"
+
+/*! number of originators in the duplicate set */
+#define ORIGINATOR_COUNT 5000
+
+/*! default number of messages per originator for measurement */
+#define DEFAULT_ITERATIONS 20
+
+/*! validity time of duplicate entries used by the benchmark */
+#define VALIDITY_TIME 300000
+
+/*! maximum distance of reordered sequence numbers */
+#define REORDER_DISTANCE 100
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "bench_oonf_duplicate_set",
+};
+
+static struct netaddr _originators[ORIGINATOR_COUNT];
+static struct oonf_duplicate_set _processed_set;
+
+static void
+_clear_elements(void) {
+}
+
+/**
+ * @return monotonic time in microseconds
+ */
+static uint64_t
+_get_time(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/**
+ * Generate a mix of IPv4 and IPv6 originator addresses
+ */
+static void
+_generate_originators(void) {
+  uint8_t bin[16];
+  int i;
+
+  memset(bin, 0, sizeof(bin));
+  for (i = 0; i < ORIGINATOR_COUNT; i++) {
+    if (i % 4 == 3) {
+      /* every fourth originator uses IPv6 */
+      bin[0] = 0xfd;
+      bin[14] = (uint8_t)(i >> 8);
+      bin[15] = (uint8_t)i;
+      netaddr_from_binary(&_originators[i], bin, 16, AF_INET6);
+    }
+    else {
+      bin[0] = 10;
+      bin[2] = (uint8_t)(i >> 8);
+      bin[3] = (uint8_t)i;
+      netaddr_from_binary(&_originators[i], bin, 4, AF_INET);
+    }
+  }
+}
+
+/**
+ * Feed messages of all originators through the duplicate set like
+ * olsrv2_mpr_shall_process() does. Each message is received twice,
+ * the second copy must be detected as duplicate.
+ * @param name name of test
+ * @param window sliding window size of duplicate set
+ * @param iterations number of messages per originator
+ */
+static void
+_run_bench(const char *name, uint16_t window, int iterations) {
+  enum oonf_duplicate_result result;
+  uint64_t start, end;
+  int i, j, bad_new, bad_dup;
+  uint16_t seqno;
+
+  cunit_start_test(name);
+
+  oonf_duplicate_set_add(&_processed_set, OONF_DUPSET_16BIT);
+  oonf_duplicate_set_set_window(&_processed_set, window);
+
+  /* first message of each originator */
+  bad_new = 0;
+  for (j = 0; j < ORIGINATOR_COUNT; j++) {
+    result = oonf_duplicate_entry_add(&_processed_set, RFC7181_MSGTYPE_TC,
+        &_originators[j], 0, VALIDITY_TIME);
+    if (result != OONF_DUPSET_FIRST) {
+      bad_new++;
+    }
+  }
+  CHECK_TRUE(bad_new == 0, "%d originators were not new", bad_new);
+
+  bad_new = 0;
+  bad_dup = 0;
+  start = _get_time();
+  for (i = 1; i <= iterations; i++) {
+    /* let the sequence number wrap around */
+    seqno = (uint16_t)(i * 4099);
+
+    for (j = 0; j < ORIGINATOR_COUNT; j++) {
+      result = oonf_duplicate_entry_add(&_processed_set, RFC7181_MSGTYPE_TC,
+          &_originators[j], seqno, VALIDITY_TIME);
+      if (result != OONF_DUPSET_NEWEST && (result != OONF_DUPSET_TOO_OLD || seqno >= 32768)) {
+        bad_new++;
+      }
+
+      result = oonf_duplicate_entry_add(&_processed_set, RFC7181_MSGTYPE_TC,
+          &_originators[j], seqno, VALIDITY_TIME);
+      if (oonf_duplicate_is_new(result)) {
+        bad_dup++;
+      }
+    }
+  }
+  end = _get_time();
+
+  CHECK_TRUE(bad_new == 0, "%d new messages not detected", bad_new);
+  CHECK_TRUE(bad_dup == 0, "%d duplicates not detected", bad_dup);
+
+  CHECK_TRUE(oonf_duplicate_set_get_duplicates(&_processed_set) == (uint32_t)(iterations * ORIGINATOR_COUNT),
+      "%u duplicates counted", oonf_duplicate_set_get_duplicates(&_processed_set));
+
+  printf("\t%d originators, window %u: %.0f messages/s\n", ORIGINATOR_COUNT,
+      oonf_duplicate_set_get_window(&_processed_set),
+      end > start ? 2.0 * iterations * ORIGINATOR_COUNT * 1000000.0 / (end - start) : 0.0);
+
+  oonf_duplicate_set_remove(&_processed_set);
+
+  cunit_end_test(name);
+}
+
+/**
+ * Deliver the messages of a single originator with reordering
+ * of up to REORDER_DISTANCE sequence numbers and count the messages
+ * that are not detected as new.
+ * @param name name of test
+ * @param window sliding window size of duplicate set
+ * @param expect_loss true if the window is too small for the reordering
+ */
+static void
+_run_reorder(const char *name, uint16_t window, bool expect_loss) {
+  uint16_t seqno;
+  int i, lost;
+
+  cunit_start_test(name);
+
+  oonf_duplicate_set_add(&_processed_set, OONF_DUPSET_16BIT);
+  oonf_duplicate_set_set_window(&_processed_set, window);
+
+  lost = 0;
+  for (i = 0; i < 4096; i++) {
+    /* every second message is delayed by REORDER_DISTANCE sequence numbers */
+    seqno = (i & 1) ? i - REORDER_DISTANCE : i;
+    if (seqno > i) {
+      continue;
+    }
+
+    if (!oonf_duplicate_is_new(oonf_duplicate_entry_add(&_processed_set,
+        RFC7181_MSGTYPE_TC, &_originators[0], seqno, VALIDITY_TIME))) {
+      lost++;
+    }
+  }
+
+  if (expect_loss) {
+    CHECK_TRUE(lost > 0, "no message was lost with window %u",
+        oonf_duplicate_set_get_window(&_processed_set));
+  }
+  else {
+    CHECK_TRUE(lost == 0, "%d messages lost with window %u", lost,
+        oonf_duplicate_set_get_window(&_processed_set));
+  }
+  CHECK_TRUE(oonf_duplicate_set_get_too_old(&_processed_set) + oonf_duplicate_set_get_duplicates(&_processed_set) == (uint32_t)lost,
+      "counters do not match %d lost messages", lost);
+
+  printf("\twindow %u: %d of 4096 messages lost, %u too old, %u resets\n",
+      oonf_duplicate_set_get_window(&_processed_set), lost,
+      oonf_duplicate_set_get_too_old(&_processed_set),
+      oonf_duplicate_set_get_resets(&_processed_set));
+
+  oonf_duplicate_set_remove(&_processed_set);
+
+  cunit_end_test(name);
+}
+
+int
+main(int argc, char **argv) {
+  struct oonf_subsystem *dupset;
+  int iterations;
+
+  iterations = DEFAULT_ITERATIONS;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  /* initialize duplicate set with all of its dependencies */
+  dupset = oonf_subsystem_get(OONF_DUPSET_SUBSYSTEM);
+  if (dupset == NULL || oonf_subsystem_call_init(dupset)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_DUPSET_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  _generate_originators();
+
+  BEGIN_TESTING(_clear_elements);
+
+  _run_bench("bench_duplicate_set_processed", 0, iterations);
+  _run_bench("bench_duplicate_set_processed_wide", 1024, iterations);
+
+  _run_reorder("reorder_default_window", 0, true);
+  _run_reorder("reorder_wide_window", 256, false);
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
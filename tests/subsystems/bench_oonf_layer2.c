@@ -0,0 +1,342 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/avl.h"
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_layer2.h"
+#include "cunit/cunit.h"
+
+/*! number of layer2 networks */
+#define NETWORK_COUNT 32
+
+/*! number of layer2 neighbors of each network */
+#define NEIGHBOR_COUNT 128
+
+/*! first (fake) interface index of the layer2 networks */
+#define FIRST_IF_INDEX 1000
+
+/*! default number of lookup rounds for measurement */
+#define DEFAULT_ITERATIONS 100
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "bench_oonf_layer2",
+};
+
+static struct oonf_layer2_net *_nets[NETWORK_COUNT];
+static struct oonf_layer2_neigh *_neighs[NETWORK_COUNT][NEIGHBOR_COUNT];
+static struct netaddr _macs[NETWORK_COUNT][NEIGHBOR_COUNT];
+
+static void
+_clear_elements(void) {
+}
+
+/**
+ * @return monotonic time in microseconds
+ */
+static uint64_t
+_get_time(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/**
+ * Fill the layer2 database with networks and neighbors. Neighbors
+ * of different networks share the same MAC prefix, like stations of
+ * one vendor.
+ */
+static void
+_fill_db(void) {
+  char ifname[IF_NAMESIZE];
+  uint8_t mac[6];
+  int n, i;
+
+  for (n = 0; n < NETWORK_COUNT; n++) {
+    snprintf(ifname, sizeof(ifname), "bench%d", n);
+    _nets[n] = oonf_layer2_net_add(ifname);
+
+    /* simulate the interface showing up in the operation system */
+    _nets[n]->if_listener.data->index = FIRST_IF_INDEX + n;
+    _nets[n]->if_listener.if_changed(&_nets[n]->if_listener);
+
+    for (i = 0; i < NEIGHBOR_COUNT; i++) {
+      mac[0] = 0x02;
+      mac[1] = 0x00;
+      mac[2] = 0x5e;
+      mac[3] = (uint8_t)n;
+      mac[4] = (uint8_t)(i >> 8);
+      mac[5] = (uint8_t)i;
+      netaddr_from_binary(&_macs[n][i], mac, sizeof(mac), AF_MAC48);
+
+      _neighs[n][i] = oonf_layer2_neigh_add(_nets[n], &_macs[n][i]);
+    }
+  }
+}
+
+/**
+ * Remove all networks from the layer2 database
+ */
+static void
+_clear_db(void) {
+  int n;
+
+  for (n = 0; n < NETWORK_COUNT; n++) {
+    if (_nets[n]) {
+      oonf_layer2_net_remove(_nets[n], NULL);
+    }
+  }
+}
+
+/**
+ * Print lookup rate
+ * @param what name of lookup
+ * @param lookups number of lookups
+ * @param start start timestamp
+ * @param end end timestamp
+ */
+static void
+_print_rate(const char *what, int lookups, uint64_t start, uint64_t end) {
+  printf("\t%-28s %.0f lookups/s\n", what,
+      end > start ? lookups * 1000000.0 / (end - start) : 0.0);
+}
+
+/**
+ * Measure network lookups by interface index and by
+ * interface name
+ * @param iterations number of lookup rounds
+ */
+static void
+_bench_net(int iterations) {
+  struct oonf_layer2_net *l2net;
+  uint64_t start, mid, end;
+  int i, n, bad;
+
+  START_TEST();
+
+  bad = 0;
+  start = _get_time();
+  for (i = 0; i < iterations * NEIGHBOR_COUNT; i++) {
+    for (n = 0; n < NETWORK_COUNT; n++) {
+      l2net = oonf_layer2_net_get_by_index(FIRST_IF_INDEX + n);
+      if (l2net != _nets[n]) {
+        bad++;
+      }
+    }
+  }
+  mid = _get_time();
+  for (i = 0; i < iterations * NEIGHBOR_COUNT; i++) {
+    for (n = 0; n < NETWORK_COUNT; n++) {
+      l2net = oonf_layer2_net_get(_nets[n]->name);
+      if (l2net != _nets[n]) {
+        bad++;
+      }
+    }
+  }
+  end = _get_time();
+
+  CHECK_TRUE(bad == 0, "%d network lookups failed", bad);
+
+  _print_rate("l2net (ifindex hash)", iterations * NEIGHBOR_COUNT * NETWORK_COUNT, start, mid);
+  _print_rate("l2net (name avl tree)", iterations * NEIGHBOR_COUNT * NETWORK_COUNT, mid, end);
+
+  END_TEST();
+}
+
+/**
+ * Measure neighbor lookups with the MAC hash index and
+ * the ordered avl tree
+ * @param iterations number of lookup rounds
+ */
+static void
+_bench_neigh(int iterations) {
+  struct oonf_layer2_neigh *l2neigh;
+  uint64_t start, mid1, mid2, end;
+  int i, n, j, bad;
+
+  START_TEST();
+
+  bad = 0;
+  start = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NETWORK_COUNT; n++) {
+      for (j = 0; j < NEIGHBOR_COUNT; j++) {
+        l2neigh = oonf_layer2_neigh_get(_nets[n], &_macs[n][j]);
+        if (l2neigh != _neighs[n][j]) {
+          bad++;
+        }
+      }
+    }
+  }
+  mid1 = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NETWORK_COUNT; n++) {
+      for (j = 0; j < NEIGHBOR_COUNT; j++) {
+        l2neigh = oonf_layer2_neigh_get_by_index(FIRST_IF_INDEX + n,
+            netaddr_get_binptr(&_macs[n][j]), 6);
+        if (l2neigh != _neighs[n][j]) {
+          bad++;
+        }
+      }
+    }
+  }
+  mid2 = _get_time();
+  for (i = 0; i < iterations; i++) {
+    for (n = 0; n < NETWORK_COUNT; n++) {
+      for (j = 0; j < NEIGHBOR_COUNT; j++) {
+        l2neigh = avl_find_element(&_nets[n]->neighbors, &_macs[n][j], l2neigh, _node);
+        if (l2neigh != _neighs[n][j]) {
+          bad++;
+        }
+      }
+    }
+  }
+  end = _get_time();
+
+  CHECK_TRUE(bad == 0, "%d neighbor lookups failed", bad);
+
+  _print_rate("l2neigh (mac hash)", iterations * NEIGHBOR_COUNT * NETWORK_COUNT, start, mid1);
+  _print_rate("l2neigh (ifindex + raw mac)", iterations * NEIGHBOR_COUNT * NETWORK_COUNT, mid1, mid2);
+  _print_rate("l2neigh (avl tree)", iterations * NEIGHBOR_COUNT * NETWORK_COUNT, mid2, end);
+
+  END_TEST();
+}
+
+/**
+ * Remove part of the database and change interface indices,
+ * then check that the indexes still match the trees
+ */
+static void
+_test_remove(void) {
+  struct oonf_layer2_neigh *l2neigh;
+  int n, j, bad;
+
+  START_TEST();
+
+  /* remove every second neighbor of every network */
+  for (n = 0; n < NETWORK_COUNT; n++) {
+    for (j = 0; j < NEIGHBOR_COUNT; j += 2) {
+      oonf_layer2_neigh_remove(_neighs[n][j], NULL);
+      _neighs[n][j] = NULL;
+    }
+  }
+
+  /* remove the first network */
+  oonf_layer2_net_remove(_nets[0], NULL);
+  _nets[0] = NULL;
+
+  /* simulate a re-created interface with a new index */
+  _nets[1]->if_listener.data->index = FIRST_IF_INDEX + NETWORK_COUNT;
+  _nets[1]->if_listener.if_changed(&_nets[1]->if_listener);
+
+  bad = 0;
+  if (oonf_layer2_net_get_by_index(FIRST_IF_INDEX) != NULL) {
+    bad++;
+  }
+  if (oonf_layer2_net_get_by_index(FIRST_IF_INDEX + 1) != NULL) {
+    bad++;
+  }
+  if (oonf_layer2_net_get_by_index(FIRST_IF_INDEX + NETWORK_COUNT) != _nets[1]) {
+    bad++;
+  }
+
+  for (n = 1; n < NETWORK_COUNT; n++) {
+    for (j = 0; j < NEIGHBOR_COUNT; j++) {
+      if (oonf_layer2_neigh_get(_nets[n], &_macs[n][j]) != _neighs[n][j]
+          || _neighs[n][j] != avl_find_element(
+              &_nets[n]->neighbors, &_macs[n][j], l2neigh, _node)) {
+        bad++;
+      }
+    }
+  }
+  CHECK_TRUE(bad == 0, "%d lookups differ between hash index and tree", bad);
+
+  END_TEST();
+}
+
+int
+main(int argc, char **argv) {
+  struct oonf_subsystem *layer2;
+  int iterations;
+
+  iterations = DEFAULT_ITERATIONS;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+  }
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  /* initialize layer2 database with all of its dependencies */
+  layer2 = oonf_subsystem_get(OONF_LAYER2_SUBSYSTEM);
+  if (layer2 == NULL || oonf_subsystem_call_init(layer2)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_LAYER2_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  _fill_db();
+
+  BEGIN_TESTING(_clear_elements);
+
+  _bench_net(iterations);
+  _bench_neigh(iterations);
+  _test_remove();
+
+  _clear_db();
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
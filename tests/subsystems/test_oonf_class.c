@@ -0,0 +1,747 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+/**
+ * @file
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "common/common_types.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_class.h"
+#include "cunit/cunit.h"
+
+/*! number of objects allocated by the tests */
+#define OBJECT_COUNT 1000
+
+/*! number of objects fitting into the memory budget of the budget tests */
+#define BUDGET_COUNT 100
+
+/*! object size of the budget tests, does not need rounding */
+#define BUDGET_OBJECT_SIZE 128
+
+struct test_object {
+  uint32_t index;
+  char payload[100];
+};
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "test_oonf_class",
+};
+
+static struct oonf_class _slab_class = {
+  .name = "slab test",
+  .size = sizeof(struct test_object),
+  .slab = true,
+};
+
+static struct oonf_class _hugepage_class = {
+  .name = "hugepage test",
+  .size = sizeof(struct test_object),
+  .slab = true,
+  .slab_hugepage = true,
+};
+
+static struct oonf_class _extended_class = {
+  .name = "extended slab test",
+  .size = sizeof(struct test_object),
+  .slab = true,
+};
+
+static struct oonf_class_extension _slab_extension = {
+  .ext_name = "slab test extension",
+  .class_name = "extended slab test",
+  .size = 200,
+};
+
+static void _cb_add(void *);
+static void _cb_change(void *);
+static void _cb_remove(void *);
+static void _cb_change_batch(void **, size_t);
+static void _cb_change_and_remove(void *);
+static void _cb_change_batch_and_remove(void **, size_t);
+
+static struct oonf_class _event_class = {
+  .name = "event test",
+  .size = sizeof(struct test_object),
+};
+
+static struct oonf_class_extension _add_listener = {
+  .ext_name = "add listener",
+  .class_name = "event test",
+  .cb_add = _cb_add,
+};
+
+static struct oonf_class_extension _change_listener = {
+  .ext_name = "change listener",
+  .class_name = "event test",
+  .cb_change = _cb_change,
+  .cb_remove = _cb_remove,
+};
+
+static struct oonf_class_extension _batch_listener = {
+  .ext_name = "batch listener",
+  .class_name = "event test",
+  .cb_change_batch = _cb_change_batch,
+};
+
+static struct oonf_class_extension _removing_listener = {
+  .ext_name = "removing listener",
+  .class_name = "event test",
+  .cb_change = _cb_change_and_remove,
+};
+
+static struct oonf_class_extension _removing_batch_listener = {
+  .ext_name = "removing batch listener",
+  .class_name = "event test",
+  .cb_change_batch = _cb_change_batch_and_remove,
+};
+
+static void _cb_pressure(struct oonf_class *, uint32_t);
+
+static struct oonf_class _budget_class = {
+  .name = "budget",
+  .size = BUDGET_OBJECT_SIZE,
+  .budget = BUDGET_COUNT * BUDGET_OBJECT_SIZE,
+  .cb_pressure = _cb_pressure,
+};
+
+static struct oonf_class _limit_class = {
+  .name = "limit",
+  .size = BUDGET_OBJECT_SIZE,
+  .budget = BUDGET_COUNT * BUDGET_OBJECT_SIZE,
+};
+
+static struct test_object *_objects[OBJECT_COUNT];
+
+/* index of the oldest object not yet evicted by the pressure callback */
+static uint32_t _oldest;
+
+static int _added, _changed, _removed, _batches, _batch_changed, _batch_null;
+
+static void
+_clear_elements(void) {
+  memset(_objects, 0, sizeof(_objects));
+  _added = 0;
+  _changed = 0;
+  _removed = 0;
+  _batches = 0;
+  _batch_changed = 0;
+  _batch_null = 0;
+}
+
+static void
+_cb_add(void *ptr __attribute__((unused))) {
+  _added++;
+}
+
+static void
+_cb_change(void *ptr __attribute__((unused))) {
+  _changed++;
+}
+
+static void
+_cb_remove(void *ptr __attribute__((unused))) {
+  _removed++;
+}
+
+static void
+_cb_change_batch(void **ptr, size_t count) {
+  size_t i;
+
+  _batches++;
+  for (i = 0; i < count; i++) {
+    if (ptr[i]) {
+      _batch_changed++;
+    }
+  }
+}
+
+/**
+ * Free the oldest objects of the budget class
+ * @param cl budget class
+ * @param count number of objects to free
+ */
+static void
+_cb_pressure(struct oonf_class *cl, uint32_t count) {
+  for (; count > 0 && _oldest < OBJECT_COUNT; _oldest++) {
+    if (_objects[_oldest]) {
+      oonf_class_free(cl, _objects[_oldest]);
+      _objects[_oldest] = NULL;
+      count--;
+    }
+  }
+}
+
+/**
+ * Remove the object following the changed one from the test array
+ * @param ptr pointer to changed object
+ */
+static void
+_cb_change_and_remove(void *ptr) {
+  struct test_object *obj = ptr;
+  uint32_t next;
+
+  next = obj->index + 1;
+  if (next < OBJECT_COUNT && _objects[next] != NULL) {
+    oonf_class_event(&_event_class, _objects[next], OONF_OBJECT_REMOVED);
+    oonf_class_free(&_event_class, _objects[next]);
+    _objects[next] = NULL;
+  }
+}
+
+/**
+ * Remove the object following each changed one from the test array
+ * while the batch is delivered.
+ * @param ptr array of pointers to changed objects
+ * @param count number of objects in array
+ */
+static void
+_cb_change_batch_and_remove(void **ptr, size_t count) {
+  size_t i;
+
+  _batches++;
+  for (i = 0; i < count; i++) {
+    if (ptr[i] == NULL) {
+      /* object was removed earlier in this callback */
+      _batch_null++;
+      continue;
+    }
+
+    _batch_changed++;
+    _cb_change_and_remove(ptr[i]);
+  }
+}
+
+/**
+ * @param ptr pointer to memory block
+ * @param length length of memory block
+ * @return true if all bytes of the block are zero
+ */
+static bool
+_is_zero(const void *ptr, size_t length) {
+  const uint8_t *data = ptr;
+  size_t i;
+
+  for (i = 0; i < length; i++) {
+    if (data[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Allocate all test objects and fill their memory
+ * @param c memory class
+ * @return number of blocks that were not zeroed
+ */
+static int
+_allocate_all(struct oonf_class *c) {
+  int i, dirty = 0;
+
+  for (i = 0; i < OBJECT_COUNT; i++) {
+    _objects[i] = oonf_class_malloc(c);
+    if (!_is_zero(_objects[i], c->total_size)) {
+      dirty++;
+    }
+    memset(_objects[i], 0xaa, c->total_size);
+    _objects[i]->index = i;
+  }
+  return dirty;
+}
+
+static void
+test_slab_alloc_free(void) {
+  uint32_t slabs;
+  int i, corrupt;
+
+  START_TEST();
+
+  oonf_class_add(&_slab_class);
+
+  CHECK_TRUE(_allocate_all(&_slab_class) == 0, "blocks not zeroed");
+
+  corrupt = 0;
+  for (i = 0; i < OBJECT_COUNT; i++) {
+    if (_objects[i]->index != (uint32_t)i) {
+      corrupt++;
+    }
+  }
+  CHECK_TRUE(corrupt == 0, "%d blocks overlap", corrupt);
+
+  slabs = oonf_class_get_slabs(&_slab_class);
+  CHECK_TRUE(slabs > 1, "only %u slabs", slabs);
+  CHECK_TRUE(slabs * _slab_class._slab_capacity >= OBJECT_COUNT
+      && (slabs - 1) * _slab_class._slab_capacity < OBJECT_COUNT,
+      "%u slabs for %u objects per slab", slabs, _slab_class._slab_capacity);
+  CHECK_TRUE(oonf_class_get_usage(&_slab_class) == OBJECT_COUNT,
+      "usage is %u", oonf_class_get_usage(&_slab_class));
+  CHECK_TRUE(oonf_class_get_slab_occupancy(&_slab_class) > 90,
+      "occupancy is %u%%", oonf_class_get_slab_occupancy(&_slab_class));
+
+  /* free every second object, then reallocate them */
+  for (i = 0; i < OBJECT_COUNT; i += 2) {
+    oonf_class_free(&_slab_class, _objects[i]);
+  }
+  CHECK_TRUE(oonf_class_get_free(&_slab_class) + OBJECT_COUNT / 2
+      == slabs * _slab_class._slab_capacity,
+      "%u free blocks", oonf_class_get_free(&_slab_class));
+
+  for (i = 0; i < OBJECT_COUNT; i += 2) {
+    _objects[i] = oonf_class_malloc(&_slab_class);
+    CHECK_TRUE(_is_zero(_objects[i], _slab_class.total_size), "recycled block not zeroed");
+  }
+  CHECK_TRUE(oonf_class_get_slabs(&_slab_class) == slabs,
+      "reallocation created new slabs: %u", oonf_class_get_slabs(&_slab_class));
+  CHECK_TRUE(oonf_class_get_recycled(&_slab_class) + oonf_class_get_allocations(&_slab_class)
+      == OBJECT_COUNT + OBJECT_COUNT / 2, "%u blocks recycled, %u allocated",
+      oonf_class_get_recycled(&_slab_class), oonf_class_get_allocations(&_slab_class));
+
+  /* free everything, only one empty slab is kept */
+  for (i = 0; i < OBJECT_COUNT; i++) {
+    oonf_class_free(&_slab_class, _objects[i]);
+  }
+  CHECK_TRUE(oonf_class_get_usage(&_slab_class) == 0,
+      "usage is %u", oonf_class_get_usage(&_slab_class));
+  CHECK_TRUE(oonf_class_get_slabs(&_slab_class) == 1,
+      "%u slabs left", oonf_class_get_slabs(&_slab_class));
+  CHECK_TRUE(oonf_class_get_empty_slabs(&_slab_class) == 1,
+      "%u empty slabs", oonf_class_get_empty_slabs(&_slab_class));
+
+  oonf_class_reclaim(&_slab_class);
+  CHECK_TRUE(oonf_class_get_slabs(&_slab_class) == 0,
+      "%u slabs after reclaim", oonf_class_get_slabs(&_slab_class));
+  CHECK_TRUE(oonf_class_get_free(&_slab_class) == 0,
+      "%u free blocks after reclaim", oonf_class_get_free(&_slab_class));
+
+  oonf_class_remove(&_slab_class);
+
+  END_TEST();
+}
+
+static void
+test_slab_extension(void) {
+  struct test_object *obj;
+  size_t old_capacity;
+
+  START_TEST();
+
+  oonf_class_add(&_extended_class);
+  old_capacity = _extended_class._slab_capacity;
+
+  CHECK_TRUE(oonf_class_extension_add(&_slab_extension) == 0, "extension failed");
+  CHECK_TRUE(_extended_class._slab_capacity < old_capacity,
+      "capacity not adapted to extension: %u", _extended_class._slab_capacity);
+  CHECK_TRUE(_extended_class._slab_capacity >= OONF_CLASS_SLAB_MIN_OBJECTS,
+      "capacity too small: %u", _extended_class._slab_capacity);
+
+  obj = oonf_class_malloc(&_extended_class);
+  CHECK_TRUE(_is_zero(obj, _extended_class.total_size), "block not zeroed");
+  memset(oonf_class_get_extension(&_slab_extension, obj), 0x55, _slab_extension.size);
+  oonf_class_free(&_extended_class, obj);
+
+  oonf_class_extension_remove(&_slab_extension);
+  oonf_class_remove(&_extended_class);
+
+  END_TEST();
+}
+
+static void
+test_slab_hugepage(void) {
+  START_TEST();
+
+  oonf_class_add(&_hugepage_class);
+
+  CHECK_TRUE(_hugepage_class._slab_size == OONF_CLASS_SLAB_HUGEPAGE_SIZE,
+      "slab size is %" PRINTF_SIZE_T_SPECIFIER, _hugepage_class._slab_size);
+
+  CHECK_TRUE(_allocate_all(&_hugepage_class) == 0, "blocks not zeroed");
+  CHECK_TRUE(oonf_class_get_slabs(&_hugepage_class) == 1,
+      "%u slabs", oonf_class_get_slabs(&_hugepage_class));
+
+  while (oonf_class_get_usage(&_hugepage_class) > 0) {
+    oonf_class_free(&_hugepage_class, _objects[oonf_class_get_usage(&_hugepage_class) - 1]);
+  }
+
+  oonf_class_remove(&_hugepage_class);
+  CHECK_TRUE(oonf_class_get_slabs(&_hugepage_class) == 0,
+      "%u slabs after removal", oonf_class_get_slabs(&_hugepage_class));
+
+  END_TEST();
+}
+
+static void
+test_event_listeners(void) {
+  int i;
+
+  START_TEST();
+
+  oonf_class_add(&_event_class);
+  CHECK_TRUE(oonf_class_extension_add(&_add_listener) == 0, "add listener failed");
+  CHECK_TRUE(oonf_class_extension_add(&_change_listener) == 0, "change listener failed");
+  CHECK_TRUE(oonf_class_extension_add(&_batch_listener) == 0, "batch listener failed");
+
+  for (i = 0; i < 10; i++) {
+    _objects[i] = oonf_class_malloc(&_event_class);
+    _objects[i]->index = i;
+    oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_ADDED);
+    oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_CHANGED);
+  }
+  CHECK_TRUE(_added == 10, "%d add events", _added);
+  CHECK_TRUE(_changed == 10, "%d change events", _changed);
+  CHECK_TRUE(_batches == 10 && _batch_changed == 10,
+      "%d batches with %d change events", _batches, _batch_changed);
+
+  /* removed listener must not be called anymore */
+  oonf_class_extension_remove(&_add_listener);
+  _objects[10] = oonf_class_malloc(&_event_class);
+  oonf_class_event(&_event_class, _objects[10], OONF_OBJECT_ADDED);
+  CHECK_TRUE(_added == 10, "%d add events after listener removal", _added);
+
+  for (i = 0; i <= 10; i++) {
+    oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_REMOVED);
+    oonf_class_free(&_event_class, _objects[i]);
+  }
+  CHECK_TRUE(_removed == 11, "%d remove events", _removed);
+
+  oonf_class_extension_remove(&_change_listener);
+  oonf_class_extension_remove(&_batch_listener);
+  oonf_class_remove(&_event_class);
+
+  END_TEST();
+}
+
+static void
+test_event_batch(void) {
+  int i;
+
+  START_TEST();
+
+  oonf_class_add(&_event_class);
+  CHECK_TRUE(oonf_class_extension_add(&_change_listener) == 0, "change listener failed");
+  CHECK_TRUE(oonf_class_extension_add(&_batch_listener) == 0, "batch listener failed");
+
+  for (i = 0; i < 100; i++) {
+    _objects[i] = oonf_class_malloc(&_event_class);
+    _objects[i]->index = i;
+  }
+
+  oonf_class_event_batch_begin(&_event_class);
+  oonf_class_event_batch_begin(&_event_class);
+  for (i = 0; i < 100; i++) {
+    oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_CHANGED);
+    oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_CHANGED);
+  }
+  oonf_class_event_batch_end(&_event_class);
+  CHECK_TRUE(_changed == 0 && _batches == 0, "events delivered in nested batch");
+
+  /* removed objects must not be delivered */
+  oonf_class_event(&_event_class, _objects[50], OONF_OBJECT_REMOVED);
+  oonf_class_free(&_event_class, _objects[50]);
+  _objects[50] = NULL;
+
+  oonf_class_event_batch_end(&_event_class);
+  CHECK_TRUE(_changed == 99, "%d change events", _changed);
+  CHECK_TRUE(_batches == 1, "%d batches", _batches);
+  CHECK_TRUE(_batch_changed == 99, "%d objects in batch", _batch_changed);
+
+  /* listener removes objects of the batch while it is dispatched */
+  _changed = 0;
+  _removed = 0;
+  _batch_changed = 0;
+  _objects[50] = oonf_class_malloc(&_event_class);
+  _objects[50]->index = 50;
+  CHECK_TRUE(oonf_class_extension_add(&_removing_listener) == 0, "removing listener failed");
+
+  oonf_class_event_batch_begin(&_event_class);
+  for (i = 0; i < 10; i++) {
+    oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_CHANGED);
+  }
+  oonf_class_event_batch_end(&_event_class);
+
+  /* removing listener runs last, other listeners see all objects */
+  CHECK_TRUE(_changed == 10 && _batch_changed == 10,
+      "%d/%d change events", _changed, _batch_changed);
+  CHECK_TRUE(_removed == 5, "%d objects removed", _removed);
+
+  oonf_class_event_batch_begin(&_event_class);
+  for (i = 0; i < 10; i++) {
+    if (_objects[i]) {
+      oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_CHANGED);
+    }
+  }
+  oonf_class_event_batch_end(&_event_class);
+  CHECK_TRUE(_changed == 15, "%d change events in second batch", _changed);
+
+  oonf_class_extension_remove(&_removing_listener);
+
+  for (i = 0; i < 100; i++) {
+    if (_objects[i]) {
+      oonf_class_free(&_event_class, _objects[i]);
+    }
+  }
+
+  oonf_class_extension_remove(&_change_listener);
+  oonf_class_extension_remove(&_batch_listener);
+  oonf_class_remove(&_event_class);
+
+  END_TEST();
+}
+
+static void
+test_event_batch_dedup(void) {
+  int i, j;
+
+  START_TEST();
+
+  oonf_class_add(&_event_class);
+  CHECK_TRUE(oonf_class_extension_add(&_change_listener) == 0, "change listener failed");
+  CHECK_TRUE(oonf_class_extension_add(&_batch_listener) == 0, "batch listener failed");
+
+  for (i = 0; i < 10; i++) {
+    _objects[i] = oonf_class_malloc(&_event_class);
+    _objects[i]->index = i;
+  }
+
+  /* every object changes three times, never twice in a row */
+  oonf_class_event_batch_begin(&_event_class);
+  for (j = 0; j < 3; j++) {
+    for (i = 0; i < 10; i++) {
+      oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_CHANGED);
+    }
+  }
+  oonf_class_event_batch_end(&_event_class);
+
+  CHECK_TRUE(_changed == 10, "%d change events", _changed);
+  CHECK_TRUE(_batches == 1 && _batch_changed == 10,
+      "%d batches with %d change events", _batches, _batch_changed);
+
+  /* objects can be queued again after the batch was delivered */
+  oonf_class_event_batch_begin(&_event_class);
+  oonf_class_event(&_event_class, _objects[0], OONF_OBJECT_CHANGED);
+  oonf_class_event(&_event_class, _objects[1], OONF_OBJECT_CHANGED);
+  oonf_class_event(&_event_class, _objects[0], OONF_OBJECT_CHANGED);
+  oonf_class_event_batch_end(&_event_class);
+
+  CHECK_TRUE(_changed == 12, "%d change events", _changed);
+
+  for (i = 0; i < 10; i++) {
+    oonf_class_free(&_event_class, _objects[i]);
+    _objects[i] = NULL;
+  }
+
+  oonf_class_extension_remove(&_change_listener);
+  oonf_class_extension_remove(&_batch_listener);
+  oonf_class_remove(&_event_class);
+
+  END_TEST();
+}
+
+static void
+test_event_batch_remove(void) {
+  int i;
+
+  START_TEST();
+
+  oonf_class_add(&_event_class);
+  CHECK_TRUE(oonf_class_extension_add(&_removing_batch_listener) == 0,
+      "removing batch listener failed");
+  CHECK_TRUE(oonf_class_extension_add(&_change_listener) == 0, "change listener failed");
+
+  for (i = 0; i < 10; i++) {
+    _objects[i] = oonf_class_malloc(&_event_class);
+    _objects[i]->index = i;
+  }
+
+  oonf_class_event_batch_begin(&_event_class);
+  for (i = 0; i < 10; i++) {
+    oonf_class_event(&_event_class, _objects[i], OONF_OBJECT_CHANGED);
+  }
+  oonf_class_event_batch_end(&_event_class);
+
+  /* every second object is removed during the batch callback */
+  CHECK_TRUE(_batches == 1, "%d batches", _batches);
+  CHECK_TRUE(_batch_changed == 5, "%d objects in batch", _batch_changed);
+  CHECK_TRUE(_batch_null == 5, "%d removed objects in batch", _batch_null);
+  CHECK_TRUE(_removed == 5, "%d objects removed", _removed);
+
+  /* the next listener only sees the remaining objects */
+  CHECK_TRUE(_changed == 5, "%d change events", _changed);
+
+  for (i = 0; i < 10; i++) {
+    if (_objects[i]) {
+      oonf_class_free(&_event_class, _objects[i]);
+    }
+  }
+
+  oonf_class_extension_remove(&_change_listener);
+  oonf_class_extension_remove(&_removing_batch_listener);
+  oonf_class_remove(&_event_class);
+
+  END_TEST();
+}
+
+static void
+test_budget_pressure(void) {
+  uint32_t i, evicted, failed = 0;
+
+  START_TEST();
+
+  oonf_class_add(&_budget_class);
+  _oldest = 0;
+
+  CHECK_TRUE(oonf_class_get_budget(&_budget_class)
+      == BUDGET_COUNT * _budget_class.total_size,
+      "budget is %" PRINTF_SIZE_T_SPECIFIER, oonf_class_get_budget(&_budget_class));
+
+  for (i = 0; i < 2 * BUDGET_COUNT; i++) {
+    _objects[i] = oonf_class_malloc(&_budget_class);
+    if (_objects[i] == NULL) {
+      failed++;
+    }
+  }
+
+  CHECK_TRUE(failed == 0, "%u allocations failed", failed);
+  CHECK_TRUE(oonf_class_get_denied(&_budget_class) == 0,
+      "%u allocations denied", oonf_class_get_denied(&_budget_class));
+  CHECK_TRUE(oonf_class_get_pressure(&_budget_class) > 0,
+      "pressure callback was not called");
+  CHECK_TRUE(oonf_class_get_usage(&_budget_class) <= BUDGET_COUNT,
+      "%u objects in use", oonf_class_get_usage(&_budget_class));
+  CHECK_TRUE(oonf_class_get_evicted(&_budget_class)
+      == 2 * BUDGET_COUNT - oonf_class_get_usage(&_budget_class),
+      "%u objects evicted, %u in use", oonf_class_get_evicted(&_budget_class),
+      oonf_class_get_usage(&_budget_class));
+
+  evicted = oonf_class_get_evicted(&_budget_class);
+  for (i = 0; i < 2 * BUDGET_COUNT; i++) {
+    if (_objects[i]) {
+      oonf_class_free(&_budget_class, _objects[i]);
+      _objects[i] = NULL;
+    }
+  }
+
+  /* objects freed outside of the callback are not evicted */
+  CHECK_TRUE(oonf_class_get_evicted(&_budget_class) == evicted,
+      "%u objects evicted", oonf_class_get_evicted(&_budget_class));
+
+  oonf_class_remove(&_budget_class);
+
+  END_TEST();
+}
+
+static void
+test_budget_limit(void) {
+  uint32_t i, failed = 0;
+
+  START_TEST();
+
+  oonf_class_add(&_limit_class);
+
+  for (i = 0; i < BUDGET_COUNT + BUDGET_COUNT / 2; i++) {
+    _objects[i] = oonf_class_malloc(&_limit_class);
+    if (_objects[i] == NULL) {
+      failed++;
+    }
+  }
+
+  CHECK_TRUE(failed == BUDGET_COUNT / 2, "%u allocations failed", failed);
+  CHECK_TRUE(oonf_class_get_denied(&_limit_class) == BUDGET_COUNT / 2,
+      "%u allocations denied", oonf_class_get_denied(&_limit_class));
+  CHECK_TRUE(oonf_class_get_usage(&_limit_class) == BUDGET_COUNT,
+      "%u objects in use", oonf_class_get_usage(&_limit_class));
+  CHECK_TRUE(oonf_class_get_memory_usage(&_limit_class)
+      <= oonf_class_get_budget(&_limit_class),
+      "%" PRINTF_SIZE_T_SPECIFIER " bytes in use",
+      oonf_class_get_memory_usage(&_limit_class));
+
+  /* freeing an object makes room for another one */
+  oonf_class_free(&_limit_class, _objects[0]);
+  _objects[0] = oonf_class_malloc(&_limit_class);
+  CHECK_TRUE(_objects[0] != NULL, "allocation after free failed");
+
+  for (i = 0; i < BUDGET_COUNT; i++) {
+    oonf_class_free(&_limit_class, _objects[i]);
+    _objects[i] = NULL;
+  }
+  oonf_class_remove(&_limit_class);
+
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *classes;
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  classes = oonf_subsystem_get(OONF_CLASS_SUBSYSTEM);
+  if (classes == NULL || oonf_subsystem_call_init(classes)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_CLASS_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  BEGIN_TESTING(_clear_elements);
+
+  test_slab_alloc_free();
+  test_slab_extension();
+  test_slab_hugepage();
+  test_event_listeners();
+  test_event_batch();
+  test_event_batch_dedup();
+  test_event_batch_remove();
+  test_budget_pressure();
+  test_budget_limit();
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}
@@ -0,0 +1,433 @@
+
+/*
+ * The olsr.org Optimized Link-State Routing daemon version 2 (olsrd2)
+ * Copyright (c) 2004-2015, the olsr.org team - see HISTORY file
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/**
+ * @file
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/avl.h"
+#include "common/common_types.h"
+#include "common/netaddr.h"
+#include "core/oonf_appdata.h"
+#include "core/oonf_logging.h"
+#include "core/oonf_subsystem.h"
+#include "subsystems/oonf_class.h"
+#include "subsystems/oonf_clock.h"
+#include "subsystems/oonf_layer2.h"
+#include "subsystems/oonf_timer.h"
+#include "cunit/cunit.h"
+
+static void _cb_net_changed(struct oonf_layer2_net *,
+    uint32_t data_changed, uint32_t neighdata_changed);
+static void _cb_neigh_changed(struct oonf_layer2_neigh *, uint32_t data_changed);
+static void _cb_neigh_changed_remove(struct oonf_layer2_neigh *, uint32_t data_changed);
+static void _cb_neigh_changed_other(struct oonf_layer2_neigh *, uint32_t data_changed);
+
+static const struct oonf_appdata _appdata = {
+  .app_name = "test_oonf_layer2",
+};
+
+static struct oonf_layer2_origin _origin = {
+  .name = "test",
+  .priority = OONF_LAYER2_ORIGIN_RELIABLE,
+};
+
+static struct oonf_layer2_listener _signal_listener = {
+  .name = "signal",
+  .net_mask = OONF_LAYER2_MASK(OONF_LAYER2_NET_NOISE),
+  .neighdata_mask = OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_TX_SIGNAL),
+  .neigh_mask = OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_TX_SIGNAL)
+      | OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_RX_SIGNAL),
+  .cb_net_changed = _cb_net_changed,
+  .cb_neigh_changed = _cb_neigh_changed,
+};
+
+static struct oonf_layer2_listener _other_listener = {
+  .name = "other",
+  .neigh_mask = OONF_LAYER2_NEIGH_MASK_ALL,
+  .cb_neigh_changed = _cb_neigh_changed_other,
+};
+
+static struct oonf_layer2_net *_l2net;
+static struct netaddr _mac;
+
+static int _net_calls, _neigh_calls, _other_calls;
+static uint32_t _net_data, _net_neighdata, _neigh_data;
+
+static void
+_clear_elements(void) {
+  _net_calls = 0;
+  _neigh_calls = 0;
+  _other_calls = 0;
+  _net_data = 0;
+  _net_neighdata = 0;
+  _neigh_data = 0;
+}
+
+static void
+_cb_net_changed(struct oonf_layer2_net *l2net __attribute__((unused)),
+    uint32_t data_changed, uint32_t neighdata_changed) {
+  _net_calls++;
+  _net_data |= data_changed;
+  _net_neighdata |= neighdata_changed;
+}
+
+static void
+_cb_neigh_changed(struct oonf_layer2_neigh *l2neigh __attribute__((unused)),
+    uint32_t data_changed) {
+  _neigh_calls++;
+  _neigh_data |= data_changed;
+}
+
+static void
+_cb_neigh_changed_remove(struct oonf_layer2_neigh *l2neigh,
+    uint32_t data_changed) {
+  _neigh_calls++;
+  _neigh_data |= data_changed;
+
+  oonf_layer2_neigh_remove(l2neigh, &_origin);
+}
+
+static void
+_cb_neigh_changed_other(struct oonf_layer2_neigh *l2neigh __attribute__((unused)),
+    uint32_t data_changed __attribute__((unused))) {
+  _other_calls++;
+}
+
+static struct oonf_layer2_neigh *
+_set_neigh_value(enum oonf_layer2_neighbor_index idx, int64_t value) {
+  struct oonf_layer2_neigh *l2neigh;
+
+  l2neigh = oonf_layer2_neigh_add(_l2net, &_mac);
+  oonf_layer2_set_value(&l2neigh->data[idx], &_origin, value);
+  oonf_layer2_neigh_commit(l2neigh);
+  return l2neigh;
+}
+
+static void
+test_coalesce_neigh(void) {
+  struct oonf_layer2_neigh *l2neigh;
+
+  START_TEST();
+
+  _set_neigh_value(OONF_LAYER2_NEIGH_TX_SIGNAL, -50000);
+  _set_neigh_value(OONF_LAYER2_NEIGH_TX_SIGNAL, -51000);
+  l2neigh = _set_neigh_value(OONF_LAYER2_NEIGH_RX_SIGNAL, -60000);
+  CHECK_TRUE(_neigh_calls == 0, "Listener called before flush: %d", _neigh_calls);
+
+  oonf_layer2_flush_changes();
+  CHECK_TRUE(_neigh_calls == 1, "Neighbor notifications: %d", _neigh_calls);
+  CHECK_TRUE(_other_calls == 1, "Other notifications: %d", _other_calls);
+  CHECK_TRUE(_neigh_data == (OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_TX_SIGNAL)
+      | OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_RX_SIGNAL)),
+      "Changed neighbor data: 0x%x", _neigh_data);
+
+  /* commit without a changed value */
+  oonf_layer2_neigh_commit(l2neigh);
+  oonf_layer2_flush_changes();
+  CHECK_TRUE(_neigh_calls == 1, "Notification without change: %d", _neigh_calls);
+
+  /* removing a value is a change too */
+  oonf_layer2_reset_value(&l2neigh->data[OONF_LAYER2_NEIGH_RX_SIGNAL]);
+  oonf_layer2_neigh_commit(l2neigh);
+  oonf_layer2_flush_changes();
+  CHECK_TRUE(_neigh_calls == 2, "Neighbor notifications: %d", _neigh_calls);
+  CHECK_TRUE(_neigh_data == (OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_TX_SIGNAL)
+      | OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_RX_SIGNAL)),
+      "Changed neighbor data: 0x%x", _neigh_data);
+
+  oonf_layer2_neigh_remove(l2neigh, &_origin);
+  END_TEST();
+}
+
+static void
+test_mask_filter(void) {
+  struct oonf_layer2_neigh *l2neigh;
+
+  START_TEST();
+
+  l2neigh = _set_neigh_value(OONF_LAYER2_NEIGH_TX_BITRATE, 1000000);
+  oonf_layer2_flush_changes();
+  CHECK_TRUE(_neigh_calls == 0, "Notification for unsubscribed data: %d", _neigh_calls);
+  CHECK_TRUE(_other_calls == 1, "Other notifications: %d", _other_calls);
+
+  oonf_layer2_set_value(&_l2net->data[OONF_LAYER2_NET_FREQUENCY_1], &_origin, 2412000000ll);
+  oonf_layer2_net_commit(_l2net);
+  oonf_layer2_flush_changes();
+  CHECK_TRUE(_net_calls == 0, "Notification for unsubscribed data: %d", _net_calls);
+
+  oonf_layer2_set_value(&_l2net->data[OONF_LAYER2_NET_NOISE], &_origin, -90000);
+  oonf_layer2_set_value(&_l2net->neighdata[OONF_LAYER2_NEIGH_TX_SIGNAL], &_origin, -70000);
+  oonf_layer2_net_commit(_l2net);
+  oonf_layer2_flush_changes();
+  CHECK_TRUE(_net_calls == 1, "Network notifications: %d", _net_calls);
+  CHECK_TRUE(_net_data == OONF_LAYER2_MASK(OONF_LAYER2_NET_NOISE),
+      "Changed network data: 0x%x", _net_data);
+  CHECK_TRUE(_net_neighdata == OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_TX_SIGNAL),
+      "Changed neighbor defaults: 0x%x", _net_neighdata);
+
+  oonf_layer2_neigh_remove(l2neigh, &_origin);
+  END_TEST();
+}
+
+static void
+test_remove_pending(void) {
+  struct oonf_layer2_neigh *l2neigh;
+
+  START_TEST();
+
+  l2neigh = _set_neigh_value(OONF_LAYER2_NEIGH_TX_SIGNAL, -50000);
+  CHECK_TRUE(oonf_layer2_neigh_remove(l2neigh, &_origin), "Neighbor not removed");
+  CHECK_TRUE(oonf_layer2_neigh_get(_l2net, &_mac) == NULL, "Neighbor still in database");
+
+  oonf_layer2_flush_changes();
+  CHECK_TRUE(_neigh_calls == 0, "Notification for removed neighbor: %d", _neigh_calls);
+  CHECK_TRUE(_other_calls == 0, "Notification for removed neighbor: %d", _other_calls);
+
+  END_TEST();
+}
+
+static void
+test_remove_during_notification(void) {
+  START_TEST();
+
+  _signal_listener.cb_neigh_changed = _cb_neigh_changed_remove;
+
+  _set_neigh_value(OONF_LAYER2_NEIGH_TX_SIGNAL, -50000);
+  oonf_layer2_flush_changes();
+
+  CHECK_TRUE(_neigh_calls == 1, "Neighbor notifications: %d", _neigh_calls);
+  CHECK_TRUE(_other_calls == 0, "Notification for removed neighbor: %d", _other_calls);
+  CHECK_TRUE(oonf_layer2_neigh_get(_l2net, &_mac) == NULL, "Neighbor still in database");
+
+  _signal_listener.cb_neigh_changed = _cb_neigh_changed;
+  END_TEST();
+}
+
+static void
+_next_time_slice(void) {
+  uint64_t now;
+
+  now = oonf_clock_getNow();
+  while (oonf_clock_getNow() == now) {
+    if (oonf_clock_update()) {
+      return;
+    }
+  }
+}
+
+static void
+test_history(void) {
+  const struct oonf_layer2_history *history;
+  const struct oonf_layer2_sample *first, *last;
+  struct oonf_layer2_neigh *l2neigh;
+  int64_t i, rate;
+
+  START_TEST();
+
+  oonf_layer2_set_history_mask(OONF_LAYER2_MASK(OONF_LAYER2_NET_NOISE),
+      OONF_LAYER2_MASK(OONF_LAYER2_NEIGH_RX_BYTES));
+
+  for (i=1; i<=20; i++) {
+    _next_time_slice();
+    l2neigh = _set_neigh_value(OONF_LAYER2_NEIGH_RX_BYTES, i * 1000);
+    _set_neigh_value(OONF_LAYER2_NEIGH_TX_BYTES, i * 1000);
+  }
+
+  CHECK_TRUE(oonf_layer2_neigh_get_history(l2neigh, OONF_LAYER2_NEIGH_TX_BYTES) == NULL,
+      "History for unselected data");
+
+  history = oonf_layer2_neigh_get_history(l2neigh, OONF_LAYER2_NEIGH_RX_BYTES);
+  CHECK_TRUE(history != NULL, "No history for selected data");
+  if (history) {
+    CHECK_TRUE(oonf_layer2_history_get_count(history) == OONF_LAYER2_HISTORY_LENGTH,
+        "History length: %"PRINTF_SIZE_T_SPECIFIER, oonf_layer2_history_get_count(history));
+    CHECK_TRUE(oonf_layer2_history_get_min(history) == 5000,
+        "History minimum: %"PRId64, oonf_layer2_history_get_min(history));
+    CHECK_TRUE(oonf_layer2_history_get_max(history) == 20000,
+        "History maximum: %"PRId64, oonf_layer2_history_get_max(history));
+    CHECK_TRUE(oonf_layer2_history_get_average(history) == 12500,
+        "History average: %"PRId64, oonf_layer2_history_get_average(history));
+    CHECK_TRUE(oonf_layer2_history_get_sample(history, 0)->value == 5000,
+        "Oldest sample: %"PRId64, oonf_layer2_history_get_sample(history, 0)->value);
+
+    first = oonf_layer2_history_get_sample(history, 0);
+    last = oonf_layer2_history_get_last(history);
+    rate = 15000 * 1000 / (int64_t)(last->timestamp - first->timestamp);
+    CHECK_TRUE(oonf_layer2_history_get_rate(history) == rate,
+        "History rate: %"PRId64" != %"PRId64, oonf_layer2_history_get_rate(history), rate);
+
+    /* two commits in one time slice only store the last value */
+    _set_neigh_value(OONF_LAYER2_NEIGH_RX_BYTES, 1);
+    CHECK_TRUE(oonf_layer2_history_get_last(history)->value == 1,
+        "Last sample: %"PRId64, oonf_layer2_history_get_last(history)->value);
+    CHECK_TRUE(oonf_layer2_history_get_sample(history, 14)->value == 19000,
+        "Sample before last: %"PRId64, oonf_layer2_history_get_sample(history, 14)->value);
+    CHECK_TRUE(oonf_layer2_history_get_min(history) == 1,
+        "History minimum: %"PRId64, oonf_layer2_history_get_min(history));
+  }
+
+  /* network histories */
+  oonf_layer2_set_value(&_l2net->data[OONF_LAYER2_NET_NOISE], &_origin, -95000);
+  oonf_layer2_net_commit(_l2net);
+  history = oonf_layer2_net_get_history(_l2net, OONF_LAYER2_NET_NOISE);
+  CHECK_TRUE(history != NULL && oonf_layer2_history_get_count(history) == 1,
+      "No network history");
+  CHECK_TRUE(oonf_layer2_net_get_history(_l2net, OONF_LAYER2_NET_FREQUENCY_1) == NULL,
+      "History for unselected network data");
+
+  /* unselecting data removes its history */
+  oonf_layer2_set_history_mask(0, 0);
+  CHECK_TRUE(oonf_layer2_neigh_get_history(l2neigh, OONF_LAYER2_NEIGH_RX_BYTES) == NULL,
+      "History not removed");
+  CHECK_TRUE(oonf_layer2_net_get_history(_l2net, OONF_LAYER2_NET_NOISE) == NULL,
+      "Network history not removed");
+
+  oonf_layer2_flush_changes();
+  oonf_layer2_neigh_remove(l2neigh, &_origin);
+  END_TEST();
+}
+
+static void
+test_neigh_pressure(void) {
+  static const uint64_t last_seen[] = { 3000, 1000, 4000, 2000 };
+  struct oonf_layer2_neigh *l2neighs[ARRAYSIZE(last_seen)];
+  struct netaddr macs[ARRAYSIZE(last_seen)];
+  struct oonf_class *cl;
+  uint32_t evicted;
+  size_t i;
+
+  START_TEST();
+
+  cl = avl_find_element(oonf_class_get_tree(), LAYER2_CLASS_NEIGHBOR, cl, _node);
+  CHECK_TRUE(cl != NULL && cl->cb_pressure != NULL, "No pressure callback for layer2 neighbors");
+  if (cl == NULL || cl->cb_pressure == NULL) {
+    END_TEST();
+    return;
+  }
+
+  for (i=0; i<ARRAYSIZE(last_seen); i++) {
+    memcpy(&macs[i], &_mac, sizeof(_mac));
+    macs[i]._addr[5] = 0x10 + i;
+
+    l2neighs[i] = oonf_layer2_neigh_add(_l2net, &macs[i]);
+    oonf_layer2_set_value(&l2neighs[i]->data[OONF_LAYER2_NEIGH_TX_SIGNAL], &_origin, -60000);
+    oonf_layer2_neigh_commit(l2neighs[i]);
+    l2neighs[i]->last_seen = last_seen[i];
+  }
+  oonf_layer2_flush_changes();
+
+  /* neighbors are removed by a timer, not during the allocation */
+  evicted = oonf_class_get_evicted(cl);
+  cl->cb_pressure(cl, 2);
+  CHECK_TRUE(oonf_layer2_neigh_get(_l2net, &macs[1]) != NULL, "Neighbor removed during pressure callback");
+
+  /* wait for the eviction timer */
+  for (i=0; i<10 && oonf_class_get_evicted(cl) == evicted; i++) {
+    usleep(100000);
+    if (oonf_clock_update()) {
+      break;
+    }
+    oonf_timer_walk();
+  }
+
+  CHECK_TRUE(oonf_class_get_evicted(cl) - evicted == 2,
+      "%u neighbors evicted", oonf_class_get_evicted(cl) - evicted);
+  for (i=0; i<ARRAYSIZE(last_seen); i++) {
+    /* the two neighbors with the oldest activity are gone */
+    CHECK_TRUE((oonf_layer2_neigh_get(_l2net, &macs[i]) == NULL) == (last_seen[i] <= 2000),
+        "Neighbor %"PRINTF_SIZE_T_SPECIFIER" (last seen %"PRIu64") %s", i, last_seen[i],
+        last_seen[i] <= 2000 ? "not evicted" : "evicted");
+  }
+
+  for (i=0; i<ARRAYSIZE(last_seen); i++) {
+    if (last_seen[i] > 2000) {
+      oonf_layer2_neigh_remove(l2neighs[i], &_origin);
+    }
+  }
+  END_TEST();
+}
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused))) {
+  struct oonf_subsystem *layer2;
+
+  if (oonf_log_init(&_appdata, LOG_SEVERITY_WARN) || oonf_subsystem_init()) {
+    return 1;
+  }
+
+  /* initialize layer2 database with all of its dependencies */
+  layer2 = oonf_subsystem_get(OONF_LAYER2_SUBSYSTEM);
+  if (layer2 == NULL || oonf_subsystem_call_init(layer2)) {
+    fprintf(stderr, "Could not initialize subsystem " OONF_LAYER2_SUBSYSTEM "\n");
+    return 1;
+  }
+
+  oonf_layer2_add_origin(&_origin);
+  oonf_layer2_add_listener(&_signal_listener);
+  oonf_layer2_add_listener(&_other_listener);
+
+  _l2net = oonf_layer2_net_add("test0");
+  if (_l2net == NULL || netaddr_from_string(&_mac, "02:00:5e:00:00:01")) {
+    return 1;
+  }
+
+  BEGIN_TESTING(_clear_elements);
+
+  test_coalesce_neigh();
+  test_mask_filter();
+  test_remove_pending();
+  test_remove_during_notification();
+  test_history();
+  test_neigh_pressure();
+
+  oonf_layer2_remove_listener(&_other_listener);
+  oonf_layer2_remove_listener(&_signal_listener);
+  oonf_layer2_remove_origin(&_origin);
+
+  oonf_subsystem_cleanup();
+  oonf_log_cleanup();
+
+  return FINISH_TESTING();
+}